@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "cupoch/cupoch.h"
+
+using namespace cupoch;
+
+namespace {
+
+template <typename Func>
+double MeasureMilliseconds(int n_iter, Func func) {
+    func();  // warm up
+    utility::GetExecutionContext().Synchronize();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_iter; ++i) func();
+    utility::GetExecutionContext().Synchronize();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / n_iter;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    utility::SetVerbosityLevel(utility::VerbosityLevel::Debug);
+
+    const std::string filename = (argc > 1) ? argv[1] : "../../testdata/fragment.pcd";
+    const float radius = (argc > 2) ? std::stof(argv[2]) : 0.05;
+    const int max_nn = 30;
+    const int n_iter = 10;
+    auto pcd = io::CreatePointCloudFromFile(filename);
+    if (pcd->IsEmpty()) {
+        utility::LogInfo("Failed to read {}.", filename);
+        return 0;
+    }
+    utility::LogInfo("{:d} points, radius {:f}", pcd->points_.size(), radius);
+
+    thrustcupoch::device_vector<int> offsets;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+
+    geometry::KDTreeFlann kdtree;
+    const double kdtree_build = MeasureMilliseconds(n_iter, [&] { kdtree.SetGeometry(*pcd); });
+    const double kdtree_hybrid = MeasureMilliseconds(n_iter, [&] {
+        kdtree.SearchHybrid(pcd->points_, radius, max_nn, indices, distance2);
+    });
+    const double kdtree_csr = MeasureMilliseconds(n_iter, [&] {
+        kdtree.SearchRadiusCSR(pcd->points_, radius, offsets, indices, distance2);
+    });
+    const int kdtree_total = kdtree.SearchRadiusCSR(pcd->points_, radius, offsets, indices, distance2);
+
+    geometry::UniformGridIndex grid(radius);
+    const double grid_build = MeasureMilliseconds(n_iter, [&] { grid.SetGeometry(*pcd); });
+    const double grid_hybrid = MeasureMilliseconds(n_iter, [&] {
+        grid.SearchHybrid(pcd->points_, radius, max_nn, indices, distance2);
+    });
+    const double grid_csr = MeasureMilliseconds(n_iter, [&] {
+        grid.SearchRadiusCSR(pcd->points_, radius, offsets, indices, distance2);
+    });
+    const int grid_total = grid.SearchRadiusCSR(pcd->points_, radius, offsets, indices, distance2);
+
+    utility::LogInfo("                   build [ms]  hybrid [ms]  radius CSR [ms]  neighbors");
+    utility::LogInfo("KDTreeFlann      {:12.3f} {:12.3f} {:16.3f} {:10d}",
+                     kdtree_build, kdtree_hybrid, kdtree_csr, kdtree_total);
+    utility::LogInfo("UniformGridIndex {:12.3f} {:12.3f} {:16.3f} {:10d}",
+                     grid_build, grid_hybrid, grid_csr, grid_total);
+    utility::LogInfo("{:d} occupied cells", grid.GetNumCells());
+
+    // memory locality of the neighbor searches in file, random and Morton order
+    thrust::host_vector<Eigen::Vector3f> shuffled = pcd->GetPoints();
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0));
+    geometry::PointCloud reordered(shuffled);
+    const geometry::KDTreeSearchParamHybrid param(radius, max_nn);
+    auto estimate_normals = [&] {
+        reordered.InvalidateKDTree();
+        reordered.EstimateNormals(param);
+    };
+    const double shuffled_normals = MeasureMilliseconds(n_iter, estimate_normals);
+    reordered.SortSpatially();
+    const double sorted_normals = MeasureMilliseconds(n_iter, estimate_normals);
+    utility::LogInfo("EstimateNormals: shuffled {:.3f} ms, Morton sorted {:.3f} ms",
+                     shuffled_normals, sorted_normals);
+    return 0;
+}
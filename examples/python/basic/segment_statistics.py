@@ -0,0 +1,23 @@
+import numpy as np
+import cupoch as cph
+
+if __name__ == "__main__":
+    # two lines of points 5 apart
+    line0 = np.array([[0.1 * i, 0.0, 0.0] for i in range(30)], dtype=np.float32)
+    line1 = np.array([[5.0, 0.0, 0.1 * i] for i in range(10)], dtype=np.float32)
+    pcd = cph.geometry.PointCloud()
+    pcd.points = cph.utility.Vector3fVector(np.vstack([line0, line1]))
+
+    labels = pcd.cluster_euclidean(0.15)
+    stats = pcd.compute_segment_statistics(labels)
+    print(stats)
+    counts = np.asarray(stats.counts)
+    centroids = np.asarray(stats.centroids)
+    assert stats.get_num_segments() == 2
+    assert sorted(counts.tolist()) == [10, 30]
+    for i in range(stats.get_num_segments()):
+        members = np.asarray(stats.indices)[stats.offsets[i]:stats.offsets[i + 1]]
+        ref = np.asarray(pcd.points)[members].mean(axis=0)
+        assert np.allclose(centroids[i], ref, atol=1.0e-4)
+        print("segment", i, "count", counts[i], "centroid", centroids[i],
+              "obb extent", np.asarray(stats.obb_extents)[i])
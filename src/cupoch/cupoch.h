@@ -3,23 +3,36 @@
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/camera/pinhole_camera_parameters.h"
 #include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/compact_pointcloud.h"
+#include "cupoch/geometry/crop_regions.h"
+#include "cupoch/geometry/dynamic_kdtree.h"
 #include "cupoch/geometry/geometry.h"
 #include "cupoch/geometry/image.h"
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/kdtree_query_batcher.h"
 #include "cupoch/geometry/lineset.h"
+#include "cupoch/geometry/organized_pointcloud.h"
 #include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/pointcloud_pipeline.h"
+#include "cupoch/geometry/segment_statistics.h"
 #include "cupoch/geometry/trianglemesh.h"
+#include "cupoch/geometry/uniform_grid_index.h"
 #include "cupoch/io/class_io/ijson_convertible_io.h"
 #include "cupoch/io/class_io/image_io.h"
 #include "cupoch/io/class_io/pointcloud_io.h"
 #include "cupoch/io/class_io/trianglemesh_io.h"
 #include "cupoch/registration/feature.h"
+#include "cupoch/registration/generalized_icp.h"
 #include "cupoch/registration/registration.h"
+#include "cupoch/registration/robust_kernel.h"
 #include "cupoch/registration/transformation_estimation.h"
 #include "cupoch/utility/console.h"
 #include "cupoch/utility/eigen.h"
+#include "cupoch/utility/execution_context.h"
 #include "cupoch/utility/filesystem.h"
 #include "cupoch/utility/helper.h"
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
 #include "cupoch/visualization/utility/draw_geometry.h"
 #include "cupoch/visualization/visualizer/view_control.h"
-#include "cupoch/visualization/visualizer/visualizer.h"
\ No newline at end of file
+#include "cupoch/visualization/visualizer/visualizer.h"
+#endif
\ No newline at end of file
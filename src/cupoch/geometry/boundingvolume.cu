@@ -19,14 +19,14 @@ struct check_within_oriented_bounding_box_functor {
         : points_(points), box_points_(box_points) {};
     const Eigen::Vector3f* points_;
     const std::array<Eigen::Vector3f, 8> box_points_;
-    __device__
+    __host__ __device__
     float test_plane(const Eigen::Vector3f& a, const Eigen::Vector3f& b,
                      const Eigen::Vector3f c, const Eigen::Vector3f& x) const {
         Eigen::Matrix3f design;
         design << (b - a), (c - a), (x - a);
         return design.determinant();
     };
-    __device__
+    __host__ __device__
     bool operator()(size_t idx) const {
         const Eigen::Vector3f& point = points_[idx];
         return (test_plane(box_points_[0], box_points_[1], box_points_[3], point) <=
@@ -52,7 +52,7 @@ struct check_within_axis_aligned_bounding_box_functor {
     const Eigen::Vector3f* points_;
     const Eigen::Vector3f min_bound_;
     const Eigen::Vector3f max_bound_;
-    __device__
+    __host__ __device__
     bool operator() (size_t idx) const {
         const Eigen::Vector3f& point = points_[idx];
         return (point(0) >= min_bound_(0) && point(0) <= max_bound_(0) &&
@@ -153,11 +153,11 @@ std::array<Eigen::Vector3f, 8> OrientedBoundingBox::GetBoxPoints() const {
     return points;
 }
 
-thrust::device_vector<size_t> OrientedBoundingBox::GetPointIndicesWithinBoundingBox(
-        const thrust::device_vector<Eigen::Vector3f>& points) const {
+thrustcupoch::device_vector<size_t> OrientedBoundingBox::GetPointIndicesWithinBoundingBox(
+        const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     auto box_points = GetBoxPoints();
     check_within_oriented_bounding_box_functor func(thrust::raw_pointer_cast(points.data()), box_points);
-    thrust::device_vector<size_t> indices(points.size());
+    thrustcupoch::device_vector<size_t> indices(points.size());
     auto end = thrust::copy_if(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(points.size()),
                                indices.begin(), func);
     indices.resize(thrust::distance(indices.begin(), end));
@@ -262,7 +262,7 @@ AxisAlignedBoundingBox& AxisAlignedBoundingBox::operator+=(
 }
 
 AxisAlignedBoundingBox AxisAlignedBoundingBox::CreateFromPoints(
-        const thrust::device_vector<Eigen::Vector3f>& points) {
+        const thrustcupoch::device_vector<Eigen::Vector3f>& points) {
     AxisAlignedBoundingBox box;
     if (points.empty()) {
         box.min_bound_ = Eigen::Vector3f(0.0, 0.0, 0.0);
@@ -290,9 +290,9 @@ std::array<Eigen::Vector3f, 8> AxisAlignedBoundingBox::GetBoxPoints() const {
     return points;
 }
 
-thrust::device_vector<size_t> AxisAlignedBoundingBox::GetPointIndicesWithinBoundingBox(
-        const thrust::device_vector<Eigen::Vector3f>& points) const {
-    thrust::device_vector<size_t> indices(points.size());
+thrustcupoch::device_vector<size_t> AxisAlignedBoundingBox::GetPointIndicesWithinBoundingBox(
+        const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
+    thrustcupoch::device_vector<size_t> indices(points.size());
     check_within_axis_aligned_bounding_box_functor func(thrust::raw_pointer_cast(points.data()),
                                                         min_bound_, max_bound_);
     auto end = thrust::copy_if(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(points.size()),
@@ -0,0 +1,237 @@
+#include "cupoch/geometry/compact_pointcloud.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+struct encode_half_point_functor {
+    encode_half_point_functor(const Eigen::Vector3f& origin) : origin_(origin) {};
+    const Eigen::Vector3f origin_;
+    __host__ __device__
+    HalfPoint operator() (const Eigen::Vector3f& pt) const {
+        return EncodeHalfPoint(pt, origin_);
+    }
+};
+
+struct decode_half_point_functor {
+    decode_half_point_functor(const Eigen::Vector3f& origin) : origin_(origin) {};
+    const Eigen::Vector3f origin_;
+    __host__ __device__
+    Eigen::Vector3f operator() (const HalfPoint& hp) const {
+        return DecodeHalfPoint(hp, origin_);
+    }
+};
+
+struct encode_normal32_functor {
+    __host__ __device__
+    uint32_t operator() (const Eigen::Vector3f& nl) const {
+        return EncodeNormal32(nl);
+    }
+};
+
+struct decode_normal32_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (uint32_t code) const {
+        return DecodeNormal32(code);
+    }
+};
+
+struct encode_normal16_functor {
+    __host__ __device__
+    uint16_t operator() (const Eigen::Vector3f& nl) const {
+        return EncodeNormal16(nl);
+    }
+};
+
+struct decode_normal16_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (uint16_t code) const {
+        return DecodeNormal16(code);
+    }
+};
+
+struct encode_color8_functor {
+    __host__ __device__
+    uint32_t operator() (const Eigen::Vector3f& color) const {
+        return EncodeColor8(color);
+    }
+};
+
+struct decode_color8_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (uint32_t code) const {
+        return DecodeColor8(code);
+    }
+};
+
+struct transform_half_point_functor {
+    transform_half_point_functor(const Eigen::Matrix3f& linear) : linear_(linear) {};
+    const Eigen::Matrix3f linear_;
+    __host__ __device__
+    void operator() (HalfPoint& hp) const {
+        const Eigen::Vector3f offset = linear_ * DecodeHalfPoint(hp, Eigen::Vector3f::Zero());
+        hp = EncodeHalfPoint(offset, Eigen::Vector3f::Zero());
+    }
+};
+
+struct transform_point_functor {
+    transform_point_functor(const Eigen::Matrix4f& transform) : transform_(transform) {};
+    const Eigen::Matrix4f transform_;
+    __host__ __device__
+    void operator() (Eigen::Vector3f& pt) const {
+        pt = transform_.block<3, 3>(0, 0) * pt + transform_.block<3, 1>(0, 3);
+    }
+};
+
+struct transform_normal32_functor {
+    transform_normal32_functor(const Eigen::Matrix3f& linear) : linear_(linear) {};
+    const Eigen::Matrix3f linear_;
+    __host__ __device__
+    void operator() (uint32_t& code) const {
+        code = EncodeNormal32(linear_ * DecodeNormal32(code));
+    }
+};
+
+struct transform_normal16_functor {
+    transform_normal16_functor(const Eigen::Matrix3f& linear) : linear_(linear) {};
+    const Eigen::Matrix3f linear_;
+    __host__ __device__
+    void operator() (uint16_t& code) const {
+        code = EncodeNormal16(linear_ * DecodeNormal16(code));
+    }
+};
+
+}
+
+CompactPointCloud::CompactPointCloud() {}
+
+CompactPointCloud::~CompactPointCloud() {}
+
+std::shared_ptr<CompactPointCloud> CompactPointCloud::CreateFromPointCloud(
+        const PointCloud &cloud,
+        bool half_precision_points,
+        NormalEncoding normal_encoding) {
+    auto output = std::make_shared<CompactPointCloud>();
+    output->half_precision_points_ = half_precision_points;
+    output->normal_encoding_ = normal_encoding;
+    if (half_precision_points) {
+        output->origin_ = cloud.GetCenter();
+        output->half_points_.resize(cloud.points_.size());
+        thrust::transform(cloud.points_.begin(), cloud.points_.end(),
+                          output->half_points_.begin(),
+                          encode_half_point_functor(output->origin_));
+    } else {
+        output->points_ = cloud.points_;
+    }
+    if (cloud.HasNormals()) {
+        if (normal_encoding == NormalEncoding::Oct32) {
+            output->normals32_.resize(cloud.normals_.size());
+            thrust::transform(cloud.normals_.begin(), cloud.normals_.end(),
+                              output->normals32_.begin(), encode_normal32_functor());
+        } else {
+            output->normals16_.resize(cloud.normals_.size());
+            thrust::transform(cloud.normals_.begin(), cloud.normals_.end(),
+                              output->normals16_.begin(), encode_normal16_functor());
+        }
+    }
+    if (cloud.HasColors()) {
+        output->colors_.resize(cloud.colors_.size());
+        thrust::transform(cloud.colors_.begin(), cloud.colors_.end(),
+                          output->colors_.begin(), encode_color8_functor());
+    }
+    return output;
+}
+
+std::shared_ptr<PointCloud> CompactPointCloud::ToPointCloud() const {
+    auto output = std::make_shared<PointCloud>();
+    if (half_precision_points_) {
+        output->points_.resize(half_points_.size());
+        thrust::transform(half_points_.begin(), half_points_.end(),
+                          output->points_.begin(),
+                          decode_half_point_functor(origin_));
+    } else {
+        output->points_ = points_;
+    }
+    if (HasNormals()) {
+        output->normals_.resize(Size());
+        if (normal_encoding_ == NormalEncoding::Oct32) {
+            thrust::transform(normals32_.begin(), normals32_.end(),
+                              output->normals_.begin(), decode_normal32_functor());
+        } else {
+            thrust::transform(normals16_.begin(), normals16_.end(),
+                              output->normals_.begin(), decode_normal16_functor());
+        }
+    }
+    if (HasColors()) {
+        output->colors_.resize(Size());
+        thrust::transform(colors_.begin(), colors_.end(),
+                          output->colors_.begin(), decode_color8_functor());
+    }
+    return output;
+}
+
+CompactPointCloud &CompactPointCloud::Clear() {
+    origin_ = Eigen::Vector3f::Zero();
+    points_.clear();
+    half_points_.clear();
+    normals32_.clear();
+    normals16_.clear();
+    colors_.clear();
+    return *this;
+}
+
+bool CompactPointCloud::IsEmpty() const { return Size() == 0; }
+
+size_t CompactPointCloud::Size() const {
+    return half_precision_points_ ? half_points_.size() : points_.size();
+}
+
+bool CompactPointCloud::HasNormals() const {
+    const size_t n_normals = (normal_encoding_ == NormalEncoding::Oct32)
+                                     ? normals32_.size()
+                                     : normals16_.size();
+    return Size() > 0 && n_normals == Size();
+}
+
+bool CompactPointCloud::HasColors() const {
+    return Size() > 0 && colors_.size() == Size();
+}
+
+size_t CompactPointCloud::GetMemorySize() const {
+    return points_.size() * sizeof(Eigen::Vector3f) +
+           half_points_.size() * sizeof(HalfPoint) +
+           normals32_.size() * sizeof(uint32_t) +
+           normals16_.size() * sizeof(uint16_t) +
+           colors_.size() * sizeof(uint32_t);
+}
+
+CompactPointCloud &CompactPointCloud::Transform(const Eigen::Matrix4f &transformation) {
+    if (transformation.row(3) != Eigen::RowVector4f(0.0, 0.0, 0.0, 1.0)) {
+        utility::LogError(
+                "[CompactPointCloud::Transform] The bottom row of the "
+                "transformation must be (0, 0, 0, 1).\n");
+        return *this;
+    }
+    const Eigen::Matrix3f linear = transformation.block<3, 3>(0, 0);
+    if (half_precision_points_) {
+        origin_ = linear * origin_ + transformation.block<3, 1>(0, 3);
+        thrust::for_each(half_points_.begin(), half_points_.end(),
+                         transform_half_point_functor(linear));
+    } else {
+        thrust::for_each(points_.begin(), points_.end(),
+                         transform_point_functor(transformation));
+    }
+    if (HasNormals()) {
+        if (normal_encoding_ == NormalEncoding::Oct32) {
+            thrust::for_each(normals32_.begin(), normals32_.end(),
+                             transform_normal32_functor(linear));
+        } else {
+            thrust::for_each(normals16_.begin(), normals16_.end(),
+                             transform_normal16_functor(linear));
+        }
+    }
+    return *this;
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cuda_fp16.h>
+#include <stdint.h>
+#include <cmath>
+#include <memory>
+
+#include "cupoch/geometry/geometry.h"
+#include "cupoch/utility/eigen.h"
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace geometry {
+
+class PointCloud;
+
+/// Point stored as half-precision offsets from the origin of the cloud.
+struct HalfPoint {
+    __half x_;
+    __half y_;
+    __half z_;
+};
+
+__host__ __device__ inline uint32_t EncodeColor8(const Eigen::Vector3f &color) {
+    uint32_t code = 0;
+    for (int i = 0; i < 3; ++i) {
+        const float c = fminf(fmaxf(color[i], 0.0f), 1.0f);
+        code |= uint32_t(c * 255.0f + 0.5f) << (8 * i);
+    }
+    return code;
+}
+
+__host__ __device__ inline Eigen::Vector3f DecodeColor8(uint32_t code) {
+    return Eigen::Vector3f(float(code & 0xff), float((code >> 8) & 0xff),
+                           float((code >> 16) & 0xff)) / 255.0f;
+}
+
+/// Octahedral mapping of a unit vector to [-1, 1]^2.
+/// Cigolle et al., "A Survey of Efficient Representations for Independent
+/// Unit Vectors", 2014
+__host__ __device__ inline Eigen::Vector2f OctahedralEncode(const Eigen::Vector3f &n) {
+    const float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    if (l1 == 0.0f) return Eigen::Vector2f::Zero();
+    Eigen::Vector2f e(n[0] / l1, n[1] / l1);
+    if (n[2] < 0.0f) {
+        const float ex = (1.0f - fabsf(e[1])) * (e[0] >= 0.0f ? 1.0f : -1.0f);
+        const float ey = (1.0f - fabsf(e[0])) * (e[1] >= 0.0f ? 1.0f : -1.0f);
+        e = Eigen::Vector2f(ex, ey);
+    }
+    return e;
+}
+
+__host__ __device__ inline Eigen::Vector3f OctahedralDecode(const Eigen::Vector2f &e) {
+    Eigen::Vector3f n(e[0], e[1], 1.0f - fabsf(e[0]) - fabsf(e[1]));
+    const float t = fmaxf(-n[2], 0.0f);
+    n[0] += (n[0] >= 0.0f) ? -t : t;
+    n[1] += (n[1] >= 0.0f) ? -t : t;
+    return n.normalized();
+}
+
+/// Octahedral normal quantized to two 16-bit signed integers.
+__host__ __device__ inline uint32_t EncodeNormal32(const Eigen::Vector3f &n) {
+    const Eigen::Vector2f e = OctahedralEncode(n);
+    const int16_t x = int16_t(roundf(fminf(fmaxf(e[0], -1.0f), 1.0f) * 32767.0f));
+    const int16_t y = int16_t(roundf(fminf(fmaxf(e[1], -1.0f), 1.0f) * 32767.0f));
+    return uint32_t(uint16_t(x)) | (uint32_t(uint16_t(y)) << 16);
+}
+
+__host__ __device__ inline Eigen::Vector3f DecodeNormal32(uint32_t code) {
+    const int16_t x = int16_t(code & 0xffff);
+    const int16_t y = int16_t(code >> 16);
+    return OctahedralDecode(Eigen::Vector2f(x / 32767.0f, y / 32767.0f));
+}
+
+/// Octahedral normal quantized to two 8-bit signed integers.
+__host__ __device__ inline uint16_t EncodeNormal16(const Eigen::Vector3f &n) {
+    const Eigen::Vector2f e = OctahedralEncode(n);
+    const int8_t x = int8_t(roundf(fminf(fmaxf(e[0], -1.0f), 1.0f) * 127.0f));
+    const int8_t y = int8_t(roundf(fminf(fmaxf(e[1], -1.0f), 1.0f) * 127.0f));
+    return uint16_t(uint8_t(x)) | uint16_t(uint16_t(uint8_t(y)) << 8);
+}
+
+__host__ __device__ inline Eigen::Vector3f DecodeNormal16(uint16_t code) {
+    const int8_t x = int8_t(code & 0xff);
+    const int8_t y = int8_t(code >> 8);
+    return OctahedralDecode(Eigen::Vector2f(x / 127.0f, y / 127.0f));
+}
+
+__host__ __device__ inline HalfPoint EncodeHalfPoint(const Eigen::Vector3f &pt,
+                                                     const Eigen::Vector3f &origin) {
+    HalfPoint hp;
+    hp.x_ = __float2half(pt[0] - origin[0]);
+    hp.y_ = __float2half(pt[1] - origin[1]);
+    hp.z_ = __float2half(pt[2] - origin[2]);
+    return hp;
+}
+
+__host__ __device__ inline Eigen::Vector3f DecodeHalfPoint(const HalfPoint &hp,
+                                                           const Eigen::Vector3f &origin) {
+    return Eigen::Vector3f(__half2float(hp.x_), __half2float(hp.y_),
+                           __half2float(hp.z_)) + origin;
+}
+
+/// \class CompactPointCloud
+///
+/// \brief Point cloud with compact attribute encodings.
+///
+/// Colors are stored as 8-bit RGB packed into a uint32_t, whose highest byte
+/// is unused, so they take 4 bytes per point. Normals are stored as
+/// octahedral 16 or 32-bit codes and, optionally, points as half-precision
+/// offsets from origin_.
+/// The attributes are decoded on the fly by the operations below.
+class CompactPointCloud {
+public:
+    enum class NormalEncoding {
+        /// 2 x 8-bit octahedral code
+        Oct16 = 0,
+        /// 2 x 16-bit octahedral code
+        Oct32 = 1,
+    };
+
+    CompactPointCloud();
+    ~CompactPointCloud();
+
+    /// Encodes \param cloud. If \param half_precision_points is true, the
+    /// points are stored as half-precision offsets from the center of the
+    /// cloud, whose precision drops with the extent of the cloud.
+    static std::shared_ptr<CompactPointCloud> CreateFromPointCloud(
+            const PointCloud &cloud,
+            bool half_precision_points = false,
+            NormalEncoding normal_encoding = NormalEncoding::Oct32);
+
+    /// Decodes all the attributes into a PointCloud.
+    std::shared_ptr<PointCloud> ToPointCloud() const;
+
+    CompactPointCloud &Clear();
+    bool IsEmpty() const;
+    size_t Size() const;
+    bool HasNormals() const;
+    bool HasColors() const;
+    bool IsHalfPrecision() const { return half_precision_points_; }
+    /// Returns the bytes of device memory used by the encoded attributes.
+    size_t GetMemorySize() const;
+
+    /// Applies an affine \param transformation. Half-precision points keep
+    /// their offsets relative to the transformed origin. There is no
+    /// projective division: a transformation whose bottom row is not
+    /// (0, 0, 0, 1) is rejected with an error and the cloud is unchanged.
+    CompactPointCloud &Transform(const Eigen::Matrix4f &transformation);
+
+    /// Same as PointCloud::VoxelDownSample; the attributes are decoded
+    /// directly into the working buffers of the down sampling.
+    std::shared_ptr<PointCloud> VoxelDownSample(float voxel_size) const;
+
+public:
+    Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    bool half_precision_points_ = false;
+    NormalEncoding normal_encoding_ = NormalEncoding::Oct32;
+    thrustcupoch::device_vector<Eigen::Vector3f> points_;
+    thrustcupoch::device_vector<HalfPoint> half_points_;
+    thrustcupoch::device_vector<uint32_t> normals32_;
+    thrustcupoch::device_vector<uint16_t> normals16_;
+    thrustcupoch::device_vector<uint32_t> colors_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,211 @@
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/crop_regions.h"
+#include "cupoch/utility/console.h"
+#include <thrust/binary_search.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+typedef CropRegions::Region Region;
+
+__host__ __device__
+inline bool IsInsidePolygon(const Eigen::Vector2f* vertices, int begin, int end,
+                            const Eigen::Vector3f& pt) {
+    // even-odd rule
+    bool inside = false;
+    for (int i = begin, j = end - 1; i < end; j = i++) {
+        const Eigen::Vector2f& a = vertices[i];
+        const Eigen::Vector2f& b = vertices[j];
+        if ((a[1] > pt[1]) != (b[1] > pt[1]) &&
+            pt[0] < (b[0] - a[0]) * (pt[1] - a[1]) / (b[1] - a[1]) + a[0]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+__host__ __device__
+inline bool IsInsideRegion(const Region& region, const Eigen::Vector2f* vertices,
+                           const Eigen::Vector3f& pt) {
+    if (pt[0] < region.min_bound_[0] || pt[0] > region.max_bound_[0] ||
+        pt[1] < region.min_bound_[1] || pt[1] > region.max_bound_[1] ||
+        pt[2] < region.min_bound_[2] || pt[2] > region.max_bound_[2]) {
+        return false;
+    }
+    switch (region.type_) {
+        case Region::Type::OrientedBox: {
+            const Eigen::Vector3f q = region.R_.transpose() * (pt - region.center_);
+            return (abs(q[0]) <= region.half_extent_[0] &&
+                    abs(q[1]) <= region.half_extent_[1] &&
+                    abs(q[2]) <= region.half_extent_[2]);
+        }
+        case Region::Type::PolygonPrism:
+            return IsInsidePolygon(vertices, region.vertex_begin_, region.vertex_end_, pt);
+        default:
+            return false;
+    }
+}
+
+struct first_region_functor {
+    first_region_functor(const Region* regions, int n_regions,
+                         const Eigen::Vector2f* vertices)
+        : regions_(regions), n_regions_(n_regions), vertices_(vertices) {};
+    const Region* regions_;
+    const int n_regions_;
+    const Eigen::Vector2f* vertices_;
+    __host__ __device__
+    int operator() (const Eigen::Vector3f& pt) const {
+        for (int r = 0; r < n_regions_; ++r) {
+            if (IsInsideRegion(regions_[r], vertices_, pt)) return r;
+        }
+        return -1;
+    }
+};
+
+struct count_regions_functor {
+    count_regions_functor(const Region* regions, int n_regions,
+                          const Eigen::Vector2f* vertices)
+        : regions_(regions), n_regions_(n_regions), vertices_(vertices) {};
+    const Region* regions_;
+    const int n_regions_;
+    const Eigen::Vector2f* vertices_;
+    __host__ __device__
+    int operator() (const Eigen::Vector3f& pt) const {
+        int count = 0;
+        for (int r = 0; r < n_regions_; ++r) {
+            if (IsInsideRegion(regions_[r], vertices_, pt)) ++count;
+        }
+        return count;
+    }
+};
+
+// Writes the (region, point) pairs of the idx-th point from its offset.
+struct fill_region_pairs_functor {
+    fill_region_pairs_functor(const Eigen::Vector3f* points, const Region* regions,
+                              int n_regions, const Eigen::Vector2f* vertices,
+                              const int* point_offsets, int* region_ids,
+                              int* indices)
+        : points_(points), regions_(regions), n_regions_(n_regions),
+          vertices_(vertices), point_offsets_(point_offsets),
+          region_ids_(region_ids), indices_(indices) {};
+    const Eigen::Vector3f* points_;
+    const Region* regions_;
+    const int n_regions_;
+    const Eigen::Vector2f* vertices_;
+    const int* point_offsets_;
+    int* region_ids_;
+    int* indices_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        const Eigen::Vector3f& pt = points_[idx];
+        int k = point_offsets_[idx];
+        for (int r = 0; r < n_regions_; ++r) {
+            if (IsInsideRegion(regions_[r], vertices_, pt)) {
+                region_ids_[k] = r;
+                indices_[k] = idx;
+                ++k;
+            }
+        }
+    }
+};
+
+}
+
+int CropRegions::AddBox(const OrientedBoundingBox &box) {
+    Region region;
+    region.type_ = Region::Type::OrientedBox;
+    region.center_ = box.center_;
+    region.R_ = box.R_;
+    region.half_extent_ = 0.5 * box.extent_;
+    // tight axis-aligned bounds of the rotated box
+    const Eigen::Vector3f half_size = box.R_.cwiseAbs() * region.half_extent_;
+    region.min_bound_ = box.center_ - half_size;
+    region.max_bound_ = box.center_ + half_size;
+    regions_.push_back(region);
+    return int(regions_.size()) - 1;
+}
+
+int CropRegions::AddBox(const AxisAlignedBoundingBox &box) {
+    return AddBox(box.GetOrientedBoundingBox());
+}
+
+int CropRegions::AddPolygonPrism(const thrust::host_vector<Eigen::Vector2f> &polygon,
+                                 float min_z,
+                                 float max_z) {
+    if (polygon.size() < 3) {
+        utility::LogError("[CropRegions::AddPolygonPrism] A polygon needs at least 3 vertices.");
+        return -1;
+    }
+    Region region;
+    region.type_ = Region::Type::PolygonPrism;
+    region.vertex_begin_ = polygon_vertices_.size();
+    polygon_vertices_.insert(polygon_vertices_.end(), polygon.begin(), polygon.end());
+    region.vertex_end_ = polygon_vertices_.size();
+    Eigen::Vector2f min_xy = polygon[0];
+    Eigen::Vector2f max_xy = polygon[0];
+    for (const auto &v : polygon) {
+        min_xy = min_xy.cwiseMin(v);
+        max_xy = max_xy.cwiseMax(v);
+    }
+    region.min_bound_ = Eigen::Vector3f(min_xy[0], min_xy[1], min_z);
+    region.max_bound_ = Eigen::Vector3f(max_xy[0], max_xy[1], max_z);
+    regions_.push_back(region);
+    return int(regions_.size()) - 1;
+}
+
+void CropRegions::Clear() {
+    regions_.clear();
+    polygon_vertices_.clear();
+}
+
+thrustcupoch::device_vector<int> CropRegions::GetPointRegionLabels(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points) const {
+    thrustcupoch::device_vector<int> labels(points.size());
+    const thrustcupoch::device_vector<Region> regions = regions_;
+    const thrustcupoch::device_vector<Eigen::Vector2f> vertices = polygon_vertices_;
+    first_region_functor func(thrust::raw_pointer_cast(regions.data()), regions.size(),
+                              thrust::raw_pointer_cast(vertices.data()));
+    thrust::transform(points.begin(), points.end(), labels.begin(), func);
+    return labels;
+}
+
+int CropRegions::GetPointIndicesWithinRegions(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        thrustcupoch::device_vector<int> &offsets,
+        thrustcupoch::device_vector<int> &indices) const {
+    const int n_regions = regions_.size();
+    const size_t n_pt = points.size();
+    const thrustcupoch::device_vector<Region> regions = regions_;
+    const thrustcupoch::device_vector<Eigen::Vector2f> vertices = polygon_vertices_;
+    const Region* regions_ptr = thrust::raw_pointer_cast(regions.data());
+    const Eigen::Vector2f* vertices_ptr = thrust::raw_pointer_cast(vertices.data());
+
+    // count, then write the (region, point) pairs in point order
+    thrustcupoch::device_vector<int> point_offsets(n_pt + 1, 0);
+    thrust::transform(points.begin(), points.end(), point_offsets.begin(),
+                      count_regions_functor(regions_ptr, n_regions, vertices_ptr));
+    thrust::exclusive_scan(point_offsets.begin(), point_offsets.end(), point_offsets.begin());
+    const int total = point_offsets.back();
+    thrustcupoch::device_vector<int> region_ids(total);
+    indices.resize(total);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_pt),
+                     fill_region_pairs_functor(thrust::raw_pointer_cast(points.data()),
+                                               regions_ptr, n_regions, vertices_ptr,
+                                               thrust::raw_pointer_cast(point_offsets.data()),
+                                               thrust::raw_pointer_cast(region_ids.data()),
+                                               thrust::raw_pointer_cast(indices.data())));
+
+    // group the pairs by region, the stable sort keeps the point order
+    thrust::stable_sort_by_key(region_ids.begin(), region_ids.end(), indices.begin());
+    offsets.resize(n_regions + 1);
+    thrust::lower_bound(region_ids.begin(), region_ids.end(),
+                        thrust::make_counting_iterator(0),
+                        thrust::make_counting_iterator(n_regions + 1),
+                        offsets.begin());
+    return total;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <thrust/host_vector.h>
+
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace geometry {
+
+class AxisAlignedBoundingBox;
+class OrientedBoundingBox;
+
+/// \class CropRegions
+///
+/// \brief Set of regions of interest tested against all the points of a
+/// scan at once.
+///
+/// The regions are oriented boxes and polygon prisms, numbered in the order
+/// in which they are added. Every point is tested against all the regions
+/// in a single pass, so cropping a scan against hundreds of regions reads
+/// the scan once.
+class CropRegions {
+public:
+    CropRegions() {}
+    ~CropRegions() {}
+
+public:
+    /// Adds a box and returns its region index.
+    int AddBox(const OrientedBoundingBox &box);
+    int AddBox(const AxisAlignedBoundingBox &box);
+    /// Adds the prism extruding \param polygon, given by its vertices in the
+    /// xy plane, over [\param min_z, \param max_z] and returns its region
+    /// index. The polygon may be concave but not self-intersecting.
+    int AddPolygonPrism(const thrust::host_vector<Eigen::Vector2f> &polygon,
+                        float min_z,
+                        float max_z);
+    size_t GetNumRegions() const { return regions_.size(); }
+    void Clear();
+
+    /// Returns the index of the first region containing each point, or -1
+    /// for points outside of all the regions.
+    thrustcupoch::device_vector<int> GetPointRegionLabels(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points) const;
+
+    /// Returns the points within each region in CSR form: the indices of
+    /// the points within the i-th region are
+    /// indices[offsets[i]:offsets[i + 1]], in ascending order. A point is
+    /// listed in every region containing it. Returns the total number of
+    /// entries.
+    int GetPointIndicesWithinRegions(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+            thrustcupoch::device_vector<int> &offsets,
+            thrustcupoch::device_vector<int> &indices) const;
+
+public:
+    /// Region parameters in the layout read by the device code.
+    struct Region {
+        enum class Type {
+            OrientedBox = 0,
+            PolygonPrism = 1,
+        };
+        Type type_ = Type::OrientedBox;
+        /// Axis-aligned bounds of the region, for early rejection.
+        Eigen::Vector3f min_bound_ = Eigen::Vector3f::Zero();
+        Eigen::Vector3f max_bound_ = Eigen::Vector3f::Zero();
+        /// Oriented box: the point R^T (p - center) lies in
+        /// [-half_extent, half_extent].
+        Eigen::Vector3f center_ = Eigen::Vector3f::Zero();
+        Eigen::Matrix3f R_ = Eigen::Matrix3f::Identity();
+        Eigen::Vector3f half_extent_ = Eigen::Vector3f::Zero();
+        /// Polygon prism: vertices [vertex_begin_, vertex_end_) of
+        /// polygon_vertices_, the z range is given by the bounds.
+        int vertex_begin_ = 0;
+        int vertex_end_ = 0;
+    };
+
+private:
+    thrust::host_vector<Region> regions_;
+    thrust::host_vector<Eigen::Vector2f> polygon_vertices_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
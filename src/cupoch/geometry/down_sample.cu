@@ -1,10 +1,26 @@
 #include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/compact_pointcloud.h"
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/voxel_key.h"
 #include "cupoch/utility/console.h"
 #include "cupoch/utility/helper.h"
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/random.h"
+#include "cupoch/utility/atomic.h"
+#include "cupoch/utility/thrust_cupoch.h"
+#include "cupoch/utility/execution_context.h"
 #include <thrust/gather.h>
-#include <thrust/iterator/discard_iterator.h>
+#include <thrust/count.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <algorithm>
+#include <limits>
 
 using namespace cupoch;
 using namespace cupoch::geometry;
@@ -12,103 +28,317 @@ using namespace cupoch::geometry;
 namespace {
 
 void SelectDownSampleImpl(const geometry::PointCloud& src, geometry::PointCloud& dst,
-                          const thrust::device_vector<size_t> &indices) {
+                          const thrustcupoch::device_vector<size_t> &indices) {
     const bool has_normals = src.HasNormals();
     const bool has_colors = src.HasColors();
+    const bool has_covariances = src.HasCovariances();
     if (has_normals) dst.normals_.resize(indices.size());
     if (has_colors) dst.colors_.resize(indices.size());
+    if (has_covariances) dst.covariances_.resize(indices.size());
     dst.points_.resize(indices.size());
-    thrust::gather(thrust::cuda::par.on(utility::GetStream(0)), indices.begin(), indices.end(), src.points_.begin(), dst.points_.begin());
+    thrust::gather(exec_policy_on(utility::GetStream(0)), indices.begin(), indices.end(), src.points_.begin(), dst.points_.begin());
     if (has_normals) {
-        thrust::gather(thrust::cuda::par.on(utility::GetStream(1)), indices.begin(), indices.end(), src.normals_.begin(), dst.normals_.begin());
+        thrust::gather(exec_policy_on(utility::GetStream(1)), indices.begin(), indices.end(), src.normals_.begin(), dst.normals_.begin());
     }
     if (has_colors) {
-        thrust::gather(thrust::cuda::par.on(utility::GetStream(2)), indices.begin(), indices.end(), src.colors_.begin(), dst.colors_.begin());
+        thrust::gather(exec_policy_on(utility::GetStream(2)), indices.begin(), indices.end(), src.colors_.begin(), dst.colors_.begin());
     }
-    cudaSafeCall(cudaDeviceSynchronize());
+    if (has_covariances) {
+        thrust::gather(exec_policy_on(utility::GetStream(3)), indices.begin(), indices.end(), src.covariances_.begin(), dst.covariances_.begin());
+    }
+    utility::GetExecutionContext().Synchronize();
 }
 
-struct compute_key_functor {
-    compute_key_functor(const Eigen::Vector3f& voxel_min_bound, float voxel_size)
-        : voxel_min_bound_(voxel_min_bound), voxel_size_(voxel_size) {};
+const int MAX_VOXEL_ATTRIBUTES = 3;
+// Marks the empty slots of the voxel hash table.
+const int EMPTY_VOXEL_SLOT = -1;
+// Smallest number of slots of the voxel hash table.
+const size_t MIN_VOXEL_TABLE_SIZE = 1024;
+// Longest probe sequence of an insertion before the table is grown.
+const int MAX_VOXEL_PROBES = 64;
+
+struct elementwise_min_functor {
+    __host__ __device__
+    Eigen::Vector3f operator()(const Eigen::Vector3f& a, const Eigen::Vector3f& b) const {
+        return a.array().min(b.array()).matrix();
+    }
+};
+
+struct elementwise_max_functor {
+    __host__ __device__
+    Eigen::Vector3f operator()(const Eigen::Vector3f& a, const Eigen::Vector3f& b) const {
+        return a.array().max(b.array()).matrix();
+    }
+};
+
+// Attribute array read by the voxel down sampling. The encodings of
+// CompactPointCloud are decoded on the fly, so no decoded copy of the
+// cloud is materialized.
+struct voxel_source {
+    enum Encoding {
+        Float3 = 0,
+        HalfPoint3 = 1,
+        Normal32 = 2,
+        Normal16 = 3,
+        Color8 = 4,
+    };
+    voxel_source() {};
+    voxel_source(const void* data, Encoding encoding,
+                 const Eigen::Vector3f& origin = Eigen::Vector3f::Zero())
+        : data_(data), encoding_(encoding), origin_(origin) {};
+    voxel_source(const thrustcupoch::device_vector<Eigen::Vector3f>& data)
+        : voxel_source(thrust::raw_pointer_cast(data.data()), Float3) {};
+    const void* data_ = nullptr;
+    Encoding encoding_ = Float3;
+    Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    __host__ __device__
+    Eigen::Vector3f operator() (size_t idx) const {
+        switch (encoding_) {
+            case HalfPoint3:
+                return DecodeHalfPoint(((const HalfPoint*)data_)[idx], origin_);
+            case Normal32:
+                return DecodeNormal32(((const uint32_t*)data_)[idx]);
+            case Normal16:
+                return DecodeNormal16(((const uint16_t*)data_)[idx]);
+            case Color8:
+                return DecodeColor8(((const uint32_t*)data_)[idx]);
+            default:
+                return ((const Eigen::Vector3f*)data_)[idx];
+        }
+    }
+};
+
+// Points, normals and colors of the cloud to down sample.
+struct voxel_input {
+    voxel_input(const geometry::PointCloud& cloud)
+        : n_(cloud.points_.size()), points_(cloud.points_),
+          has_normals_(cloud.HasNormals()), has_colors_(cloud.HasColors()) {
+        if (has_normals_) normals_ = voxel_source(cloud.normals_);
+        if (has_colors_) colors_ = voxel_source(cloud.colors_);
+    };
+    voxel_input(const geometry::CompactPointCloud& cloud)
+        : n_(cloud.Size()),
+          has_normals_(cloud.HasNormals()), has_colors_(cloud.HasColors()) {
+        if (cloud.IsHalfPrecision()) {
+            points_ = voxel_source(thrust::raw_pointer_cast(cloud.half_points_.data()),
+                                   voxel_source::HalfPoint3, cloud.origin_);
+        } else {
+            points_ = voxel_source(cloud.points_);
+        }
+        if (has_normals_) {
+            normals_ = (cloud.normal_encoding_ == geometry::CompactPointCloud::NormalEncoding::Oct32)
+                    ? voxel_source(thrust::raw_pointer_cast(cloud.normals32_.data()), voxel_source::Normal32)
+                    : voxel_source(thrust::raw_pointer_cast(cloud.normals16_.data()), voxel_source::Normal16);
+        }
+        if (has_colors_) {
+            colors_ = voxel_source(thrust::raw_pointer_cast(cloud.colors_.data()), voxel_source::Color8);
+        }
+    };
+    size_t n_;
+    voxel_source points_;
+    voxel_source normals_;
+    voxel_source colors_;
+    bool has_normals_;
+    bool has_colors_;
+    thrust::transform_iterator<voxel_source, thrust::counting_iterator<size_t>> PointsBegin() const {
+        return thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0), points_);
+    }
+};
+
+// Input and output arrays of the attributes averaged per voxel.
+struct voxel_attributes {
+    voxel_source src_[MAX_VOXEL_ATTRIBUTES];
+    Eigen::Vector3f* dst_[MAX_VOXEL_ATTRIBUTES];
+    int n_ = 0;
+    void Add(const voxel_source& src,
+             thrustcupoch::device_vector<Eigen::Vector3f>& dst) {
+        src_[n_] = src;
+        dst_[n_] = thrust::raw_pointer_cast(dst.data());
+        ++n_;
+    }
+};
+
+__host__ __device__
+inline size_t HashVoxelIndex(const Eigen::Vector3i& voxel) {
+    unsigned long long key = (unsigned long long)(unsigned int)voxel[0] * 0x9e3779b97f4a7c15ull ^
+                             (unsigned long long)(unsigned int)voxel[1] * 0xc2b2ae3d27d4eb4full ^
+                             (unsigned long long)(unsigned int)voxel[2] * 0x165667b19e3779f9ull;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+// Open-addressing hash table of the occupied voxels with linear probing.
+// The key of a slot is the index of the first point inserted into its
+// voxel, so voxels are compared exactly over the whole int range of the
+// voxel indices. The value of a slot is the index of its voxel among the
+// occupied ones.
+struct voxel_table_view {
+    voxel_table_view(const voxel_source& points, int* keys, int* values,
+                     size_t mask, const Eigen::Vector3f& voxel_min_bound,
+                     float voxel_size)
+        : points_(points), keys_(keys), values_(values), mask_(mask),
+          voxel_min_bound_(voxel_min_bound), voxel_size_(voxel_size) {};
+    const voxel_source points_;
+    int* keys_;
+    int* values_;
+    const size_t mask_;
     const Eigen::Vector3f voxel_min_bound_;
     const float voxel_size_;
-    __device__
-    Eigen::Vector3i operator()(const Eigen::Vector3f& pt) {
-        auto ref_coord = (pt - voxel_min_bound_) / voxel_size_;
-        return Eigen::Vector3i(int(floor(ref_coord(0))), int(floor(ref_coord(1))), int(floor(ref_coord(2))));
+    __host__ __device__
+    Eigen::Vector3i VoxelOf(size_t idx) const {
+        return ComputeVoxelIndex(points_(idx), voxel_min_bound_, voxel_size_);
+    }
+    // Index of the voxel of the idx-th point, which has been inserted.
+    __host__ __device__
+    int operator() (size_t idx) const {
+        const Eigen::Vector3i voxel = VoxelOf(idx);
+        size_t h = HashVoxelIndex(voxel) & mask_;
+        while (keys_[h] != int(idx) && VoxelOf(keys_[h]) != voxel) h = (h + 1) & mask_;
+        return values_[h];
+    }
+};
+
+// Inserts the voxels of the points into the table. An insertion that does
+// not find its voxel or an empty slot within max_probes slots sets failed,
+// and the table has to be grown.
+struct insert_voxel_functor {
+    insert_voxel_functor(const voxel_table_view& table, int max_probes, int* failed)
+        : table_(table), max_probes_(max_probes), failed_(failed) {};
+    const voxel_table_view table_;
+    const int max_probes_;
+    int* failed_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        const Eigen::Vector3i voxel = table_.VoxelOf(idx);
+        size_t h = HashVoxelIndex(voxel) & table_.mask_;
+        for (int i = 0; i < max_probes_; ++i) {
+            const int prev = utility::AtomicCAS(table_.keys_ + h, EMPTY_VOXEL_SLOT, int(idx));
+            if (prev == EMPTY_VOXEL_SLOT || table_.VoxelOf(prev) == voxel) return;
+            h = (h + 1) & table_.mask_;
+        }
+        *failed_ = 1;
+    }
+};
+
+struct is_occupied_functor {
+    __host__ __device__
+    int operator() (int key) const {
+        return (key == EMPTY_VOXEL_SLOT) ? 0 : 1;
+    }
+};
+
+// Voxel index of each point, as computed by GroupSortedPoints.
+struct point_voxel_functor {
+    point_voxel_functor(const int* point_voxels) : point_voxels_(point_voxels) {};
+    const int* point_voxels_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        return point_voxels_[idx];
+    }
+};
+
+template <class VoxelOf>
+struct accumulate_voxel_functor {
+    accumulate_voxel_functor(const VoxelOf& voxel_of, const voxel_attributes& attrs,
+                             int* counts, float* sums)
+        : voxel_of_(voxel_of), attrs_(attrs), counts_(counts), sums_(sums) {};
+    const VoxelOf voxel_of_;
+    const voxel_attributes attrs_;
+    int* counts_;
+    float* sums_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        const int v = voxel_of_(idx);
+        utility::AtomicAdd(counts_ + v, 1);
+        for (int a = 0; a < attrs_.n_; ++a) {
+            float* sum = sums_ + (v * attrs_.n_ + a) * 3;
+            const Eigen::Vector3f x = attrs_.src_[a](idx);
+            for (int c = 0; c < 3; ++c) utility::AtomicAdd(sum + c, x[c]);
+        }
     }
 };
 
-template<typename OutputIterator, class... Args>
-__host__
-int CalcAverageByKey(thrust::device_vector<Eigen::Vector3i>& keys,
-                     OutputIterator buf_begins, OutputIterator output_begins) {
-    const size_t n = keys.size();
-    thrust::sort_by_key(keys.begin(), keys.end(), buf_begins);
-
-    thrust::device_vector<int> counts(n);
-    auto end1 = thrust::reduce_by_key(keys.begin(), keys.end(),
-                                      thrust::make_constant_iterator(1),
-                                      thrust::make_discard_iterator(), counts.begin());
-    int n_out = thrust::distance(counts.begin(), end1.second);
-    counts.resize(n_out);
-
-    thrust::equal_to<Eigen::Vector3i> binary_pred;
-    add_tuple_functor<Args...> add_func;
-    auto end2 = thrust::reduce_by_key(keys.begin(), keys.end(), buf_begins,
-                                      thrust::make_discard_iterator(), output_begins,
-                                      binary_pred, add_func);
-
-    devided_tuple_functor<Args...> dv_func;
-    thrust::transform(output_begins, output_begins + n_out,
-                      counts.begin(), output_begins,
-                      dv_func);
-    return n_out;
+
+struct average_voxel_functor {
+    average_voxel_functor(const int* counts, const float* sums,
+                          const voxel_attributes& attrs)
+        : counts_(counts), sums_(sums), attrs_(attrs) {};
+    const int* counts_;
+    const float* sums_;
+    const voxel_attributes attrs_;
+    __host__ __device__
+    void operator() (size_t v) const {
+        for (int a = 0; a < attrs_.n_; ++a) {
+            const float* sum = sums_ + (v * attrs_.n_ + a) * 3;
+            attrs_.dst_[a][v] = Eigen::Vector3f(sum[0], sum[1], sum[2]) / counts_[v];
+        }
+    }
+};
+
+size_t NextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
 }
 
+// Collects the occupied voxels of the points in a hash table, so no sort of
+// the points is needed. The table starts from an estimate of one voxel per
+// eight points and is grown four times whenever an insertion probes too
+// long, so its size follows the number of voxels and not of the points.
+// With 2n slots every point fits in its own voxel, so probing is not
+// limited there. Returns the number of occupied voxels.
+int BuildVoxelTable(const voxel_input& input,
+                    const Eigen::Vector3f& voxel_min_bound, float voxel_size,
+                    thrustcupoch::device_vector<int>& keys,
+                    thrustcupoch::device_vector<int>& values) {
+    const size_t n = input.n_;
+    const size_t max_capacity = NextPowerOfTwo(std::max(2 * n, MIN_VOXEL_TABLE_SIZE));
+    size_t capacity = NextPowerOfTwo(std::max(n / 4, MIN_VOXEL_TABLE_SIZE));
+    thrustcupoch::device_vector<int> failed(1);
+    while (true) {
+        keys.assign(capacity, EMPTY_VOXEL_SLOT);
+        failed[0] = 0;
+        const bool last = capacity >= max_capacity;
+        voxel_table_view table(input.points_, thrust::raw_pointer_cast(keys.data()),
+                               nullptr, capacity - 1, voxel_min_bound, voxel_size);
+        insert_voxel_functor func(table, last ? int(capacity) : MAX_VOXEL_PROBES,
+                                  thrust::raw_pointer_cast(failed.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n), func);
+        if (last || failed[0] == 0) break;
+        capacity = std::min(capacity * 4, max_capacity);
+    }
+    // number the occupied slots in table order
+    values.resize(capacity);
+    thrust::transform_exclusive_scan(keys.begin(), keys.end(), values.begin(),
+                                     is_occupied_functor(), 0, thrust::plus<int>());
+    return thrust::count_if(keys.begin(), keys.end(), is_occupied_functor());
+}
+
+
 struct stride_copy_functor {
     stride_copy_functor(const Eigen::Vector3f* data, int every_k_points)
         : data_(data), every_k_points_(every_k_points) {};
     const Eigen::Vector3f* data_;
     const int every_k_points_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (int idx) const {
         return data_[idx * every_k_points_];
     }
 };
 
 struct has_radius_points_functor {
-    has_radius_points_functor(const int* indices, int n_points, int knn)
-        : indices_(indices), n_points_(n_points), knn_(knn) {};
-    const int* indices_;
+    has_radius_points_functor(const int* counts, int n_points)
+        : counts_(counts), n_points_(n_points) {};
+    const int* counts_;
     const int n_points_;
-    const int knn_;
-    __device__
+    __host__ __device__
     bool operator() (int idx) const {
-        int count = 0;
-        for (int i = 0; i < knn_; ++i) {
-            if (indices_[idx * knn_ + i] >= 0) count++;
-        }
-        return (count > n_points_);
-    }
-};
-
-struct average_distance_functor {
-    average_distance_functor(const float* distance, int knn) : distance_(distance), knn_(knn) {};
-    const float* distance_;
-    const int knn_;
-    __device__
-    float operator() (int idx) const {
-        int count = 0;
-        float avg = 0;
-        for (int i = 0; i < knn_; ++i) {
-            const float d = distance_[idx * knn_ + i];
-            if (std::isinf(d) || d < 0.0) continue;
-            avg += d;
-            count++;
-        }
-        return (count == 0) ? -1.0 : avg / (float)count;
+        return (counts_[idx] > n_points_);
     }
 };
 
@@ -117,22 +347,309 @@ struct check_distance_threshold_functor {
         : distances_(distances), distance_threshold_(distance_threshold) {};
     const float* distances_;
     const float distance_threshold_;
-    __device__
+    __host__ __device__
     bool operator() (int idx) const {
         return (distances_[idx] > 0 && distances_[idx] < distance_threshold_);
     }
 };
 
+struct normalize_functor {
+    __host__ __device__
+    void operator() (Eigen::Vector3f& nl) const {
+        nl.normalize();
+    }
+};
+
+// Updates the distance of a point to the samples of its cloud with the
+// latest sample and returns it with the point index. The update is
+// idempotent, so it can be fused into the reduction.
+struct update_sample_distance_functor {
+    update_sample_distance_functor(const Eigen::Vector3f* points, const int* cloud_ids,
+                                   const Eigen::Vector3f* last_samples,
+                                   float* min_distance2)
+        : points_(points), cloud_ids_(cloud_ids), last_samples_(last_samples),
+          min_distance2_(min_distance2) {};
+    const Eigen::Vector3f* points_;
+    const int* cloud_ids_;
+    const Eigen::Vector3f* last_samples_;
+    float* min_distance2_;
+    __host__ __device__
+    thrust::tuple<float, int> operator() (int idx) const {
+        const float d2 = (points_[idx] - last_samples_[cloud_ids_[idx]]).squaredNorm();
+        const float min_d2 = min(min_distance2_[idx], d2);
+        min_distance2_[idx] = min_d2;
+        return thrust::make_tuple(min_d2, idx);
+    }
+};
+
+// Farther point first, lower index on ties
+struct farthest_point_functor {
+    __host__ __device__
+    thrust::tuple<float, int> operator() (const thrust::tuple<float, int>& a,
+                                          const thrust::tuple<float, int>& b) const {
+        if (thrust::get<0>(a) != thrust::get<0>(b)) {
+            return (thrust::get<0>(a) > thrust::get<0>(b)) ? a : b;
+        }
+        return (thrust::get<1>(a) < thrust::get<1>(b)) ? a : b;
+    }
+};
+
+struct select_sample_functor {
+    select_sample_functor(const Eigen::Vector3f* points, const int* clouds,
+                          const int* farthest, const int* offsets,
+                          int iteration, int num_samples,
+                          Eigen::Vector3f* last_samples, int* samples)
+        : points_(points), clouds_(clouds), farthest_(farthest), offsets_(offsets),
+          iteration_(iteration), num_samples_(num_samples),
+          last_samples_(last_samples), samples_(samples) {};
+    const Eigen::Vector3f* points_;
+    const int* clouds_;
+    const int* farthest_;
+    const int* offsets_;
+    const int iteration_;
+    const int num_samples_;
+    Eigen::Vector3f* last_samples_;
+    int* samples_;
+    __host__ __device__
+    void operator() (size_t row) const {
+        const int c = clouds_[row];
+        if (iteration_ >= offsets_[c + 1] - offsets_[c]) return;
+        const int idx = farthest_[row];
+        samples_[c * num_samples_ + iteration_] = idx - offsets_[c];
+        last_samples_[c] = points_[idx];
+    }
+};
+
+// Farthest point sampling of the clouds stored back to back in points;
+// the points of the c-th cloud are points[offsets[c]:offsets[c + 1]].
+// Every iteration selects the next sample of all the clouds with one
+// segmented argmax over the distances to the samples.
+// The c-th row of samples receives the indices of the samples of the c-th
+// cloud, starting from its first point.
+void FarthestPointDownSampleImpl(const thrustcupoch::device_vector<Eigen::Vector3f>& points,
+                                 const thrust::host_vector<int>& offsets,
+                                 int num_samples,
+                                 thrustcupoch::device_vector<int>& samples) {
+    const int n_clouds = offsets.size() - 1;
+    const thrustcupoch::device_vector<int> d_offsets = offsets;
+    thrustcupoch::device_vector<int> cloud_ids(points.size());
+    for (int c = 0; c < n_clouds; ++c) {
+        thrust::fill(cloud_ids.begin() + offsets[c], cloud_ids.begin() + offsets[c + 1], c);
+    }
+    samples.assign(n_clouds * num_samples, -1);
+    thrustcupoch::device_vector<Eigen::Vector3f> last_samples(n_clouds, Eigen::Vector3f::Zero());
+    for (int c = 0; c < n_clouds; ++c) {
+        if (offsets[c + 1] == offsets[c]) continue;
+        samples[c * num_samples] = 0;
+        last_samples[c] = points[offsets[c]];
+    }
+    thrustcupoch::device_vector<float> min_distance2(points.size(),
+                                                     std::numeric_limits<float>::infinity());
+    thrustcupoch::device_vector<int> clouds(n_clouds);
+    thrustcupoch::device_vector<float> farthest_distance2(n_clouds);
+    thrustcupoch::device_vector<int> farthest(n_clouds);
+    update_sample_distance_functor update_func(thrust::raw_pointer_cast(points.data()),
+                                               thrust::raw_pointer_cast(cloud_ids.data()),
+                                               thrust::raw_pointer_cast(last_samples.data()),
+                                               thrust::raw_pointer_cast(min_distance2.data()));
+    for (int i = 1; i < num_samples; ++i) {
+        auto end = thrust::reduce_by_key(cloud_ids.begin(), cloud_ids.end(),
+                                         thrust::make_transform_iterator(
+                                                 thrust::make_counting_iterator<int>(0), update_func),
+                                         clouds.begin(),
+                                         make_tuple_iterator(farthest_distance2.begin(), farthest.begin()),
+                                         thrust::equal_to<int>(), farthest_point_functor());
+        const size_t n_rows = thrust::distance(clouds.begin(), end.first);
+        select_sample_functor select_func(thrust::raw_pointer_cast(points.data()),
+                                          thrust::raw_pointer_cast(clouds.data()),
+                                          thrust::raw_pointer_cast(farthest.data()),
+                                          thrust::raw_pointer_cast(d_offsets.data()),
+                                          i, num_samples,
+                                          thrust::raw_pointer_cast(last_samples.data()),
+                                          thrust::raw_pointer_cast(samples.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_rows), select_func);
+    }
+}
+
+struct random_key_functor {
+    random_key_functor(uint64_t key) : key_(key) {};
+    const uint64_t key_;
+    __host__ __device__
+    uint32_t operator() (size_t idx) const {
+        return utility::RandomUint32(idx, key_);
+    }
+};
+
+struct morton_code_functor {
+    morton_code_functor(const Eigen::Vector3f& voxel_min_bound, float voxel_size)
+        : voxel_min_bound_(voxel_min_bound), voxel_size_(voxel_size) {};
+    const Eigen::Vector3f voxel_min_bound_;
+    const float voxel_size_;
+    __host__ __device__
+    uint64_t operator() (const Eigen::Vector3f& pt) const {
+        return MortonEncode(ComputeVoxelIndex(pt, voxel_min_bound_, voxel_size_));
+    }
+};
+
+// 1 at the first point of each voxel in the points sorted by Morton code.
+// Dropping the lowest 3 * level bits of the codes merges 2^level voxels
+// along each axis.
+struct voxel_head_functor {
+    voxel_head_functor(const uint64_t* codes, int level)
+        : codes_(codes), shift_(3 * level) {};
+    const uint64_t* codes_;
+    const int shift_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        return (idx == 0 || (codes_[idx] >> shift_) != (codes_[idx - 1] >> shift_)) ? 1 : 0;
+    }
+};
+
+// Sorts the indices of the points by the Morton codes of their voxels.
+void SortPointsByVoxel(const thrustcupoch::device_vector<Eigen::Vector3f>& points,
+                       const Eigen::Vector3f& voxel_min_bound, float voxel_size,
+                       thrustcupoch::device_vector<uint64_t>& codes,
+                       thrustcupoch::device_vector<int>& sorted_indices) {
+    codes.resize(points.size());
+    thrust::transform(points.begin(), points.end(), codes.begin(),
+                      morton_code_functor(voxel_min_bound, voxel_size));
+    sorted_indices.resize(points.size());
+    thrust::sequence(sorted_indices.begin(), sorted_indices.end());
+    thrust::sort_by_key(codes.begin(), codes.end(), sorted_indices.begin());
+}
+
+// Groups the points sorted by SortPointsByVoxel into the voxels of the given
+// pyramid level. The points of the i-th voxel are
+// sorted_indices[offsets[i]:offsets[i + 1]] and point_voxels maps each point
+// to its voxel. Returns the number of voxels.
+int GroupSortedPoints(const thrustcupoch::device_vector<uint64_t>& codes,
+                      const thrustcupoch::device_vector<int>& sorted_indices,
+                      int level,
+                      thrustcupoch::device_vector<int>& offsets,
+                      thrustcupoch::device_vector<int>& point_voxels) {
+    const size_t n = codes.size();
+    offsets.assign(1, 0);
+    point_voxels.resize(n);
+    if (n == 0) return 0;
+    thrustcupoch::device_vector<int> voxels(n);
+    voxel_head_functor func(thrust::raw_pointer_cast(codes.data()), level);
+    thrust::transform_inclusive_scan(thrust::make_counting_iterator<size_t>(0),
+                                     thrust::make_counting_iterator(n),
+                                     voxels.begin(), func, thrust::plus<int>());
+    const int n_voxels = voxels.back();
+    offsets.resize(n_voxels + 1);
+    thrust::copy_if(thrust::make_counting_iterator<int>(0),
+                    thrust::make_counting_iterator<int>(n),
+                    thrust::make_counting_iterator<size_t>(0),
+                    offsets.begin(), func);
+    offsets[n_voxels] = n;
+    // the voxel numbers start at 1 in the scan
+    thrust::transform(voxels.begin(), voxels.end(), thrust::make_constant_iterator(1),
+                      voxels.begin(), thrust::minus<int>());
+    thrust::scatter(voxels.begin(), voxels.end(), sorted_indices.begin(),
+                    point_voxels.begin());
+    return n_voxels;
+}
+
+// Voxel of another pyramid level holding the first point of each voxel.
+// The voxels of all levels are ordered by the same sorted codes, so this maps
+// a voxel to its parent, and the first voxel of a parent to its first child.
+struct first_point_voxel_functor {
+    first_point_voxel_functor(const int* sorted_indices, const int* point_voxels)
+        : sorted_indices_(sorted_indices), point_voxels_(point_voxels) {};
+    const int* sorted_indices_;
+    const int* point_voxels_;
+    __host__ __device__
+    int operator() (int offset) const {
+        return point_voxels_[sorted_indices_[offset]];
+    }
+};
+
+// Averages the points, normals and colors falling into the same voxel;
+// voxel_of maps the index of a point to the index of its voxel.
+template <class VoxelOf>
+void AverageVoxels(const voxel_input& input, const VoxelOf& voxel_of,
+                   int n_voxels, geometry::PointCloud& output) {
+    const bool has_normals = input.has_normals_;
+    const bool has_colors = input.has_colors_;
+    output.points_.resize(n_voxels);
+    if (has_normals) output.normals_.resize(n_voxels);
+    if (has_colors) output.colors_.resize(n_voxels);
+    voxel_attributes attrs;
+    attrs.Add(input.points_, output.points_);
+    if (has_normals) attrs.Add(input.normals_, output.normals_);
+    if (has_colors) attrs.Add(input.colors_, output.colors_);
+
+    thrustcupoch::device_vector<int> counts(n_voxels, 0);
+    thrustcupoch::device_vector<float> sums(n_voxels * attrs.n_ * 3, 0.0f);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(input.n_),
+                     accumulate_voxel_functor<VoxelOf>(voxel_of, attrs,
+                                                       thrust::raw_pointer_cast(counts.data()),
+                                                       thrust::raw_pointer_cast(sums.data())));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator<size_t>(n_voxels),
+                     average_voxel_functor(thrust::raw_pointer_cast(counts.data()),
+                                           thrust::raw_pointer_cast(sums.data()), attrs));
+    if (has_normals) {
+        thrust::for_each(output.normals_.begin(), output.normals_.end(), normalize_functor());
+    }
+}
+
+void AverageVoxels(const voxel_input& input,
+                   const thrustcupoch::device_vector<int>& point_voxels,
+                   int n_voxels, geometry::PointCloud& output) {
+    AverageVoxels(input, point_voxel_functor(thrust::raw_pointer_cast(point_voxels.data())),
+                  n_voxels, output);
+}
+
+
+// The points look up their voxels in the hash table while they are
+// accumulated, so the working memory is that of the table and the voxel
+// sums. The output order follows the hash table and not the voxel
+// coordinates.
+void VoxelDownSampleImpl(const voxel_input& input,
+                         const Eigen::Vector3f& voxel_min_bound, float voxel_size,
+                         geometry::PointCloud& output) {
+    thrustcupoch::device_vector<int> keys;
+    thrustcupoch::device_vector<int> values;
+    const int n_voxels = BuildVoxelTable(input, voxel_min_bound, voxel_size, keys, values);
+    voxel_table_view table(input.points_, thrust::raw_pointer_cast(keys.data()),
+                           thrust::raw_pointer_cast(values.data()), keys.size() - 1,
+                           voxel_min_bound, voxel_size);
+    AverageVoxels(input, table, n_voxels, output);
 }
 
-std::shared_ptr<PointCloud> PointCloud::SelectDownSample(const thrust::device_vector<size_t> &indices, bool invert) const {
+// Checks that the bounds span at most max_voxels voxels along each axis.
+// The hash table compares voxel indices exactly, so it allows the whole
+// int range; the Morton codes of the sorted paths hold 21 bits per axis.
+bool CheckVoxelSize(const Eigen::Vector3f& min_bound, const Eigen::Vector3f& max_bound,
+                    float voxel_size, int max_voxels, Eigen::Vector3f& voxel_min_bound) {
+    if (voxel_size <= 0.0) {
+        utility::LogWarning("[VoxelDownSample] voxel_size <= 0.\n");
+        return false;
+    }
+    const Eigen::Vector3f voxel_size3 = Eigen::Vector3f(voxel_size, voxel_size, voxel_size);
+    voxel_min_bound = min_bound - voxel_size3 * 0.5;
+    const Eigen::Vector3f voxel_max_bound = max_bound + voxel_size3 * 0.5;
+    if (voxel_size * max_voxels < (voxel_max_bound - voxel_min_bound).maxCoeff()) {
+        utility::LogWarning("[VoxelDownSample] voxel_size is too small.\n");
+        return false;
+    }
+    return true;
+}
+
+}
+
+std::shared_ptr<PointCloud> PointCloud::SelectDownSample(const thrustcupoch::device_vector<size_t> &indices, bool invert) const {
     auto output = std::make_shared<PointCloud>();
 
     if (invert) {
         size_t n_out = points_.size() - indices.size();
-        thrust::device_vector<size_t> sorted_indices = indices;
+        thrustcupoch::device_vector<size_t> sorted_indices = indices;
         thrust::sort(sorted_indices.begin(), sorted_indices.end());
-        thrust::device_vector<size_t> inv_indices(n_out);
+        thrustcupoch::device_vector<size_t> inv_indices(n_out);
         thrust::set_difference(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(points_.size()),
                                sorted_indices.begin(), sorted_indices.end(), inv_indices.begin());
         SelectDownSampleImpl(*this, *output, inv_indices);
@@ -144,77 +661,187 @@ std::shared_ptr<PointCloud> PointCloud::SelectDownSample(const thrust::device_ve
 
 std::shared_ptr<PointCloud> PointCloud::VoxelDownSample(float voxel_size) const {
     auto output = std::make_shared<PointCloud>();
-    if (voxel_size <= 0.0) {
-        utility::LogWarning("[VoxelDownSample] voxel_size <= 0.\n");
+    Eigen::Vector3f voxel_min_bound;
+    if (!CheckVoxelSize(GetMinBound(), GetMaxBound(), voxel_size,
+                        std::numeric_limits<int>::max(), voxel_min_bound)) {
         return output;
     }
 
-    const Eigen::Vector3f voxel_size3 = Eigen::Vector3f(voxel_size, voxel_size, voxel_size);
-    const Eigen::Vector3f voxel_min_bound = GetMinBound() - voxel_size3 * 0.5;
-    const Eigen::Vector3f voxel_max_bound = GetMaxBound() + voxel_size3 * 0.5;
+    VoxelDownSampleImpl(*this, voxel_min_bound, voxel_size, *output);
 
-    if (voxel_size * std::numeric_limits<int>::max() < (voxel_max_bound - voxel_min_bound).maxCoeff()) {
-        utility::LogWarning("[VoxelDownSample] voxel_size is too small.\n");
+    utility::LogDebug(
+            "Pointcloud down sampled from {:d} points to {:d} points.\n",
+            (int)points_.size(), (int)output->points_.size());
+    return output;
+}
+
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<int>,
+           thrustcupoch::device_vector<int>, thrustcupoch::device_vector<int>>
+PointCloud::VoxelDownSampleAndTrace(float voxel_size) const {
+    auto output = std::make_shared<PointCloud>();
+    thrustcupoch::device_vector<int> point_voxels;
+    thrustcupoch::device_vector<int> offsets(1, 0);
+    thrustcupoch::device_vector<int> indices;
+    Eigen::Vector3f voxel_min_bound;
+    if (!CheckVoxelSize(GetMinBound(), GetMaxBound(), voxel_size,
+                        (1 << MORTON_CODE_BITS) - 1, voxel_min_bound)) {
+        return std::make_tuple(output, point_voxels, offsets, indices);
+    }
+    thrustcupoch::device_vector<uint64_t> codes;
+    SortPointsByVoxel(points_, voxel_min_bound, voxel_size, codes, indices);
+    const int n_voxels = GroupSortedPoints(codes, indices, 0, offsets, point_voxels);
+    AverageVoxels(*this, point_voxels, n_voxels, *output);
+    return std::make_tuple(output, point_voxels, offsets, indices);
+}
+
+std::tuple<std::vector<PointCloud::VoxelPyramidLevel>, thrustcupoch::device_vector<int>>
+PointCloud::VoxelDownSamplePyramid(float voxel_size, int n_levels) const {
+    std::vector<VoxelPyramidLevel> levels;
+    thrustcupoch::device_vector<int> sorted_indices;
+    Eigen::Vector3f voxel_min_bound;
+    if (n_levels <= 0 ||
+        !CheckVoxelSize(GetMinBound(), GetMaxBound(), voxel_size,
+                        (1 << MORTON_CODE_BITS) - 1, voxel_min_bound)) {
+        return std::make_tuple(std::move(levels), std::move(sorted_indices));
+    }
+    // the points are sorted once at the finest level; the coarser levels
+    // only drop the lowest bits of the sorted codes
+    thrustcupoch::device_vector<uint64_t> codes;
+    SortPointsByVoxel(points_, voxel_min_bound, voxel_size, codes, sorted_indices);
+    const int max_levels = MORTON_CODE_BITS + 1;
+    if (n_levels > max_levels) {
+        utility::LogWarning("[VoxelDownSamplePyramid] n_levels is limited to {:d}.\n",
+                            max_levels);
+        n_levels = max_levels;
+    }
+    levels.resize(n_levels);
+    const int* sorted_ptr = thrust::raw_pointer_cast(sorted_indices.data());
+    int n_prev_voxels = 0;
+    for (int level = 0; level < n_levels; ++level) {
+        VoxelPyramidLevel& cur = levels[level];
+        cur.cloud_ = std::make_shared<PointCloud>();
+        const int n_voxels = GroupSortedPoints(codes, sorted_indices, level,
+                                               cur.offsets_, cur.point_voxels_);
+        AverageVoxels(*this, cur.point_voxels_, n_voxels, *cur.cloud_);
+        if (level == 0) {
+            cur.child_offsets_.assign(1, 0);
+            n_prev_voxels = n_voxels;
+            continue;
+        }
+        VoxelPyramidLevel& prev = levels[level - 1];
+        // the children of a voxel are the consecutive voxels of the previous
+        // level from the one holding its first point
+        cur.child_offsets_.resize(n_voxels + 1);
+        thrust::transform(cur.offsets_.begin(), cur.offsets_.end() - 1,
+                          cur.child_offsets_.begin(),
+                          first_point_voxel_functor(sorted_ptr,
+                                                    thrust::raw_pointer_cast(prev.point_voxels_.data())));
+        cur.child_offsets_[n_voxels] = n_prev_voxels;
+        cur.children_.resize(n_prev_voxels);
+        thrust::sequence(cur.children_.begin(), cur.children_.end());
+        prev.parents_.resize(n_prev_voxels);
+        thrust::transform(prev.offsets_.begin(), prev.offsets_.end() - 1,
+                          prev.parents_.begin(),
+                          first_point_voxel_functor(sorted_ptr,
+                                                    thrust::raw_pointer_cast(cur.point_voxels_.data())));
+        n_prev_voxels = n_voxels;
+    }
+    return std::make_tuple(std::move(levels), std::move(sorted_indices));
+}
+
+std::shared_ptr<PointCloud> CompactPointCloud::VoxelDownSample(float voxel_size) const {
+    auto output = std::make_shared<PointCloud>();
+    if (voxel_size <= 0.0) {
+        utility::LogWarning("[VoxelDownSample] voxel_size <= 0.\n");
+        return output;
+    }
+    if (IsEmpty()) return output;
+    const voxel_input input(*this);
+    const Eigen::Vector3f min_bound = thrust::reduce(
+            input.PointsBegin(), input.PointsBegin() + input.n_,
+            Eigen::Vector3f::Constant(std::numeric_limits<float>::max()),
+            elementwise_min_functor());
+    const Eigen::Vector3f max_bound = thrust::reduce(
+            input.PointsBegin(), input.PointsBegin() + input.n_,
+            Eigen::Vector3f::Constant(-std::numeric_limits<float>::max()),
+            elementwise_max_functor());
+    Eigen::Vector3f voxel_min_bound;
+    if (!CheckVoxelSize(min_bound, max_bound, voxel_size,
+                        std::numeric_limits<int>::max(), voxel_min_bound)) {
         return output;
     }
+    VoxelDownSampleImpl(input, voxel_min_bound, voxel_size, *output);
+    return output;
+}
 
-    const int n = points_.size();
-    const bool has_normals = HasNormals();
-    const bool has_colors = HasColors();
-    compute_key_functor ck_func(voxel_min_bound, voxel_size);
-    thrust::device_vector<Eigen::Vector3i> keys(n);
-    thrust::transform(points_.begin(), points_.end(), keys.begin(), ck_func);
-
-    thrust::device_vector<Eigen::Vector3f> sorted_points = points_;
-    output->points_.resize(n);
-    if (!has_normals && !has_colors) {
-        typedef thrust::tuple<thrust::device_vector<Eigen::Vector3f>::iterator> IteratorTuple;
-        typedef thrust::zip_iterator<IteratorTuple> ZipIterator;
-        auto n_out = CalcAverageByKey<ZipIterator, Eigen::Vector3f>(keys,
-                    make_tuple_iterator(sorted_points.begin()),
-                    make_tuple_iterator(output->points_.begin()));
-        output->points_.resize(n_out);
-    } else if (has_normals && !has_colors) {
-        thrust::device_vector<Eigen::Vector3f> sorted_normals = normals_;
-        output->normals_.resize(n);
-        typedef thrust::tuple<thrust::device_vector<Eigen::Vector3f>::iterator, thrust::device_vector<Eigen::Vector3f>::iterator> IteratorTuple;
-        typedef thrust::zip_iterator<IteratorTuple> ZipIterator;
-        auto n_out = CalcAverageByKey<ZipIterator, Eigen::Vector3f, Eigen::Vector3f>(keys,
-                    make_tuple_iterator(sorted_points.begin(), sorted_normals.begin()),
-                    make_tuple_iterator(output->points_.begin(), output->normals_.begin()));
-        output->points_.resize(n_out);
-        output->normals_.resize(n_out);
-        thrust::for_each(output->normals_.begin(), output->normals_.end(), [] __device__ (Eigen::Vector3f& nl) {nl.normalize();});
-    } else if (!has_normals && has_colors) {
-        thrust::device_vector<Eigen::Vector3f> sorted_colors = colors_;
-        output->colors_.resize(n);
-        typedef thrust::tuple<thrust::device_vector<Eigen::Vector3f>::iterator, thrust::device_vector<Eigen::Vector3f>::iterator> IteratorTuple;
-        typedef thrust::zip_iterator<IteratorTuple> ZipIterator;
-        auto n_out = CalcAverageByKey<ZipIterator, Eigen::Vector3f, Eigen::Vector3f>(keys,
-                    make_tuple_iterator(sorted_points.begin(), sorted_colors.begin()),
-                    make_tuple_iterator(output->points_.begin(), output->colors_.begin()));
-        output->points_.resize(n_out);
-        output->colors_.resize(n_out);
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+PointCloud::FarthestPointDownSample(size_t num_samples) const {
+    std::vector<const PointCloud *> clouds(1, this);
+    return BatchFarthestPointDownSample(clouds, num_samples)[0];
+}
+
+std::vector<std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>>
+PointCloud::BatchFarthestPointDownSample(const std::vector<const PointCloud *> &clouds,
+                                         size_t num_samples) {
+    std::vector<std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>> outputs;
+    if (num_samples == 0) {
+        for (size_t c = 0; c < clouds.size(); ++c) {
+            outputs.push_back(std::make_tuple(std::make_shared<PointCloud>(),
+                                              thrustcupoch::device_vector<size_t>()));
+        }
+        return outputs;
+    }
+    thrust::host_vector<int> offsets(clouds.size() + 1, 0);
+    for (size_t c = 0; c < clouds.size(); ++c) {
+        offsets[c + 1] = offsets[c] + clouds[c]->points_.size();
+    }
+    thrustcupoch::device_vector<int> samples;
+    if (clouds.size() == 1) {
+        FarthestPointDownSampleImpl(clouds[0]->points_, offsets, num_samples, samples);
     } else {
-        thrust::device_vector<Eigen::Vector3f> sorted_normals = normals_;
-        thrust::device_vector<Eigen::Vector3f> sorted_colors = colors_;
-        output->normals_.resize(n);
-        output->colors_.resize(n);
-        typedef thrust::tuple<thrust::device_vector<Eigen::Vector3f>::iterator, thrust::device_vector<Eigen::Vector3f>::iterator, thrust::device_vector<Eigen::Vector3f>::iterator> IteratorTuple;
-        typedef thrust::zip_iterator<IteratorTuple> ZipIterator;
-        auto n_out = CalcAverageByKey<ZipIterator, Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f>(keys,
-                    make_tuple_iterator(sorted_points.begin(), sorted_normals.begin(), sorted_colors.begin()),
-                    make_tuple_iterator(output->points_.begin(), output->normals_.begin(), output->colors_.begin()));
-        output->points_.resize(n_out);
-        output->normals_.resize(n_out);
-        output->colors_.resize(n_out);
-        thrust::for_each(output->normals_.begin(), output->normals_.end(), [] __device__ (Eigen::Vector3f& nl) {nl.normalize();});
+        thrustcupoch::device_vector<Eigen::Vector3f> points(offsets.back());
+        for (size_t c = 0; c < clouds.size(); ++c) {
+            thrust::copy(clouds[c]->points_.begin(), clouds[c]->points_.end(),
+                         points.begin() + offsets[c]);
+        }
+        FarthestPointDownSampleImpl(points, offsets, num_samples, samples);
+    }
+    for (size_t c = 0; c < clouds.size(); ++c) {
+        const size_t n = std::min(num_samples, clouds[c]->points_.size());
+        thrustcupoch::device_vector<size_t> indices(samples.begin() + c * num_samples,
+                                                    samples.begin() + c * num_samples + n);
+        outputs.push_back(std::make_tuple(clouds[c]->SelectDownSample(indices), indices));
     }
+    return outputs;
+}
 
-    utility::LogDebug(
-            "Pointcloud down sampled from {:d} points to {:d} points.\n",
-            (int)points_.size(), (int)output->points_.size());
-    return output;
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+PointCloud::RandomDownSample(float sampling_ratio, uint64_t seed) const {
+    if (sampling_ratio < 0 || sampling_ratio > 1) {
+        utility::LogError(
+                "[RandomDownSample] Illegal sampling_ratio {}, sampling_ratio "
+                "must be between 0 and 1.", sampling_ratio);
+        return std::make_tuple(std::make_shared<PointCloud>(),
+                               thrustcupoch::device_vector<size_t>());
+    }
+    return RandomDownSampleToSize(size_t(sampling_ratio * points_.size()), seed);
+}
+
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+PointCloud::RandomDownSampleToSize(size_t num_samples, uint64_t seed) const {
+    const size_t n_pt = points_.size();
+    num_samples = std::min(num_samples, n_pt);
+    // shuffle the indices by sorting them with random keys
+    thrustcupoch::device_vector<uint32_t> keys(n_pt);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt), keys.begin(),
+                      random_key_functor(utility::MakeRandomKey(seed)));
+    thrustcupoch::device_vector<size_t> indices(n_pt);
+    thrust::sequence(indices.begin(), indices.end());
+    thrust::sort_by_key(keys.begin(), keys.end(), indices.begin());
+    indices.resize(num_samples);
+    thrust::sort(indices.begin(), indices.end());
+    return std::make_tuple(SelectDownSample(indices), indices);
 }
 
 std::shared_ptr<PointCloud> PointCloud::UniformDownSample(
@@ -230,41 +857,39 @@ std::shared_ptr<PointCloud> PointCloud::UniformDownSample(
     output->points_.resize(n_out);
     if (has_normals) output->normals_.resize(n_out);
     if (has_colors) output->colors_.resize(n_out);
-    thrust::transform(thrust::cuda::par.on(utility::GetStream(0)),
+    thrust::transform(exec_policy_on(utility::GetStream(0)),
                       thrust::make_counting_iterator(0), thrust::make_counting_iterator(n_out),
                       output->points_.begin(),
                       stride_copy_functor(thrust::raw_pointer_cast(output->points_.data()), every_k_points));
     if (has_normals) {
-        thrust::transform(thrust::cuda::par.on(utility::GetStream(1)),
+        thrust::transform(exec_policy_on(utility::GetStream(1)),
                           thrust::make_counting_iterator(0), thrust::make_counting_iterator(n_out),
                           output->normals_.begin(),
                           stride_copy_functor(thrust::raw_pointer_cast(output->normals_.data()), every_k_points));
     }
     if (has_colors) {
-        thrust::transform(thrust::cuda::par.on(utility::GetStream(2)),
+        thrust::transform(exec_policy_on(utility::GetStream(2)),
                           thrust::make_counting_iterator(0), thrust::make_counting_iterator(n_out),
                           output->colors_.begin(),
                           stride_copy_functor(thrust::raw_pointer_cast(output->colors_.data()), every_k_points));
     }
-    cudaSafeCall(cudaDeviceSynchronize());
+    utility::GetExecutionContext().Synchronize();
     return output;
 }
 
-std::tuple<std::shared_ptr<PointCloud>, thrust::device_vector<size_t>>
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
 PointCloud::RemoveRadiusOutliers(size_t nb_points, float search_radius) const {
     if (nb_points < 1 || search_radius <= 0) {
         utility::LogError(
                 "[RemoveRadiusOutliers] Illegal input parameters,"
                 "number of points and radius must be positive");
     }
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(*this);
-    thrust::device_vector<int> tmp_indices;
-    thrust::device_vector<float> dist;
-    kdtree.SearchRadius(points_, search_radius, tmp_indices, dist);
+    // only the number of neighbors is needed, not the neighbor lists
+    thrustcupoch::device_vector<int> counts;
+    GetKDTree()->CountRadius(points_, search_radius, counts);
     const size_t n_pt = points_.size();
-    thrust::device_vector<size_t> indices(n_pt);
-    has_radius_points_functor func(thrust::raw_pointer_cast(tmp_indices.data()), nb_points, NUM_MAX_NN);
+    thrustcupoch::device_vector<size_t> indices(n_pt);
+    has_radius_points_functor func(thrust::raw_pointer_cast(counts.data()), nb_points);
     auto end = thrust::copy_if(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(n_pt),
                                indices.begin(), func);
     indices.resize(thrust::distance(indices.begin(), end));
@@ -277,7 +902,7 @@ PointCloud::RemoveRadiusOutliersHost(size_t nb_points, float search_radius) cons
     return std::make_tuple(std::get<0>(output), thrust::host_vector<size_t>(std::get<1>(output)));
 }
 
-std::tuple<std::shared_ptr<PointCloud>, thrust::device_vector<size_t>>
+std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
 PointCloud::RemoveStatisticalOutliers(size_t nb_neighbors,
                                       float std_ratio) const {
     if (nb_neighbors < 1 || std_ratio <= 0) {
@@ -287,30 +912,24 @@ PointCloud::RemoveStatisticalOutliers(size_t nb_neighbors,
     }
     if (points_.empty()) {
         return std::make_tuple(std::make_shared<PointCloud>(),
-                               thrust::device_vector<size_t>());
+                               thrustcupoch::device_vector<size_t>());
     }
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(*this);
     const int n_pt = points_.size();
-    thrust::device_vector<float> avg_distances(n_pt);
-    thrust::device_vector<size_t> indices(n_pt);
-    thrust::device_vector<int> tmp_indices;
-    thrust::device_vector<float> dist;
-    kdtree.SearchKNN(points_, int(nb_neighbors), tmp_indices, dist);
-    average_distance_functor avg_func(thrust::raw_pointer_cast(dist.data()), nb_neighbors);
-    thrust::transform(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator((size_t)n_pt),
-                      avg_distances.begin(), avg_func);
-    const size_t valid_distances = thrust::count_if(avg_distances.begin(), avg_distances.end(), [] __device__ (float x) {return (x >= 0.0);});
-    if (valid_distances == 0) {
+    thrustcupoch::device_vector<float> avg_distances;
+    thrustcupoch::device_vector<size_t> indices(n_pt);
+    // the distances are averaged during the search without the n x k lists
+    const int valid_distances = GetKDTree()->SearchKNNMeanDistance2(
+            points_, int(nb_neighbors), avg_distances);
+    if (valid_distances <= 0) {
         return std::make_tuple(std::make_shared<PointCloud>(),
-                               thrust::device_vector<size_t>());
+                               thrustcupoch::device_vector<size_t>());
     }
     float cloud_mean = thrust::reduce(avg_distances.begin(), avg_distances.end(), 0.0,
-            [] __device__ (float const &x, float const &y) { return (y > 0) ? x + y : x; });
+            [] __host__ __device__ (float const &x, float const &y) { return (y > 0) ? x + y : x; });
     cloud_mean /= valid_distances;
     const float sq_sum = thrust::transform_reduce(
             avg_distances.begin(), avg_distances.end(),
-            [cloud_mean] __device__ (const float x) {return (x > 0) ? (x - cloud_mean) * (x - cloud_mean) : 0;},
+            [cloud_mean] __host__ __device__ (const float x) {return (x > 0) ? (x - cloud_mean) * (x - cloud_mean) : 0;},
             0.0, thrust::plus<float>());
     // Bessel's correction
     const float std_dev = std::sqrt(sq_sum / (valid_distances - 1));
@@ -0,0 +1,544 @@
+#include "cupoch/geometry/dynamic_kdtree.h"
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include <thrust/binary_search.h>
+#include <thrust/count.h>
+#include <thrust/gather.h>
+#include <thrust/remove.h>
+#include <thrust/replace.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/unique.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+struct is_alive_functor {
+    __host__ __device__
+    bool operator() (uint8_t alive) const {
+        return alive != 0;
+    }
+};
+
+struct is_valid_index_functor {
+    __host__ __device__
+    bool operator() (int idx) const {
+        return idx >= 0;
+    }
+};
+
+struct inside_box_functor {
+    inside_box_functor(const Eigen::Vector3f& min_bound,
+                       const Eigen::Vector3f& max_bound)
+        : min_bound_(min_bound), max_bound_(max_bound) {};
+    const Eigen::Vector3f min_bound_;
+    const Eigen::Vector3f max_bound_;
+    __host__ __device__
+    bool operator() (const Eigen::Vector3f& p) const {
+        return (p.array() >= min_bound_.array()).all() &&
+               (p.array() <= max_bound_.array()).all();
+    }
+};
+
+struct count_inside_box_functor {
+    count_inside_box_functor(const Eigen::Vector3f& min_bound,
+                             const Eigen::Vector3f& max_bound)
+        : inside_(min_bound, max_bound) {};
+    const inside_box_functor inside_;
+    __host__ __device__
+    bool operator() (const thrust::tuple<Eigen::Vector3f, uint8_t>& x) const {
+        return thrust::get<1>(x) != 0 && inside_(thrust::get<0>(x));
+    }
+};
+
+// Marks the point with the given id as deleted and returns 1 if it was
+// alive in the level.
+struct delete_id_functor {
+    delete_id_functor(const int* ids, uint8_t* alive, int n_ids)
+        : ids_(ids), alive_(alive), n_ids_(n_ids) {};
+    const int* ids_;
+    uint8_t* alive_;
+    const int n_ids_;
+    __host__ __device__
+    int operator() (int id) const {
+        const int* it = thrust::lower_bound(thrust::seq, ids_, ids_ + n_ids_, id);
+        if (it == ids_ + n_ids_ || *it != id) return 0;
+        const int idx = it - ids_;
+        if (alive_[idx] == 0) return 0;
+        alive_[idx] = 0;
+        return 1;
+    }
+};
+
+// Inserts the remaining candidates of a level into the rows of the results,
+// sorted by distance. The rows of the candidates are either given by
+// offsets_ or have a fixed stride_.
+struct merge_neighbors_functor {
+    merge_neighbors_functor(const int* offsets, int stride,
+                            const int* candidates, const float* candidate_distance2,
+                            const int* ids, const uint8_t* alive,
+                            const int* query_map, int knn,
+                            int* indices, float* distance2)
+        : offsets_(offsets), stride_(stride), candidates_(candidates),
+          candidate_distance2_(candidate_distance2), ids_(ids), alive_(alive),
+          query_map_(query_map), knn_(knn), indices_(indices),
+          distance2_(distance2) {};
+    const int* offsets_;
+    const int stride_;
+    const int* candidates_;
+    const float* candidate_distance2_;
+    const int* ids_;
+    const uint8_t* alive_;
+    const int* query_map_;
+    const int knn_;
+    int* indices_;
+    float* distance2_;
+    __host__ __device__
+    void operator() (size_t row) const {
+        const int q = (query_map_) ? query_map_[row] : row;
+        int* idxs = indices_ + q * knn_;
+        float* dists = distance2_ + q * knn_;
+        const int begin = (offsets_) ? offsets_[row] : row * stride_;
+        const int end = (offsets_) ? offsets_[row + 1] : (row + 1) * stride_;
+        for (int j = begin; j < end; ++j) {
+            const int local = candidates_[j];
+            if (local < 0 || alive_[local] == 0) continue;
+            const float d2 = candidate_distance2_[j];
+            if (d2 >= dists[knn_ - 1]) continue;
+            const int id = ids_[local];
+            bool found = false;
+            for (int k = 0; k < knn_ && !found; ++k) found = (idxs[k] == id);
+            if (found) continue;
+            int k = knn_ - 1;
+            while (k > 0 && dists[k - 1] > d2) {
+                dists[k] = dists[k - 1];
+                idxs[k] = idxs[k - 1];
+                --k;
+            }
+            dists[k] = d2;
+            idxs[k] = id;
+        }
+    }
+};
+
+__host__ __device__
+inline int CountAlive(const int* candidates, const uint8_t* alive, int begin, int end) {
+    int n = 0;
+    for (int j = begin; j < end; ++j) {
+        if (candidates[j] >= 0 && alive[candidates[j]] != 0) ++n;
+    }
+    return n;
+}
+
+// A knn row of a level needs a larger search if it is full but holds less
+// than knn remaining points.
+struct needs_expansion_functor {
+    needs_expansion_functor(const int* candidates, const uint8_t* alive,
+                            int stride, int knn)
+        : candidates_(candidates), alive_(alive), stride_(stride), knn_(knn) {};
+    const int* candidates_;
+    const uint8_t* alive_;
+    const int stride_;
+    const int knn_;
+    __host__ __device__
+    bool operator() (int row) const {
+        const int begin = row * stride_;
+        if (candidates_[begin + stride_ - 1] < 0) return false;
+        return CountAlive(candidates_, alive_, begin, begin + stride_) < knn_;
+    }
+};
+
+struct kth_distance_functor {
+    kth_distance_functor(const float* distance2, int stride)
+        : distance2_(distance2), stride_(stride) {};
+    const float* distance2_;
+    const int stride_;
+    __host__ __device__
+    float operator() (int row) const {
+        return distance2_[(row + 1) * stride_ - 1];
+    }
+};
+
+// A radius row is complete if it reached the candidate limit or holds knn
+// remaining points.
+struct expansion_done_functor {
+    expansion_done_functor(const int* offsets, const int* candidates,
+                           const uint8_t* alive, int max_candidates, int knn)
+        : offsets_(offsets), candidates_(candidates), alive_(alive),
+          max_candidates_(max_candidates), knn_(knn) {};
+    const int* offsets_;
+    const int* candidates_;
+    const uint8_t* alive_;
+    const int max_candidates_;
+    const int knn_;
+    __host__ __device__
+    bool operator() (int row) const {
+        const int begin = offsets_[row];
+        const int end = offsets_[row + 1];
+        if (end - begin >= max_candidates_) return true;
+        return CountAlive(candidates_, alive_, begin, end) >= knn_;
+    }
+};
+
+}
+
+struct DynamicKDTree::Level {
+    KDTreeFlann kdtree_;
+    /// Points sorted by id
+    thrustcupoch::device_vector<Eigen::Vector3f> points_;
+    thrustcupoch::device_vector<int> ids_;
+    thrustcupoch::device_vector<uint8_t> alive_;
+    size_t num_deleted_ = 0;
+    size_t GetNumAlive() const { return ids_.size() - num_deleted_; }
+};
+
+DynamicKDTree::DynamicKDTree() {}
+
+DynamicKDTree::~DynamicKDTree() {}
+
+std::unique_ptr<DynamicKDTree::Level> DynamicKDTree::MakeLevel(
+        thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        thrustcupoch::device_vector<int> &ids) const {
+    std::unique_ptr<Level> level(new Level());
+    level->points_.swap(points);
+    level->ids_.swap(ids);
+    level->alive_.assign(level->ids_.size(), 1);
+    level->kdtree_.SetRawData(level->points_);
+    return level;
+}
+
+void DynamicKDTree::AppendAlivePoints(
+        const Level &level,
+        thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        thrustcupoch::device_vector<int> &ids) const {
+    const size_t n = points.size();
+    points.resize(n + level.GetNumAlive());
+    ids.resize(n + level.GetNumAlive());
+    thrust::copy_if(make_tuple_iterator(level.points_.begin(), level.ids_.begin()),
+                    make_tuple_iterator(level.points_.end(), level.ids_.end()),
+                    level.alive_.begin(),
+                    make_tuple_iterator(points.begin() + n, ids.begin() + n),
+                    is_alive_functor());
+}
+
+void DynamicKDTree::CompactLevels() {
+    std::vector<std::unique_ptr<Level>> levels;
+    for (auto &level : levels_) {
+        if (level->GetNumAlive() == 0) continue;
+        if (level->num_deleted_ * 2 > level->ids_.size()) {
+            thrustcupoch::device_vector<Eigen::Vector3f> points;
+            thrustcupoch::device_vector<int> ids;
+            AppendAlivePoints(*level, points, ids);
+            levels.push_back(MakeLevel(points, ids));
+        } else {
+            levels.push_back(std::move(level));
+        }
+    }
+    std::stable_sort(levels.begin(), levels.end(),
+                     [](const std::unique_ptr<Level> &a,
+                        const std::unique_ptr<Level> &b) {
+                         return a->GetNumAlive() > b->GetNumAlive();
+                     });
+    levels_.swap(levels);
+}
+
+int DynamicKDTree::Insert(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points) {
+    const int first_id = next_id_;
+    if (points.empty()) return first_id;
+    thrustcupoch::device_vector<Eigen::Vector3f> new_points = points;
+    thrustcupoch::device_vector<int> new_ids(points.size());
+    thrust::sequence(new_ids.begin(), new_ids.end(), first_id);
+    next_id_ += points.size();
+    // merge the levels that are not larger than the new one
+    bool merged = false;
+    while (!levels_.empty() &&
+           levels_.back()->GetNumAlive() <= new_ids.size()) {
+        AppendAlivePoints(*levels_.back(), new_points, new_ids);
+        levels_.pop_back();
+        merged = true;
+    }
+    if (merged) {
+        thrust::sort_by_key(new_ids.begin(), new_ids.end(), new_points.begin());
+    }
+    levels_.push_back(MakeLevel(new_points, new_ids));
+    return first_id;
+}
+
+size_t DynamicKDTree::DeleteByIndex(const thrustcupoch::device_vector<int> &ids) {
+    if (ids.empty() || levels_.empty()) return 0;
+    thrustcupoch::device_vector<int> sorted_ids = ids;
+    thrust::sort(sorted_ids.begin(), sorted_ids.end());
+    auto end = thrust::unique(sorted_ids.begin(), sorted_ids.end());
+    sorted_ids.resize(thrust::distance(sorted_ids.begin(), end));
+    thrustcupoch::device_vector<int> deleted(sorted_ids.size());
+    size_t n_deleted = 0;
+    for (auto &level : levels_) {
+        delete_id_functor func(thrust::raw_pointer_cast(level->ids_.data()),
+                               thrust::raw_pointer_cast(level->alive_.data()),
+                               level->ids_.size());
+        thrust::transform(sorted_ids.begin(), sorted_ids.end(), deleted.begin(), func);
+        const size_t n = thrust::reduce(deleted.begin(), deleted.end(), 0);
+        level->num_deleted_ += n;
+        n_deleted += n;
+    }
+    CompactLevels();
+    return n_deleted;
+}
+
+size_t DynamicKDTree::DeleteInBoundingBox(const AxisAlignedBoundingBox &box) {
+    size_t n_deleted = 0;
+    for (auto &level : levels_) {
+        const size_t n = thrust::count_if(
+                make_tuple_iterator(level->points_.begin(), level->alive_.begin()),
+                make_tuple_iterator(level->points_.end(), level->alive_.end()),
+                count_inside_box_functor(box.min_bound_, box.max_bound_));
+        if (n == 0) continue;
+        thrust::replace_if(level->alive_.begin(), level->alive_.end(),
+                           level->points_.begin(),
+                           inside_box_functor(box.min_bound_, box.max_bound_),
+                           0);
+        level->num_deleted_ += n;
+        n_deleted += n;
+    }
+    if (n_deleted > 0) CompactLevels();
+    return n_deleted;
+}
+
+void DynamicKDTree::Rebuild() {
+    if (levels_.empty()) return;
+    thrustcupoch::device_vector<Eigen::Vector3f> points;
+    thrustcupoch::device_vector<int> ids;
+    ExtractPoints(points, ids);
+    levels_.clear();
+    if (ids.empty()) return;
+    levels_.push_back(MakeLevel(points, ids));
+}
+
+void DynamicKDTree::Clear() {
+    levels_.clear();
+    next_id_ = 0;
+}
+
+void DynamicKDTree::ExtractPoints(
+        thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        thrustcupoch::device_vector<int> &ids) const {
+    points.clear();
+    ids.clear();
+    for (const auto &level : levels_) {
+        AppendAlivePoints(*level, points, ids);
+    }
+    thrust::sort_by_key(ids.begin(), ids.end(), points.begin());
+}
+
+size_t DynamicKDTree::GetNumPoints() const {
+    size_t n = 0;
+    for (const auto &level : levels_) n += level->GetNumAlive();
+    return n;
+}
+
+int DynamicKDTree::SearchKNNInLevel(
+        const Level &level,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        int knn,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const {
+    // the deleted points of the level may take the place of remaining ones
+    const int n_points = level.ids_.size();
+    const int n_candidates = std::min(knn + int(level.num_deleted_), n_points);
+    const int stride = std::min(n_candidates, NUM_MAX_NN);
+    const int* ids = thrust::raw_pointer_cast(level.ids_.data());
+    const uint8_t* alive = thrust::raw_pointer_cast(level.alive_.data());
+    thrustcupoch::device_vector<int> candidates;
+    thrustcupoch::device_vector<float> candidate_distance2;
+    if (level.kdtree_.SearchKNN(query, stride, candidates, candidate_distance2) < 0) {
+        return -1;
+    }
+    merge_neighbors_functor func(nullptr, stride,
+                                 thrust::raw_pointer_cast(candidates.data()),
+                                 thrust::raw_pointer_cast(candidate_distance2.data()),
+                                 ids, alive, nullptr, knn,
+                                 thrust::raw_pointer_cast(indices.data()),
+                                 thrust::raw_pointer_cast(distance2.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(query.size()), func);
+    if (stride == n_candidates) return knn;
+
+    // The rows capped by NUM_MAX_NN may miss remaining points. They are
+    // searched again by radius searches without the cap, doubling the
+    // radius until knn remaining points are found.
+    thrustcupoch::device_vector<int> rows(query.size());
+    auto end = thrust::copy_if(thrust::make_counting_iterator<int>(0),
+                               thrust::make_counting_iterator<int>(query.size()),
+                               rows.begin(),
+                               needs_expansion_functor(
+                                       thrust::raw_pointer_cast(candidates.data()),
+                                       alive, stride, knn));
+    rows.resize(thrust::distance(rows.begin(), end));
+    if (rows.empty()) return knn;
+    const float max_distance2 = thrust::transform_reduce(
+            rows.begin(), rows.end(),
+            kth_distance_functor(thrust::raw_pointer_cast(candidate_distance2.data()), stride),
+            0.0f, thrust::maximum<float>());
+    float radius = std::max(std::sqrt(max_distance2),
+                            std::numeric_limits<float>::epsilon());
+    while (!rows.empty()) {
+        radius *= 2.0f;
+        thrustcupoch::device_vector<Eigen::Vector3f> sub_query(rows.size());
+        thrust::gather(rows.begin(), rows.end(), query.begin(), sub_query.begin());
+        thrustcupoch::device_vector<int> offsets;
+        if (level.kdtree_.SearchHybridCSR(sub_query, radius, n_candidates, offsets,
+                                          candidates, candidate_distance2) < 0) {
+            return -1;
+        }
+        merge_neighbors_functor expand_func(thrust::raw_pointer_cast(offsets.data()), 0,
+                                            thrust::raw_pointer_cast(candidates.data()),
+                                            thrust::raw_pointer_cast(candidate_distance2.data()),
+                                            ids, alive, thrust::raw_pointer_cast(rows.data()),
+                                            knn, thrust::raw_pointer_cast(indices.data()),
+                                            thrust::raw_pointer_cast(distance2.data()));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(rows.size()), expand_func);
+        auto rows_end = thrust::remove_if(rows.begin(), rows.end(),
+                                     thrust::make_counting_iterator<int>(0),
+                                     expansion_done_functor(
+                                             thrust::raw_pointer_cast(offsets.data()),
+                                             thrust::raw_pointer_cast(candidates.data()),
+                                             alive, n_candidates, knn));
+        rows.resize(thrust::distance(rows.begin(), rows_end));
+    }
+    return knn;
+}
+
+int DynamicKDTree::SearchHybridInLevel(
+        const Level &level,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        float radius,
+        int max_nn,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const {
+    // the nearest max_nn + num_deleted_ candidates hold the nearest max_nn
+    // remaining points
+    const int n_candidates =
+            std::min(max_nn + int(level.num_deleted_), int(level.ids_.size()));
+    thrustcupoch::device_vector<int> offsets;
+    thrustcupoch::device_vector<int> candidates;
+    thrustcupoch::device_vector<float> candidate_distance2;
+    if (level.kdtree_.SearchHybridCSR(query, radius, n_candidates, offsets,
+                                      candidates, candidate_distance2) < 0) {
+        return -1;
+    }
+    merge_neighbors_functor func(thrust::raw_pointer_cast(offsets.data()), 0,
+                                 thrust::raw_pointer_cast(candidates.data()),
+                                 thrust::raw_pointer_cast(candidate_distance2.data()),
+                                 thrust::raw_pointer_cast(level.ids_.data()),
+                                 thrust::raw_pointer_cast(level.alive_.data()),
+                                 nullptr, max_nn,
+                                 thrust::raw_pointer_cast(indices.data()),
+                                 thrust::raw_pointer_cast(distance2.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(query.size()), func);
+    return max_nn;
+}
+
+int DynamicKDTree::Search(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                          const KDTreeSearchParam &param,
+                          thrustcupoch::device_vector<int> &indices,
+                          thrustcupoch::device_vector<float> &distance2) const {
+    switch (param.GetSearchType()) {
+        case KDTreeSearchParam::SearchType::Knn:
+            return SearchKNN(query, ((const KDTreeSearchParamKNN &)param).knn_,
+                             indices, distance2);
+        case KDTreeSearchParam::SearchType::Radius:
+            return SearchRadius(
+                    query, ((const KDTreeSearchParamRadius &)param).radius_,
+                    indices, distance2);
+        case KDTreeSearchParam::SearchType::Hybrid:
+            return SearchHybrid(
+                    query, ((const KDTreeSearchParamHybrid &)param).radius_,
+                    ((const KDTreeSearchParamHybrid &)param).max_nn_,
+                    indices, distance2);
+        default:
+            return -1;
+    }
+    return -1;
+}
+
+int DynamicKDTree::SearchKNN(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                             int knn,
+                             thrustcupoch::device_vector<int> &indices,
+                             thrustcupoch::device_vector<float> &distance2) const {
+    if (levels_.empty() || query.empty() || knn <= 0 || knn > NUM_MAX_NN) return -1;
+    indices.assign(query.size() * knn, -1);
+    distance2.assign(query.size() * knn, std::numeric_limits<float>::infinity());
+    for (const auto &level : levels_) {
+        if (SearchKNNInLevel(*level, query, knn, indices, distance2) < 0) return -1;
+    }
+    return thrust::count_if(indices.begin(), indices.end(), is_valid_index_functor());
+}
+
+int DynamicKDTree::SearchRadius(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                                float radius,
+                                thrustcupoch::device_vector<int> &indices,
+                                thrustcupoch::device_vector<float> &distance2) const {
+    return SearchHybrid(query, radius, NUM_MAX_NN, indices, distance2);
+}
+
+int DynamicKDTree::SearchHybrid(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                                float radius,
+                                int max_nn,
+                                thrustcupoch::device_vector<int> &indices,
+                                thrustcupoch::device_vector<float> &distance2) const {
+    if (levels_.empty() || query.empty() || max_nn <= 0 || max_nn > NUM_MAX_NN) return -1;
+    indices.assign(query.size() * max_nn, -1);
+    distance2.assign(query.size() * max_nn, std::numeric_limits<float>::infinity());
+    for (const auto &level : levels_) {
+        if (SearchHybridInLevel(*level, query, radius, max_nn, indices, distance2) < 0) {
+            return -1;
+        }
+    }
+    return thrust::count_if(indices.begin(), indices.end(), is_valid_index_functor());
+}
+
+int DynamicKDTree::Search(const Eigen::Vector3f &query,
+                          const KDTreeSearchParam &param,
+                          thrust::host_vector<int> &indices,
+                          thrust::host_vector<float> &distance2) const {
+    thrustcupoch::device_vector<Eigen::Vector3f> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
+    auto result = Search(query_dv, param, indices_dv, distance2_dv);
+    indices = indices_dv;
+    distance2 = distance2_dv;
+    return result;
+}
+
+int DynamicKDTree::SearchKNN(const Eigen::Vector3f &query,
+                             int knn,
+                             thrust::host_vector<int> &indices,
+                             thrust::host_vector<float> &distance2) const {
+    return Search(query, KDTreeSearchParamKNN(knn), indices, distance2);
+}
+
+int DynamicKDTree::SearchRadius(const Eigen::Vector3f &query,
+                                float radius,
+                                thrust::host_vector<int> &indices,
+                                thrust::host_vector<float> &distance2) const {
+    return Search(query, KDTreeSearchParamRadius(radius), indices, distance2);
+}
+
+int DynamicKDTree::SearchHybrid(const Eigen::Vector3f &query,
+                                float radius,
+                                int max_nn,
+                                thrust::host_vector<int> &indices,
+                                thrust::host_vector<float> &distance2) const {
+    return Search(query, KDTreeSearchParamHybrid(radius, max_nn), indices, distance2);
+}
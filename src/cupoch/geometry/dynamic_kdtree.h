@@ -0,0 +1,141 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <memory>
+#include <vector>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/utility/thrust_cupoch.h"
+#include <thrust/host_vector.h>
+
+namespace cupoch {
+namespace geometry {
+
+class AxisAlignedBoundingBox;
+
+/// \class DynamicKDTree
+///
+/// \brief KD-tree index supporting incremental insertion and deletion.
+///
+/// The points are kept in a log-structured forest of static KDTreeFlann
+/// trees (levels). An inserted batch becomes a new level and is merged with
+/// the smaller levels, so that the levels have geometrically decreasing
+/// sizes and every point is rebuilt O(log n) times over its lifetime.
+/// Deleted points are marked in their level and skipped by the searches;
+/// a level is rebuilt from its remaining points once more than half of them
+/// are deleted.
+///
+/// Every inserted point gets a stable id, the position of the point in the
+/// sequence of all the inserted points. The searches return these ids in the
+/// same layout as KDTreeFlann.
+class DynamicKDTree {
+public:
+    DynamicKDTree();
+    ~DynamicKDTree();
+    DynamicKDTree(const DynamicKDTree &) = delete;
+    DynamicKDTree &operator=(const DynamicKDTree &) = delete;
+
+public:
+    /// Inserts \param points. Returns the id of the first point; the ids of
+    /// the batch are consecutive.
+    int Insert(const thrustcupoch::device_vector<Eigen::Vector3f> &points);
+
+    /// Deletes the points with the given ids. Unknown or already deleted ids
+    /// are ignored. Returns the number of deleted points.
+    size_t DeleteByIndex(const thrustcupoch::device_vector<int> &ids);
+
+    /// Deletes the points inside \param box. Returns the number of deleted
+    /// points.
+    size_t DeleteInBoundingBox(const AxisAlignedBoundingBox &box);
+
+    /// Merges all the levels into a single tree without deleted points.
+    void Rebuild();
+
+    void Clear();
+
+    /// Copies the remaining points and their ids, sorted by id.
+    void ExtractPoints(thrustcupoch::device_vector<Eigen::Vector3f> &points,
+                       thrustcupoch::device_vector<int> &ids) const;
+
+    size_t GetNumPoints() const;
+    size_t GetNumLevels() const { return levels_.size(); }
+    bool IsEmpty() const { return GetNumPoints() == 0; }
+
+    /// The searches return the total number of neighbors found, or -1 on
+    /// failure.
+    int Search(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+               const KDTreeSearchParam &param,
+               thrustcupoch::device_vector<int> &indices,
+               thrustcupoch::device_vector<float> &distance2) const;
+
+    int SearchKNN(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                  int knn,
+                  thrustcupoch::device_vector<int> &indices,
+                  thrustcupoch::device_vector<float> &distance2) const;
+
+    int SearchRadius(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                     float radius,
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
+
+    int SearchHybrid(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                     float radius,
+                     int max_nn,
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
+
+    int Search(const Eigen::Vector3f &query,
+               const KDTreeSearchParam &param,
+               thrust::host_vector<int> &indices,
+               thrust::host_vector<float> &distance2) const;
+
+    int SearchKNN(const Eigen::Vector3f &query,
+                  int knn,
+                  thrust::host_vector<int> &indices,
+                  thrust::host_vector<float> &distance2) const;
+
+    int SearchRadius(const Eigen::Vector3f &query,
+                     float radius,
+                     thrust::host_vector<int> &indices,
+                     thrust::host_vector<float> &distance2) const;
+
+    int SearchHybrid(const Eigen::Vector3f &query,
+                     float radius,
+                     int max_nn,
+                     thrust::host_vector<int> &indices,
+                     thrust::host_vector<float> &distance2) const;
+
+protected:
+    struct Level;
+
+    /// Builds a level from points sorted by id.
+    std::unique_ptr<Level> MakeLevel(
+            thrustcupoch::device_vector<Eigen::Vector3f> &points,
+            thrustcupoch::device_vector<int> &ids) const;
+    /// Appends the remaining points of \param level to \param points.
+    void AppendAlivePoints(const Level &level,
+                           thrustcupoch::device_vector<Eigen::Vector3f> &points,
+                           thrustcupoch::device_vector<int> &ids) const;
+    /// Rebuilds the levels with too many deleted points.
+    void CompactLevels();
+
+    int SearchKNNInLevel(const Level &level,
+                         const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                         int knn,
+                         thrustcupoch::device_vector<int> &indices,
+                         thrustcupoch::device_vector<float> &distance2) const;
+
+    int SearchHybridInLevel(const Level &level,
+                            const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                            float radius,
+                            int max_nn,
+                            thrustcupoch::device_vector<int> &indices,
+                            thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Levels sorted by decreasing size.
+    std::vector<std::unique_ptr<Level>> levels_;
+    int next_id_ = 0;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -1,14 +1,24 @@
 #include <Eigen/Geometry>
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/organized_pointcloud.h"
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/union_find.h"
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/sequence.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <limits>
 
 using namespace cupoch;
 using namespace cupoch::geometry;
 
 namespace {
 
-__device__
+__host__ __device__
 Eigen::Vector3f ComputeEigenvector0(const Eigen::Matrix3f &A, float eval0) {
     Eigen::Vector3f row0(A(0, 0) - eval0, A(0, 1), A(0, 2));
     Eigen::Vector3f row1(A(0, 1), A(1, 1) - eval0, A(1, 2));
@@ -39,7 +49,7 @@ Eigen::Vector3f ComputeEigenvector0(const Eigen::Matrix3f &A, float eval0) {
     }
 }
     
-__device__
+__host__ __device__
 Eigen::Vector3f ComputeEigenvector1(const Eigen::Matrix3f &A,
                                     const Eigen::Vector3f &evec0,
                                     float eval1) {
@@ -106,8 +116,10 @@ Eigen::Vector3f ComputeEigenvector1(const Eigen::Matrix3f &A,
     }
 }
 
-__device__
-Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
+// Returns the eigenvector of the smallest eigenvalue and writes the
+// eigenvalues in ascending order to \param evals.
+__host__ __device__
+Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A, Eigen::Vector3f &evals) {
     // Previous version based on:
     // https://en.wikipedia.org/wiki/Eigenvalue_algorithm#3.C3.973_matrices
     // Current version based on
@@ -116,6 +128,7 @@ Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
 
     float max_coeff = A.maxCoeff();
     if (max_coeff == 0) {
+        evals = Eigen::Vector3f::Zero();
         return Eigen::Vector3f::Zero();
     }
     A /= max_coeff;
@@ -153,6 +166,7 @@ Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
         eval(0) = q + p * beta0;
         eval(1) = q + p * beta1;
         eval(2) = q + p * beta2;
+        evals = eval * max_coeff;
 
         if (half_det >= 0) {
             evec2 = ComputeEigenvector0(A, eval(2));
@@ -183,6 +197,10 @@ Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
         }
     } else {
         A *= max_coeff;
+        const float d0 = A(0, 0), d1 = A(1, 1), d2 = A(2, 2);
+        evals(0) = min(min(d0, d1), d2);
+        evals(2) = max(max(d0, d1), d2);
+        evals(1) = d0 + d1 + d2 - evals(0) - evals(2);
         if (A(0, 0) < A(1, 1) && A(0, 0) < A(2, 2)) {
             return Eigen::Vector3f(1, 0, 0);
         } else if (A(1, 1) < A(0, 0) && A(1, 1) < A(2, 2)) {
@@ -193,7 +211,13 @@ Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
     }
 }
 
-__device__
+__host__ __device__
+Eigen::Vector3f FastEigen3x3(Eigen::Matrix3f &A) {
+    Eigen::Vector3f evals;
+    return FastEigen3x3(A, evals);
+}
+
+__host__ __device__
 Eigen::Vector3f ComputeNormal(const Eigen::Vector3f* points,
                                 const KNNIndices &indices, int knn) {
     if (indices[0] < 0) return Eigen::Vector3f(0.0, 0.0, 1.0);
@@ -238,7 +262,7 @@ struct compute_normal_functor {
     const Eigen::Vector3f* points_;
     const int* indices_;
     const int knn_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator()(const int& idx) const {
         KNNIndices idxs = KNNIndices::Constant(-1);
         for (int k = 0; k < knn_; ++k) idxs[k] = indices_[idx * knn_ + k];
@@ -250,11 +274,227 @@ struct compute_normal_functor {
     }
 };
 
+// Normal and shape features of a point from the covariance of its
+// neighbors accumulated by the search.
+struct compute_normal_from_covariance_functor {
+    compute_normal_from_covariance_functor(const Eigen::Matrix3f* covariances,
+                                           const int* counts,
+                                           Eigen::Vector3f* features)
+        : covariances_(covariances), counts_(counts), features_(features) {};
+    const Eigen::Matrix3f* covariances_;
+    const int* counts_;
+    Eigen::Vector3f* features_;
+    __host__ __device__
+    Eigen::Vector3f operator()(size_t idx) const {
+        if (counts_[idx] < 3) {
+            if (features_) features_[idx] = Eigen::Vector3f::Zero();
+            return Eigen::Vector3f(0.0, 0.0, 1.0);
+        }
+        Eigen::Matrix3f covariance = covariances_[idx];
+        Eigen::Vector3f evals;
+        Eigen::Vector3f normal = FastEigen3x3(covariance, evals);
+        if (normal.norm() == 0.0) {
+            normal = Eigen::Vector3f(0.0, 0.0, 1.0);
+        }
+        if (features_) {
+            // l0 >= l1 >= l2
+            const float l0 = max(evals(2), 0.0f);
+            const float l1 = max(evals(1), 0.0f);
+            const float l2 = max(evals(0), 0.0f);
+            const float sum = l0 + l1 + l2;
+            features_[idx] = (l0 > 0.0) ? Eigen::Vector3f(l2 / sum, (l0 - l1) / l0, (l1 - l2) / l0)
+                                        : Eigen::Vector3f::Zero();
+        }
+        return normal;
+    }
+};
+
+// Plane covariance U diag(1, 1, epsilon) U^T of the neighbor covariance,
+// written as I - (1 - epsilon) n n^T with n the smallest eigenvector.
+struct regularize_covariance_functor {
+    regularize_covariance_functor(float epsilon) : epsilon_(epsilon) {};
+    const float epsilon_;
+    __host__ __device__
+    Eigen::Matrix3f operator()(const thrust::tuple<Eigen::Matrix3f, int>& x) const {
+        if (thrust::get<1>(x) < 3) return Eigen::Matrix3f::Identity();
+        Eigen::Matrix3f covariance = thrust::get<0>(x);
+        const Eigen::Vector3f normal = FastEigen3x3(covariance);
+        if (normal.norm() == 0.0) return Eigen::Matrix3f::Identity();
+        return Eigen::Matrix3f::Identity() - (1.0 - epsilon_) * normal * normal.transpose();
+    }
+};
+
+struct organized_normal_functor {
+    organized_normal_functor(const Eigen::Vector3f* points, const uint8_t* mask,
+                             int width, int height, int window_radius,
+                             const Eigen::Vector3f& viewpoint)
+        : points_(points), mask_(mask), width_(width), height_(height),
+          window_radius_(window_radius), viewpoint_(viewpoint) {};
+    const Eigen::Vector3f* points_;
+    const uint8_t* mask_;
+    const int width_;
+    const int height_;
+    const int window_radius_;
+    const Eigen::Vector3f viewpoint_;
+    __host__ __device__
+    Eigen::Vector3f Orient(const Eigen::Vector3f& normal, size_t idx) const {
+        if (normal.norm() == 0.0) return Eigen::Vector3f(0.0, 0.0, 1.0);
+        const Eigen::Vector3f nl = normal.normalized();
+        return (nl.dot(viewpoint_ - points_[idx]) < 0.0) ? Eigen::Vector3f(-nl) : nl;
+    }
+};
+
+struct cross_product_normal_functor : public organized_normal_functor {
+    cross_product_normal_functor(const Eigen::Vector3f* points, const uint8_t* mask,
+                                 int width, int height, int window_radius,
+                                 float max_distance2, const Eigen::Vector3f& viewpoint)
+        : organized_normal_functor(points, mask, width, height, window_radius, viewpoint),
+          max_distance2_(max_distance2) {};
+    const float max_distance2_;
+    __host__ __device__
+    bool GetNeighbor(int row, int col, const Eigen::Vector3f& pt,
+                     Eigen::Vector3f& neighbor) const {
+        if (row < 0 || row >= height_ || col < 0 || col >= width_) return false;
+        const int j = row * width_ + col;
+        if (!mask_[j]) return false;
+        neighbor = points_[j];
+        return max_distance2_ <= 0.0 || (neighbor - pt).squaredNorm() <= max_distance2_;
+    }
+    // Central difference between the pixels (row0, col0) and (row1, col1),
+    // one-sided if only one of them is usable.
+    __host__ __device__
+    bool GetTangent(int row0, int col0, int row1, int col1,
+                    const Eigen::Vector3f& pt, Eigen::Vector3f& tangent) const {
+        Eigen::Vector3f p0, p1;
+        const bool valid0 = GetNeighbor(row0, col0, pt, p0);
+        const bool valid1 = GetNeighbor(row1, col1, pt, p1);
+        if (valid0 && valid1) {
+            tangent = p1 - p0;
+        } else if (valid1) {
+            tangent = p1 - pt;
+        } else if (valid0) {
+            tangent = pt - p0;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    __host__ __device__
+    Eigen::Vector3f operator()(size_t idx) const {
+        if (!mask_[idx]) return Eigen::Vector3f::Zero();
+        const int row = idx / width_;
+        const int col = idx % width_;
+        const Eigen::Vector3f& pt = points_[idx];
+        Eigen::Vector3f dx, dy;
+        if (!GetTangent(row, col - window_radius_, row, col + window_radius_, pt, dx) ||
+            !GetTangent(row - window_radius_, col, row + window_radius_, col, pt, dy)) {
+            return Eigen::Vector3f(0.0, 0.0, 1.0);
+        }
+        return Orient(dx.cross(dy), idx);
+    }
+};
+
+// Count, first and second moments of a point. Accumulated in double
+// because the integral image sums over the whole image.
+typedef Eigen::Matrix<double, 10, 1> Vector10d;
+
+struct integral_element_functor {
+    integral_element_functor(const Eigen::Vector3f* points, const uint8_t* mask,
+                             int width, const Eigen::Vector3f& origin)
+        : points_(points), mask_(mask), width_(width), origin_(origin) {};
+    const Eigen::Vector3f* points_;
+    const uint8_t* mask_;
+    const int width_;
+    const Eigen::Vector3f origin_;
+    __host__ __device__
+    Vector10d operator()(size_t k) const {
+        // the first row and column of the integral image are zero
+        const int row = k / (width_ + 1);
+        const int col = k % (width_ + 1);
+        Vector10d elem = Vector10d::Zero();
+        if (row == 0 || col == 0) return elem;
+        const int idx = (row - 1) * width_ + col - 1;
+        if (!mask_[idx]) return elem;
+        const Eigen::Vector3d p = (points_[idx] - origin_).cast<double>();
+        elem << 1.0, p(0), p(1), p(2), p(0) * p(0), p(0) * p(1), p(0) * p(2),
+                p(1) * p(1), p(1) * p(2), p(2) * p(2);
+        return elem;
+    }
+};
+
+struct divide_index_functor {
+    divide_index_functor(size_t divisor) : divisor_(divisor) {};
+    const size_t divisor_;
+    __host__ __device__
+    size_t operator()(size_t k) const {
+        return k / divisor_;
+    }
+};
+
+// Maps the k-th element of the column-major order to its row-major index.
+struct transpose_index_functor {
+    transpose_index_functor(size_t rows, size_t cols) : rows_(rows), cols_(cols) {};
+    const size_t rows_;
+    const size_t cols_;
+    __host__ __device__
+    size_t operator()(size_t k) const {
+        return (k % rows_) * cols_ + k / rows_;
+    }
+};
+
+struct masked_point_functor {
+    __host__ __device__
+    Eigen::Vector4f operator()(const thrust::tuple<Eigen::Vector3f, uint8_t>& x) const {
+        if (!thrust::get<1>(x)) return Eigen::Vector4f::Zero();
+        const Eigen::Vector3f& pt = thrust::get<0>(x);
+        return Eigen::Vector4f(pt(0), pt(1), pt(2), 1.0);
+    }
+};
+
+struct integral_image_normal_functor : public organized_normal_functor {
+    integral_image_normal_functor(const Vector10d* integral,
+                                  const Eigen::Vector3f* points, const uint8_t* mask,
+                                  int width, int height, int window_radius,
+                                  const Eigen::Vector3f& viewpoint)
+        : organized_normal_functor(points, mask, width, height, window_radius, viewpoint),
+          integral_(integral) {};
+    const Vector10d* integral_;
+    __host__ __device__
+    const Vector10d& At(int row, int col) const {
+        return integral_[row * (width_ + 1) + col];
+    }
+    __host__ __device__
+    Eigen::Vector3f operator()(size_t idx) const {
+        if (!mask_[idx]) return Eigen::Vector3f::Zero();
+        const int row = idx / width_;
+        const int col = idx % width_;
+        const int r0 = max(row - window_radius_, 0);
+        const int r1 = min(row + window_radius_, height_ - 1) + 1;
+        const int c0 = max(col - window_radius_, 0);
+        const int c1 = min(col + window_radius_, width_ - 1) + 1;
+        const Vector10d sum = At(r1, c1) - At(r0, c1) - At(r1, c0) + At(r0, c0);
+        const double n = sum(0);
+        if (n < 3.0) return Eigen::Vector3f(0.0, 0.0, 1.0);
+        const Eigen::Vector3d mean(sum(1) / n, sum(2) / n, sum(3) / n);
+        Eigen::Matrix3f covariance;
+        covariance(0, 0) = sum(4) / n - mean(0) * mean(0);
+        covariance(0, 1) = sum(5) / n - mean(0) * mean(1);
+        covariance(0, 2) = sum(6) / n - mean(0) * mean(2);
+        covariance(1, 1) = sum(7) / n - mean(1) * mean(1);
+        covariance(1, 2) = sum(8) / n - mean(1) * mean(2);
+        covariance(2, 2) = sum(9) / n - mean(2) * mean(2);
+        covariance(1, 0) = covariance(0, 1);
+        covariance(2, 0) = covariance(0, 2);
+        covariance(2, 1) = covariance(1, 2);
+        return Orient(FastEigen3x3(covariance), idx);
+    }
+};
+
 struct align_normals_direction_functor {
     align_normals_direction_functor(const Eigen::Vector3f& orientation_reference)
         : orientation_reference_(orientation_reference) {};
     const Eigen::Vector3f orientation_reference_;
-    __device__
+    __host__ __device__
     void operator()(Eigen::Vector3f& normal) const {
         if (normal.norm() == 0.0) {
             normal = orientation_reference_;
@@ -264,40 +504,238 @@ struct align_normals_direction_functor {
     }
 };
 
+struct orient_towards_camera_functor {
+    orient_towards_camera_functor(const Eigen::Vector3f& camera_location)
+        : camera_location_(camera_location) {};
+    const Eigen::Vector3f camera_location_;
+    __host__ __device__
+    Eigen::Vector3f operator()(const Eigen::Vector3f& point,
+                               const Eigen::Vector3f& normal) const {
+        const Eigen::Vector3f reference = camera_location_ - point;
+        if (normal.norm() == 0.0) {
+            const float norm = reference.norm();
+            return (norm > 0.0) ? Eigen::Vector3f(reference / norm)
+                                : Eigen::Vector3f(0.0, 0.0, 1.0);
+        }
+        return (normal.dot(reference) < 0.0) ? Eigen::Vector3f(-normal) : normal;
+    }
+};
+
+struct compress_path_functor {
+    compress_path_functor(int* parents) : parents_(parents) {};
+    int* parents_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        parents_[idx] = utility::FindRoot(parents_, idx);
+    }
+};
+
+// Edge e of the kNN graph links the point e / knn to its neighbor indices[e].
+// Edges within a component or to missing neighbors are skipped. The kNN
+// relation is not symmetric, so every edge bids for the components of both
+// of its ends; otherwise an edge listed only by u would be invisible to the
+// component of v and the forest would not be minimum.
+struct riemannian_edge_functor {
+    riemannian_edge_functor(const Eigen::Vector3f* normals, const int* indices,
+                            int knn, const int* parents)
+        : normals_(normals), indices_(indices), knn_(knn), parents_(parents) {};
+    const Eigen::Vector3f* normals_;
+    const int* indices_;
+    const int knn_;
+    const int* parents_;
+    __host__ __device__
+    bool GetEdge(size_t e, int& u, int& v) const {
+        u = e / knn_;
+        v = indices_[e];
+        return v >= 0 && parents_[u] != parents_[v];
+    }
+    // Riemannian weight 1 - |n_u . n_v|, quantized so that equal weights
+    // compare equal from both ends.
+    __host__ __device__
+    unsigned int Weight(int u, int v) const {
+        const float w = 1.0 - std::abs(normals_[u].dot(normals_[v]));
+        return (unsigned int)(min(max(w, 0.0f), 1.0f) * 2147483647.0f);
+    }
+    // Canonical key of the undirected edge, to break the weight ties
+    // the same way in every component.
+    __host__ __device__
+    unsigned long long Key(int u, int v) const {
+        return ((unsigned long long)min(u, v) << 32) | (unsigned long long)max(u, v);
+    }
+};
+
+struct min_edge_weight_functor : public riemannian_edge_functor {
+    min_edge_weight_functor(const Eigen::Vector3f* normals, const int* indices,
+                            int knn, const int* parents, unsigned int* min_weights)
+        : riemannian_edge_functor(normals, indices, knn, parents),
+          min_weights_(min_weights) {};
+    unsigned int* min_weights_;
+    __host__ __device__
+    void operator() (size_t e) const {
+        int u, v;
+        if (!GetEdge(e, u, v)) return;
+        const unsigned int w = Weight(u, v);
+        utility::AtomicMin(min_weights_ + parents_[u], w);
+        utility::AtomicMin(min_weights_ + parents_[v], w);
+    }
+};
+
+struct min_edge_key_functor : public riemannian_edge_functor {
+    min_edge_key_functor(const Eigen::Vector3f* normals, const int* indices,
+                         int knn, const int* parents,
+                         const unsigned int* min_weights,
+                         unsigned long long* min_keys)
+        : riemannian_edge_functor(normals, indices, knn, parents),
+          min_weights_(min_weights), min_keys_(min_keys) {};
+    const unsigned int* min_weights_;
+    unsigned long long* min_keys_;
+    __host__ __device__
+    void operator() (size_t e) const {
+        int u, v;
+        if (!GetEdge(e, u, v)) return;
+        const unsigned int w = Weight(u, v);
+        const unsigned long long key = Key(u, v);
+        if (w == min_weights_[parents_[u]]) utility::AtomicMin(min_keys_ + parents_[u], key);
+        if (w == min_weights_[parents_[v]]) utility::AtomicMin(min_keys_ + parents_[v], key);
+    }
+};
+
+// Adds the lightest edge of the component to the spanning tree. An edge
+// chosen by both of its components is only added by the first union.
+struct add_min_edge_functor {
+    add_min_edge_functor(const unsigned long long* min_keys, int* parents,
+                         Eigen::Vector2i* edges, int* n_edges)
+        : min_keys_(min_keys), parents_(parents), edges_(edges), n_edges_(n_edges) {};
+    const unsigned long long* min_keys_;
+    int* parents_;
+    Eigen::Vector2i* edges_;
+    int* n_edges_;
+    __host__ __device__
+    void operator() (size_t c) const {
+        const unsigned long long key = min_keys_[c];
+        if (key == std::numeric_limits<unsigned long long>::max()) return;
+        const int u = int(key >> 32);
+        const int v = int(key & 0xffffffffull);
+        if (utility::UnionRoots(parents_, u, v)) {
+            edges_[utility::AtomicAdd(n_edges_, 1)] = Eigen::Vector2i(u, v);
+        }
+    }
+};
+
+struct split_tree_edge_functor {
+    split_tree_edge_functor(const Eigen::Vector2i* edges, int* src, int* dst)
+        : edges_(edges), src_(src), dst_(dst) {};
+    const Eigen::Vector2i* edges_;
+    int* src_;
+    int* dst_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        const Eigen::Vector2i& e = edges_[idx];
+        src_[2 * idx] = e[0];
+        dst_[2 * idx] = e[1];
+        src_[2 * idx + 1] = e[1];
+        dst_[2 * idx + 1] = e[0];
+    }
+};
+
+struct is_root_functor {
+    is_root_functor(const int* parents) : parents_(parents) {};
+    const int* parents_;
+    __host__ __device__
+    bool operator() (int idx) const {
+        return parents_[idx] == idx;
+    }
+};
+
+// Visits the children of a frontier point of the tree and orients their
+// normals like the already oriented normal of the point. Every child has a
+// single parent, so no two threads write the same child.
+struct propagate_orientation_functor {
+    propagate_orientation_functor(const int* offsets, const int* dst,
+                                  int* visited, Eigen::Vector3f* normals,
+                                  int* next, int* n_next)
+        : offsets_(offsets), dst_(dst), visited_(visited), normals_(normals),
+          next_(next), n_next_(n_next) {};
+    const int* offsets_;
+    const int* dst_;
+    int* visited_;
+    Eigen::Vector3f* normals_;
+    int* next_;
+    int* n_next_;
+    __host__ __device__
+    void operator() (int u) const {
+        for (int k = offsets_[u]; k < offsets_[u + 1]; ++k) {
+            const int v = dst_[k];
+            if (visited_[v]) continue;
+            visited_[v] = 1;
+            if (normals_[u].dot(normals_[v]) < 0.0) normals_[v] *= -1.0;
+            next_[utility::AtomicAdd(n_next_, 1)] = v;
+        }
+    }
+};
+
 }
 
 bool PointCloud::EstimateNormals(const KDTreeSearchParam &search_param) {
     if (HasNormals() == false) {
         normals_.resize(points_.size());
     }
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(*this);
-    thrust::device_vector<int> indices;
-    thrust::device_vector<float> distance2;
-    kdtree.Search(points_, search_param, indices, distance2);
-    int knn;
-    switch(search_param.GetSearchType()) {
-        case KDTreeSearchParam::SearchType::Knn:
-            knn = ((const KDTreeSearchParamKNN &)search_param).knn_;
-            break;
-        case KDTreeSearchParam::SearchType::Radius:
-            knn = NUM_MAX_NN;
-            break;
-        case KDTreeSearchParam::SearchType::Hybrid:
-            knn = ((const KDTreeSearchParamHybrid &)search_param).max_nn_;
-            break;
-        default:
-            utility::LogError("Unknown search param type.");
-            return false;
-    }
+    auto neighbors = SearchNeighbors(search_param);
+    if (neighbors->knn_ == 0) return false;
     compute_normal_functor func(thrust::raw_pointer_cast(points_.data()),
-                                thrust::raw_pointer_cast(indices.data()),
-                                knn);
+                                thrust::raw_pointer_cast(neighbors->indices_.data()),
+                                neighbors->knn_);
     thrust::transform(thrust::make_counting_iterator(0), thrust::make_counting_iterator((int)points_.size()),
                       normals_.begin(), func);
     return true;
 }
 
+bool PointCloud::EstimateNormalsFused(const KDTreeSearchParam &search_param) {
+    return EstimateNormalsFused(search_param, nullptr);
+}
+
+bool PointCloud::EstimateNormalsFused(const KDTreeSearchParam &search_param,
+                                      thrustcupoch::device_vector<Eigen::Vector3f> &features) {
+    features.resize(points_.size());
+    return EstimateNormalsFused(search_param, &features);
+}
+
+bool PointCloud::EstimateNormalsFused(const KDTreeSearchParam &search_param,
+                                      thrustcupoch::device_vector<Eigen::Vector3f> *features) {
+    thrustcupoch::device_vector<Eigen::Matrix3f> covariances;
+    thrustcupoch::device_vector<int> counts;
+    if (GetKDTree()->SearchCovariance(points_, search_param, covariances, counts) < 0) {
+        utility::LogWarning("[EstimateNormalsFused] Invalid search parameter.");
+        return false;
+    }
+    if (HasNormals() == false) {
+        normals_.resize(points_.size());
+    }
+    compute_normal_from_covariance_functor func(
+            thrust::raw_pointer_cast(covariances.data()),
+            thrust::raw_pointer_cast(counts.data()),
+            (features) ? thrust::raw_pointer_cast(features->data()) : nullptr);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(points_.size()),
+                      normals_.begin(), func);
+    return true;
+}
+
+bool PointCloud::EstimateCovariances(const KDTreeSearchParam &search_param,
+                                     float epsilon) {
+    thrustcupoch::device_vector<Eigen::Matrix3f> covariances;
+    thrustcupoch::device_vector<int> counts;
+    if (GetKDTree()->SearchCovariance(points_, search_param, covariances, counts) < 0) {
+        utility::LogWarning("[EstimateCovariances] Invalid search parameter.");
+        return false;
+    }
+    thrust::transform(make_tuple_iterator(covariances.begin(), counts.begin()),
+                      make_tuple_iterator(covariances.end(), counts.end()),
+                      covariances.begin(), regularize_covariance_functor(epsilon));
+    covariances_.swap(covariances);
+    return true;
+}
+
 bool PointCloud::OrientNormalsToAlignWithDirection(const Eigen::Vector3f &orientation_reference) {
     if (HasNormals() == false) {
         utility::LogWarning(
@@ -309,3 +747,178 @@ bool PointCloud::OrientNormalsToAlignWithDirection(const Eigen::Vector3f &orient
     thrust::for_each(normals_.begin(), normals_.end(), func);
     return true;
 }
+
+bool PointCloud::OrientNormalsTowardsCameraLocation(const Eigen::Vector3f &camera_location) {
+    if (HasNormals() == false) {
+        utility::LogWarning(
+                "[OrientNormalsTowardsCameraLocation] No normals in the "
+                "PointCloud. Call EstimateNormals() first.\n");
+        return false;
+    }
+    thrust::transform(points_.begin(), points_.end(), normals_.begin(),
+                      normals_.begin(), orient_towards_camera_functor(camera_location));
+    return true;
+}
+
+bool PointCloud::OrientNormalsConsistentTangentPlane(size_t k) {
+    if (HasNormals() == false) {
+        utility::LogWarning(
+                "[OrientNormalsConsistentTangentPlane] No normals in the "
+                "PointCloud. Call EstimateNormals() first.\n");
+        return false;
+    }
+    const size_t n_pt = points_.size();
+    auto neighbors = SearchNeighbors(KDTreeSearchParamKNN(k));
+    const int knn = neighbors->knn_;
+    if (knn == 0) return false;
+    const Eigen::Vector3f* normals_ptr = thrust::raw_pointer_cast(normals_.data());
+    const int* indices_ptr = thrust::raw_pointer_cast(neighbors->indices_.data());
+
+    // minimum spanning forest of the Riemannian graph with Boruvka's
+    // algorithm, all the components pick their lightest edge at once
+    thrustcupoch::device_vector<int> parents(n_pt);
+    thrust::sequence(parents.begin(), parents.end());
+    thrustcupoch::device_vector<unsigned int> min_weights(n_pt);
+    thrustcupoch::device_vector<unsigned long long> min_keys(n_pt);
+    thrustcupoch::device_vector<Eigen::Vector2i> tree_edges(n_pt);
+    thrustcupoch::device_vector<int> n_edges(1, 0);
+    int* parents_ptr = thrust::raw_pointer_cast(parents.data());
+    int n_tree_edges = 0;
+    while (true) {
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt),
+                         compress_path_functor(parents_ptr));
+        thrust::fill(min_weights.begin(), min_weights.end(),
+                     std::numeric_limits<unsigned int>::max());
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt * knn),
+                         min_edge_weight_functor(normals_ptr, indices_ptr, knn, parents_ptr,
+                                                 thrust::raw_pointer_cast(min_weights.data())));
+        thrust::fill(min_keys.begin(), min_keys.end(),
+                     std::numeric_limits<unsigned long long>::max());
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt * knn),
+                         min_edge_key_functor(normals_ptr, indices_ptr, knn, parents_ptr,
+                                              thrust::raw_pointer_cast(min_weights.data()),
+                                              thrust::raw_pointer_cast(min_keys.data())));
+        thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                         thrust::make_counting_iterator(n_pt),
+                         add_min_edge_functor(thrust::raw_pointer_cast(min_keys.data()),
+                                              parents_ptr,
+                                              thrust::raw_pointer_cast(tree_edges.data()),
+                                              thrust::raw_pointer_cast(n_edges.data())));
+        const int n_total = n_edges[0];
+        if (n_total == n_tree_edges) break;
+        n_tree_edges = n_total;
+    }
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_pt),
+                     compress_path_functor(parents_ptr));
+
+    // adjacency of the forest in CSR form
+    thrustcupoch::device_vector<int> src(2 * n_tree_edges);
+    thrustcupoch::device_vector<int> dst(2 * n_tree_edges);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator<size_t>(n_tree_edges),
+                     split_tree_edge_functor(thrust::raw_pointer_cast(tree_edges.data()),
+                                             thrust::raw_pointer_cast(src.data()),
+                                             thrust::raw_pointer_cast(dst.data())));
+    thrust::sort_by_key(src.begin(), src.end(), dst.begin());
+    thrustcupoch::device_vector<int> offsets(n_pt + 1);
+    thrust::lower_bound(src.begin(), src.end(),
+                        thrust::make_counting_iterator(0),
+                        thrust::make_counting_iterator<int>(n_pt + 1),
+                        offsets.begin());
+
+    // propagate the orientation of the roots level by level
+    thrustcupoch::device_vector<int> visited(n_pt, 0);
+    thrustcupoch::device_vector<int> frontier(n_pt);
+    thrustcupoch::device_vector<int> next(n_pt);
+    auto end = thrust::copy_if(thrust::make_counting_iterator(0),
+                               thrust::make_counting_iterator<int>(n_pt),
+                               frontier.begin(), is_root_functor(parents_ptr));
+    int n_frontier = thrust::distance(frontier.begin(), end);
+    thrust::fill(thrust::make_permutation_iterator(visited.begin(), frontier.begin()),
+                 thrust::make_permutation_iterator(visited.begin(), frontier.begin() + n_frontier),
+                 1);
+    thrustcupoch::device_vector<int> n_next(1);
+    while (n_frontier > 0) {
+        n_next[0] = 0;
+        thrust::for_each(frontier.begin(), frontier.begin() + n_frontier,
+                         propagate_orientation_functor(
+                                 thrust::raw_pointer_cast(offsets.data()),
+                                 thrust::raw_pointer_cast(dst.data()),
+                                 thrust::raw_pointer_cast(visited.data()),
+                                 thrust::raw_pointer_cast(normals_.data()),
+                                 thrust::raw_pointer_cast(next.data()),
+                                 thrust::raw_pointer_cast(n_next.data())));
+        n_frontier = n_next[0];
+        frontier.swap(next);
+    }
+    return true;
+}
+
+bool OrganizedPointCloud::EstimateNormals(NormalMethod method,
+                                          int window_radius,
+                                          float max_distance) {
+    if (window_radius <= 0 || IsEmpty() || points_.size() != Size() ||
+        mask_.size() != Size()) {
+        utility::LogError("[OrganizedPointCloud::EstimateNormals] Invalid window radius or point cloud.");
+        return false;
+    }
+    normals_.resize(points_.size());
+    const Eigen::Vector3f* points_ptr = thrust::raw_pointer_cast(points_.data());
+    const uint8_t* mask_ptr = thrust::raw_pointer_cast(mask_.data());
+    if (method == NormalMethod::CrossProduct) {
+        cross_product_normal_functor func(points_ptr, mask_ptr, width_, height_,
+                                          window_radius, max_distance * max_distance,
+                                          viewpoint_);
+        thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                          thrust::make_counting_iterator(points_.size()),
+                          normals_.begin(), func);
+        return true;
+    }
+
+    // moments relative to the centroid to keep the sums small
+    const Eigen::Vector4f total = thrust::transform_reduce(
+            make_tuple_iterator(points_.begin(), mask_.begin()),
+            make_tuple_iterator(points_.end(), mask_.end()),
+            masked_point_functor(), Eigen::Vector4f(Eigen::Vector4f::Zero()),
+            thrust::plus<Eigen::Vector4f>());
+    if (total(3) == 0.0) {
+        thrust::fill(normals_.begin(), normals_.end(), Eigen::Vector3f::Zero());
+        return true;
+    }
+    const Eigen::Vector3f origin = total.head<3>() / total(3);
+
+    // integral image with a zero first row and column, scanned along the
+    // rows then along the columns
+    const size_t rows = height_ + 1;
+    const size_t cols = width_ + 1;
+    const size_t n_integral = rows * cols;
+    thrustcupoch::device_vector<Vector10d> integral(n_integral);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_integral),
+                      integral.begin(),
+                      integral_element_functor(points_ptr, mask_ptr, width_, origin));
+    auto row_keys = thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                                    divide_index_functor(cols));
+    thrust::inclusive_scan_by_key(row_keys, row_keys + n_integral,
+                                  integral.begin(), integral.begin());
+    auto col_keys = thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                                    divide_index_functor(rows));
+    auto col_major = thrust::make_permutation_iterator(
+            integral.begin(),
+            thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                            transpose_index_functor(rows, cols)));
+    thrust::inclusive_scan_by_key(col_keys, col_keys + n_integral,
+                                  col_major, col_major);
+
+    integral_image_normal_functor func(thrust::raw_pointer_cast(integral.data()),
+                                       points_ptr, mask_ptr, width_, height_,
+                                       window_radius, viewpoint_);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(points_.size()),
+                      normals_.begin(), func);
+    return true;
+}
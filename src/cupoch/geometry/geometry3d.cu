@@ -1,22 +1,27 @@
 #include "cupoch/geometry/geometry3d.h"
 #include <Eigen/Dense>
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/thrust_cupoch.h"
 
 using namespace cupoch;
 using namespace cupoch::geometry;
 
 namespace {
 
+template <int Dim>
 struct elementwise_min_functor {
-    __device__
-    Eigen::Vector3f operator()(const Eigen::Vector3f& a, const Eigen::Vector3f& b) {
+    __host__ __device__
+    Eigen::Matrix<float, Dim, 1> operator()(const Eigen::Matrix<float, Dim, 1>& a,
+                                            const Eigen::Matrix<float, Dim, 1>& b) {
         return a.array().min(b.array()).matrix();
     }
 };
-    
+
+template <int Dim>
 struct elementwise_max_functor {
-    __device__
-    Eigen::Vector3f operator()(const Eigen::Vector3f& a, const Eigen::Vector3f& b) {
+    __host__ __device__
+    Eigen::Matrix<float, Dim, 1> operator()(const Eigen::Matrix<float, Dim, 1>& a,
+                                            const Eigen::Matrix<float, Dim, 1>& b) {
         return a.array().max(b.array()).matrix();
     }
 };
@@ -24,54 +29,85 @@ struct elementwise_max_functor {
 struct transform_points_functor {
     transform_points_functor(const Eigen::Matrix4f& transform) : transform_(transform){};
     const Eigen::Matrix4f transform_;
-    __device__
+    __host__ __device__
     void operator()(Eigen::Vector3f& pt) {
         const Eigen::Vector4f new_pt = transform_ * Eigen::Vector4f(pt(0), pt(1), pt(2), 1.0);
         pt = new_pt.head<3>() / new_pt(3);
     }
+    __host__ __device__
+    void operator()(Eigen::Vector4f& pt) {
+        const Eigen::Vector4f new_pt = transform_ * Eigen::Vector4f(pt(0), pt(1), pt(2), 1.0);
+        pt = Eigen::Vector4f(new_pt(0) / new_pt(3), new_pt(1) / new_pt(3), new_pt(2) / new_pt(3), 0.0);
+    }
 };
 
 struct transform_normals_functor {
     transform_normals_functor(const Eigen::Matrix4f& transform) : transform_(transform){};
     const Eigen::Matrix4f transform_;
-    __device__
+    __host__ __device__
     void operator()(Eigen::Vector3f& nl) {
         const Eigen::Vector4f new_pt = transform_ * Eigen::Vector4f(nl(0), nl(1), nl(2), 0.0);
         nl = new_pt.head<3>();
     }
+    __host__ __device__
+    void operator()(Eigen::Vector4f& nl) {
+        const Eigen::Vector4f new_pt = transform_ * Eigen::Vector4f(nl(0), nl(1), nl(2), 0.0);
+        nl = Eigen::Vector4f(new_pt(0), new_pt(1), new_pt(2), 0.0);
+    }
 };
 }
 
 Geometry3D::Geometry3D(GeometryType type) : Geometry(type, 3) {}
 
-Eigen::Vector3f Geometry3D::ComputeMinBound(const thrust::device_vector<Eigen::Vector3f>& points) const {
+Eigen::Vector3f Geometry3D::ComputeMinBound(const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     return ComputeMinBound(0, points);
 }
 
-Eigen::Vector3f Geometry3D::ComputeMinBound(cudaStream_t stream, const thrust::device_vector<Eigen::Vector3f>& points) const {
+Eigen::Vector3f Geometry3D::ComputeMinBound(cudaStream_t stream, const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     if (points.empty()) return Eigen::Vector3f::Zero();
     Eigen::Vector3f init = points[0];
-    return thrust::reduce(thrust::cuda::par.on(stream), points.begin(), points.end(), init, elementwise_min_functor());
+    return thrust::reduce(exec_policy_on(stream), points.begin(), points.end(), init, elementwise_min_functor<3>());
 }
 
-Eigen::Vector3f Geometry3D::ComputeMaxBound(const thrust::device_vector<Eigen::Vector3f>& points) const {
+Eigen::Vector3f Geometry3D::ComputeMaxBound(const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     return ComputeMaxBound(0, points);
 }
 
-Eigen::Vector3f Geometry3D::ComputeMaxBound(cudaStream_t stream, const thrust::device_vector<Eigen::Vector3f>& points) const {
+Eigen::Vector3f Geometry3D::ComputeMaxBound(cudaStream_t stream, const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     if (points.empty()) return Eigen::Vector3f::Zero();
     Eigen::Vector3f init = points[0];
-    return thrust::reduce(thrust::cuda::par.on(stream), points.begin(), points.end(), init, elementwise_max_functor());
+    return thrust::reduce(exec_policy_on(stream), points.begin(), points.end(), init, elementwise_max_functor<3>());
 }
 
-Eigen::Vector3f Geometry3D::ComputeCenter(const thrust::device_vector<Eigen::Vector3f>& points) const {
+Eigen::Vector3f Geometry3D::ComputeCenter(const thrustcupoch::device_vector<Eigen::Vector3f>& points) const {
     Eigen::Vector3f init = Eigen::Vector3f::Zero();
     if (points.empty()) return init;
     Eigen::Vector3f sum = thrust::reduce(points.begin(), points.end(), init, thrust::plus<Eigen::Vector3f>());
     return sum / points.size();
 }
 
-void Geometry3D::ResizeAndPaintUniformColor(thrust::device_vector<Eigen::Vector3f>& colors,
+Eigen::Vector3f Geometry3D::ComputeMinBound(cudaStream_t stream, const thrustcupoch::device_vector<Eigen::Vector4f>& points) const {
+    if (points.empty()) return Eigen::Vector3f::Zero();
+    Eigen::Vector4f init = points[0];
+    Eigen::Vector4f min_bound = thrust::reduce(exec_policy_on(stream), points.begin(), points.end(), init, elementwise_min_functor<4>());
+    return min_bound.head<3>();
+}
+
+Eigen::Vector3f Geometry3D::ComputeMaxBound(cudaStream_t stream, const thrustcupoch::device_vector<Eigen::Vector4f>& points) const {
+    if (points.empty()) return Eigen::Vector3f::Zero();
+    Eigen::Vector4f init = points[0];
+    Eigen::Vector4f max_bound = thrust::reduce(exec_policy_on(stream), points.begin(), points.end(), init, elementwise_max_functor<4>());
+    return max_bound.head<3>();
+}
+
+Eigen::Vector3f Geometry3D::ComputeCenter(const thrustcupoch::device_vector<Eigen::Vector4f>& points) const {
+    Eigen::Vector4f init = Eigen::Vector4f::Zero();
+    if (points.empty()) return init.head<3>();
+    Eigen::Vector4f sum = thrust::reduce(points.begin(), points.end(), init, thrust::plus<Eigen::Vector4f>());
+    return sum.head<3>() / points.size();
+}
+
+void Geometry3D::ResizeAndPaintUniformColor(thrustcupoch::device_vector<Eigen::Vector3f>& colors,
     const size_t size,
     const Eigen::Vector3f& color) {
     colors.resize(size);
@@ -90,75 +126,87 @@ void Geometry3D::ResizeAndPaintUniformColor(thrust::device_vector<Eigen::Vector3
 }
 
 void Geometry3D::TransformPoints(const Eigen::Matrix4f& transformation,
-                                 thrust::device_vector<Eigen::Vector3f>& points) {
+                                 thrustcupoch::device_vector<Eigen::Vector3f>& points) {
     TransformPoints(0, transformation, points);
 }
 
 void Geometry3D::TransformPoints(cudaStream_t stream, const Eigen::Matrix4f& transformation,
-                                 thrust::device_vector<Eigen::Vector3f>& points) {
+                                 thrustcupoch::device_vector<Eigen::Vector3f>& points) {
     transform_points_functor func(transformation);
-    thrust::for_each(thrust::cuda::par.on(stream), points.begin(), points.end(), func);
+    thrust::for_each(exec_policy_on(stream), points.begin(), points.end(), func);
 }
 
 void Geometry3D::TransformNormals(const Eigen::Matrix4f& transformation,
-                                  thrust::device_vector<Eigen::Vector3f>& normals) {
+                                  thrustcupoch::device_vector<Eigen::Vector3f>& normals) {
     TransformNormals(0, transformation, normals);
 }
 
 void Geometry3D::TransformNormals(cudaStream_t stream, const Eigen::Matrix4f& transformation,
-                                  thrust::device_vector<Eigen::Vector3f>& normals) {
+                                  thrustcupoch::device_vector<Eigen::Vector3f>& normals) {
+    transform_normals_functor func(transformation);
+    thrust::for_each(exec_policy_on(stream), normals.begin(), normals.end(), func);
+}
+
+void Geometry3D::TransformPoints(cudaStream_t stream, const Eigen::Matrix4f& transformation,
+                                 thrustcupoch::device_vector<Eigen::Vector4f>& points) {
+    transform_points_functor func(transformation);
+    thrust::for_each(exec_policy_on(stream), points.begin(), points.end(), func);
+}
+
+void Geometry3D::TransformNormals(cudaStream_t stream, const Eigen::Matrix4f& transformation,
+                                  thrustcupoch::device_vector<Eigen::Vector4f>& normals) {
     transform_normals_functor func(transformation);
-    thrust::for_each(thrust::cuda::par.on(stream), normals.begin(), normals.end(), func);
+    thrust::for_each(exec_policy_on(stream), normals.begin(), normals.end(), func);
 }
 
 void Geometry3D::TranslatePoints(const Eigen::Vector3f& translation,
-                                 thrust::device_vector<Eigen::Vector3f>& points,
+                                 thrustcupoch::device_vector<Eigen::Vector3f>& points,
                                  bool relative) const {
     Eigen::Vector3f transform = translation;
     if (!relative) {
         transform -= ComputeCenter(points);
     }
-    thrust::for_each(points.begin(), points.end(), [=] __device__ (Eigen::Vector3f& pt) {pt += transform;});
+    thrust::for_each(points.begin(), points.end(), [=] __host__ __device__ (Eigen::Vector3f& pt) {pt += transform;});
 }
 
 void Geometry3D::ScalePoints(const float scale,
-                             thrust::device_vector<Eigen::Vector3f>& points,
+                             thrustcupoch::device_vector<Eigen::Vector3f>& points,
                              bool center) const {
     Eigen::Vector3f points_center(0, 0, 0);
     if (center && !points.empty()) {
         points_center = ComputeCenter(points);
     }
     thrust::for_each(points.begin(), points.end(),
-                     [=] __device__ (Eigen::Vector3f& pt) {pt = (pt - points_center) * scale + points_center;});
+                     [=] __host__ __device__ (Eigen::Vector3f& pt) {pt = (pt - points_center) * scale + points_center;});
 }
 
 void Geometry3D::RotatePoints(const Eigen::Matrix3f& R,
-                              thrust::device_vector<Eigen::Vector3f>& points,
+                              thrustcupoch::device_vector<Eigen::Vector3f>& points,
                               bool center) const {
     RotatePoints(0, R, points, center);
 }
 
 void Geometry3D::RotatePoints(cudaStream_t stream, const Eigen::Matrix3f& R,
-                              thrust::device_vector<Eigen::Vector3f>& points,
+                              thrustcupoch::device_vector<Eigen::Vector3f>& points,
                               bool center) const {
     Eigen::Vector3f points_center(0, 0, 0);
     if (center && !points.empty()) {
         points_center = ComputeCenter(points);
     }
-    thrust::for_each(thrust::cuda::par.on(stream), points.begin(), points.end(),
-                     [=] __device__ (Eigen::Vector3f& pt) {pt = R * (pt - points_center) + points_center;});
+    thrust::for_each(exec_policy_on(stream), points.begin(), points.end(),
+                     [=] __host__ __device__ (Eigen::Vector3f& pt) {pt = R * (pt - points_center) + points_center;});
 }
 
 
 void Geometry3D::RotateNormals(const Eigen::Matrix3f& R,
-                               thrust::device_vector<Eigen::Vector3f>& normals) const {
+                               thrustcupoch::device_vector<Eigen::Vector3f>& normals) const {
     RotateNormals(0, R, normals);
 }
 
 void Geometry3D::RotateNormals(cudaStream_t stream, const Eigen::Matrix3f& R,
-                               thrust::device_vector<Eigen::Vector3f>& normals) const {
-    thrust::for_each(thrust::cuda::par.on(stream), normals.begin(), normals.end(),
-                     [=] __device__ (Eigen::Vector3f& normal) {normal = R * normal;});
+                               thrustcupoch::device_vector<Eigen::Vector3f>& normals) const {
+    thrust::for_each(exec_policy_on(stream), normals.begin(), normals.end(),
+                     [=] __host__ __device__ (Eigen::Vector3f& normal) {normal = R * normal;});
 }
 
 Eigen::Matrix3f Geometry3D::GetRotationMatrixFromXYZ(
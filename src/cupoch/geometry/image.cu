@@ -8,11 +8,11 @@ namespace {
 
 /// Isotropic 2D kernels are separable:
 /// two 1D kernels are applied in x and y direction.
-std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterKernel(Image::FilterType ftype) {
+std::pair<thrustcupoch::device_vector<float>, thrustcupoch::device_vector<float>> GetFilterKernel(Image::FilterType ftype) {
     switch (ftype) {
         case Image::FilterType::Gaussian3:
         {
-            thrust::device_vector<float> g3(3);
+            thrustcupoch::device_vector<float> g3(3);
             g3[0] = 0.25;
             g3[1] = 0.5;
             g3[2] = 0.25;
@@ -20,7 +20,7 @@ std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterK
         }
         case Image::FilterType::Gaussian5:
         {
-            thrust::device_vector<float> g5(5);
+            thrustcupoch::device_vector<float> g5(5);
             g5[0] = 0.0625;
             g5[1] = 0.25;
             g5[2] = 0.375;
@@ -30,7 +30,7 @@ std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterK
         }
         case Image::FilterType::Gaussian7:
         {
-            thrust::device_vector<float> g7(7);
+            thrustcupoch::device_vector<float> g7(7);
             g7[0] = 0.03125;
             g7[1] = 0.109375;
             g7[2] = 0.21875;
@@ -42,8 +42,8 @@ std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterK
         }
         case Image::FilterType::Sobel3Dx:
         {
-            thrust::device_vector<float> s31(3);
-            thrust::device_vector<float> s32(3);
+            thrustcupoch::device_vector<float> s31(3);
+            thrustcupoch::device_vector<float> s32(3);
             s31[0] = -1.0;
             s31[1] = 0.0;
             s31[2] = 1.0;
@@ -54,8 +54,8 @@ std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterK
         }
         case Image::FilterType::Sobel3Dy:
         {
-            thrust::device_vector<float> s31(3);
-            thrust::device_vector<float> s32(3);
+            thrustcupoch::device_vector<float> s31(3);
+            thrustcupoch::device_vector<float> s32(3);
             s31[0] = -1.0;
             s31[1] = 0.0;
             s31[2] = 1.0;
@@ -67,7 +67,7 @@ std::pair<thrust::device_vector<float>, thrust::device_vector<float>> GetFilterK
         default:
         {
             utility::LogError("[Filter] Unsupported filter type.");
-            return std::make_pair(thrust::device_vector<float>(), thrust::device_vector<float>());
+            return std::make_pair(thrustcupoch::device_vector<float>(), thrustcupoch::device_vector<float>());
         }
     }
 }
@@ -86,7 +86,7 @@ struct transpose_functor {
     const int out_bytes_per_line_;
     const int bytes_per_pixel_;
     uint8_t* dst_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         const int y = idx / width_;
         const int x = idx % width_;
@@ -102,7 +102,7 @@ struct clip_intensity_functor {
     uint8_t* fimage_;
     const float min_;
     const float max_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         float *p = (float*)(fimage_ + idx * sizeof(float));
         if (*p > max_) *p = (float)max_;
@@ -116,7 +116,7 @@ struct linear_transform_functor {
     uint8_t* fimage_;
     const float scale_;
     const float offset_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         float *p = (float*)(fimage_ + idx * sizeof(float));
         (*p) = (float)(scale_ * (*p) + offset_);
@@ -131,7 +131,7 @@ struct downsample_functor {
     const int src_width_;
     uint8_t* dst_;
     const int dst_width_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         const int y = idx / dst_width_;
         const int x = idx % dst_width_;
@@ -156,7 +156,7 @@ struct filter_horizontal_functor {
     const float* kernel_;
     const int half_kernel_size_;
     uint8_t* dst_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         const int y = idx / width_;
         const int x = idx % width_;
@@ -182,7 +182,7 @@ struct vertical_flip_functor {
     const int height_;
     const int bytes_per_pixel_;
     uint8_t* dst_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         const int y = idx / width_;
         const int x = idx % width_;
@@ -198,7 +198,7 @@ struct horizontal_flip_functor {
     const int width_;
     const int bytes_per_pixel_;
     uint8_t* dst_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         const int y = idx / width_;
         const int x = idx % width_;
@@ -212,7 +212,7 @@ struct depth_to_float_functor {
     const int depth_scale_;
     const int depth_trunc_;
     uint8_t* fimage_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         float *p = (float*)(fimage_ + idx * sizeof(float));
         *p /= (float)depth_scale_;
@@ -329,7 +329,7 @@ std::shared_ptr<Image> Image::Downsample() const {
 }
 
 std::shared_ptr<Image> Image::FilterHorizontal(
-        const thrust::device_vector<float> &kernel) const {
+        const thrustcupoch::device_vector<float> &kernel) const {
     auto output = std::make_shared<Image>();
     if (num_of_channels_ != 1 || bytes_per_channel_ != 4 ||
         kernel.size() % 2 != 1) {
@@ -370,8 +370,8 @@ ImagePyramid Image::FilterPyramid(const ImagePyramid &input,
     return output;
 }
 
-std::shared_ptr<Image> Image::Filter(const thrust::device_vector<float> &dx,
-                                     const thrust::device_vector<float> &dy) const {
+std::shared_ptr<Image> Image::Filter(const thrustcupoch::device_vector<float> &dx,
+                                     const thrustcupoch::device_vector<float> &dy) const {
     auto output = std::make_shared<Image>();
     if (num_of_channels_ != 1 || bytes_per_channel_ != 4) {
         utility::LogError("[Filter] Unsupported image format.");
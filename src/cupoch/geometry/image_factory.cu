@@ -19,7 +19,7 @@ struct make_float_image_functor {
     int bytes_per_channel_;
     Image::ColorToIntensityConversionType type_;
     uint8_t* fimage_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         float *p = (float *)(fimage_ + idx * 4);
         const uint8_t *pi =
@@ -77,7 +77,7 @@ struct restore_from_float_image_functor {
         : src_(src), dst_(dst) {};
     const float* src_;
     uint8_t* dst_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         if (sizeof(T) == 1) *(dst_ + idx) = static_cast<T>(*(src_ + idx) * 255.0f);
         if (sizeof(T) == 2) *(dst_ + idx) = static_cast<T>(*(src_ + idx));
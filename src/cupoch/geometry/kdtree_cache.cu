@@ -0,0 +1,178 @@
+#include "cupoch/geometry/kdtree_cache.h"
+#include "cupoch/utility/console.h"
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform_reduce.h>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+// Hash of a point and its index. The hashes of the points are summed, so
+// the fingerprint does not depend on the order of the reduction.
+struct point_hash_functor {
+    point_hash_functor(const Eigen::Vector3f* points) : points_(points) {};
+    const Eigen::Vector3f* points_;
+    __host__ __device__
+    unsigned long long operator() (size_t idx) const {
+        unsigned long long h = idx;
+        for (int i = 0; i < 3; ++i) {
+            union {
+                float f;
+                unsigned int u;
+            } bits;
+            bits.f = points_[idx][i];
+            h = (h ^ bits.u) * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 32;
+        }
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+}  // namespace
+
+KDTreeCache::Fingerprint KDTreeCache::ComputeFingerprint(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points) {
+    Fingerprint fingerprint;
+    fingerprint.size_ = points.size();
+    fingerprint.hash_ = thrust::transform_reduce(
+            thrust::make_counting_iterator<size_t>(0),
+            thrust::make_counting_iterator(points.size()),
+            point_hash_functor(thrust::raw_pointer_cast(points.data())),
+            0ull, thrust::plus<unsigned long long>());
+    return fingerprint;
+}
+
+std::shared_ptr<const KDTreeFlann> KDTreeCache::GetKDTree(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points) {
+    return GetKDTree(points, ComputeFingerprint(points));
+}
+
+std::shared_ptr<const KDTreeFlann> KDTreeCache::GetKDTree(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        const Fingerprint &fingerprint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Bind(fingerprint);
+    if (!kdtree_) {
+        auto kdtree = std::make_shared<KDTreeFlann>();
+        kdtree->SetRawData(points);
+        kdtree_ = kdtree;
+    }
+    return kdtree_;
+}
+
+std::shared_ptr<const NeighborSearchResult> KDTreeCache::SearchNeighbors(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        const KDTreeSearchParam &param) {
+    SearchKey key;
+    key.type_ = param.GetSearchType();
+    key.csr_ = false;
+    switch (key.type_) {
+        case KDTreeSearchParam::SearchType::Knn:
+            key.knn_ = ((const KDTreeSearchParamKNN &)param).knn_;
+            key.radius_ = 0.0;
+            break;
+        case KDTreeSearchParam::SearchType::Radius:
+            key.knn_ = NUM_MAX_NN;
+            key.radius_ = ((const KDTreeSearchParamRadius &)param).radius_;
+            break;
+        case KDTreeSearchParam::SearchType::Hybrid:
+            key.knn_ = ((const KDTreeSearchParamHybrid &)param).max_nn_;
+            key.radius_ = ((const KDTreeSearchParamHybrid &)param).radius_;
+            break;
+        default:
+            utility::LogError("[KDTreeCache::SearchNeighbors] Unknown search param type.");
+            return std::make_shared<NeighborSearchResult>();
+    }
+    const Fingerprint fingerprint = ComputeFingerprint(points);
+    auto cached = FindResult(fingerprint, key);
+    if (cached) return cached;
+    const auto kdtree = GetKDTree(points, fingerprint);
+    auto result = std::make_shared<NeighborSearchResult>();
+    result->knn_ = key.knn_;
+    kdtree->Search(points, param, result->indices_, result->distance2_);
+    AddResult(fingerprint, key, result);
+    return result;
+}
+
+std::shared_ptr<const NeighborSearchResult> KDTreeCache::SearchNeighborsCSR(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+        const KDTreeSearchParam &param) {
+    SearchKey key;
+    key.type_ = param.GetSearchType();
+    key.csr_ = true;
+    switch (key.type_) {
+        case KDTreeSearchParam::SearchType::Radius:
+            key.knn_ = 0;
+            key.radius_ = ((const KDTreeSearchParamRadius &)param).radius_;
+            break;
+        case KDTreeSearchParam::SearchType::Hybrid:
+            key.knn_ = ((const KDTreeSearchParamHybrid &)param).max_nn_;
+            key.radius_ = ((const KDTreeSearchParamHybrid &)param).radius_;
+            break;
+        default:
+            utility::LogError("[KDTreeCache::SearchNeighborsCSR] Only radius and hybrid search params are supported.");
+            return std::make_shared<NeighborSearchResult>();
+    }
+    const Fingerprint fingerprint = ComputeFingerprint(points);
+    auto cached = FindResult(fingerprint, key);
+    if (cached) return cached;
+    const auto kdtree = GetKDTree(points, fingerprint);
+    auto result = std::make_shared<NeighborSearchResult>();
+    if (key.type_ == KDTreeSearchParam::SearchType::Radius) {
+        kdtree->SearchRadiusCSR(points, key.radius_, result->offsets_,
+                               result->indices_, result->distance2_);
+    } else {
+        kdtree->SearchHybridCSR(points, key.radius_, key.knn_, result->offsets_,
+                               result->indices_, result->distance2_);
+    }
+    AddResult(fingerprint, key, result);
+    return result;
+}
+
+void KDTreeCache::Bind(const Fingerprint &fingerprint) {
+    if (fingerprint == fingerprint_) return;
+    kdtree_.reset();
+    results_.clear();
+    result_bytes_ = 0;
+    fingerprint_ = fingerprint;
+}
+
+std::shared_ptr<const NeighborSearchResult> KDTreeCache::FindResult(
+        const Fingerprint &fingerprint, const SearchKey &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Bind(fingerprint);
+    for (auto it = results_.begin(); it != results_.end(); ++it) {
+        if (it->first == key) {
+            results_.splice(results_.begin(), results_, it);
+            return results_.front().second;
+        }
+    }
+    return std::shared_ptr<const NeighborSearchResult>();
+}
+
+namespace {
+
+size_t ResultBytes(const NeighborSearchResult &result) {
+    return (result.offsets_.size() + result.indices_.size()) * sizeof(int) +
+           result.distance2_.size() * sizeof(float);
+}
+
+}  // namespace
+
+void KDTreeCache::AddResult(const Fingerprint &fingerprint, const SearchKey &key,
+                            const std::shared_ptr<const NeighborSearchResult> &result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the cache may have moved on to other points during the search
+    if (!(fingerprint == fingerprint_)) return;
+    const size_t bytes = ResultBytes(*result);
+    if (bytes > kMaxResultBytes) return;
+    results_.emplace_front(key, result);
+    result_bytes_ += bytes;
+    while (results_.size() > kMaxNumResults || result_bytes_ > kMaxResultBytes) {
+        result_bytes_ -= ResultBytes(*results_.back().second);
+        results_.pop_back();
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace geometry {
+
+/// Neighbors of every point of a geometry in the geometry itself.
+/// In the padded layout, row i holds the neighbors of the i-th point in the
+/// slots [i * knn_, (i + 1) * knn_), padded with -1. In the CSR layout
+/// (IsCSR()), the neighbors of the i-th point are in the slots
+/// [offsets_[i], offsets_[i + 1]) and knn_ is 0.
+struct NeighborSearchResult {
+    bool IsCSR() const { return !offsets_.empty(); }
+    int knn_ = 0;
+    thrustcupoch::device_vector<int> offsets_;
+    thrustcupoch::device_vector<int> indices_;
+    thrustcupoch::device_vector<float> distance2_;
+};
+
+/// \class KDTreeCache
+///
+/// \brief KD-tree of the points of a geometry together with memoized
+/// searches of the points in themselves.
+///
+/// The owning geometry replaces its cache when its points are modified.
+/// The cache also remembers the size and a fingerprint of the contents of
+/// the points it was computed for and starts over when called with other
+/// points, so writes to the points that bypass the geometry, in place or by
+/// reassignment, cost a rebuild rather than stale neighbors.
+class KDTreeCache {
+public:
+    KDTreeCache() {}
+    KDTreeCache(const KDTreeCache &) = delete;
+    KDTreeCache &operator=(const KDTreeCache &) = delete;
+
+public:
+    /// Returns the KD-tree of \param points, building it on first use.
+    /// The tree stays valid for the caller when the cache moves on to other
+    /// points.
+    std::shared_ptr<const KDTreeFlann> GetKDTree(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points);
+
+    /// Searches the neighbors of all \param points in \param points.
+    /// The last results are kept and returned for an identical
+    /// \param param.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighbors(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+            const KDTreeSearchParam &param);
+
+    /// Same as SearchNeighbors for radius and hybrid parameters, returning
+    /// the results in the CSR layout without the NUM_MAX_NN limit.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighborsCSR(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+            const KDTreeSearchParam &param);
+
+    bool HasKDTree() const { return bool(kdtree_); }
+
+private:
+    struct SearchKey {
+        KDTreeSearchParam::SearchType type_;
+        int knn_;
+        float radius_;
+        bool csr_;
+        bool operator==(const SearchKey &other) const {
+            return type_ == other.type_ && knn_ == other.knn_ &&
+                   radius_ == other.radius_ && csr_ == other.csr_;
+        }
+    };
+
+    struct Fingerprint {
+        size_t size_ = 0;
+        unsigned long long hash_ = 0;
+        bool operator==(const Fingerprint &other) const {
+            return size_ == other.size_ && hash_ == other.hash_;
+        }
+    };
+
+    static Fingerprint ComputeFingerprint(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points);
+    /// Drops the KD-tree and the results if they were computed for other
+    /// points than \param fingerprint. Must be called with mutex_ held.
+    void Bind(const Fingerprint &fingerprint);
+    std::shared_ptr<const KDTreeFlann> GetKDTree(
+            const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+            const Fingerprint &fingerprint);
+    std::shared_ptr<const NeighborSearchResult> FindResult(
+            const Fingerprint &fingerprint, const SearchKey &key);
+    void AddResult(const Fingerprint &fingerprint, const SearchKey &key,
+                   const std::shared_ptr<const NeighborSearchResult> &result);
+
+    /// Maximum number of memoized search results.
+    static const size_t kMaxNumResults = 4;
+    /// Maximum total size of the memoized search results, the oldest ones
+    /// are dropped beyond it and larger results are not kept.
+    static const size_t kMaxResultBytes = 256 << 20;
+
+    std::mutex mutex_;
+    Fingerprint fingerprint_;
+    std::shared_ptr<const KDTreeFlann> kdtree_;
+    std::list<std::pair<SearchKey, std::shared_ptr<const NeighborSearchResult>>> results_;
+    size_t result_bytes_ = 0;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -1,12 +1,22 @@
 
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/utility/platform.h"
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
 #define FLANN_USE_CUDA
+#endif
 #include <flann/flann.hpp>
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/trianglemesh.h"
 #include "cupoch/utility/eigen.h"
 #include "cupoch/utility/helper.h"
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/execution_context.h"
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/scan.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 using namespace cupoch;
 using namespace cupoch::geometry;
@@ -14,12 +24,299 @@ using namespace cupoch::geometry;
 namespace {
 
 struct convert_float4_functor {
-    __device__
+    __host__ __device__
     float4 operator() (const Eigen::Vector3f& x) const {
         return make_float4(x[0], x[1], x[2], 0.0f);
     }
+    __host__ __device__
+    float4 operator() (const Eigen::Vector4f& x) const {
+        return make_float4(x[0], x[1], x[2], 0.0f);
+    }
+};
+
+// Number of coordinates used for the search. The 4th element of the aligned
+// Eigen::Vector4f points is padding.
+template <typename T>
+struct point_dimension {
+    static const int value = T::SizeAtCompileTime;
+};
+
+template <>
+struct point_dimension<Eigen::Vector4f> {
+    static const int value = 3;
+};
+
+// Converts the queries into the float4 layout of flann. The converted queries
+// are written to the scratch workspace of the current execution context, so
+// repeated searches do not allocate.
+template <typename T>
+flann::Matrix<float> MakeQueryMatrix(const thrustcupoch::device_vector<T> &query,
+                                     size_t dimension) {
+    float4 *query_f4 = (float4 *)utility::GetExecutionContext().GetWorkspace(
+            query.size() * sizeof(float4));
+    thrust::transform(query.begin(), query.end(),
+                      thrust::device_pointer_cast(query_f4),
+                      convert_float4_functor());
+    return flann::Matrix<float>((float *)query_f4, query.size(), dimension,
+                                sizeof(float) * 4);
+}
+
+// Aligned queries already have the layout of flann and are used in place.
+template <>
+flann::Matrix<float> MakeQueryMatrix<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        size_t dimension) {
+    return flann::Matrix<float>(
+            (float *)thrust::raw_pointer_cast(query.data()), query.size(),
+            dimension, sizeof(float) * 4);
+}
+
+// The host flann indices only terminate a result row with a single -1 entry
+// and leave the remaining slots untouched, while the CUDA index pads the
+// whole row. Pad the rows here so that consumers behave the same on every
+// device system.
+struct pad_invalid_neighbors_functor {
+    pad_invalid_neighbors_functor(int* indices, float* distance2, int knn)
+        : indices_(indices), distance2_(distance2), knn_(knn) {};
+    int* indices_;
+    float* distance2_;
+    const int knn_;
+    __host__ __device__
+    void operator() (size_t idx) {
+        bool terminated = false;
+        for (int k = 0; k < knn_; ++k) {
+            terminated |= (indices_[idx * knn_ + k] < 0);
+            if (terminated) {
+                indices_[idx * knn_ + k] = -1;
+                distance2_[idx * knn_ + k] = std::numeric_limits<float>::infinity();
+            }
+        }
+    }
 };
 
+struct is_valid_mean_distance2_functor {
+    __host__ __device__
+    bool operator() (float d) const {
+        return d >= 0.0;
+    }
+};
+
+struct is_positive_count_functor {
+    __host__ __device__
+    bool operator() (int n) const {
+        return n > 0;
+    }
+};
+
+flann::SearchParams MakeSearchParams(int checks, float eps) {
+    flann::SearchParams param(checks, eps);
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    param.matrices_in_gpu_ram = true;
+#else
+    // use all available cores on the host device systems
+    param.cores = 0;
+#endif
+    return param;
+}
+
+void PadInvalidNeighbors(thrustcupoch::device_vector<int> &indices,
+                         thrustcupoch::device_vector<float> &distance2,
+                         size_t n_query, int knn) {
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    pad_invalid_neighbors_functor func(thrust::raw_pointer_cast(indices.data()),
+                                       thrust::raw_pointer_cast(distance2.data()),
+                                       knn);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_query), func);
+#endif
+}
+
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+typedef flann::KDTreeSingleIndex<flann::L2<float>> HostFlannIndex;
+
+// First pass of the CSR radius search on the host device systems.
+struct count_radius_neighbors_functor {
+    count_radius_neighbors_functor(const HostFlannIndex* index,
+                                   const flann::Matrix<float>& queries,
+                                   float radius2, int max_nn,
+                                   const flann::SearchParams& params)
+        : index_(index), queries_(queries), radius2_(radius2),
+          max_nn_(max_nn), params_(params) {};
+    const HostFlannIndex* index_;
+    const flann::Matrix<float> queries_;
+    const float radius2_;
+    const int max_nn_;
+    const flann::SearchParams params_;
+    int operator() (size_t idx) const {
+        flann::CountRadiusResultSet<float> result(radius2_);
+        index_->findNeighbors(result, queries_[idx], params_);
+        const int n = int(result.size());
+        return (max_nn_ > 0 && n > max_nn_) ? max_nn_ : n;
+    }
+};
+
+// Mean squared distance to the knn nearest neighbors on the host device
+// systems. The result set only lives during the traversal of one query.
+struct knn_mean_distance2_functor {
+    knn_mean_distance2_functor(const HostFlannIndex* index,
+                               const flann::Matrix<float>& queries,
+                               int knn, const flann::SearchParams& params)
+        : index_(index), queries_(queries), knn_(knn), params_(params) {};
+    const HostFlannIndex* index_;
+    const flann::Matrix<float> queries_;
+    const int knn_;
+    const flann::SearchParams params_;
+    float operator() (size_t idx) const {
+        flann::KNNSimpleResultSet<float> result(knn_);
+        index_->findNeighbors(result, queries_[idx], params_);
+        const int n = std::min(int(result.size()), knn_);
+        if (n == 0) return -1.0;
+        size_t tmp_indices[NUM_MAX_NN];
+        float tmp_distance2[NUM_MAX_NN];
+        result.copy(tmp_indices, tmp_distance2, n, false);
+        float sum = 0;
+        for (int k = 0; k < n; ++k) sum += tmp_distance2[k];
+        return sum / n;
+    }
+};
+
+// Neighbors accumulated relative to the query, which keeps the covariance
+// accurate far from the origin.
+struct CovarianceAccumulator {
+    CovarianceAccumulator(const Eigen::Vector3f& query) : query_(query) {};
+    const Eigen::Vector3f query_;
+    Eigen::Vector3f sum_ = Eigen::Vector3f::Zero();
+    Eigen::Matrix3f sum2_ = Eigen::Matrix3f::Zero();
+    int count_ = 0;
+    void Add(const float4& p) {
+        const Eigen::Vector3f d = Eigen::Vector3f(p.x, p.y, p.z) - query_;
+        sum_ += d;
+        sum2_ += d * d.transpose();
+        ++count_;
+    }
+    Eigen::Matrix3f GetCovariance() const {
+        if (count_ == 0) return Eigen::Matrix3f::Zero();
+        const Eigen::Vector3f mean = sum_ / count_;
+        return sum2_ / count_ - mean * mean.transpose();
+    }
+};
+
+// Accumulates all the neighbors within the radius as they are found.
+class CovarianceRadiusResultSet : public flann::ResultSet<float> {
+public:
+    CovarianceRadiusResultSet(const float4* data, const Eigen::Vector3f& query,
+                              float radius2)
+        : data_(data), radius2_(radius2), acc_(query) {};
+    bool full() const { return true; }
+    void addPoint(float dist, size_t index) {
+        if (dist < radius2_) acc_.Add(data_[index]);
+    }
+    float worstDist() const { return radius2_; }
+    const CovarianceAccumulator& GetAccumulator() const { return acc_; }
+private:
+    const float4* data_;
+    const float radius2_;
+    CovarianceAccumulator acc_;
+};
+
+// Covariance of the neighbors on the host device systems. With knn > 0 the
+// knn nearest neighbors within the radius are used, otherwise all the
+// neighbors within the radius.
+struct neighbor_covariance_functor {
+    neighbor_covariance_functor(const HostFlannIndex* index,
+                                const flann::Matrix<float>& queries,
+                                const float4* data, int knn, float radius2,
+                                Eigen::Matrix3f* covariances, int* counts,
+                                const flann::SearchParams& params)
+        : index_(index), queries_(queries), data_(data), knn_(knn),
+          radius2_(radius2), covariances_(covariances), counts_(counts),
+          params_(params) {};
+    const HostFlannIndex* index_;
+    const flann::Matrix<float> queries_;
+    const float4* data_;
+    const int knn_;
+    const float radius2_;
+    Eigen::Matrix3f* covariances_;
+    int* counts_;
+    const flann::SearchParams params_;
+    void operator() (size_t idx) const {
+        const float* q = queries_[idx];
+        const Eigen::Vector3f query(q[0], q[1], q[2]);
+        if (knn_ > 0) {
+            flann::KNNRadiusResultSet<float> result(radius2_, knn_);
+            index_->findNeighbors(result, q, params_);
+            const int n = std::min(int(result.size()), knn_);
+            size_t tmp_indices[NUM_MAX_NN];
+            float tmp_distance2[NUM_MAX_NN];
+            result.copy(tmp_indices, tmp_distance2, n, false);
+            CovarianceAccumulator acc(query);
+            for (int k = 0; k < n; ++k) acc.Add(data_[tmp_indices[k]]);
+            covariances_[idx] = acc.GetCovariance();
+            counts_[idx] = acc.count_;
+        } else {
+            CovarianceRadiusResultSet result(data_, query, radius2_);
+            index_->findNeighbors(result, q, params_);
+            covariances_[idx] = result.GetAccumulator().GetCovariance();
+            counts_[idx] = result.GetAccumulator().count_;
+        }
+    }
+};
+
+// Second pass of the CSR radius search; the row of each query is sized by
+// the first pass.
+struct fill_radius_neighbors_functor {
+    fill_radius_neighbors_functor(const HostFlannIndex* index,
+                                  const flann::Matrix<float>& queries,
+                                  float radius2, const int* offsets,
+                                  int* indices, float* distance2,
+                                  const flann::SearchParams& params)
+        : index_(index), queries_(queries), radius2_(radius2),
+          offsets_(offsets), indices_(indices), distance2_(distance2),
+          params_(params) {};
+    const HostFlannIndex* index_;
+    const flann::Matrix<float> queries_;
+    const float radius2_;
+    const int* offsets_;
+    int* indices_;
+    float* distance2_;
+    const flann::SearchParams params_;
+    void operator() (size_t idx) const {
+        const int n = offsets_[idx + 1] - offsets_[idx];
+        if (n == 0) return;
+        flann::KNNRadiusResultSet<float> result(radius2_, n);
+        index_->findNeighbors(result, queries_[idx], params_);
+        std::vector<size_t> tmp(n);
+        result.copy(tmp.data(), distance2_ + offsets_[idx], n, true);
+        for (int k = 0; k < n; ++k) indices_[offsets_[idx] + k] = int(tmp[k]);
+    }
+};
+
+// Traverses the host index for a single query without staging the query and
+// the results in device vectors. The results are padded to \param knn.
+template <typename ResultSet>
+int SearchSingleOnHost(const HostFlannIndex &index,
+                       const Eigen::Vector3f &query,
+                       const flann::SearchParams &params,
+                       int knn,
+                       ResultSet &result,
+                       thrust::host_vector<int> &indices,
+                       thrust::host_vector<float> &distance2) {
+    const float query_f[4] = {query[0], query[1], query[2], 0.0f};
+    index.findNeighbors(result, query_f, params);
+    const int n = std::min(int(result.size()), knn);
+    std::vector<size_t> tmp(n);
+    indices.resize(knn);
+    distance2.resize(knn);
+    result.copy(tmp.data(), distance2.data(), n, true);
+    for (int k = 0; k < n; ++k) indices[k] = int(tmp[k]);
+    for (int k = n; k < knn; ++k) {
+        indices[k] = -1;
+        distance2[k] = std::numeric_limits<float>::infinity();
+    }
+    return n;
+}
+#endif
+
 }
 
 
@@ -45,10 +342,10 @@ bool KDTreeFlann::SetGeometry(const Geometry &geometry) {
 }
 
 template <typename T>
-int KDTreeFlann::Search(const thrust::device_vector<T> &query,
+int KDTreeFlann::Search(const thrustcupoch::device_vector<T> &query,
                         const KDTreeSearchParam &param,
-                        thrust::device_vector<int> &indices,
-                        thrust::device_vector<float> &distance2) const {
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const {
     switch (param.GetSearchType()) {
         case KDTreeSearchParam::SearchType::Knn:
             return SearchKNN(query, ((const KDTreeSearchParamKNN &)param).knn_,
@@ -69,92 +366,262 @@ int KDTreeFlann::Search(const thrust::device_vector<T> &query,
 }
 
 template <typename T>
-int KDTreeFlann::SearchKNN(const thrust::device_vector<T> &query,
+int KDTreeFlann::SearchKNN(const thrustcupoch::device_vector<T> &query,
                            int knn,
-                           thrust::device_vector<int> &indices,
-                           thrust::device_vector<float> &distance2) const {
+                           thrustcupoch::device_vector<int> &indices,
+                           thrustcupoch::device_vector<float> &distance2) const {
     // This is optimized code for heavily repeated search.
     // Other flann::Index::knnSearch() implementations lose performance due to
     // memory allocation/deallocation.
     if (data_.empty() || query.empty() || dataset_size_ <= 0 || knn < 0 || knn > NUM_MAX_NN) return -1;
-    T query0 = query[0];
-    if (size_t(query0.size()) != dimension_) return -1;
-    convert_float4_functor func;
-    thrust::device_vector<float4> query_f4(query.size());
-    thrust::transform(query.begin(), query.end(), query_f4.begin(), func);
-    flann::Matrix<float> query_flann((float *)(thrust::raw_pointer_cast(query_f4.data())), query.size(), dimension_, sizeof(float) * 4);
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
     const int total_size = query.size() * knn;
     indices.resize(total_size);
     distance2.resize(total_size);
     flann::Matrix<int> indices_flann(thrust::raw_pointer_cast(indices.data()), query_flann.rows, knn);
     flann::Matrix<float> dists_flann(thrust::raw_pointer_cast(distance2.data()), query_flann.rows, knn);
-    flann::SearchParams param;
-    param.matrices_in_gpu_ram = true;
+    flann::SearchParams param = MakeSearchParams(32, 0.0);
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    thrust::fill(indices.begin(), indices.end(), -1);
+#endif
     int k = flann_index_->knnSearch(query_flann, indices_flann, dists_flann,
                                     knn, param);
+    PadInvalidNeighbors(indices, distance2, query.size(), knn);
     return k;
 }
 
 template <typename T>
-int KDTreeFlann::SearchRadius(const thrust::device_vector<T> &query,
+int KDTreeFlann::SearchRadius(const thrustcupoch::device_vector<T> &query,
                               float radius,
-                              thrust::device_vector<int> &indices,
-                              thrust::device_vector<float> &distance2) const {
+                              thrustcupoch::device_vector<int> &indices,
+                              thrustcupoch::device_vector<float> &distance2) const {
     // This is optimized code for heavily repeated search.
     // Since max_nn is not given, we let flann to do its own memory management.
     // Other flann::Index::radiusSearch() implementations lose performance due
     // to memory management and CPU caching.
     if (data_.empty() || query.empty() || dataset_size_ <= 0) return -1;
-    T query0 = query[0];
-    if (size_t(query0.size()) != dimension_) return -1;
-    convert_float4_functor func;
-    thrust::device_vector<float4> query_f4(query.size());
-    thrust::transform(query.begin(), query.end(), query_f4.begin(), func);
-    flann::Matrix<float> query_flann((float *)(thrust::raw_pointer_cast(query_f4.data())), query.size(), dimension_, sizeof(float) * 4);
-    flann::SearchParams param(-1, 0.0);
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    flann::SearchParams param = MakeSearchParams(-1, 0.0);
     param.max_neighbors = NUM_MAX_NN;
-    param.matrices_in_gpu_ram = true;
     indices.resize(query.size() * NUM_MAX_NN);
     distance2.resize(query.size() * NUM_MAX_NN);
     flann::Matrix<int> indices_flann(thrust::raw_pointer_cast(indices.data()), query_flann.rows, NUM_MAX_NN);
     flann::Matrix<float> dists_flann(thrust::raw_pointer_cast(distance2.data()), query_flann.rows, NUM_MAX_NN);
     int k = flann_index_->radiusSearch(query_flann, indices_flann, dists_flann,
                                        float(radius * radius), param);
+    PadInvalidNeighbors(indices, distance2, query.size(), NUM_MAX_NN);
     return k;
 }
 
 template <typename T>
-int KDTreeFlann::SearchHybrid(const thrust::device_vector<T> &query,
+int KDTreeFlann::SearchHybrid(const thrustcupoch::device_vector<T> &query,
                               float radius,
                               int max_nn,
-                              thrust::device_vector<int> &indices,
-                              thrust::device_vector<float> &distance2) const {
+                              thrustcupoch::device_vector<int> &indices,
+                              thrustcupoch::device_vector<float> &distance2) const {
     // This is optimized code for heavily repeated search.
     // It is also the recommended setting for search.
     // Other flann::Index::radiusSearch() implementations lose performance due
     // to memory allocation/deallocation.
     if (data_.empty() || query.empty() || dataset_size_ <= 0 || max_nn < 0 || max_nn > NUM_MAX_NN) return -1;
-    T query0 = query[0];
-    if (size_t(query0.size()) != dimension_) return -1;
-    convert_float4_functor func;
-    thrust::device_vector<float4> query_f4(query.size());
-    thrust::transform(query.begin(), query.end(), query_f4.begin(), func);
-    flann::Matrix<float> query_flann((float *)(thrust::raw_pointer_cast(query_f4.data())), query.size(), dimension_, sizeof(float) * 4);
-    flann::SearchParams param(-1, 0.0);
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    flann::SearchParams param = MakeSearchParams(-1, 0.0);
     param.max_neighbors = max_nn;
-    param.matrices_in_gpu_ram = true;
     indices.resize(query.size() * max_nn);
     distance2.resize(query.size() * max_nn);
     flann::Matrix<int> indices_flann(thrust::raw_pointer_cast(indices.data()), query_flann.rows, max_nn);
     flann::Matrix<float> dists_flann(thrust::raw_pointer_cast(distance2.data()), query_flann.rows, max_nn);
     int k = flann_index_->radiusSearch(query_flann, indices_flann, dists_flann,
                                        float(radius * radius), param);
+    PadInvalidNeighbors(indices, distance2, query.size(), max_nn);
     return k;
 }
 
 template <typename T>
-bool KDTreeFlann::SetRawData(const thrust::device_vector<T> &data) {
-    dimension_ = T::SizeAtCompileTime;
+int KDTreeFlann::SearchRadiusCSR(const thrustcupoch::device_vector<T> &query,
+                                 float radius,
+                                 thrustcupoch::device_vector<int> &offsets,
+                                 thrustcupoch::device_vector<int> &indices,
+                                 thrustcupoch::device_vector<float> &distance2) const {
+    if (data_.empty() || query.empty() || dataset_size_ <= 0) return -1;
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    return SearchCSR(query_flann, radius, -1, offsets, indices, distance2);
+}
+
+template <typename T>
+int KDTreeFlann::SearchHybridCSR(const thrustcupoch::device_vector<T> &query,
+                                 float radius,
+                                 int max_nn,
+                                 thrustcupoch::device_vector<int> &offsets,
+                                 thrustcupoch::device_vector<int> &indices,
+                                 thrustcupoch::device_vector<float> &distance2) const {
+    if (data_.empty() || query.empty() || dataset_size_ <= 0 || max_nn <= 0) return -1;
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    return SearchCSR(query_flann, radius, max_nn, offsets, indices, distance2);
+}
+
+template <typename T>
+int KDTreeFlann::CountRadius(const thrustcupoch::device_vector<T> &query,
+                             float radius,
+                             thrustcupoch::device_vector<int> &counts) const {
+    if (data_.empty() || query.empty() || dataset_size_ <= 0) return -1;
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    counts.resize(query.size());
+    CountRadiusNeighbors(query_flann, radius, -1,
+                         thrust::raw_pointer_cast(counts.data()));
+    return thrust::reduce(counts.begin(), counts.end());
+}
+
+template <typename T>
+int KDTreeFlann::SearchKNNMeanDistance2(const thrustcupoch::device_vector<T> &query,
+                                        int knn,
+                                        thrustcupoch::device_vector<float> &mean_distance2) const {
+    if (data_.empty() || query.empty() || dataset_size_ <= 0 || knn <= 0 || knn > NUM_MAX_NN) return -1;
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    flann::SearchParams param = MakeSearchParams(32, 0.0);
+    mean_distance2.resize(query.size());
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    flann_index_->knnMeanDistanceGpu(query_flann,
+                                     thrust::raw_pointer_cast(mean_distance2.data()),
+                                     knn, param);
+#else
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(query.size()),
+                      mean_distance2.begin(),
+                      knn_mean_distance2_functor(flann_index_.get(), query_flann,
+                                                 knn, param));
+#endif
+    return thrust::count_if(mean_distance2.begin(), mean_distance2.end(),
+                            is_valid_mean_distance2_functor());
+}
+
+template <typename T>
+int KDTreeFlann::SearchCovariance(const thrustcupoch::device_vector<T> &query,
+                                  const KDTreeSearchParam &param,
+                                  thrustcupoch::device_vector<Eigen::Matrix3f> &covariances,
+                                  thrustcupoch::device_vector<int> &counts) const {
+    if (data_.empty() || query.empty() || dataset_size_ <= 0) return -1;
+    if (size_t(point_dimension<T>::value) != dimension_) return -1;
+    int knn = 0;
+    float radius = 0;
+    float radius2 = std::numeric_limits<float>::infinity();
+    switch (param.GetSearchType()) {
+        case KDTreeSearchParam::SearchType::Knn:
+            knn = ((const KDTreeSearchParamKNN &)param).knn_;
+            break;
+        case KDTreeSearchParam::SearchType::Radius:
+            radius = ((const KDTreeSearchParamRadius &)param).radius_;
+            radius2 = radius * radius;
+            break;
+        case KDTreeSearchParam::SearchType::Hybrid:
+            knn = ((const KDTreeSearchParamHybrid &)param).max_nn_;
+            radius = ((const KDTreeSearchParamHybrid &)param).radius_;
+            radius2 = radius * radius;
+            break;
+        default:
+            return -1;
+    }
+    if (param.GetSearchType() != KDTreeSearchParam::SearchType::Radius &&
+        (knn <= 0 || knn > NUM_MAX_NN)) return -1;
+    flann::Matrix<float> query_flann = MakeQueryMatrix(query, dimension_);
+    covariances.resize(query.size());
+    counts.resize(query.size());
+    flann::SearchParams search_param = MakeSearchParams(-1, 0.0);
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    flann_index_->covarianceGpu(query_flann,
+                                (float *)thrust::raw_pointer_cast(covariances.data()),
+                                thrust::raw_pointer_cast(counts.data()),
+                                knn, radius2, search_param);
+#else
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(query.size()),
+                     neighbor_covariance_functor(flann_index_.get(), query_flann,
+                                                 thrust::raw_pointer_cast(data_.data()),
+                                                 knn, radius2,
+                                                 thrust::raw_pointer_cast(covariances.data()),
+                                                 thrust::raw_pointer_cast(counts.data()),
+                                                 search_param));
+#endif
+    return thrust::count_if(counts.begin(), counts.end(), is_positive_count_functor());
+}
+
+void KDTreeFlann::CountRadiusNeighbors(const flann::Matrix<float> &query_flann,
+                                       float radius,
+                                       int max_nn,
+                                       int *counts) const {
+    const float radius2 = radius * radius;
+    flann::SearchParams param = MakeSearchParams(-1, 0.0);
+    param.max_neighbors = (max_nn > 0) ? max_nn : -1;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    flann_index_->radiusCountGpu(query_flann, counts, radius2, param);
+#else
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(query_flann.rows),
+                      thrust::device_pointer_cast(counts),
+                      count_radius_neighbors_functor(flann_index_.get(), query_flann,
+                                                     radius2, max_nn, param));
+#endif
+}
+
+int KDTreeFlann::SearchCSR(const flann::Matrix<float> &query_flann,
+                           float radius,
+                           int max_nn,
+                           thrustcupoch::device_vector<int> &offsets,
+                           thrustcupoch::device_vector<int> &indices,
+                           thrustcupoch::device_vector<float> &distance2) const {
+    const size_t n_query = query_flann.rows;
+    const float radius2 = radius * radius;
+    flann::SearchParams param = MakeSearchParams(-1, 0.0);
+    param.max_neighbors = (max_nn > 0) ? max_nn : -1;
+    offsets.resize(n_query + 1);
+    thrust::fill(offsets.begin() + n_query, offsets.end(), 0);
+    // count the neighbors of each query
+    CountRadiusNeighbors(query_flann, radius, max_nn,
+                         thrust::raw_pointer_cast(offsets.data()));
+    // the offsets are int, so large radius searches may not fit in them
+    const size_t n_neighbors = thrust::reduce(offsets.begin(), offsets.begin() + n_query,
+                                              size_t(0));
+    if (n_neighbors > size_t(std::numeric_limits<int>::max())) {
+        utility::LogError("[KDTreeFlann::SearchCSR] {:d} neighbors overflow the int offsets, "
+                          "reduce the radius or max_nn.\n", n_neighbors);
+        offsets.clear();
+        indices.clear();
+        distance2.clear();
+        return -1;
+    }
+    thrust::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+    const int total = int(n_neighbors);
+    indices.resize(total);
+    distance2.resize(total);
+    if (total == 0) return 0;
+    // fill the rows sized by the counts
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    flann_index_->radiusSearchCSRGpu(query_flann, thrust::raw_pointer_cast(offsets.data()),
+                                     total, thrust::raw_pointer_cast(indices.data()),
+                                     thrust::raw_pointer_cast(distance2.data()),
+                                     radius2, param);
+#else
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_query),
+                     fill_radius_neighbors_functor(flann_index_.get(), query_flann, radius2,
+                                                   thrust::raw_pointer_cast(offsets.data()),
+                                                   thrust::raw_pointer_cast(indices.data()),
+                                                   thrust::raw_pointer_cast(distance2.data()),
+                                                   param));
+#endif
+    return total;
+}
+
+template <typename T>
+bool KDTreeFlann::SetRawData(const thrustcupoch::device_vector<T> &data) {
+    dimension_ = point_dimension<T>::value;
     dataset_size_ = data.size();
     if (dimension_ == 0 || dataset_size_ == 0) {
         utility::LogWarning(
@@ -166,9 +633,12 @@ bool KDTreeFlann::SetRawData(const thrust::device_vector<T> &data) {
     thrust::transform(data.begin(), data.end(), data_.begin(), func);
     flann_dataset_.reset(new flann::Matrix<float>((float*)thrust::raw_pointer_cast(data_.data()),
                                                   dataset_size_, dimension_, sizeof(float) * 4));
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     flann::KDTreeCuda3dIndexParams index_params;
-    flann_index_.reset(new flann::KDTreeCuda3dIndex<flann::L2<float>>(
-            *flann_dataset_, index_params));
+#else
+    flann::KDTreeSingleIndexParams index_params;
+#endif
+    flann_index_.reset(new FlannIndex(*flann_dataset_, index_params));
     flann_index_->buildIndex();
     return true;
 }
@@ -178,9 +648,9 @@ int KDTreeFlann::Search(const T &query,
                         const KDTreeSearchParam &param,
                         thrust::host_vector<int> &indices,
                         thrust::host_vector<float> &distance2) const {
-    thrust::device_vector<T> query_dv(1, query);
-    thrust::device_vector<int> indices_dv;
-    thrust::device_vector<float> distance2_dv;
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
     auto result = Search<T>(query_dv, param, indices_dv, distance2_dv);
     indices = indices_dv;
     distance2 = distance2_dv;
@@ -192,13 +662,20 @@ int KDTreeFlann::SearchKNN(const T &query,
                            int knn,
                            thrust::host_vector<int> &indices,
                            thrust::host_vector<float> &distance2) const {
-    thrust::device_vector<T> query_dv(1, query);
-    thrust::device_vector<int> indices_dv;
-    thrust::device_vector<float> distance2_dv;
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    if (data_.empty() || dataset_size_ <= 0 || knn < 0 || knn > NUM_MAX_NN) return -1;
+    flann::KNNResultSet<float> result_set(knn);
+    return SearchSingleOnHost(*flann_index_, query, MakeSearchParams(32, 0.0),
+                              knn, result_set, indices, distance2);
+#else
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
     auto result = SearchKNN<T>(query_dv, knn, indices_dv, distance2_dv);
     indices = indices_dv;
     distance2 = distance2_dv;
     return result;
+#endif
 }
 
 template <typename T>
@@ -206,13 +683,20 @@ int KDTreeFlann::SearchRadius(const T &query,
                               float radius,
                               thrust::host_vector<int> &indices,
                               thrust::host_vector<float> &distance2) const {
-    thrust::device_vector<T> query_dv(1, query);
-    thrust::device_vector<int> indices_dv;
-    thrust::device_vector<float> distance2_dv;
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    if (data_.empty() || dataset_size_ <= 0) return -1;
+    flann::KNNRadiusResultSet<float> result_set(radius * radius, NUM_MAX_NN);
+    return SearchSingleOnHost(*flann_index_, query, MakeSearchParams(-1, 0.0),
+                              NUM_MAX_NN, result_set, indices, distance2);
+#else
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
     auto result = SearchRadius<T>(query_dv, radius, indices_dv, distance2_dv);
     indices = indices_dv;
     distance2 = distance2_dv;
     return result;
+#endif
 }
 
 template <typename T>
@@ -221,36 +705,116 @@ int KDTreeFlann::SearchHybrid(const T &query,
                               int max_nn,
                               thrust::host_vector<int> &indices,
                               thrust::host_vector<float> &distance2) const {
-    thrust::device_vector<T> query_dv(1, query);
-    thrust::device_vector<int> indices_dv;
-    thrust::device_vector<float> distance2_dv;
+#ifndef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    if (data_.empty() || dataset_size_ <= 0 || max_nn < 0 || max_nn > NUM_MAX_NN) return -1;
+    flann::KNNRadiusResultSet<float> result_set(radius * radius, max_nn);
+    return SearchSingleOnHost(*flann_index_, query, MakeSearchParams(-1, 0.0),
+                              max_nn, result_set, indices, distance2);
+#else
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
     auto result = SearchHybrid<T>(query_dv, radius, max_nn, indices_dv, distance2_dv);
     indices = indices_dv;
     distance2 = distance2_dv;
     return result;
+#endif
 }
 
 template int KDTreeFlann::Search<Eigen::Vector3f>(
-        const thrust::device_vector<Eigen::Vector3f> &query,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
         const KDTreeSearchParam &param,
-        thrust::device_vector<int> &indices,
-        thrust::device_vector<float> &distance2) const;
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
 template int KDTreeFlann::SearchKNN<Eigen::Vector3f>(
-        const thrust::device_vector<Eigen::Vector3f> &query,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
         int knn,
-        thrust::device_vector<int> &indices,
-        thrust::device_vector<float> &distance2) const;
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
 template int KDTreeFlann::SearchRadius<Eigen::Vector3f>(
-        const thrust::device_vector<Eigen::Vector3f> &query,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
         float radius,
-        thrust::device_vector<int> &indices,
-        thrust::device_vector<float> &distance2) const;
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
 template int KDTreeFlann::SearchHybrid<Eigen::Vector3f>(
-        const thrust::device_vector<Eigen::Vector3f> &query,
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        float radius,
+        int max_nn,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchRadiusCSR<Eigen::Vector3f>(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        float radius,
+        thrustcupoch::device_vector<int> &offsets,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchHybridCSR<Eigen::Vector3f>(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
         float radius,
         int max_nn,
-        thrust::device_vector<int> &indices,
-        thrust::device_vector<float> &distance2) const;
+        thrustcupoch::device_vector<int> &offsets,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::CountRadius<Eigen::Vector3f>(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        float radius,
+        thrustcupoch::device_vector<int> &counts) const;
+template int KDTreeFlann::SearchKNNMeanDistance2<Eigen::Vector3f>(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        int knn,
+        thrustcupoch::device_vector<float> &mean_distance2) const;
+template int KDTreeFlann::SearchCovariance<Eigen::Vector3f>(
+        const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+        const KDTreeSearchParam &param,
+        thrustcupoch::device_vector<Eigen::Matrix3f> &covariances,
+        thrustcupoch::device_vector<int> &counts) const;
+template int KDTreeFlann::Search<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        const KDTreeSearchParam &param,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchKNN<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        int knn,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchRadius<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        float radius,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchHybrid<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        float radius,
+        int max_nn,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchRadiusCSR<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        float radius,
+        thrustcupoch::device_vector<int> &offsets,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::SearchHybridCSR<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        float radius,
+        int max_nn,
+        thrustcupoch::device_vector<int> &offsets,
+        thrustcupoch::device_vector<int> &indices,
+        thrustcupoch::device_vector<float> &distance2) const;
+template int KDTreeFlann::CountRadius<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        float radius,
+        thrustcupoch::device_vector<int> &counts) const;
+template int KDTreeFlann::SearchKNNMeanDistance2<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        int knn,
+        thrustcupoch::device_vector<float> &mean_distance2) const;
+template int KDTreeFlann::SearchCovariance<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &query,
+        const KDTreeSearchParam &param,
+        thrustcupoch::device_vector<Eigen::Matrix3f> &covariances,
+        thrustcupoch::device_vector<int> &counts) const;
 template int KDTreeFlann::Search<Eigen::Vector3f>(
         const Eigen::Vector3f &query,
         const KDTreeSearchParam &param,
@@ -273,5 +837,6 @@ template int KDTreeFlann::SearchHybrid<Eigen::Vector3f>(
         thrust::host_vector<int> &indices,
         thrust::host_vector<float> &distance2) const;
 template bool KDTreeFlann::SetRawData<Eigen::Vector3f>(
-        const thrust::device_vector<Eigen::Vector3f> &data);
-        
\ No newline at end of file
+        const thrustcupoch::device_vector<Eigen::Vector3f> &data);
+template bool KDTreeFlann::SetRawData<Eigen::Vector4f>(
+        const thrustcupoch::device_vector<Eigen::Vector4f> &data);
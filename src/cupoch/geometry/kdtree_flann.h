@@ -4,7 +4,7 @@
 #include <memory>
 
 #include "cupoch/geometry/kdtree_search_param.h"
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
 #include <thrust/host_vector.h>
 
 namespace flann {
@@ -14,6 +14,8 @@ template <typename T>
 struct L2;
 template <typename T>
 class KDTreeCuda3dIndex;
+template <typename T>
+class KDTreeSingleIndex;
 }  // namespace flann
 
 namespace cupoch {
@@ -32,30 +34,90 @@ public:
 public:
     bool SetGeometry(const Geometry &geometry);
 
+    /// Builds the index from raw points. Besides Eigen::Vector3f, 16-byte
+    /// aligned Eigen::Vector4f points (x, y, z, padding) are accepted.
+    template <typename T>
+    bool SetRawData(const thrustcupoch::device_vector<T> &data);
+
+    /// The search functions accept Eigen::Vector3f and aligned
+    /// Eigen::Vector4f queries. Aligned queries are passed to flann in place,
+    /// the others are converted to the aligned layout first.
     template <typename T>
-    int Search(const thrust::device_vector<T> &query,
+    int Search(const thrustcupoch::device_vector<T> &query,
                const KDTreeSearchParam &param,
-               thrust::device_vector<int> &indices,
-               thrust::device_vector<float> &distance2) const;
+               thrustcupoch::device_vector<int> &indices,
+               thrustcupoch::device_vector<float> &distance2) const;
 
     template <typename T>
-    int SearchKNN(const thrust::device_vector<T> &query,
+    int SearchKNN(const thrustcupoch::device_vector<T> &query,
                   int knn,
-                  thrust::device_vector<int> &indices,
-                  thrust::device_vector<float> &distance2) const;
+                  thrustcupoch::device_vector<int> &indices,
+                  thrustcupoch::device_vector<float> &distance2) const;
 
     template <typename T>
-    int SearchRadius(const thrust::device_vector<T> &query,
+    int SearchRadius(const thrustcupoch::device_vector<T> &query,
                      float radius,
-                     thrust::device_vector<int> &indices,
-                     thrust::device_vector<float> &distance2) const;
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
 
     template <typename T>
-    int SearchHybrid(const thrust::device_vector<T> &query,
+    int SearchHybrid(const thrustcupoch::device_vector<T> &query,
                      float radius,
                      int max_nn,
-                     thrust::device_vector<int> &indices,
-                     thrust::device_vector<float> &distance2) const;
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Radius search returning the neighbors in CSR form: the neighbors of
+    /// the i-th query are indices[offsets[i]:offsets[i + 1]], sorted by
+    /// distance. Unlike SearchRadius, the number of neighbors is not limited
+    /// by NUM_MAX_NN and the memory scales with the actual neighbor count.
+    /// Returns the total number of neighbors, or -1 on failure, including
+    /// when the total does not fit in the int offsets.
+    template <typename T>
+    int SearchRadiusCSR(const thrustcupoch::device_vector<T> &query,
+                        float radius,
+                        thrustcupoch::device_vector<int> &offsets,
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Same as SearchRadiusCSR, keeping at most \param max_nn nearest
+    /// neighbors of each query.
+    template <typename T>
+    int SearchHybridCSR(const thrustcupoch::device_vector<T> &query,
+                        float radius,
+                        int max_nn,
+                        thrustcupoch::device_vector<int> &offsets,
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Counts the neighbors within \param radius of each query without
+    /// writing the neighbor lists, so the memory is O(n) regardless of the
+    /// density. Returns the total number of neighbors, or -1 on failure.
+    template <typename T>
+    int CountRadius(const thrustcupoch::device_vector<T> &query,
+                    float radius,
+                    thrustcupoch::device_vector<int> &counts) const;
+
+    /// Mean squared distance of each query to its \param knn nearest
+    /// neighbors, accumulated during the traversal without writing the
+    /// neighbor lists. Queries without neighbors get -1. Returns the number
+    /// of queries with neighbors, or -1 on failure.
+    template <typename T>
+    int SearchKNNMeanDistance2(const thrustcupoch::device_vector<T> &query,
+                               int knn,
+                               thrustcupoch::device_vector<float> &mean_distance2) const;
+
+    /// Covariance of the neighbors of each query, selected by \param param
+    /// as in Search, accumulated during the traversal without writing the
+    /// neighbor lists. \param counts receives the number of neighbors;
+    /// queries without neighbors get a zero covariance. Unlike Search, the
+    /// radius search is not limited by NUM_MAX_NN. Returns the number of
+    /// queries with neighbors, or -1 on failure.
+    template <typename T>
+    int SearchCovariance(const thrustcupoch::device_vector<T> &query,
+                         const KDTreeSearchParam &param,
+                         thrustcupoch::device_vector<Eigen::Matrix3f> &covariances,
+                         thrustcupoch::device_vector<int> &counts) const;
 
     template <typename T>
     int Search(const T &query,
@@ -82,14 +144,31 @@ public:
                      thrust::host_vector<int> &indices,
                      thrust::host_vector<float> &distance2) const;
 
-private:
-    template <typename T>
-    bool SetRawData(const thrust::device_vector<T> &data);
-
 protected:
-    thrust::device_vector<float4> data_;
+    /// Writes the number of neighbors within \param radius of each query,
+    /// clipped to \param max_nn if it is positive.
+    void CountRadiusNeighbors(const flann::Matrix<float> &query_flann,
+                              float radius,
+                              int max_nn,
+                              int *counts) const;
+
+    /// Two-pass count-then-fill radius search shared by SearchRadiusCSR
+    /// and SearchHybridCSR. \param max_nn <= 0 means no limit.
+    int SearchCSR(const flann::Matrix<float> &query_flann,
+                  float radius,
+                  int max_nn,
+                  thrustcupoch::device_vector<int> &offsets,
+                  thrustcupoch::device_vector<int> &indices,
+                  thrustcupoch::device_vector<float> &distance2) const;
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+    typedef flann::KDTreeCuda3dIndex<flann::L2<float>> FlannIndex;
+#else
+    typedef flann::KDTreeSingleIndex<flann::L2<float>> FlannIndex;
+#endif
+    thrustcupoch::device_vector<float4> data_;
     std::unique_ptr<flann::Matrix<float>> flann_dataset_;
-    std::unique_ptr<flann::KDTreeCuda3dIndex<flann::L2<float>>> flann_index_;
+    std::unique_ptr<FlannIndex> flann_index_;
     size_t dimension_ = 0;
     size_t dataset_size_ = 0;
 };
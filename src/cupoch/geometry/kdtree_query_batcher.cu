@@ -0,0 +1,144 @@
+#include <algorithm>
+
+#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/kdtree_query_batcher.h"
+#include "cupoch/utility/console.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+NeighborQueryResult MakeResult(const int *indices,
+                               const float *distance2,
+                               int stride) {
+    NeighborQueryResult result;
+    int n = 0;
+    while (n < stride && indices[n] >= 0) ++n;
+    result.indices_.assign(indices, indices + n);
+    result.distance2_.assign(distance2, distance2 + n);
+    return result;
+}
+
+std::vector<NeighborQueryResult> MakeResults(const int *indices,
+                                             const float *distance2,
+                                             int stride,
+                                             size_t n) {
+    std::vector<NeighborQueryResult> results(n);
+    for (size_t i = 0; i < n; ++i) {
+        results[i] = MakeResult(indices + i * stride, distance2 + i * stride,
+                                stride);
+    }
+    return results;
+}
+
+}  // namespace
+
+KDTreeQueryBatcher::KDTreeQueryBatcher(const KDTreeFlann &kdtree,
+                                       const KDTreeSearchParam &param,
+                                       size_t max_batch_size)
+    : kdtree_(kdtree),
+      param_(CloneSearchParam(param)),
+      max_batch_size_(std::max(max_batch_size, size_t(1))) {
+    if (!param_) {
+        utility::LogError("[KDTreeQueryBatcher] Unknown search param type.");
+    }
+}
+
+KDTreeQueryBatcher::~KDTreeQueryBatcher() { Flush(); }
+
+std::future<NeighborQueryResult> KDTreeQueryBatcher::Enqueue(
+        const Eigen::Vector3f &query) {
+    auto promise = std::make_shared<std::promise<NeighborQueryResult>>();
+    auto future = promise->get_future();
+    Push(&query, 1,
+         [promise](const int *indices, const float *distance2, int stride) {
+             promise->set_value(MakeResult(indices, distance2, stride));
+         });
+    return future;
+}
+
+void KDTreeQueryBatcher::Enqueue(const Eigen::Vector3f &query,
+                                 Callback callback) {
+    Push(&query, 1,
+         [callback](const int *indices, const float *distance2, int stride) {
+             callback(MakeResult(indices, distance2, stride));
+         });
+}
+
+std::future<std::vector<NeighborQueryResult>> KDTreeQueryBatcher::Enqueue(
+        const Eigen::Vector3f *queries, size_t n) {
+    auto promise = std::make_shared<
+            std::promise<std::vector<NeighborQueryResult>>>();
+    auto future = promise->get_future();
+    Push(queries, n,
+         [promise, n](const int *indices, const float *distance2,
+                      int stride) {
+             promise->set_value(MakeResults(indices, distance2, stride, n));
+         });
+    return future;
+}
+
+void KDTreeQueryBatcher::Enqueue(const Eigen::Vector3f *queries,
+                                 size_t n,
+                                 BatchCallback callback) {
+    Push(queries, n,
+         [callback, n](const int *indices, const float *distance2,
+                       int stride) {
+             callback(MakeResults(indices, distance2, stride, n));
+         });
+}
+
+void KDTreeQueryBatcher::Push(const Eigen::Vector3f *queries,
+                              size_t n,
+                              Completion completion) {
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Request request = {queries_.size(), n, completion};
+        queries_.insert(queries_.end(), queries, queries + n);
+        requests_.push_back(request);
+        full = queries_.size() >= max_batch_size_;
+    }
+    if (full) Flush();
+}
+
+void KDTreeQueryBatcher::Flush() {
+    thrust::host_vector<Eigen::Vector3f> queries;
+    std::vector<Request> requests;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queries.swap(queries_);
+        requests.swap(requests_);
+    }
+    if (requests.empty()) return;
+
+    thrust::host_vector<int> indices;
+    thrust::host_vector<float> distance2;
+    int stride = 0;
+    if (param_ && !queries.empty()) {
+        thrustcupoch::device_vector<Eigen::Vector3f> queries_dv = queries;
+        thrustcupoch::device_vector<int> indices_dv;
+        thrustcupoch::device_vector<float> distance2_dv;
+        if (kdtree_.Search(queries_dv, *param_, indices_dv, distance2_dv) >=
+            0) {
+            indices = indices_dv;
+            distance2 = distance2_dv;
+            stride = indices.size() / queries.size();
+        }
+    }
+    for (const auto &request : requests) {
+        if (stride == 0) {
+            // the search failed, deliver empty rows
+            request.completion_(nullptr, nullptr, 0);
+            continue;
+        }
+        request.completion_(indices.data() + request.begin_ * stride,
+                            distance2.data() + request.begin_ * stride, stride);
+    }
+}
+
+size_t KDTreeQueryBatcher::GetNumPendingQueries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queries_.size();
+}
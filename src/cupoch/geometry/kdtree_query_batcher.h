@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include <thrust/host_vector.h>
+
+namespace cupoch {
+namespace geometry {
+
+class KDTreeFlann;
+
+/// Neighbors of a single host query, sorted by distance and without the
+/// padding of the device search results.
+struct NeighborQueryResult {
+    thrust::host_vector<int> indices_;
+    thrust::host_vector<float> distance2_;
+};
+
+/// \class KDTreeQueryBatcher
+///
+/// \brief Collects host queries and searches them in a single device launch.
+///
+/// Searching the host queries one by one with the host overloads of
+/// KDTreeFlann pays a transfer and a launch for each query. The batcher
+/// queues the queries and runs one search for all of them when Flush() is
+/// called, when max_batch_size queries are pending or when the batcher is
+/// destroyed. The results are delivered through futures or callbacks; the
+/// callbacks are called on the thread that flushes.
+class KDTreeQueryBatcher {
+public:
+    typedef std::function<void(const NeighborQueryResult &)> Callback;
+    typedef std::function<void(const std::vector<NeighborQueryResult> &)>
+            BatchCallback;
+
+    /// \param kdtree must outlive the batcher.
+    KDTreeQueryBatcher(const KDTreeFlann &kdtree,
+                       const KDTreeSearchParam &param,
+                       size_t max_batch_size = 65536);
+    ~KDTreeQueryBatcher();
+    KDTreeQueryBatcher(const KDTreeQueryBatcher &) = delete;
+    KDTreeQueryBatcher &operator=(const KDTreeQueryBatcher &) = delete;
+
+public:
+    std::future<NeighborQueryResult> Enqueue(const Eigen::Vector3f &query);
+    void Enqueue(const Eigen::Vector3f &query, Callback callback);
+
+    /// Enqueues \param n queries starting at \param queries. The results are
+    /// in the order of the queries.
+    std::future<std::vector<NeighborQueryResult>> Enqueue(
+            const Eigen::Vector3f *queries, size_t n);
+    void Enqueue(const Eigen::Vector3f *queries,
+                 size_t n,
+                 BatchCallback callback);
+
+    /// Searches all the pending queries and delivers their results.
+    void Flush();
+
+    size_t GetNumPendingQueries() const;
+
+private:
+    /// Receives the padded result rows of a request.
+    typedef std::function<void(const int *indices, const float *distance2,
+                               int stride)>
+            Completion;
+
+    struct Request {
+        size_t begin_;
+        size_t size_;
+        Completion completion_;
+    };
+
+    void Push(const Eigen::Vector3f *queries, size_t n, Completion completion);
+
+    const KDTreeFlann &kdtree_;
+    std::unique_ptr<KDTreeSearchParam> param_;
+    const size_t max_batch_size_;
+    mutable std::mutex mutex_;
+    thrust::host_vector<Eigen::Vector3f> queries_;
+    std::vector<Request> requests_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
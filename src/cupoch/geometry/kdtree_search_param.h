@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 namespace cupoch {
 namespace geometry {
 
@@ -57,5 +59,25 @@ public:
     int max_nn_;
 };
 
+/// Returns a copy of \param param with the same dynamic type, or an empty
+/// pointer for an unknown search type.
+inline std::unique_ptr<KDTreeSearchParam> CloneSearchParam(
+        const KDTreeSearchParam &param) {
+    switch (param.GetSearchType()) {
+        case KDTreeSearchParam::SearchType::Knn:
+            return std::unique_ptr<KDTreeSearchParam>(new KDTreeSearchParamKNN(
+                    ((const KDTreeSearchParamKNN &)param).knn_));
+        case KDTreeSearchParam::SearchType::Radius:
+            return std::unique_ptr<KDTreeSearchParam>(new KDTreeSearchParamRadius(
+                    ((const KDTreeSearchParamRadius &)param).radius_));
+        case KDTreeSearchParam::SearchType::Hybrid:
+            return std::unique_ptr<KDTreeSearchParam>(new KDTreeSearchParamHybrid(
+                    ((const KDTreeSearchParamHybrid &)param).radius_,
+                    ((const KDTreeSearchParamHybrid &)param).max_nn_));
+        default:
+            return std::unique_ptr<KDTreeSearchParam>();
+    }
+}
+
 }  // namespace geometry
-}  // namespace cupoch
\ No newline at end of file
+}  // namespace cupoch
@@ -1,6 +1,7 @@
 #include "cupoch/geometry/meshbase.h"
 #include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/execution_context.h"
 
 using namespace cupoch;
 using namespace cupoch::geometry;
@@ -9,12 +10,15 @@ MeshBase::MeshBase() : Geometry3D(Geometry::GeometryType::MeshBase) {}
 MeshBase::~MeshBase() {}
 MeshBase::MeshBase(const MeshBase& other)
     : Geometry3D(Geometry::GeometryType::MeshBase), vertices_(other.vertices_),
-      vertex_normals_(other.vertex_normals_), vertex_colors_(other.vertex_colors_) {}
+      vertex_normals_(other.vertex_normals_), vertex_colors_(other.vertex_colors_),
+      generation_(other.generation_), kdtree_cache_(other.kdtree_cache_) {}
 
 MeshBase& MeshBase::operator=(const MeshBase& other) {
     vertices_ = other.vertices_;
     vertex_normals_ = other.vertex_normals_;
     vertex_colors_ = other.vertex_colors_;
+    ++generation_;
+    kdtree_cache_ = other.kdtree_cache_;
     return *this;
 }
 
@@ -25,6 +29,7 @@ thrust::host_vector<Eigen::Vector3f> MeshBase::GetVertices() const {
 
 void MeshBase::SetVertices(const thrust::host_vector<Eigen::Vector3f>& vertices) {
     vertices_ = vertices;
+    InvalidateKDTree();
 }
 
 thrust::host_vector<Eigen::Vector3f> MeshBase::GetVertexNormals() const {
@@ -49,6 +54,7 @@ MeshBase &MeshBase::Clear() {
     vertices_.clear();
     vertex_normals_.clear();
     vertex_colors_.clear();
+    InvalidateKDTree();
     return *this;
 }
 
@@ -71,25 +77,29 @@ AxisAlignedBoundingBox MeshBase::GetAxisAlignedBoundingBox() const {
 MeshBase &MeshBase::Transform(const Eigen::Matrix4f &transformation) {
     TransformPoints(utility::GetStream(0), transformation, vertices_);
     TransformNormals(utility::GetStream(1), transformation, vertex_normals_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
+    InvalidateKDTree();
     return *this;
 }
 
 MeshBase &MeshBase::Translate(const Eigen::Vector3f &translation,
                               bool relative) {
     TranslatePoints(translation, vertices_, relative);
+    InvalidateKDTree();
     return *this;
 }
 
 MeshBase &MeshBase::Scale(const float scale, bool center) {
     ScalePoints(scale, vertices_, center);
+    InvalidateKDTree();
     return *this;
 }
 
 MeshBase &MeshBase::Rotate(const Eigen::Matrix3f &R, bool center) {
     RotatePoints(utility::GetStream(0), R, vertices_, center);
     RotateNormals(utility::GetStream(0), R, vertex_normals_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
+    InvalidateKDTree();
     return *this;
 }
 
@@ -112,6 +122,7 @@ MeshBase &MeshBase::operator+=(const MeshBase &mesh) {
     }
     vertices_.resize(new_vert_num);
     thrust::copy(mesh.vertices_.begin(), mesh.vertices_.end(), vertices_.begin() + old_vert_num);
+    InvalidateKDTree();
     return (*this);
 }
 
@@ -119,9 +130,28 @@ MeshBase MeshBase::operator+(const MeshBase &mesh) const {
     return (MeshBase(*this) += mesh);
 }
 
+std::shared_ptr<const KDTreeFlann> MeshBase::GetKDTree() const {
+    return kdtree_cache_->GetKDTree(vertices_);
+}
+
+std::shared_ptr<const NeighborSearchResult> MeshBase::SearchNeighbors(
+        const KDTreeSearchParam &param) const {
+    return kdtree_cache_->SearchNeighbors(vertices_, param);
+}
+
+std::shared_ptr<const NeighborSearchResult> MeshBase::SearchNeighborsCSR(
+        const KDTreeSearchParam &param) const {
+    return kdtree_cache_->SearchNeighborsCSR(vertices_, param);
+}
+
+void MeshBase::InvalidateKDTree() {
+    ++generation_;
+    kdtree_cache_ = std::make_shared<KDTreeCache>();
+}
+
 MeshBase &MeshBase::NormalizeNormals() {
     thrust::for_each(vertex_normals_.begin(), vertex_normals_.end(),
-                     [] __device__ (Eigen::Vector3f& nl) {
+                     [] __host__ __device__ (Eigen::Vector3f& nl) {
                          nl.normalize();
                          if (std::isnan(nl(0))) {
                             nl = Eigen::Vector3f(0.0, 0.0, 1.0);
@@ -133,13 +163,13 @@ MeshBase &MeshBase::NormalizeNormals() {
 MeshBase::MeshBase(Geometry::GeometryType type) : Geometry3D(type) {}
 
 MeshBase::MeshBase(Geometry::GeometryType type,
-         const thrust::device_vector<Eigen::Vector3f> &vertices)
+         const thrustcupoch::device_vector<Eigen::Vector3f> &vertices)
     : Geometry3D(type), vertices_(vertices) {}
 
 MeshBase::MeshBase(Geometry::GeometryType type,
-                   const thrust::device_vector<Eigen::Vector3f> &vertices,
-                   const thrust::device_vector<Eigen::Vector3f> &vertex_normals,
-                   const thrust::device_vector<Eigen::Vector3f> &vertex_colors)
+                   const thrustcupoch::device_vector<Eigen::Vector3f> &vertices,
+                   const thrustcupoch::device_vector<Eigen::Vector3f> &vertex_normals,
+                   const thrustcupoch::device_vector<Eigen::Vector3f> &vertex_colors)
     : Geometry3D(type), vertices_(vertices),
       vertex_normals_(vertex_normals), vertex_colors_(vertex_colors) {}
 
@@ -1,10 +1,11 @@
 #pragma once
 
 #include <Eigen/Core>
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
 #include <thrust/host_vector.h>
 
 #include "cupoch/geometry/geometry3d.h"
+#include "cupoch/geometry/kdtree_cache.h"
 #include "cupoch/utility/helper.h"
 
 namespace cupoch {
@@ -78,6 +79,28 @@ public:
                vertex_colors_.size() == vertices_.size();
     }
 
+    /// Returns the KD-tree of vertices_, built on first use and reused until
+    /// the vertices are modified. Direct writes to vertices_ are detected
+    /// from a fingerprint of the vertices; InvalidateKDTree() skips that
+    /// check.
+    std::shared_ptr<const KDTreeFlann> GetKDTree() const;
+
+    /// Searches the neighbors of all the vertices in the mesh itself.
+    /// The results are memoized per search parameter.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighbors(
+            const KDTreeSearchParam &param) const;
+
+    /// Same as SearchNeighbors for radius and hybrid parameters, returning
+    /// the neighbors in the CSR layout without the NUM_MAX_NN limit.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighborsCSR(
+            const KDTreeSearchParam &param) const;
+
+    /// Drops the cached KD-tree and search results.
+    void InvalidateKDTree();
+
+    /// Counter incremented whenever the vertices are modified.
+    size_t GetGeneration() const { return generation_; }
+
     MeshBase &NormalizeNormals();
 
     /// Assigns each vertex in the TriangleMesh the same color \param color.
@@ -90,17 +113,21 @@ protected:
     // Forward child class type to avoid indirect nonvirtual base
     MeshBase(Geometry::GeometryType type);
     MeshBase(Geometry::GeometryType type,
-             const thrust::device_vector<Eigen::Vector3f> &vertices);
+             const thrustcupoch::device_vector<Eigen::Vector3f> &vertices);
     MeshBase(Geometry::GeometryType type,
-             const thrust::device_vector<Eigen::Vector3f> &vertices,
-             const thrust::device_vector<Eigen::Vector3f> &vertex_normals,
-             const thrust::device_vector<Eigen::Vector3f> &vertex_colors);
+             const thrustcupoch::device_vector<Eigen::Vector3f> &vertices,
+             const thrustcupoch::device_vector<Eigen::Vector3f> &vertex_normals,
+             const thrustcupoch::device_vector<Eigen::Vector3f> &vertex_colors);
     MeshBase(Geometry::GeometryType type,
              const thrust::host_vector<Eigen::Vector3f> &vertices);
 public:
-    thrust::device_vector<Eigen::Vector3f> vertices_;
-    thrust::device_vector<Eigen::Vector3f> vertex_normals_;
-    thrust::device_vector<Eigen::Vector3f> vertex_colors_;
+    thrustcupoch::device_vector<Eigen::Vector3f> vertices_;
+    thrustcupoch::device_vector<Eigen::Vector3f> vertex_normals_;
+    thrustcupoch::device_vector<Eigen::Vector3f> vertex_colors_;
+
+private:
+    size_t generation_ = 0;
+    std::shared_ptr<KDTreeCache> kdtree_cache_ = std::make_shared<KDTreeCache>();
 };
 
 }
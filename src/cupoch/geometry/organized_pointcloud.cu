@@ -0,0 +1,137 @@
+#include "cupoch/geometry/organized_pointcloud.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+struct is_valid_pixel_functor {
+    __host__ __device__
+    bool operator() (uint8_t mask) const {
+        return mask != 0;
+    }
+};
+
+struct search_window_functor {
+    search_window_functor(const Eigen::Vector3f* points, const uint8_t* mask,
+                          int width, int height, int window_radius,
+                          float max_distance2, int* indices, float* distance2)
+        : points_(points), mask_(mask), width_(width), height_(height),
+          window_radius_(window_radius), max_distance2_(max_distance2),
+          n_slots_((2 * window_radius + 1) * (2 * window_radius + 1) - 1),
+          indices_(indices), distance2_(distance2) {};
+    const Eigen::Vector3f* points_;
+    const uint8_t* mask_;
+    const int width_;
+    const int height_;
+    const int window_radius_;
+    const float max_distance2_;
+    const int n_slots_;
+    int* indices_;
+    float* distance2_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        int* indices = indices_ + idx * n_slots_;
+        float* distance2 = distance2_ + idx * n_slots_;
+        int count = 0;
+        if (mask_[idx]) {
+            const int row = idx / width_;
+            const int col = idx % width_;
+            const Eigen::Vector3f& pt = points_[idx];
+            for (int r = max(row - window_radius_, 0);
+                 r <= min(row + window_radius_, height_ - 1); ++r) {
+                for (int c = max(col - window_radius_, 0);
+                     c <= min(col + window_radius_, width_ - 1); ++c) {
+                    const int j = r * width_ + c;
+                    if (j == int(idx) || !mask_[j]) continue;
+                    const float d2 = (points_[j] - pt).squaredNorm();
+                    if (max_distance2_ > 0.0 && d2 > max_distance2_) continue;
+                    indices[count] = j;
+                    distance2[count] = d2;
+                    ++count;
+                }
+            }
+        }
+        for (int k = count; k < n_slots_; ++k) {
+            indices[k] = -1;
+            distance2[k] = 0.0;
+        }
+    }
+};
+
+}  // namespace
+
+OrganizedPointCloud::OrganizedPointCloud() {}
+OrganizedPointCloud::~OrganizedPointCloud() {}
+
+std::shared_ptr<PointCloud> OrganizedPointCloud::ToPointCloud() const {
+    auto pointcloud = std::make_shared<PointCloud>();
+    const size_t n_valid = CountValidPoints();
+    pointcloud->points_.resize(n_valid);
+    thrust::copy_if(points_.begin(), points_.end(), mask_.begin(),
+                    pointcloud->points_.begin(), is_valid_pixel_functor());
+    if (HasNormals()) {
+        pointcloud->normals_.resize(n_valid);
+        thrust::copy_if(normals_.begin(), normals_.end(), mask_.begin(),
+                        pointcloud->normals_.begin(), is_valid_pixel_functor());
+    }
+    if (HasColors()) {
+        pointcloud->colors_.resize(n_valid);
+        thrust::copy_if(colors_.begin(), colors_.end(), mask_.begin(),
+                        pointcloud->colors_.begin(), is_valid_pixel_functor());
+    }
+    return pointcloud;
+}
+
+OrganizedPointCloud &OrganizedPointCloud::Clear() {
+    width_ = 0;
+    height_ = 0;
+    viewpoint_ = Eigen::Vector3f::Zero();
+    points_.clear();
+    normals_.clear();
+    colors_.clear();
+    mask_.clear();
+    return *this;
+}
+
+bool OrganizedPointCloud::IsEmpty() const { return points_.empty(); }
+
+size_t OrganizedPointCloud::Size() const { return size_t(width_) * height_; }
+
+size_t OrganizedPointCloud::CountValidPoints() const {
+    return thrust::count_if(mask_.begin(), mask_.end(), is_valid_pixel_functor());
+}
+
+bool OrganizedPointCloud::HasNormals() const {
+    return !points_.empty() && normals_.size() == points_.size();
+}
+
+bool OrganizedPointCloud::HasColors() const {
+    return !points_.empty() && colors_.size() == points_.size();
+}
+
+int OrganizedPointCloud::SearchNeighbors(int window_radius,
+                                         float max_distance,
+                                         thrustcupoch::device_vector<int> &indices,
+                                         thrustcupoch::device_vector<float> &distance2) const {
+    if (window_radius <= 0 || IsEmpty() || points_.size() != Size() ||
+        mask_.size() != Size()) {
+        utility::LogError("[OrganizedPointCloud::SearchNeighbors] Invalid window radius or point cloud.");
+        return -1;
+    }
+    const int n_slots = (2 * window_radius + 1) * (2 * window_radius + 1) - 1;
+    indices.resize(Size() * n_slots);
+    distance2.resize(Size() * n_slots);
+    search_window_functor func(thrust::raw_pointer_cast(points_.data()),
+                               thrust::raw_pointer_cast(mask_.data()),
+                               width_, height_, window_radius,
+                               max_distance * max_distance,
+                               thrust::raw_pointer_cast(indices.data()),
+                               thrust::raw_pointer_cast(distance2.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(Size()), func);
+    return n_slots;
+}
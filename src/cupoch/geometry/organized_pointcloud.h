@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+
+#include "cupoch/utility/eigen.h"
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+
+namespace camera {
+class PinholeCameraIntrinsic;
+}
+
+namespace geometry {
+
+class Image;
+class RGBDImage;
+class PointCloud;
+
+/// \class OrganizedPointCloud
+///
+/// \brief Point cloud keeping the pixel grid of the depth image it was
+/// created from.
+///
+/// The point of pixel (row, col) is points_[row * width_ + col]. Pixels
+/// without a valid depth are kept with mask_ set to 0, their points are
+/// infinite. Neighbors are found in a pixel window instead of a KD-tree.
+class OrganizedPointCloud {
+public:
+    enum class NormalMethod {
+        /// Cross product of the horizontal and vertical pixel differences
+        CrossProduct = 0,
+        /// Smallest eigenvector of the window covariance summed from
+        /// integral images
+        IntegralImage = 1,
+    };
+
+    OrganizedPointCloud();
+    ~OrganizedPointCloud();
+
+    /// Factory function to create an organized point cloud from a depth
+    /// image and a camera model, see PointCloud::CreateFromDepthImage.
+    static std::shared_ptr<OrganizedPointCloud> CreateFromDepthImage(
+            const Image &depth,
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4f &extrinsic = Eigen::Matrix4f::Identity(),
+            float depth_scale = 1000.0,
+            float depth_trunc = 1000.0);
+
+    /// Factory function to create an organized point cloud from an RGB-D
+    /// image and a camera model, see PointCloud::CreateFromRGBDImage.
+    static std::shared_ptr<OrganizedPointCloud> CreateFromRGBDImage(
+            const RGBDImage &image,
+            const camera::PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4f &extrinsic = Eigen::Matrix4f::Identity());
+
+    /// Returns a PointCloud of the valid pixels in row-major order.
+    std::shared_ptr<PointCloud> ToPointCloud() const;
+
+    OrganizedPointCloud &Clear();
+    bool IsEmpty() const;
+    /// Number of pixels, width_ * height_.
+    size_t Size() const;
+    size_t CountValidPoints() const;
+    bool HasNormals() const;
+    bool HasColors() const;
+
+    /// Estimates the normals of the valid pixels from the pixels within
+    /// \param window_radius. With the cross product method, neighbors
+    /// farther than \param max_distance from the center point (0 for no
+    /// limit) are skipped so that normals do not bend across depth
+    /// discontinuities. Normals are oriented towards viewpoint_, pixels
+    /// without enough neighbors get (0, 0, 1).
+    bool EstimateNormals(NormalMethod method = NormalMethod::CrossProduct,
+                         int window_radius = 1,
+                         float max_distance = 0.0);
+
+    /// Searches the valid pixels within \param window_radius of each pixel
+    /// and within \param max_distance (0 for no limit) of its point.
+    /// The neighbors of the i-th pixel are
+    /// indices[i * n : (i + 1) * n], padded with -1, where n is the
+    /// returned number of slots per pixel, (2 * window_radius + 1)^2 - 1.
+    /// Returns -1 on invalid arguments.
+    int SearchNeighbors(int window_radius,
+                        float max_distance,
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const;
+
+public:
+    int width_ = 0;
+    int height_ = 0;
+    /// Camera center the points were observed from.
+    Eigen::Vector3f viewpoint_ = Eigen::Vector3f::Zero();
+    thrustcupoch::device_vector<Eigen::Vector3f> points_;
+    thrustcupoch::device_vector<Eigen::Vector3f> normals_;
+    thrustcupoch::device_vector<Eigen::Vector3f> colors_;
+    thrustcupoch::device_vector<uint8_t> mask_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -1,11 +1,16 @@
 #include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/kdtree_cache.h"
 #include "cupoch/geometry/boundingvolume.h"
 #include "cupoch/geometry/image.h"
+#include "cupoch/geometry/voxel_key.h"
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/utility/console.h"
 #include "cupoch/utility/helper.h"
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/execution_context.h"
 #include <thrust/gather.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
 
 using namespace cupoch;
 using namespace cupoch::geometry;
@@ -17,7 +22,7 @@ struct check_nan_functor {
         : remove_nan_(remove_nan), remove_infinite_(remove_infinite) {};
     const bool remove_nan_;
     const bool remove_infinite_;
-    __device__
+    __host__ __device__
     bool operator()(const Eigen::Vector3f& point) const {
         bool is_nan = remove_nan_ &&
                       (std::isnan(point(0)) || std::isnan(point(1)) ||
@@ -29,11 +34,56 @@ struct check_nan_functor {
     }
 };
 
+struct pack_aligned_functor {
+    __host__ __device__
+    Eigen::Vector4f operator()(const Eigen::Vector3f& x) const {
+        return Eigen::Vector4f(x[0], x[1], x[2], 0.0);
+    }
+};
+
+struct unpack_aligned_functor {
+    __host__ __device__
+    Eigen::Vector3f operator()(const Eigen::Vector4f& x) const {
+        return x.head<3>();
+    }
+};
+
+struct compute_morton_code_functor {
+    compute_morton_code_functor(const Eigen::Vector3f& min_bound, float voxel_size)
+        : min_bound_(min_bound), voxel_size_(voxel_size) {};
+    const Eigen::Vector3f min_bound_;
+    const float voxel_size_;
+    __host__ __device__
+    uint64_t operator()(const Eigen::Vector3f& pt) const {
+        return MortonEncode(ComputeVoxelIndex(pt, min_bound_, voxel_size_));
+    }
+};
+
+struct rotate_covariance_functor {
+    rotate_covariance_functor(const Eigen::Matrix3f& R) : R_(R) {};
+    const Eigen::Matrix3f R_;
+    __host__ __device__
+    void operator() (Eigen::Matrix3f& covariance) const {
+        covariance = R_ * covariance * R_.transpose();
+    }
+};
+
+template <typename T>
+void GatherInPlace(const thrustcupoch::device_vector<size_t>& permutation,
+                   thrustcupoch::device_vector<T>& data) {
+    thrustcupoch::device_vector<T> sorted(data.size());
+    thrust::gather(permutation.begin(), permutation.end(), data.begin(), sorted.begin());
+    data.swap(sorted);
+}
+
 }
 
 PointCloud::PointCloud() : Geometry3D(Geometry::GeometryType::PointCloud) {}
 PointCloud::PointCloud(const thrust::host_vector<Eigen::Vector3f>& points) : Geometry3D(Geometry::GeometryType::PointCloud), points_(points) {}
-PointCloud::PointCloud(const PointCloud& other) : Geometry3D(Geometry::GeometryType::PointCloud), points_(other.points_), normals_(other.normals_), colors_(other.colors_) {}
+PointCloud::PointCloud(const PointCloud& other)
+    : Geometry3D(Geometry::GeometryType::PointCloud), points_(other.points_), normals_(other.normals_), colors_(other.colors_),
+      covariances_(other.covariances_),
+      generation_(other.generation_), kdtree_cache_(other.kdtree_cache_) {}
 
 PointCloud::~PointCloud() {}
 
@@ -41,11 +91,15 @@ PointCloud& PointCloud::operator=(const PointCloud& other) {
     points_ = other.points_;
     normals_ = other.normals_;
     colors_ = other.colors_;
+    covariances_ = other.covariances_;
+    ++generation_;
+    kdtree_cache_ = other.kdtree_cache_;
     return *this;
 }
 
 void PointCloud::SetPoints(const thrust::host_vector<Eigen::Vector3f>& points) {
     points_ = points;
+    InvalidateKDTree();
 }
 
 thrust::host_vector<Eigen::Vector3f> PointCloud::GetPoints() const {
@@ -53,6 +107,18 @@ thrust::host_vector<Eigen::Vector3f> PointCloud::GetPoints() const {
     return points;
 }
 
+thrustcupoch::device_vector<Eigen::Vector4f> PointCloud::GetAlignedPoints() const {
+    thrustcupoch::device_vector<Eigen::Vector4f> aligned(points_.size());
+    thrust::transform(points_.begin(), points_.end(), aligned.begin(), pack_aligned_functor());
+    return aligned;
+}
+
+void PointCloud::SetAlignedPoints(const thrustcupoch::device_vector<Eigen::Vector4f>& points) {
+    points_.resize(points.size());
+    thrust::transform(points.begin(), points.end(), points_.begin(), unpack_aligned_functor());
+    InvalidateKDTree();
+}
+
 void PointCloud::SetNormals(const thrust::host_vector<Eigen::Vector3f>& normals) {
     normals_ = normals;
 }
@@ -75,6 +141,8 @@ PointCloud &PointCloud::Clear() {
     points_.clear();
     normals_.clear();
     colors_.clear();
+    covariances_.clear();
+    InvalidateKDTree();
     return *this;
 }
 
@@ -99,23 +167,27 @@ AxisAlignedBoundingBox PointCloud::GetAxisAlignedBoundingBox() const {
 PointCloud& PointCloud::Translate(const Eigen::Vector3f &translation,
                                   bool relative) {
     TranslatePoints(translation, points_, relative);
+    InvalidateKDTree();
     return *this;
 }
 
 PointCloud& PointCloud::Scale(const float scale, bool center) {
     ScalePoints(scale, points_, center);
+    InvalidateKDTree();
     return *this;
 }
 
 PointCloud &PointCloud::Rotate(const Eigen::Matrix3f &R, bool center) {
     RotatePoints(utility::GetStream(0), R, points_, center);
     RotateNormals(utility::GetStream(1), R, normals_);
-    cudaSafeCall(cudaDeviceSynchronize());
+    utility::GetExecutionContext().Synchronize();
+    thrust::for_each(covariances_.begin(), covariances_.end(), rotate_covariance_functor(R));
+    InvalidateKDTree();
     return *this;
 }
 
 PointCloud &PointCloud::NormalizeNormals() {
-    thrust::for_each(normals_.begin(), normals_.end(), [] __device__ (Eigen::Vector3f& nl) {nl.normalize();});
+    thrust::for_each(normals_.begin(), normals_.end(), [] __host__ __device__ (Eigen::Vector3f& nl) {nl.normalize();});
     return *this;
 }
 
@@ -127,10 +199,32 @@ PointCloud &PointCloud::PaintUniformColor(const Eigen::Vector3f &color) {
 PointCloud& PointCloud::Transform(const Eigen::Matrix4f& transformation) {
     TransformPoints(utility::GetStream(0), transformation, points_);
     TransformNormals(utility::GetStream(1), transformation, normals_);
-    cudaSafeCall(cudaDeviceSynchronize());
+    utility::GetExecutionContext().Synchronize();
+    thrust::for_each(covariances_.begin(), covariances_.end(),
+                     rotate_covariance_functor(transformation.block<3, 3>(0, 0)));
+    InvalidateKDTree();
     return *this;
 }
 
+std::shared_ptr<const KDTreeFlann> PointCloud::GetKDTree() const {
+    return kdtree_cache_->GetKDTree(points_);
+}
+
+std::shared_ptr<const NeighborSearchResult> PointCloud::SearchNeighbors(
+        const KDTreeSearchParam &param) const {
+    return kdtree_cache_->SearchNeighbors(points_, param);
+}
+
+std::shared_ptr<const NeighborSearchResult> PointCloud::SearchNeighborsCSR(
+        const KDTreeSearchParam &param) const {
+    return kdtree_cache_->SearchNeighborsCSR(points_, param);
+}
+
+void PointCloud::InvalidateKDTree() {
+    ++generation_;
+    kdtree_cache_ = std::make_shared<KDTreeCache>();
+}
+
 std::shared_ptr<PointCloud> PointCloud::Crop(
         const AxisAlignedBoundingBox &bbox) const {
     if (bbox.IsEmpty()) {
@@ -141,36 +235,79 @@ std::shared_ptr<PointCloud> PointCloud::Crop(
     return SelectDownSample(bbox.GetPointIndicesWithinBoundingBox(points_));
 }
 
+std::shared_ptr<PointCloud> PointCloud::Crop(
+        const OrientedBoundingBox &bbox) const {
+    if (bbox.IsEmpty()) {
+        utility::LogError(
+                "[CropPointCloud] OrientedBoundingBox either has zeros "
+                "size, or has wrong bounds.");
+    }
+    return SelectDownSample(bbox.GetPointIndicesWithinBoundingBox(points_));
+}
+
 PointCloud &PointCloud::RemoveNoneFinitePoints(bool remove_nan, bool remove_infinite) {
     bool has_normal = HasNormals();
     bool has_color = HasColors();
+    bool has_covariance = HasCovariances();
     size_t old_point_num = points_.size();
-    size_t k = 0;
-    check_nan_functor func(remove_nan, remove_infinite);
-    if (!has_normal && !has_color) {
-        auto end = thrust::remove_if(points_.begin(), points_.end(), func);
-        k = thrust::distance(points_.begin(), end);
-    } else if (has_normal && !has_color) {
-        auto begin = make_tuple_iterator(points_.begin(), normals_.begin());
-        auto end = thrust::remove_if(begin, make_tuple_iterator(points_.end(), normals_.end()),
-                                     points_.begin(), func);
-        k = thrust::distance(begin, end);
-    } else if (!has_normal && has_color) {
-        auto begin = make_tuple_iterator(points_.begin(), colors_.begin());
-        auto end = thrust::remove_if(begin, make_tuple_iterator(points_.end(), colors_.end()),
-                                     points_.begin(), func);
-        k = thrust::distance(begin, end);
-    } else {
-        auto begin = make_tuple_iterator(points_.begin(), normals_.begin(), colors_.begin());
-        auto end = thrust::remove_if(begin, make_tuple_iterator(points_.end(), normals_.end(), colors_.end()),
-                                     points_.begin(), func);
-        k = thrust::distance(begin, end);
-    }
+    // the removed points are flagged once and every attribute is compacted
+    // with the same stencil
+    thrustcupoch::device_vector<int> removed(old_point_num);
+    thrust::transform(points_.begin(), points_.end(), removed.begin(),
+                      check_nan_functor(remove_nan, remove_infinite));
+    auto end = thrust::remove_if(points_.begin(), points_.end(), removed.begin(),
+                                 thrust::identity<int>());
+    const size_t k = thrust::distance(points_.begin(), end);
     points_.resize(k);
-    if (has_normal) normals_.resize(k);
-    if (has_color) colors_.resize(k);
+    if (has_normal) {
+        thrust::remove_if(normals_.begin(), normals_.end(), removed.begin(),
+                          thrust::identity<int>());
+        normals_.resize(k);
+    }
+    if (has_color) {
+        thrust::remove_if(colors_.begin(), colors_.end(), removed.begin(),
+                          thrust::identity<int>());
+        colors_.resize(k);
+    }
+    if (has_covariance) {
+        thrust::remove_if(covariances_.begin(), covariances_.end(), removed.begin(),
+                          thrust::identity<int>());
+        covariances_.resize(k);
+    }
     utility::LogDebug(
             "[RemoveNoneFinitePoints] {:d} nan points have been removed.",
             (int)(old_point_num - k));
+    InvalidateKDTree();
     return *this; 
 }
+
+thrustcupoch::device_vector<size_t> PointCloud::SortSpatially(float voxel_size) {
+    thrustcupoch::device_vector<size_t> permutation(points_.size());
+    thrust::sequence(permutation.begin(), permutation.end());
+    if (!HasPoints()) return permutation;
+    const Eigen::Vector3f min_bound = GetMinBound();
+    const float extent = (GetMaxBound() - min_bound).maxCoeff();
+    const float min_voxel_size = extent / ((1 << MORTON_CODE_BITS) - 1);
+    if (voxel_size <= 0.0) {
+        voxel_size = min_voxel_size;
+    } else if (voxel_size < min_voxel_size) {
+        utility::LogWarning("[SortSpatially] voxel_size {:f} is too small, using {:f}.",
+                            voxel_size, min_voxel_size);
+        voxel_size = min_voxel_size;
+    }
+    if (voxel_size <= 0.0) return permutation;  // all the points coincide
+
+    thrustcupoch::device_vector<uint64_t> codes(points_.size());
+    thrust::transform(points_.begin(), points_.end(), codes.begin(),
+                      compute_morton_code_functor(min_bound, voxel_size));
+    thrust::stable_sort_by_key(codes.begin(), codes.end(), permutation.begin());
+    const bool has_normals = HasNormals();
+    const bool has_colors = HasColors();
+    const bool has_covariances = HasCovariances();
+    GatherInPlace(permutation, points_);
+    if (has_normals) GatherInPlace(permutation, normals_);
+    if (has_colors) GatherInPlace(permutation, colors_);
+    if (has_covariances) GatherInPlace(permutation, covariances_);
+    InvalidateKDTree();
+    return permutation;
+}
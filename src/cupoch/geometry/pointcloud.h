@@ -2,8 +2,11 @@
 #include "cupoch/geometry/geometry3d.h"
 #include "cupoch/utility/eigen.h"
 #include "cupoch/geometry/kdtree_search_param.h"
-#include <thrust/device_vector.h>
+#include "cupoch/geometry/kdtree_cache.h"
+#include "cupoch/utility/thrust_cupoch.h"
 #include <thrust/host_vector.h>
+#include <limits>
+#include <vector>
 
 namespace cupoch {
 
@@ -15,6 +18,7 @@ namespace geometry {
 
 class Image;
 class RGBDImage;
+struct SegmentStatistics;
 
 class PointCloud : public Geometry3D {
 public:
@@ -33,6 +37,14 @@ public:
     void SetColors(const thrust::host_vector<Eigen::Vector3f>& colors);
     thrust::host_vector<Eigen::Vector3f> GetColors() const;
 
+    /// Packs the points into 16-byte aligned (x, y, z, 0) vectors.
+    /// KDTreeFlann and the aligned Geometry3D overloads consume this layout
+    /// without per-call conversion.
+    thrustcupoch::device_vector<Eigen::Vector4f> GetAlignedPoints() const;
+    /// Sets the points from 16-byte aligned vectors, the 4th element is
+    /// ignored.
+    void SetAlignedPoints(const thrustcupoch::device_vector<Eigen::Vector4f>& points);
+
     PointCloud &Clear() override;
     bool IsEmpty() const override;
     Eigen::Vector3f GetMinBound() const override;
@@ -58,6 +70,34 @@ public:
         return !points_.empty() && colors_.size() == points_.size();
     }
 
+    __host__ __device__
+    bool HasCovariances() const {
+        return !points_.empty() && covariances_.size() == points_.size();
+    }
+
+    /// Returns the KD-tree of points_. The tree is built on first use and
+    /// reused until the points are modified. Direct writes to points_ are
+    /// detected from a fingerprint of the points; InvalidateKDTree() skips
+    /// that check.
+    std::shared_ptr<const KDTreeFlann> GetKDTree() const;
+
+    /// Searches the neighbors of all the points in the point cloud itself.
+    /// The results are memoized per search parameter together with the
+    /// KD-tree.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighbors(
+            const KDTreeSearchParam &param) const;
+
+    /// Same as SearchNeighbors for radius and hybrid parameters, returning
+    /// the neighbors in the CSR layout without the NUM_MAX_NN limit.
+    std::shared_ptr<const NeighborSearchResult> SearchNeighborsCSR(
+            const KDTreeSearchParam &param) const;
+
+    /// Drops the cached KD-tree and search results.
+    void InvalidateKDTree();
+
+    /// Counter incremented whenever the points are modified.
+    size_t GetGeneration() const { return generation_; }
+
     PointCloud &NormalizeNormals();
 
     /// Assigns each point in the PointCloud the same color \param color.
@@ -69,10 +109,21 @@ public:
     PointCloud &RemoveNoneFinitePoints(bool remove_nan = true,
                                        bool remove_infinite = true);
 
+    /// Reorders the points, normals and colors along a Morton (Z-order)
+    /// curve over voxels of size \param voxel_size, so that points close in
+    /// space are close in memory. The KD-tree and the neighbor searches of
+    /// the point cloud then visit the points in this order, which improves
+    /// the memory locality of the gather-heavy kernels (normals, FPFH, ICP).
+    /// A \param voxel_size of 0 uses the finest grid of the 21-bit codes.
+    /// The points must be finite.
+    /// Returns the permutation: the i-th point after sorting is the
+    /// permutation[i]-th point before.
+    thrustcupoch::device_vector<size_t> SortSpatially(float voxel_size = 0.0);
+
     /// Function to select points from \param input pointcloud into
     /// \return output pointcloud
     /// Points with indices in \param indices are selected.
-    std::shared_ptr<PointCloud> SelectDownSample(const thrust::device_vector<size_t> &indices, bool invert = false) const;
+    std::shared_ptr<PointCloud> SelectDownSample(const thrustcupoch::device_vector<size_t> &indices, bool invert = false) const;
 
     /// Function to downsample \param input pointcloud into output pointcloud
     /// with a voxel \param voxel_size defines the resolution of the voxel grid,
@@ -80,19 +131,83 @@ public:
     /// averaged if they exist.
     std::shared_ptr<PointCloud> VoxelDownSample(float voxel_size) const;
 
+    /// Same as VoxelDownSample, also returning which input points fell into
+    /// each output voxel. Returns the output point cloud, the voxel index of
+    /// each input point, and the voxels in CSR form: the input points of the
+    /// i-th voxel are indices[offsets[i]:offsets[i + 1]]. The voxels are
+    /// ordered by their Morton code, so the extent of the cloud is limited to
+    /// 2^21 - 1 voxels per axis, against the int range of VoxelDownSample.
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<int>,
+               thrustcupoch::device_vector<int>, thrustcupoch::device_vector<int>>
+    VoxelDownSampleAndTrace(float voxel_size) const;
+
+    /// One level of VoxelDownSamplePyramid. The input points of the i-th
+    /// voxel are indices[offsets_[i]:offsets_[i + 1]] of the shared sorted
+    /// indices, and the voxels of the previous (finer) level merged into it
+    /// are children_[child_offsets_[i]:child_offsets_[i + 1]]. parents_ maps
+    /// each voxel to its voxel in the next (coarser) level.
+    struct VoxelPyramidLevel {
+        std::shared_ptr<PointCloud> cloud_;
+        thrustcupoch::device_vector<int> point_voxels_;
+        thrustcupoch::device_vector<int> offsets_;
+        /// {0} and empty at level 0.
+        thrustcupoch::device_vector<int> child_offsets_;
+        thrustcupoch::device_vector<int> children_;
+        /// Empty at the last level.
+        thrustcupoch::device_vector<int> parents_;
+    };
+
+    /// Downsamples the point cloud with the voxel sizes
+    /// voxel_size * 2^l, l = 0, ..., \param n_levels - 1, e.g. for
+    /// coarse-to-fine registration. The points are sorted once by the Morton
+    /// codes of the finest voxels; each coarser level merges 2x2x2 voxels of
+    /// the previous one, so all the levels share the grid origin of level 0.
+    /// Returns the levels and the input point indices sorted by voxel, which
+    /// the offsets of every level refer to. As in VoxelDownSampleAndTrace,
+    /// the extent of the cloud is limited to 2^21 - 1 finest voxels per axis.
+    std::tuple<std::vector<VoxelPyramidLevel>, thrustcupoch::device_vector<int>>
+    VoxelDownSamplePyramid(float voxel_size, int n_levels) const;
+
     /// Function to downsample \param input pointcloud into output pointcloud
     /// uniformly \param every_k_points indicates the sample rate.
     std::shared_ptr<PointCloud> UniformDownSample(size_t every_k_points) const;
 
-
-    std::tuple<std::shared_ptr<PointCloud>, thrust::device_vector<size_t>>
+    /// Function to downsample the point cloud to \param num_samples points
+    /// by farthest point sampling: starting from the first point, the point
+    /// farthest from the already selected ones is selected next.
+    /// Returns the output point cloud and the indices of the selected points.
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+    FarthestPointDownSample(size_t num_samples) const;
+
+    /// Farthest point sampling of several point clouds at once. Each
+    /// iteration selects the next point of every cloud with a single
+    /// segmented reduction, so small clouds share the kernel launches.
+    static std::vector<std::tuple<std::shared_ptr<PointCloud>,
+                                  thrustcupoch::device_vector<size_t>>>
+    BatchFarthestPointDownSample(const std::vector<const PointCloud *> &clouds,
+                                 size_t num_samples);
+
+    /// Function to downsample the point cloud to a random subset of
+    /// \param sampling_ratio of its points. The selection is a function of
+    /// \param seed only. Returns the output point cloud and the sorted
+    /// indices of the selected points.
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+    RandomDownSample(float sampling_ratio, uint64_t seed = 0) const;
+
+    /// Same as RandomDownSample, selecting exactly
+    /// min(\param num_samples, number of points) points.
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
+    RandomDownSampleToSize(size_t num_samples, uint64_t seed = 0) const;
+
+
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
     RemoveRadiusOutliers(size_t nb_points, float search_radius) const;
 
     std::tuple<std::shared_ptr<PointCloud>, thrust::host_vector<size_t>>
     RemoveRadiusOutliersHost(size_t nb_points, float search_radius) const;
 
 
-    std::tuple<std::shared_ptr<PointCloud>, thrust::device_vector<size_t>>
+    std::tuple<std::shared_ptr<PointCloud>, thrustcupoch::device_vector<size_t>>
     RemoveStatisticalOutliers(size_t nb_neighbors, float std_ratio) const;
 
     std::tuple<std::shared_ptr<PointCloud>, thrust::host_vector<size_t>>
@@ -104,6 +219,11 @@ public:
     /// clipped.
     std::shared_ptr<PointCloud> Crop(const AxisAlignedBoundingBox& bbox) const;
 
+    /// Function to crop pointcloud into output pointcloud
+    /// All points with coordinates outside the oriented bounding box
+    /// \param bbox are clipped.
+    std::shared_ptr<PointCloud> Crop(const OrientedBoundingBox& bbox) const;
+
     /// Function to compute the normals of a point cloud
     /// \param cloud is the input point cloud. It also stores the output
     /// normals. Normals are oriented with respect to the input point cloud if
@@ -111,23 +231,122 @@ public:
     /// parameters
     bool EstimateNormals(const KDTreeSearchParam& search_param = KDTreeSearchParamKNN());
 
+    /// Same as EstimateNormals, with the covariance of the neighbors
+    /// accumulated during the search instead of storing the neighbor lists,
+    /// so the memory is O(n). With a radius parameter all the neighbors
+    /// within the radius are used, without the NUM_MAX_NN limit.
+    bool EstimateNormalsFused(const KDTreeSearchParam& search_param = KDTreeSearchParamKNN());
+
+    /// Same as above, also writing the shape features of each point to
+    /// \param features: (surface variation l2 / (l0 + l1 + l2), linearity
+    /// (l0 - l1) / l0, planarity (l1 - l2) / l0) with l0 >= l1 >= l2 the
+    /// eigenvalues of the covariance. Points with less than 3 neighbors get
+    /// zero features.
+    bool EstimateNormalsFused(const KDTreeSearchParam& search_param,
+                              thrustcupoch::device_vector<Eigen::Vector3f>& features);
+
+    /// Function to compute the covariance of each point for generalized ICP,
+    /// from the same fused neighbor search as EstimateNormalsFused. The
+    /// covariance of the neighbors is replaced by the plane covariance
+    /// U diag(1, 1, \param epsilon) U^T of its eigenvectors U, points with
+    /// less than 3 neighbors get the identity. The covariances follow
+    /// Transform and Rotate.
+    bool EstimateCovariances(const KDTreeSearchParam& search_param = KDTreeSearchParamKNN(20),
+                             float epsilon = 1.0e-3);
+
     /// Function to orient the normals of a point cloud
     /// \param cloud is the input point cloud. It must have normals.
     /// Normals are oriented with respect to \param orientation_reference
     bool OrientNormalsToAlignWithDirection(const Eigen::Vector3f &orientation_reference = Eigen::Vector3f(0.0, 0.0, 1.0));
 
+    /// Function to orient the normals of a point cloud
+    /// \param cloud is the input point cloud. It must have normals.
+    /// Normals are oriented towards \param camera_location
+    bool OrientNormalsTowardsCameraLocation(const Eigen::Vector3f &camera_location = Eigen::Vector3f::Zero());
+
+    /// Function to consistently orient the normals of a point cloud based on
+    /// tangent planes, Hoppe et al., "Surface Reconstruction from
+    /// Unorganized Points", 1992. The minimum spanning forest of the
+    /// Riemannian graph of the \param k nearest neighbors is computed with
+    /// Boruvka's algorithm, then the orientation of the first point of
+    /// each tree is propagated level by level.
+    bool OrientNormalsConsistentTangentPlane(size_t k);
+
     /// Cluster PointCloud using the DBSCAN algorithm
     /// Ester et al., "A Density-Based Algorithm for Discovering Clusters
     /// in Large Spatial Databases with Noise", 1996
     /// Returns a vector of point labels, -1 indicates noise according to
-    /// the algorithm.
-    thrust::device_vector<int> ClusterDBSCAN(float eps,
+    /// the algorithm. A point is a core point if at least \param min_points
+    /// points (itself included) lie within \param eps. The clusters are the
+    /// connected components of the core points, numbered 0..k-1, and border
+    /// points join the cluster of their nearest core neighbor. Memory is
+    /// linear in the number of neighbor pairs.
+    thrustcupoch::device_vector<int> ClusterDBSCAN(float eps,
                                              size_t min_points,
                                              bool print_progress = false) const;
     thrust::host_vector<int> ClusterDBSCANHost(float eps,
                                                size_t min_points,
                                                bool print_progress = false) const;
 
+    /// Euclidean cluster extraction, Rusu, "Semantic 3D Object Maps for
+    /// Everyday Manipulation in Human Living Environments", 2009.
+    /// The clusters are the connected components of the points closer than
+    /// \param tolerance to each other. Clusters of less than \param min_size
+    /// or more than \param max_size points are labeled -1, the others are
+    /// numbered 0..k-1 in the order of their first point.
+    thrustcupoch::device_vector<int> ClusterEuclidean(
+            float tolerance,
+            size_t min_size = 1,
+            size_t max_size = std::numeric_limits<int>::max()) const;
+    thrust::host_vector<int> ClusterEuclideanHost(
+            float tolerance,
+            size_t min_size = 1,
+            size_t max_size = std::numeric_limits<int>::max()) const;
+
+    /// Segments the dominant plane with RANSAC. \param num_iterations
+    /// hypotheses are each fitted to \param ransac_n random points, and
+    /// all of them are scored by a single batched inlier count. The best
+    /// plane is refined by least squares on its inliers. Returns the plane
+    /// (a, b, c, d) with ax + by + cz + d = 0 and (a, b, c) of unit norm,
+    /// and the indices of the points closer than \param distance_threshold.
+    std::tuple<Eigen::Vector4f, thrustcupoch::device_vector<size_t>>
+    SegmentPlane(float distance_threshold = 0.01,
+                 int ransac_n = 3,
+                 int num_iterations = 100,
+                 uint64_t seed = 0) const;
+    std::tuple<Eigen::Vector4f, thrust::host_vector<size_t>>
+    SegmentPlaneHost(float distance_threshold = 0.01,
+                     int ransac_n = 3,
+                     int num_iterations = 100,
+                     uint64_t seed = 0) const;
+
+    /// Extracts up to \param max_planes planes by running SegmentPlane on
+    /// the points not assigned to a previous plane, until a plane has less
+    /// than \param min_inliers inliers. Returns the planes and the plane
+    /// index of each point, -1 for the points on none of them.
+    std::tuple<thrust::host_vector<Eigen::Vector4f>, thrustcupoch::device_vector<int>>
+    SegmentPlanes(float distance_threshold = 0.01,
+                  int ransac_n = 3,
+                  int num_iterations = 100,
+                  size_t max_planes = 10,
+                  size_t min_inliers = 100,
+                  uint64_t seed = 0) const;
+    std::tuple<thrust::host_vector<Eigen::Vector4f>, thrust::host_vector<int>>
+    SegmentPlanesHost(float distance_threshold = 0.01,
+                      int ransac_n = 3,
+                      int num_iterations = 100,
+                      size_t max_planes = 10,
+                      size_t min_inliers = 100,
+                      uint64_t seed = 0) const;
+
+    /// Summarizes the segments of the point cloud given by one label per
+    /// point, e.g. the result of ClusterDBSCAN or ClusterEuclidean. Points
+    /// labeled -1 are ignored. All segments are reduced at once.
+    std::shared_ptr<SegmentStatistics> ComputeSegmentStatistics(
+            const thrustcupoch::device_vector<int> &labels) const;
+    std::shared_ptr<SegmentStatistics> ComputeSegmentStatisticsHost(
+            const thrust::host_vector<int> &labels) const;
+
     /// Factory function to create a pointcloud from a depth image and a camera
     /// model (PointCloudFactory.cpp)
     /// The input depth image can be either a float image, or a uint16_t image.
@@ -157,9 +376,17 @@ public:
             bool project_valid_depth_only = true);
 
 public:
-    thrust::device_vector<Eigen::Vector3f> points_;
-    thrust::device_vector<Eigen::Vector3f> normals_;
-    thrust::device_vector<Eigen::Vector3f> colors_;
+    thrustcupoch::device_vector<Eigen::Vector3f> points_;
+    thrustcupoch::device_vector<Eigen::Vector3f> normals_;
+    thrustcupoch::device_vector<Eigen::Vector3f> colors_;
+    thrustcupoch::device_vector<Eigen::Matrix3f> covariances_;
+
+private:
+    bool EstimateNormalsFused(const KDTreeSearchParam& search_param,
+                              thrustcupoch::device_vector<Eigen::Vector3f>* features);
+
+    size_t generation_ = 0;
+    std::shared_ptr<KDTreeCache> kdtree_cache_ = std::make_shared<KDTreeCache>();
 };
 
 
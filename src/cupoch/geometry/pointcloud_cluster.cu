@@ -1,165 +1,307 @@
+#include <Eigen/Eigenvalues>
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/segment_statistics.h"
+#include "cupoch/utility/atomic.h"
 #include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include "cupoch/utility/union_find.h"
+#include <thrust/binary_search.h>
+#include <thrust/gather.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
 
 using namespace cupoch;
 using namespace cupoch::geometry;
 
 namespace {
 
-struct initialize_cluster_matrix_functor {
-    initialize_cluster_matrix_functor(const int* indices, const float* dists2,
-                                      float eps, int n_points, int* cluster_matrix,
-                                      int* valid, int* reroute)
-        : indices_(indices), dists2_(dists2), eps_(eps),
-          n_points_(n_points), cluster_matrix_(cluster_matrix),
-          valid_(valid), reroute_(reroute) {};
+struct is_core_point_functor {
+    is_core_point_functor(const int* offsets, int min_points)
+        : offsets_(offsets), min_points_(min_points) {};
+    const int* offsets_;
+    const int min_points_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        return (offsets_[idx + 1] - offsets_[idx] >= min_points_) ? 1 : 0;
+    }
+};
+
+// Lock-free union of the core point with its core neighbors; the root with
+// the higher index is linked below the other one.
+struct union_core_points_functor {
+    union_core_points_functor(const int* offsets, const int* indices,
+                              const int* is_core, int* parents)
+        : offsets_(offsets), indices_(indices), is_core_(is_core),
+          parents_(parents) {};
+    const int* offsets_;
     const int* indices_;
-    const float* dists2_;
-    const float eps_;
-    const int n_points_;
-    int* cluster_matrix_;
-    int* valid_;
-    int* reroute_;
-    __device__
-    void operator() (size_t idx) {
-        cluster_matrix_[idx * n_points_ + idx] = 1;
-        for (int k = 0; k < NUM_MAX_NN; ++k) {
-            if (indices_[idx * n_points_ + k] < 0) continue;
-            if (dists2_[idx * n_points_ + k] <= eps_) {
-                cluster_matrix_[indices_[idx * n_points_ + k] * n_points_ + idx] = 1;
-            }
+    const int* is_core_;
+    int* parents_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        if (!is_core_[idx]) return;
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = indices_[k];
+            if (j >= int(idx) || !is_core_[j]) continue;
+            utility::UnionRoots(parents_, idx, j);
         }
-        valid_[idx] = 1;
-        reroute_[idx] = -1;
-    }
-};
-
-struct merge_cluster_functor {
-    merge_cluster_functor(int cluster_index,
-                          int* cluster_matrix,
-                          int* valid, int* reroute,
-                          int n_points)
-        : cluster_index_(cluster_index), cluster_matrix_(cluster_matrix), valid_(valid),
-          reroute_(reroute), n_points_(n_points) {};
-    const int cluster_index_;
-    int* cluster_matrix_;
-    int* valid_;
-    int* reroute_;
-    const int n_points_;
-    __device__
-    int get_reroute_index(int idx) {
-        int ans_idx = idx;
-        while (ans_idx != -1) {
-            if (valid_[ans_idx]) return ans_idx;
-            ans_idx = reroute_[ans_idx];
+    }
+};
+
+struct compress_path_functor {
+    compress_path_functor(int* parents) : parents_(parents) {};
+    int* parents_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        parents_[idx] = utility::FindRoot(parents_, idx);
+    }
+};
+
+struct is_cluster_root_functor {
+    is_cluster_root_functor(const int* is_core, const int* parents)
+        : is_core_(is_core), parents_(parents) {};
+    const int* is_core_;
+    const int* parents_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        return (is_core_[idx] && parents_[idx] == int(idx)) ? 1 : 0;
+    }
+};
+
+// Core points take the cluster of their root, border points the cluster of
+// their nearest core neighbor, the other points are noise.
+struct assign_cluster_functor {
+    assign_cluster_functor(const int* offsets, const int* indices,
+                           const int* is_core, const int* parents,
+                           const int* cluster_ids)
+        : offsets_(offsets), indices_(indices), is_core_(is_core),
+          parents_(parents), cluster_ids_(cluster_ids) {};
+    const int* offsets_;
+    const int* indices_;
+    const int* is_core_;
+    const int* parents_;
+    const int* cluster_ids_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        if (is_core_[idx]) return cluster_ids_[parents_[idx]];
+        for (int k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            const int j = indices_[k];
+            if (is_core_[j]) return cluster_ids_[parents_[j]];
         }
         return -1;
     }
+};
 
-    __device__
-    int operator() (int idx) {
-        if (valid_[idx] != 1 || idx == cluster_index_) return 0;
-        int target_cluster = get_reroute_index(cluster_index_);
-        if (idx == target_cluster) return 0;
-        bool do_merge = false;
-        for (int i = 0; i < n_points_; ++i) {
-            if (cluster_matrix_[i * n_points_ + idx] && cluster_matrix_[i * n_points_ + target_cluster]) {
-                do_merge = true;
-                break;
-            }
-        }
 
-        if (do_merge) {
-            valid_[idx] = 0;
-            reroute_[idx] = target_cluster;
-            for (int i = 0; i < n_points_; ++i) {
-                if (cluster_matrix_[i * n_points_ + idx] == 1) {
-                    cluster_matrix_[i * n_points_ + target_cluster] = 1;
-                }
-            }
-            return 1;
-        }
-        return 0;
-    } 
+struct count_cluster_size_functor {
+    count_cluster_size_functor(int* sizes) : sizes_(sizes) {};
+    int* sizes_;
+    __host__ __device__
+    void operator() (int label) const {
+        if (label >= 0) utility::AtomicAdd(sizes_ + label, 1);
+    }
 };
 
+struct is_valid_size_functor {
+    is_valid_size_functor(int min_size, int max_size)
+        : min_size_(min_size), max_size_(max_size) {};
+    const int min_size_;
+    const int max_size_;
+    __host__ __device__
+    int operator() (int size) const {
+        return (size >= min_size_ && size <= max_size_) ? 1 : 0;
+    }
+};
 
-struct assign_cluster_functor {
-    assign_cluster_functor(const int* cluster_matrix, const int* valid,
-                           int n_points, int min_points, int* labels)
-                           : cluster_matrix_(cluster_matrix), valid_(valid),
-                             n_points_(n_points), min_points_(min_points),
-                             labels_(labels) {};
-    const int* cluster_matrix_;
-    const int* valid_;
-    const int n_points_;
-    const int min_points_;
-    int* labels_;
-    __device__
-    void operator() (size_t idx) {
-        if (!valid_[idx]) return;
-        int count = 0;
-        for (int i = 0; i < n_points_; ++i) {
-            count += cluster_matrix_[i * n_points_ + idx];
-        }
-        if (count > min_points_) {
-            for (int i = 0; i < n_points_; ++i) {
-                if (cluster_matrix_[i * n_points_ + idx] == 1) {
-                    labels_[i] = idx;
-                }
-            }
-        }
+struct relabel_cluster_functor {
+    relabel_cluster_functor(const int* sizes, const int* cluster_ids,
+                            int min_size, int max_size)
+        : sizes_(sizes), cluster_ids_(cluster_ids),
+          min_size_(min_size), max_size_(max_size) {};
+    const int* sizes_;
+    const int* cluster_ids_;
+    const int min_size_;
+    const int max_size_;
+    __host__ __device__
+    int operator() (int label) const {
+        if (label < 0) return -1;
+        const int size = sizes_[label];
+        return (size >= min_size_ && size <= max_size_) ? cluster_ids_[label] : -1;
+    }
+};
+
+struct is_labeled_functor {
+    __host__ __device__
+    bool operator() (int label) const {
+        return label >= 0;
+    }
+};
+
+typedef thrust::tuple<Eigen::Vector3f, Eigen::Vector3f, Eigen::Vector3f> bounds_tuple;
+
+// sum, min and max of the k-th segment member
+struct member_bounds_functor {
+    member_bounds_functor(const Eigen::Vector3f* points, const int* indices)
+        : points_(points), indices_(indices) {};
+    const Eigen::Vector3f* points_;
+    const int* indices_;
+    __host__ __device__
+    bounds_tuple operator() (size_t k) const {
+        const Eigen::Vector3f& pt = points_[indices_[k]];
+        return thrust::make_tuple(pt, pt, pt);
+    }
+};
+
+struct add_bounds_functor {
+    __host__ __device__
+    bounds_tuple operator() (const bounds_tuple& lhs, const bounds_tuple& rhs) const {
+        return thrust::make_tuple(thrust::get<0>(lhs) + thrust::get<0>(rhs),
+                                  thrust::get<1>(lhs).cwiseMin(thrust::get<1>(rhs)),
+                                  thrust::get<2>(lhs).cwiseMax(thrust::get<2>(rhs)));
+    }
+};
+
+struct divide_by_count_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (const Eigen::Vector3f& sum, int count) const {
+        return (count > 0) ? Eigen::Vector3f(sum / count) : sum;
     }
 };
 
+// upper triangle of the centered outer product of the k-th segment member
+struct member_covariance_functor {
+    member_covariance_functor(const Eigen::Vector3f* points, const int* indices,
+                              const int* labels, const Eigen::Vector3f* centroids)
+        : points_(points), indices_(indices), labels_(labels), centroids_(centroids) {};
+    const Eigen::Vector3f* points_;
+    const int* indices_;
+    const int* labels_;
+    const Eigen::Vector3f* centroids_;
+    __host__ __device__
+    Eigen::Vector6f operator() (size_t k) const {
+        const Eigen::Vector3f d = points_[indices_[k]] - centroids_[labels_[k]];
+        Eigen::Vector6f cov;
+        cov << d[0] * d[0], d[0] * d[1], d[0] * d[2],
+               d[1] * d[1], d[1] * d[2], d[2] * d[2];
+        return cov;
+    }
+};
+
+typedef thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> extent_tuple;
+
+// coordinates of the k-th segment member in the principal axes
+struct member_extent_functor {
+    member_extent_functor(const Eigen::Vector3f* points, const int* indices,
+                          const int* labels, const Eigen::Vector3f* centroids,
+                          const Eigen::Matrix3f* rotations)
+        : points_(points), indices_(indices), labels_(labels),
+          centroids_(centroids), rotations_(rotations) {};
+    const Eigen::Vector3f* points_;
+    const int* indices_;
+    const int* labels_;
+    const Eigen::Vector3f* centroids_;
+    const Eigen::Matrix3f* rotations_;
+    __host__ __device__
+    extent_tuple operator() (size_t k) const {
+        const int label = labels_[k];
+        const Eigen::Vector3f q = rotations_[label].transpose() *
+                                  (points_[indices_[k]] - centroids_[label]);
+        return thrust::make_tuple(q, q);
+    }
+};
+
+struct merge_extent_functor {
+    __host__ __device__
+    extent_tuple operator() (const extent_tuple& lhs, const extent_tuple& rhs) const {
+        return thrust::make_tuple(thrust::get<0>(lhs).cwiseMin(thrust::get<0>(rhs)),
+                                  thrust::get<1>(lhs).cwiseMax(thrust::get<1>(rhs)));
+    }
+};
+
+struct compute_obb_functor {
+    __host__ __device__
+    thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator() (
+            const thrust::tuple<Eigen::Vector3f, Eigen::Matrix3f,
+                                Eigen::Vector3f, Eigen::Vector3f>& x) const {
+        const Eigen::Vector3f& centroid = thrust::get<0>(x);
+        const Eigen::Matrix3f& rotation = thrust::get<1>(x);
+        const Eigen::Vector3f& min_q = thrust::get<2>(x);
+        const Eigen::Vector3f& max_q = thrust::get<3>(x);
+        return thrust::make_tuple(
+                Eigen::Vector3f(centroid + rotation * (0.5 * (min_q + max_q))),
+                Eigen::Vector3f(max_q - min_q));
+    }
+};
+
+// Principal axes of a covariance as the columns of a rotation, in
+// decreasing order of variance.
+Eigen::Matrix3f ComputePrincipalAxes(const Eigen::Vector6f& cov) {
+    Eigen::Matrix3f covariance;
+    covariance << cov[0], cov[1], cov[2],
+                  cov[1], cov[3], cov[4],
+                  cov[2], cov[4], cov[5];
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver;
+    solver.computeDirect(covariance);
+    Eigen::Matrix3f axes;
+    axes.col(0) = solver.eigenvectors().col(2);
+    axes.col(1) = solver.eigenvectors().col(1);
+    axes.col(2) = axes.col(0).cross(axes.col(1));
+    return axes;
 }
 
-thrust::device_vector<int> PointCloud::ClusterDBSCAN(float eps,
+}
+
+thrustcupoch::device_vector<int> PointCloud::ClusterDBSCAN(float eps,
                                                      size_t min_points,
                                                      bool print_progress) const {
-    KDTreeFlann kdtree(*this);
+    utility::ConsoleProgressBar progress_bar(3, "Clustering", print_progress);
     // precompute all neighbours
     utility::LogDebug("Precompute Neighbours");
-    utility::ConsoleProgressBar progress_bar(
-        points_.size(), "Precompute Neighbours", print_progress);
-    thrust::device_vector<int> indices;
-    thrust::device_vector<float> dists2;
-    kdtree.SearchRadius(points_, eps, indices, dists2);
+    auto neighbors = SearchNeighborsCSR(KDTreeSearchParamRadius(eps));
+    const int* offsets = thrust::raw_pointer_cast(neighbors->offsets_.data());
+    const int* indices = thrust::raw_pointer_cast(neighbors->indices_.data());
+    ++progress_bar;
 
+    // the neighbors of a point include the point itself
     const size_t n_pt = points_.size();
-    thrust::device_vector<int> cluster_matrix(n_pt * n_pt);
-    thrust::device_vector<int> valid(n_pt);
-    thrust::device_vector<int> reroute(n_pt);
-    initialize_cluster_matrix_functor func(thrust::raw_pointer_cast(indices.data()),
-                                           thrust::raw_pointer_cast(dists2.data()),
-                                           eps, n_pt,
-                                           thrust::raw_pointer_cast(cluster_matrix.data()),
-                                           thrust::raw_pointer_cast(valid.data()),
-                                           thrust::raw_pointer_cast(reroute.data()));
-    thrust::for_each(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(n_pt), func);
-
-    bool is_merged = true;
-    for (int i = 0; i < n_pt; ++i) {
-        ++progress_bar;
-        while (is_merged) {
-            merge_cluster_functor func(i, thrust::raw_pointer_cast(cluster_matrix.data()),
-                                       thrust::raw_pointer_cast(valid.data()),
-                                       thrust::raw_pointer_cast(reroute.data()), n_pt);
-            const int n_merged = thrust::transform_reduce(thrust::make_counting_iterator(0),
-                                                          thrust::make_counting_iterator((int)n_pt),
-                                                          func, 0, thrust::plus<int>());
-            is_merged = n_merged > 0;
-        }
-    }
+    thrustcupoch::device_vector<int> is_core(n_pt);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt), is_core.begin(),
+                      is_core_point_functor(offsets, min_points));
+
+    // connected components of the core points
+    utility::LogDebug("Compute Clusters");
+    thrustcupoch::device_vector<int> parents(n_pt);
+    thrust::sequence(parents.begin(), parents.end());
+    union_core_points_functor union_func(offsets, indices,
+                                         thrust::raw_pointer_cast(is_core.data()),
+                                         thrust::raw_pointer_cast(parents.data()));
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_pt), union_func);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_pt),
+                     compress_path_functor(thrust::raw_pointer_cast(parents.data())));
+    ++progress_bar;
 
-    thrust::device_vector<int> labels(points_.size(), -1);
-    assign_cluster_functor assign_func(thrust::raw_pointer_cast(cluster_matrix.data()),
-                                       thrust::raw_pointer_cast(valid.data()),
-                                       n_pt, min_points,
-                                       thrust::raw_pointer_cast(labels.data()));
-    thrust::for_each(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(n_pt),
-                     assign_func);
+    // number the clusters in the order of their roots
+    thrustcupoch::device_vector<int> cluster_ids(n_pt);
+    is_cluster_root_functor root_func(thrust::raw_pointer_cast(is_core.data()),
+                                      thrust::raw_pointer_cast(parents.data()));
+    thrust::transform_exclusive_scan(thrust::make_counting_iterator<size_t>(0),
+                                     thrust::make_counting_iterator(n_pt),
+                                     cluster_ids.begin(), root_func, 0,
+                                     thrust::plus<int>());
+    thrustcupoch::device_vector<int> labels(n_pt);
+    assign_cluster_functor assign_func(offsets, indices,
+                                       thrust::raw_pointer_cast(is_core.data()),
+                                       thrust::raw_pointer_cast(parents.data()),
+                                       thrust::raw_pointer_cast(cluster_ids.data()));
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt), labels.begin(),
+                      assign_func);
+    ++progress_bar;
     return labels;
 }
 
@@ -170,3 +312,149 @@ thrust::host_vector<int> PointCloud::ClusterDBSCANHost(float eps,
     thrust::host_vector<int> host_ans = dev_ans;
     return host_ans;
  }
+
+thrustcupoch::device_vector<int> PointCloud::ClusterEuclidean(float tolerance,
+                                                        size_t min_size,
+                                                        size_t max_size) const {
+    // every point is a core point, the clusters are connected components
+    thrustcupoch::device_vector<int> labels = ClusterDBSCAN(tolerance, 1);
+    const int n_clusters = thrust::reduce(labels.begin(), labels.end(), -1,
+                                          thrust::maximum<int>()) + 1;
+    if (n_clusters == 0) return labels;
+
+    thrustcupoch::device_vector<int> sizes(n_clusters, 0);
+    thrust::for_each(labels.begin(), labels.end(),
+                     count_cluster_size_functor(thrust::raw_pointer_cast(sizes.data())));
+    const int min_s = std::min(min_size, size_t(std::numeric_limits<int>::max()));
+    const int max_s = std::min(max_size, size_t(std::numeric_limits<int>::max()));
+    thrustcupoch::device_vector<int> cluster_ids(n_clusters);
+    thrust::transform_exclusive_scan(sizes.begin(), sizes.end(), cluster_ids.begin(),
+                                     is_valid_size_functor(min_s, max_s), 0,
+                                     thrust::plus<int>());
+    thrust::transform(labels.begin(), labels.end(), labels.begin(),
+                      relabel_cluster_functor(thrust::raw_pointer_cast(sizes.data()),
+                                              thrust::raw_pointer_cast(cluster_ids.data()),
+                                              min_s, max_s));
+    return labels;
+}
+
+thrust::host_vector<int> PointCloud::ClusterEuclideanHost(float tolerance,
+                                                          size_t min_size,
+                                                          size_t max_size) const {
+    auto dev_ans = ClusterEuclidean(tolerance, min_size, max_size);
+    thrust::host_vector<int> host_ans = dev_ans;
+    return host_ans;
+}
+
+std::shared_ptr<SegmentStatistics> PointCloud::ComputeSegmentStatistics(
+        const thrustcupoch::device_vector<int> &labels) const {
+    auto stats = std::make_shared<SegmentStatistics>();
+    if (labels.size() != points_.size()) {
+        utility::LogError("[ComputeSegmentStatistics] The number of labels {:d} does not match the number of points {:d}.",
+                          labels.size(), points_.size());
+        return stats;
+    }
+    const int n_segments = thrust::reduce(labels.begin(), labels.end(), -1,
+                                          thrust::maximum<int>()) + 1;
+    if (n_segments == 0) {
+        stats->offsets_.resize(1, 0);
+        return stats;
+    }
+
+    // members of the segments in the CSR layout
+    stats->indices_.resize(labels.size());
+    auto end = thrust::copy_if(thrust::make_counting_iterator(0),
+                               thrust::make_counting_iterator<int>(labels.size()),
+                               labels.begin(), stats->indices_.begin(),
+                               is_labeled_functor());
+    const size_t n_members = thrust::distance(stats->indices_.begin(), end);
+    stats->indices_.resize(n_members);
+    thrustcupoch::device_vector<int> member_labels(n_members);
+    thrust::gather(stats->indices_.begin(), stats->indices_.end(),
+                   labels.begin(), member_labels.begin());
+    thrust::stable_sort_by_key(member_labels.begin(), member_labels.end(),
+                               stats->indices_.begin());
+    stats->offsets_.resize(n_segments + 1);
+    thrust::lower_bound(member_labels.begin(), member_labels.end(),
+                        thrust::make_counting_iterator(0),
+                        thrust::make_counting_iterator(n_segments + 1),
+                        stats->offsets_.begin());
+    stats->counts_.resize(n_segments);
+    thrust::transform(stats->offsets_.begin() + 1, stats->offsets_.end(),
+                      stats->offsets_.begin(), stats->counts_.begin(),
+                      thrust::minus<int>());
+
+    // centroids and axis-aligned bounds, segments without points keep zeros
+    const Eigen::Vector3f* points = thrust::raw_pointer_cast(points_.data());
+    const int* indices = thrust::raw_pointer_cast(stats->indices_.data());
+    const int* sorted_labels = thrust::raw_pointer_cast(member_labels.data());
+    thrustcupoch::device_vector<int> keys(n_segments);
+    thrustcupoch::device_vector<Eigen::Vector3f> sums(n_segments);
+    thrustcupoch::device_vector<Eigen::Vector3f> mins(n_segments);
+    thrustcupoch::device_vector<Eigen::Vector3f> maxs(n_segments);
+    auto bounds_end = thrust::reduce_by_key(
+            member_labels.begin(), member_labels.end(),
+            thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                            member_bounds_functor(points, indices)),
+            keys.begin(), make_tuple_iterator(sums.begin(), mins.begin(), maxs.begin()),
+            thrust::equal_to<int>(), add_bounds_functor());
+    const size_t n_found = thrust::distance(keys.begin(), bounds_end.first);
+    stats->centroids_.resize(n_segments, Eigen::Vector3f::Zero());
+    stats->min_bounds_.resize(n_segments, Eigen::Vector3f::Zero());
+    stats->max_bounds_.resize(n_segments, Eigen::Vector3f::Zero());
+    thrust::scatter(make_tuple_iterator(sums.begin(), mins.begin(), maxs.begin()),
+                    make_tuple_iterator(sums.begin() + n_found, mins.begin() + n_found,
+                                        maxs.begin() + n_found),
+                    keys.begin(),
+                    make_tuple_iterator(stats->centroids_.begin(), stats->min_bounds_.begin(),
+                                        stats->max_bounds_.begin()));
+    thrust::transform(stats->centroids_.begin(), stats->centroids_.end(),
+                      stats->counts_.begin(), stats->centroids_.begin(),
+                      divide_by_count_functor());
+
+    // principal axes from the covariances, solved on the host
+    const Eigen::Vector3f* centroids = thrust::raw_pointer_cast(stats->centroids_.data());
+    thrustcupoch::device_vector<Eigen::Vector6f> covariances(n_found);
+    thrust::reduce_by_key(member_labels.begin(), member_labels.end(),
+                          thrust::make_transform_iterator(
+                                  thrust::make_counting_iterator<size_t>(0),
+                                  member_covariance_functor(points, indices,
+                                                            sorted_labels, centroids)),
+                          keys.begin(), covariances.begin());
+    thrust::host_vector<int> h_keys(keys.begin(), keys.begin() + n_found);
+    thrust::host_vector<Eigen::Vector6f> h_covariances = covariances;
+    thrust::host_vector<Eigen::Matrix3f> h_rotations(n_segments, Eigen::Matrix3f::Identity());
+    for (size_t i = 0; i < n_found; ++i) {
+        h_rotations[h_keys[i]] = ComputePrincipalAxes(h_covariances[i]);
+    }
+    stats->obb_rotations_ = h_rotations;
+
+    // oriented bounds in the principal axes
+    thrust::reduce_by_key(member_labels.begin(), member_labels.end(),
+                          thrust::make_transform_iterator(
+                                  thrust::make_counting_iterator<size_t>(0),
+                                  member_extent_functor(points, indices, sorted_labels, centroids,
+                                                        thrust::raw_pointer_cast(stats->obb_rotations_.data()))),
+                          keys.begin(), make_tuple_iterator(mins.begin(), maxs.begin()),
+                          thrust::equal_to<int>(), merge_extent_functor());
+    thrustcupoch::device_vector<Eigen::Vector3f> min_q(n_segments, Eigen::Vector3f::Zero());
+    thrustcupoch::device_vector<Eigen::Vector3f> max_q(n_segments, Eigen::Vector3f::Zero());
+    thrust::scatter(make_tuple_iterator(mins.begin(), maxs.begin()),
+                    make_tuple_iterator(mins.begin() + n_found, maxs.begin() + n_found),
+                    keys.begin(), make_tuple_iterator(min_q.begin(), max_q.begin()));
+    stats->obb_centers_.resize(n_segments);
+    stats->obb_extents_.resize(n_segments);
+    thrust::transform(make_tuple_iterator(stats->centroids_.begin(), stats->obb_rotations_.begin(),
+                                          min_q.begin(), max_q.begin()),
+                      make_tuple_iterator(stats->centroids_.end(), stats->obb_rotations_.end(),
+                                          min_q.end(), max_q.end()),
+                      make_tuple_iterator(stats->obb_centers_.begin(), stats->obb_extents_.begin()),
+                      compute_obb_functor());
+    return stats;
+}
+
+std::shared_ptr<SegmentStatistics> PointCloud::ComputeSegmentStatisticsHost(
+        const thrust::host_vector<int> &labels) const {
+    thrustcupoch::device_vector<int> dev_labels = labels;
+    return ComputeSegmentStatistics(dev_labels);
+}
@@ -2,6 +2,7 @@
 
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/image.h"
+#include "cupoch/geometry/organized_pointcloud.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/rgbdimage.h"
 #include "cupoch/utility/helper.h"
@@ -31,7 +32,7 @@ struct depth_to_pointcloud_functor {
     const thrust::pair<float, float> principal_point_;
     const thrust::pair<float, float> focal_length_;
     const Eigen::Matrix4f camera_pose_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (size_t idx) {
         int row = idx / width_;
         int col = idx % width_;
@@ -71,7 +72,7 @@ std::shared_ptr<PointCloud> CreatePointCloudFromFloatDepthImage(
     thrust::transform(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(depth_size),
                       pointcloud->points_.begin(), func);
     auto end = thrust::remove_if(pointcloud->points_.begin(), pointcloud->points_.end(),
-                                 [] __device__ (const Eigen::Vector3f& pt) -> bool {return Eigen::device_any(pt.array().isInf());});
+                                 [] __host__ __device__ (const Eigen::Vector3f& pt) -> bool {return Eigen::device_any(pt.array().isInf());});
     size_t n_result = thrust::distance(pointcloud->points_.begin(), end);
     pointcloud->points_.resize(n_result);
     return pointcloud;
@@ -100,7 +101,7 @@ struct convert_from_rgbdimage_functor{
     const thrust::pair<float, float> focal_length_;
     const float scale_;
     const bool project_valid_depth_only_;
-    __device__
+    __host__ __device__
     thrust::tuple<Eigen::Vector3f, Eigen::Vector3f> operator() (size_t idx) const {
         int i = idx / width_;
         int j = idx % width_;
@@ -163,7 +164,7 @@ std::shared_ptr<PointCloud> CreatePointCloudFromRGBDImageT(
     auto begin = make_tuple_iterator(pointcloud->points_.begin(), pointcloud->colors_.begin());
     auto end = thrust::remove_if(begin,
                                  make_tuple_iterator(pointcloud->points_.end(), pointcloud->colors_.end()),
-                                 [] __device__ (const thrust::tuple<Eigen::Vector3f, Eigen::Vector3f>& x) {
+                                 [] __host__ __device__ (const thrust::tuple<Eigen::Vector3f, Eigen::Vector3f>& x) {
                                      Eigen::Vector3f cl = thrust::get<1>(x);
                                      return (std::isinf(cl[0]) && std::isinf(cl[1]) && std::isinf(cl[2]));
                                  });
@@ -173,6 +174,44 @@ std::shared_ptr<PointCloud> CreatePointCloudFromRGBDImageT(
     return pointcloud;
 }
 
+struct valid_point_mask_functor {
+    __host__ __device__
+    uint8_t operator() (const Eigen::Vector3f& pt) const {
+        return Eigen::device_any(pt.array().isInf()) ? 0 : 1;
+    }
+};
+
+template <typename TC, int NC>
+std::shared_ptr<OrganizedPointCloud> CreateOrganizedPointCloudFromRGBDImageT(
+        const RGBDImage &image,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic) {
+    auto organized = std::make_shared<OrganizedPointCloud>();
+    const Eigen::Matrix4f camera_pose = extrinsic.inverse();
+    const auto focal_length = intrinsic.GetFocalLength();
+    const auto principal_point = intrinsic.GetPrincipalPoint();
+    const float scale = (sizeof(TC) == 1) ? 255.0 : 1.0;
+    organized->width_ = image.depth_.width_;
+    organized->height_ = image.depth_.height_;
+    organized->viewpoint_ = camera_pose.block<3, 1>(0, 3);
+    const size_t n_pixels = organized->Size();
+    organized->points_.resize(n_pixels);
+    organized->colors_.resize(n_pixels);
+    organized->mask_.resize(n_pixels);
+    convert_from_rgbdimage_functor<TC, NC> func(thrust::raw_pointer_cast(image.depth_.data_.data()),
+                                                thrust::raw_pointer_cast(image.color_.data_.data()),
+                                                image.depth_.width_,
+                                                camera_pose,
+                                                principal_point, focal_length, scale,
+                                                true);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pixels),
+                      make_tuple_iterator(organized->points_.begin(), organized->colors_.begin()), func);
+    thrust::transform(organized->points_.begin(), organized->points_.end(),
+                      organized->mask_.begin(), valid_point_mask_functor());
+    return organized;
+}
+
 }
 
 std::shared_ptr<PointCloud> PointCloud::CreateFromDepthImage(
@@ -219,3 +258,62 @@ std::shared_ptr<PointCloud> PointCloud::CreateFromRGBDImage(
             "[CreatePointCloudFromRGBDImage] Unsupported image format.");
     return std::make_shared<PointCloud>();
 }
+
+std::shared_ptr<OrganizedPointCloud> OrganizedPointCloud::CreateFromDepthImage(
+        const Image &depth,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic /* = Eigen::Matrix4f::Identity()*/,
+        float depth_scale /* = 1000.0*/,
+        float depth_trunc /* = 1000.0*/) {
+    auto organized = std::make_shared<OrganizedPointCloud>();
+    if (depth.num_of_channels_ != 1 ||
+        (depth.bytes_per_channel_ != 2 && depth.bytes_per_channel_ != 4)) {
+        utility::LogError(
+                "[CreateOrganizedPointCloudFromDepthImage] Unsupported image format.");
+        return organized;
+    }
+    std::shared_ptr<Image> converted;
+    if (depth.bytes_per_channel_ == 2) {
+        converted = depth.ConvertDepthToFloatImage(depth_scale, depth_trunc);
+    }
+    const Image &float_depth = (converted) ? *converted : depth;
+    const Eigen::Matrix4f camera_pose = extrinsic.inverse();
+    organized->width_ = float_depth.width_;
+    organized->height_ = float_depth.height_;
+    organized->viewpoint_ = camera_pose.block<3, 1>(0, 3);
+    const size_t n_pixels = organized->Size();
+    organized->points_.resize(n_pixels);
+    organized->mask_.resize(n_pixels);
+    depth_to_pointcloud_functor func(thrust::raw_pointer_cast(float_depth.data_.data()),
+                                     float_depth.width_, float_depth.num_of_channels_,
+                                     float_depth.bytes_per_channel_, 1,
+                                     intrinsic.GetPrincipalPoint(),
+                                     intrinsic.GetFocalLength(), camera_pose);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pixels),
+                      organized->points_.begin(), func);
+    thrust::transform(organized->points_.begin(), organized->points_.end(),
+                      organized->mask_.begin(), valid_point_mask_functor());
+    return organized;
+}
+
+std::shared_ptr<OrganizedPointCloud> OrganizedPointCloud::CreateFromRGBDImage(
+        const RGBDImage &image,
+        const camera::PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4f &extrinsic /* = Eigen::Matrix4f::Identity()*/) {
+    if (image.depth_.num_of_channels_ == 1 &&
+        image.depth_.bytes_per_channel_ == 4) {
+        if (image.color_.bytes_per_channel_ == 1 &&
+            image.color_.num_of_channels_ == 3) {
+            return CreateOrganizedPointCloudFromRGBDImageT<uint8_t, 3>(
+                    image, intrinsic, extrinsic);
+        } else if (image.color_.bytes_per_channel_ == 4 &&
+                   image.color_.num_of_channels_ == 1) {
+            return CreateOrganizedPointCloudFromRGBDImageT<float, 1>(
+                    image, intrinsic, extrinsic);
+        }
+    }
+    utility::LogError(
+            "[CreateOrganizedPointCloudFromRGBDImage] Unsupported image format.");
+    return std::make_shared<OrganizedPointCloud>();
+}
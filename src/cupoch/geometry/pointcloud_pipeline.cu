@@ -0,0 +1,283 @@
+#include <chrono>
+#include <limits>
+
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/pointcloud_pipeline.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/execution_context.h"
+#include <thrust/remove.h>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+// Applies the fused operations to the idx-th point and returns whether it is
+// kept. The transformed point, normal and covariance are written to the
+// output.
+struct apply_element_wise_ops_functor {
+    apply_element_wise_ops_functor(const Eigen::Vector3f* points,
+                                   const Eigen::Vector3f* normals,
+                                   const Eigen::Matrix3f* covariances,
+                                   const PointCloudElementWiseOp* ops, int n_ops,
+                                   Eigen::Vector3f* out_points,
+                                   Eigen::Vector3f* out_normals,
+                                   Eigen::Matrix3f* out_covariances)
+        : points_(points), normals_(normals), covariances_(covariances),
+          ops_(ops), n_ops_(n_ops), out_points_(out_points),
+          out_normals_(out_normals), out_covariances_(out_covariances) {};
+    const Eigen::Vector3f* points_;
+    const Eigen::Vector3f* normals_;
+    const Eigen::Matrix3f* covariances_;
+    const PointCloudElementWiseOp* ops_;
+    const int n_ops_;
+    Eigen::Vector3f* out_points_;
+    Eigen::Vector3f* out_normals_;
+    Eigen::Matrix3f* out_covariances_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        Eigen::Vector3f pt = points_[idx];
+        Eigen::Vector3f nl = (normals_) ? normals_[idx] : Eigen::Vector3f::Zero();
+        Eigen::Matrix3f cov = (covariances_) ? covariances_[idx] : Eigen::Matrix3f::Zero();
+        bool keep = true;
+        for (int i = 0; i < n_ops_ && keep; ++i) {
+            const PointCloudElementWiseOp& op = ops_[i];
+            switch (op.type_) {
+                case PointCloudElementWiseOp::Type::RemoveNoneFinite: {
+                    const bool is_nan = op.remove_nan_ &&
+                                        (std::isnan(pt(0)) || std::isnan(pt(1)) || std::isnan(pt(2)));
+                    const bool is_infinite = op.remove_infinite_ &&
+                                             (std::isinf(pt(0)) || std::isinf(pt(1)) || std::isinf(pt(2)));
+                    keep = !is_nan && !is_infinite;
+                    break;
+                }
+                case PointCloudElementWiseOp::Type::Crop:
+                    keep = (pt(0) >= op.min_bound_(0) && pt(0) <= op.max_bound_(0) &&
+                            pt(1) >= op.min_bound_(1) && pt(1) <= op.max_bound_(1) &&
+                            pt(2) >= op.min_bound_(2) && pt(2) <= op.max_bound_(2));
+                    break;
+                case PointCloudElementWiseOp::Type::Transform: {
+                    const Eigen::Vector4f new_pt = op.transformation_ *
+                                                   Eigen::Vector4f(pt(0), pt(1), pt(2), 1.0);
+                    pt = new_pt.head<3>() / new_pt(3);
+                    nl = (op.transformation_ * Eigen::Vector4f(nl(0), nl(1), nl(2), 0.0)).head<3>();
+                    const Eigen::Matrix3f R = op.transformation_.block<3, 3>(0, 0);
+                    cov = R * cov * R.transpose();
+                    break;
+                }
+            }
+        }
+        out_points_[idx] = pt;
+        if (out_normals_) out_normals_[idx] = nl;
+        if (out_covariances_) out_covariances_[idx] = cov;
+        return keep ? 1 : 0;
+    }
+};
+
+struct is_removed_functor {
+    __host__ __device__
+    bool operator() (int keep) const {
+        return keep == 0;
+    }
+};
+
+// Compacts one attribute with the stencil shared by all the attributes.
+template <typename T>
+size_t RemoveUnflagged(const thrustcupoch::device_vector<int>& keep,
+                       thrustcupoch::device_vector<T>& attribute) {
+    auto end = thrust::remove_if(attribute.begin(), attribute.end(),
+                                 keep.begin(), is_removed_functor());
+    const size_t k = thrust::distance(attribute.begin(), end);
+    attribute.resize(k);
+    return k;
+}
+
+}
+
+PointCloudPipeline::PointCloudPipeline() {}
+
+PointCloudPipeline::~PointCloudPipeline() {}
+
+PointCloudPipeline &PointCloudPipeline::RemoveNoneFinitePoints(bool remove_nan,
+                                                               bool remove_infinite) {
+    PointCloudElementWiseOp op;
+    op.type_ = PointCloudElementWiseOp::Type::RemoveNoneFinite;
+    op.remove_nan_ = remove_nan;
+    op.remove_infinite_ = remove_infinite;
+    return AddElementWise("RemoveNoneFinitePoints", op);
+}
+
+PointCloudPipeline &PointCloudPipeline::Crop(const AxisAlignedBoundingBox &bbox) {
+    if (bbox.IsEmpty()) {
+        utility::LogError(
+                "[PointCloudPipeline::Crop] AxisAlignedBoundingBox either has "
+                "zeros size, or has wrong bounds.");
+        return *this;
+    }
+    PointCloudElementWiseOp op;
+    op.type_ = PointCloudElementWiseOp::Type::Crop;
+    op.min_bound_ = bbox.min_bound_;
+    op.max_bound_ = bbox.max_bound_;
+    return AddElementWise("Crop", op);
+}
+
+PointCloudPipeline &PointCloudPipeline::PassThrough(int axis, float min_value,
+                                                    float max_value) {
+    if (axis < 0 || axis > 2) {
+        utility::LogError("[PointCloudPipeline::PassThrough] Invalid axis {:d}.", axis);
+        return *this;
+    }
+    PointCloudElementWiseOp op;
+    op.type_ = PointCloudElementWiseOp::Type::Crop;
+    op.min_bound_ = Eigen::Vector3f::Constant(-std::numeric_limits<float>::infinity());
+    op.max_bound_ = Eigen::Vector3f::Constant(std::numeric_limits<float>::infinity());
+    op.min_bound_[axis] = min_value;
+    op.max_bound_[axis] = max_value;
+    return AddElementWise("PassThrough", op);
+}
+
+PointCloudPipeline &PointCloudPipeline::Transform(const Eigen::Matrix4f &transformation) {
+    PointCloudElementWiseOp op;
+    op.type_ = PointCloudElementWiseOp::Type::Transform;
+    op.transformation_ = transformation;
+    return AddElementWise("Transform", op);
+}
+
+PointCloudPipeline &PointCloudPipeline::VoxelDownSample(float voxel_size) {
+    return AddStage("VoxelDownSample", [voxel_size](const PointCloud &pc) {
+        return pc.VoxelDownSample(voxel_size);
+    });
+}
+
+PointCloudPipeline &PointCloudPipeline::RemoveRadiusOutliers(size_t nb_points,
+                                                             float search_radius) {
+    return AddStage("RemoveRadiusOutliers", [nb_points, search_radius](const PointCloud &pc) {
+        return std::get<0>(pc.RemoveRadiusOutliers(nb_points, search_radius));
+    });
+}
+
+PointCloudPipeline &PointCloudPipeline::RemoveStatisticalOutliers(size_t nb_neighbors,
+                                                                  float std_ratio) {
+    return AddStage("RemoveStatisticalOutliers", [nb_neighbors, std_ratio](const PointCloud &pc) {
+        return std::get<0>(pc.RemoveStatisticalOutliers(nb_neighbors, std_ratio));
+    });
+}
+
+PointCloudPipeline &PointCloudPipeline::EstimateNormals(const KDTreeSearchParam &search_param) {
+    std::shared_ptr<const KDTreeSearchParam> param = CloneSearchParam(search_param);
+    if (!param) {
+        utility::LogError("[PointCloudPipeline::EstimateNormals] Unknown search param type.");
+        return *this;
+    }
+    Stage stage;
+    stage.name_ = "EstimateNormals";
+    stage.apply_in_place_ = [param](PointCloud &pc) { pc.EstimateNormals(*param); };
+    stages_.push_back(stage);
+    return *this;
+}
+
+std::shared_ptr<PointCloud> PointCloudPipeline::Run(const PointCloud &input) {
+    timings_.clear();
+    const PointCloud* current = &input;
+    std::shared_ptr<PointCloud> owned;
+    size_t i = 0;
+    while (i < stages_.size()) {
+        const auto start = std::chrono::steady_clock::now();
+        std::string name;
+        if (stages_[i].is_element_wise_) {
+            std::vector<PointCloudElementWiseOp> ops;
+            for (; i < stages_.size() && stages_[i].is_element_wise_; ++i) {
+                name += (name.empty() ? "" : "+") + stages_[i].name_;
+                ops.push_back(stages_[i].op_);
+            }
+            auto output = AcquireBuffer();
+            ApplyElementWise(ops, *current, *output);
+            owned = output;
+        } else if (stages_[i].apply_in_place_) {
+            // the clouds created by this run are not shared yet
+            name = stages_[i].name_;
+            if (!owned) owned = std::make_shared<PointCloud>(input);
+            stages_[i].apply_in_place_(*owned);
+            ++i;
+        } else {
+            name = stages_[i].name_;
+            owned = stages_[i].apply_(*current);
+            ++i;
+        }
+        current = owned.get();
+        utility::GetExecutionContext().Synchronize();
+        const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        timings_.push_back({name, current->points_.size(), elapsed.count()});
+        utility::LogDebug("[PointCloudPipeline] {}: {:d} points, {:f} ms",
+                          name, current->points_.size(), elapsed.count());
+    }
+    return (owned) ? owned : std::make_shared<PointCloud>(input);
+}
+
+void PointCloudPipeline::Clear() {
+    stages_.clear();
+    timings_.clear();
+}
+
+PointCloudPipeline &PointCloudPipeline::AddElementWise(const std::string &name,
+                                                       const PointCloudElementWiseOp &op) {
+    Stage stage;
+    stage.name_ = name;
+    stage.is_element_wise_ = true;
+    stage.op_ = op;
+    stages_.push_back(stage);
+    return *this;
+}
+
+PointCloudPipeline &PointCloudPipeline::AddStage(
+        const std::string &name,
+        std::function<std::shared_ptr<PointCloud>(const PointCloud &)> apply) {
+    Stage stage;
+    stage.name_ = name;
+    stage.apply_ = apply;
+    stages_.push_back(stage);
+    return *this;
+}
+
+std::shared_ptr<PointCloud> PointCloudPipeline::AcquireBuffer() {
+    for (auto &buffer : buffers_) {
+        if (buffer.use_count() == 1) return buffer;
+    }
+    buffers_.push_back(std::make_shared<PointCloud>());
+    return buffers_.back();
+}
+
+void PointCloudPipeline::ApplyElementWise(const std::vector<PointCloudElementWiseOp> &ops,
+                                          const PointCloud &input,
+                                          PointCloud &output) const {
+    const bool has_normals = input.HasNormals();
+    const bool has_colors = input.HasColors();
+    const bool has_covariances = input.HasCovariances();
+    const size_t n_pt = input.points_.size();
+    output.points_.resize(n_pt);
+    output.normals_.resize(has_normals ? n_pt : 0);
+    output.colors_.resize(has_colors ? n_pt : 0);
+    output.covariances_.resize(has_covariances ? n_pt : 0);
+    thrustcupoch::device_vector<PointCloudElementWiseOp> d_ops(ops.begin(), ops.end());
+    thrustcupoch::device_vector<int> keep(n_pt);
+    apply_element_wise_ops_functor func(
+            thrust::raw_pointer_cast(input.points_.data()),
+            (has_normals) ? thrust::raw_pointer_cast(input.normals_.data()) : nullptr,
+            (has_covariances) ? thrust::raw_pointer_cast(input.covariances_.data()) : nullptr,
+            thrust::raw_pointer_cast(d_ops.data()), int(ops.size()),
+            thrust::raw_pointer_cast(output.points_.data()),
+            (has_normals) ? thrust::raw_pointer_cast(output.normals_.data()) : nullptr,
+            (has_covariances) ? thrust::raw_pointer_cast(output.covariances_.data()) : nullptr);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_pt), keep.begin(), func);
+    if (has_colors) {
+        thrust::copy(input.colors_.begin(), input.colors_.end(), output.colors_.begin());
+    }
+    RemoveUnflagged(keep, output.points_);
+    if (has_normals) RemoveUnflagged(keep, output.normals_);
+    if (has_colors) RemoveUnflagged(keep, output.colors_);
+    if (has_covariances) RemoveUnflagged(keep, output.covariances_);
+    output.InvalidateKDTree();
+}
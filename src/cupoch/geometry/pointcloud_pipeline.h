@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/utility/eigen.h"
+
+namespace cupoch {
+namespace geometry {
+
+class AxisAlignedBoundingBox;
+class PointCloud;
+
+/// Element-wise operation of a PointCloudPipeline. The operations of a run
+/// of consecutive element-wise stages are applied together in one pass.
+struct PointCloudElementWiseOp {
+    enum class Type {
+        RemoveNoneFinite = 0,
+        Crop = 1,
+        Transform = 2,
+    };
+    Type type_ = Type::RemoveNoneFinite;
+    bool remove_nan_ = false;
+    bool remove_infinite_ = false;
+    /// Inclusive bounds of Crop.
+    Eigen::Vector3f min_bound_ = Eigen::Vector3f::Zero();
+    Eigen::Vector3f max_bound_ = Eigen::Vector3f::Zero();
+    Eigen::Matrix4f_u transformation_ = Eigen::Matrix4f_u::Identity();
+};
+
+/// \class PointCloudPipeline
+///
+/// \brief Lazily recorded chain of point cloud operations.
+///
+/// The operations are only executed by Run. Consecutive element-wise
+/// operations (RemoveNoneFinitePoints, Crop, PassThrough, Transform) are
+/// fused into a single compaction pass, without intermediate point clouds.
+/// Normals, colors and covariances are compacted with the points, and
+/// Transform rotates the normals and covariances as PointCloud::Transform.
+/// The buffers of the fused passes are reused by later runs once the point
+/// clouds returned by the previous runs are released. The other stages call
+/// the PointCloud methods of the same name: VoxelDownSample and the outlier
+/// removals allocate a new point cloud on every run, and EstimateNormals
+/// works in place on the output of the previous stage.
+class PointCloudPipeline {
+public:
+    struct StageTiming {
+        /// Names of the stages, joined by '+' for fused stages.
+        std::string name_;
+        /// Number of points after the stage.
+        size_t num_points_;
+        double elapsed_ms_;
+    };
+
+    PointCloudPipeline();
+    ~PointCloudPipeline();
+    PointCloudPipeline(const PointCloudPipeline &) = delete;
+    PointCloudPipeline &operator=(const PointCloudPipeline &) = delete;
+
+public:
+    PointCloudPipeline &RemoveNoneFinitePoints(bool remove_nan = true,
+                                               bool remove_infinite = true);
+    PointCloudPipeline &Crop(const AxisAlignedBoundingBox &bbox);
+    /// Keeps the points whose coordinate \param axis (0, 1 or 2) is in
+    /// [\param min_value, \param max_value].
+    PointCloudPipeline &PassThrough(int axis, float min_value, float max_value);
+    PointCloudPipeline &Transform(const Eigen::Matrix4f &transformation);
+    PointCloudPipeline &VoxelDownSample(float voxel_size);
+    PointCloudPipeline &RemoveRadiusOutliers(size_t nb_points,
+                                             float search_radius);
+    PointCloudPipeline &RemoveStatisticalOutliers(size_t nb_neighbors,
+                                                  float std_ratio);
+    PointCloudPipeline &EstimateNormals(
+            const KDTreeSearchParam &search_param = KDTreeSearchParamKNN());
+
+    /// Applies the recorded stages to \param input, which is not modified.
+    std::shared_ptr<PointCloud> Run(const PointCloud &input);
+
+    /// Timings of the stages executed by the last Run, in execution order.
+    const std::vector<StageTiming> &GetTimings() const { return timings_; }
+    size_t GetNumStages() const { return stages_.size(); }
+    /// Removes all the stages.
+    void Clear();
+
+private:
+    struct Stage {
+        std::string name_;
+        bool is_element_wise_ = false;
+        PointCloudElementWiseOp op_;
+        /// Stage returning a new point cloud.
+        std::function<std::shared_ptr<PointCloud>(const PointCloud &)> apply_;
+        /// Stage modifying the point cloud, which is only copied if it is
+        /// the input of the pipeline.
+        std::function<void(PointCloud &)> apply_in_place_;
+    };
+
+    PointCloudPipeline &AddElementWise(const std::string &name,
+                                       const PointCloudElementWiseOp &op);
+    PointCloudPipeline &AddStage(
+            const std::string &name,
+            std::function<std::shared_ptr<PointCloud>(const PointCloud &)>
+                    apply);
+    /// Returns a buffer not referenced outside of the pipeline.
+    std::shared_ptr<PointCloud> AcquireBuffer();
+    void ApplyElementWise(const std::vector<PointCloudElementWiseOp> &ops,
+                          const PointCloud &input,
+                          PointCloud &output) const;
+
+    std::vector<Stage> stages_;
+    std::vector<StageTiming> timings_;
+    std::vector<std::shared_ptr<PointCloud>> buffers_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,329 @@
+#include <Eigen/Eigenvalues>
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/random.h"
+#include "cupoch/utility/svd3_cuda.h"
+#include <thrust/count.h>
+#include <thrust/extrema.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/remove.h>
+#include <thrust/sequence.h>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+// Plane through the ransac_n points drawn for the idx-th hypothesis, fitted
+// by least squares when ransac_n > 3. Degenerate samples give a zero plane,
+// which has no inliers.
+struct generate_plane_hypothesis_functor {
+    generate_plane_hypothesis_functor(const Eigen::Vector3f* points,
+                                      const int* candidates, int n_candidates,
+                                      int ransac_n, uint64_t key)
+        : points_(points), candidates_(candidates), n_candidates_(n_candidates),
+          ransac_n_(ransac_n), key_(key) {};
+    const Eigen::Vector3f* points_;
+    const int* candidates_;
+    const int n_candidates_;
+    const int ransac_n_;
+    const uint64_t key_;
+    __host__ __device__
+    const Eigen::Vector3f& Sample(size_t idx, int k) const {
+        const uint32_t r = utility::RandomUint32(idx * ransac_n_ + k, key_);
+        return points_[candidates_[r % n_candidates_]];
+    }
+    __host__ __device__
+    Eigen::Vector4f operator() (size_t idx) const {
+        Eigen::Vector3f normal;
+        Eigen::Vector3f centroid;
+        if (ransac_n_ == 3) {
+            const Eigen::Vector3f& p0 = Sample(idx, 0);
+            normal = (Sample(idx, 1) - p0).cross(Sample(idx, 2) - p0);
+            centroid = p0;
+        } else {
+            centroid = Eigen::Vector3f::Zero();
+            for (int k = 0; k < ransac_n_; ++k) centroid += Sample(idx, k);
+            centroid /= ransac_n_;
+            Eigen::Matrix3f cov = Eigen::Matrix3f::Zero();
+            for (int k = 0; k < ransac_n_; ++k) {
+                const Eigen::Vector3f d = Sample(idx, k) - centroid;
+                cov += d * d.transpose();
+            }
+            Eigen::Matrix3f uu, ss, vv;
+            svd(cov(0, 0), cov(0, 1), cov(0, 2), cov(1, 0), cov(1, 1), cov(1, 2), cov(2, 0), cov(2, 1), cov(2, 2),
+                uu(0, 0), uu(0, 1), uu(0, 2), uu(1, 0), uu(1, 1), uu(1, 2), uu(2, 0), uu(2, 1), uu(2, 2),
+                ss(0, 0), ss(0, 1), ss(0, 2), ss(1, 0), ss(1, 1), ss(1, 2), ss(2, 0), ss(2, 1), ss(2, 2),
+                vv(0, 0), vv(0, 1), vv(0, 2), vv(1, 0), vv(1, 1), vv(1, 2), vv(2, 0), vv(2, 1), vv(2, 2));
+            // singular values in descending order, the plane has one flat axis
+            if (ss(1, 1) <= ss(0, 0) * 1.0e-6) return Eigen::Vector4f::Zero();
+            normal = vv.col(2);
+        }
+        const float norm = normal.norm();
+        if (norm < 1.0e-12) return Eigen::Vector4f::Zero();
+        normal /= norm;
+        return Eigen::Vector4f(normal(0), normal(1), normal(2), -normal.dot(centroid));
+    }
+};
+
+struct hypothesis_index_functor {
+    hypothesis_index_functor(size_t n_candidates) : n_candidates_(n_candidates) {};
+    const size_t n_candidates_;
+    __host__ __device__
+    size_t operator() (size_t idx) const {
+        return idx / n_candidates_;
+    }
+};
+
+// Inlier flag of the (hypothesis, candidate) pair idx.
+struct is_hypothesis_inlier_functor {
+    is_hypothesis_inlier_functor(const Eigen::Vector3f* points,
+                                 const int* candidates, size_t n_candidates,
+                                 const Eigen::Vector4f* planes,
+                                 float distance_threshold)
+        : points_(points), candidates_(candidates), n_candidates_(n_candidates),
+          planes_(planes), distance_threshold_(distance_threshold) {};
+    const Eigen::Vector3f* points_;
+    const int* candidates_;
+    const size_t n_candidates_;
+    const Eigen::Vector4f* planes_;
+    const float distance_threshold_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        const Eigen::Vector4f& plane = planes_[idx / n_candidates_];
+        if (plane(0) == 0 && plane(1) == 0 && plane(2) == 0) return 0;
+        const Eigen::Vector3f& pt = points_[candidates_[idx % n_candidates_]];
+        return (abs(plane.head<3>().dot(pt) + plane(3)) <= distance_threshold_) ? 1 : 0;
+    }
+};
+
+struct is_plane_inlier_functor {
+    is_plane_inlier_functor(const Eigen::Vector3f* points,
+                            const Eigen::Vector4f& plane, float distance_threshold)
+        : points_(points), plane_(plane), distance_threshold_(distance_threshold) {};
+    const Eigen::Vector3f* points_;
+    const Eigen::Vector4f plane_;
+    const float distance_threshold_;
+    __host__ __device__
+    bool operator() (int idx) const {
+        return abs(plane_.head<3>().dot(points_[idx]) + plane_(3)) <= distance_threshold_;
+    }
+};
+
+struct inlier_sum_functor {
+    inlier_sum_functor(const Eigen::Vector3f* points,
+                       const Eigen::Vector4f& plane, float distance_threshold)
+        : is_inlier_(points, plane, distance_threshold) {};
+    const is_plane_inlier_functor is_inlier_;
+    __host__ __device__
+    Eigen::Vector4f operator() (int idx) const {
+        if (!is_inlier_(idx)) return Eigen::Vector4f::Zero();
+        const Eigen::Vector3f& pt = is_inlier_.points_[idx];
+        return Eigen::Vector4f(pt(0), pt(1), pt(2), 1.0);
+    }
+};
+
+struct inlier_covariance_functor {
+    inlier_covariance_functor(const Eigen::Vector3f* points,
+                              const Eigen::Vector4f& plane, float distance_threshold,
+                              const Eigen::Vector3f& centroid)
+        : is_inlier_(points, plane, distance_threshold), centroid_(centroid) {};
+    const is_plane_inlier_functor is_inlier_;
+    const Eigen::Vector3f centroid_;
+    __host__ __device__
+    Eigen::Vector6f operator() (int idx) const {
+        if (!is_inlier_(idx)) return Eigen::Vector6f::Zero();
+        const Eigen::Vector3f d = is_inlier_.points_[idx] - centroid_;
+        Eigen::Vector6f cov;
+        cov << d(0) * d(0), d(0) * d(1), d(0) * d(2), d(1) * d(1), d(1) * d(2), d(2) * d(2);
+        return cov;
+    }
+};
+
+struct set_plane_label_functor {
+    set_plane_label_functor(const Eigen::Vector3f* points,
+                            const Eigen::Vector4f& plane, float distance_threshold,
+                            int label, int* labels)
+        : is_inlier_(points, plane, distance_threshold), label_(label), labels_(labels) {};
+    const is_plane_inlier_functor is_inlier_;
+    const int label_;
+    int* labels_;
+    __host__ __device__
+    void operator() (int idx) const {
+        if (is_inlier_(idx)) labels_[idx] = label_;
+    }
+};
+
+struct is_labeled_functor {
+    is_labeled_functor(const int* labels) : labels_(labels) {};
+    const int* labels_;
+    __host__ __device__
+    bool operator() (int idx) const {
+        return labels_[idx] >= 0;
+    }
+};
+
+// RANSAC on the candidate points. All the hypotheses are scored by a single
+// reduction over the (hypothesis, candidate) pairs, then the best one is
+// refined by least squares on its inliers. Returns the number of inliers of
+// the refined plane.
+size_t SegmentPlaneInCandidates(const thrustcupoch::device_vector<Eigen::Vector3f> &points,
+                                const thrustcupoch::device_vector<int> &candidates,
+                                float distance_threshold,
+                                int ransac_n,
+                                int num_iterations,
+                                uint64_t key,
+                                Eigen::Vector4f &plane) {
+    plane = Eigen::Vector4f::Zero();
+    const size_t n_candidates = candidates.size();
+    if (n_candidates < size_t(ransac_n)) return 0;
+    const Eigen::Vector3f* points_ptr = thrust::raw_pointer_cast(points.data());
+    const int* candidates_ptr = thrust::raw_pointer_cast(candidates.data());
+
+    thrustcupoch::device_vector<Eigen::Vector4f> hypotheses(num_iterations);
+    generate_plane_hypothesis_functor gen_func(points_ptr, candidates_ptr,
+                                               n_candidates, ransac_n, key);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator<size_t>(num_iterations),
+                      hypotheses.begin(), gen_func);
+
+    thrustcupoch::device_vector<int> inlier_counts(num_iterations);
+    is_hypothesis_inlier_functor inlier_func(points_ptr, candidates_ptr, n_candidates,
+                                             thrust::raw_pointer_cast(hypotheses.data()),
+                                             distance_threshold);
+    thrust::reduce_by_key(thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                                          hypothesis_index_functor(n_candidates)),
+                          thrust::make_transform_iterator(thrust::make_counting_iterator(num_iterations * n_candidates),
+                                                          hypothesis_index_functor(n_candidates)),
+                          thrust::make_transform_iterator(thrust::make_counting_iterator<size_t>(0),
+                                                          inlier_func),
+                          thrust::make_discard_iterator(), inlier_counts.begin());
+    auto best = thrust::max_element(inlier_counts.begin(), inlier_counts.end());
+    if (*best < 3) return 0;
+    const Eigen::Vector4f hypothesis = hypotheses[thrust::distance(inlier_counts.begin(), best)];
+
+    // least squares refinement on the inliers of the best hypothesis
+    const Eigen::Vector4f sum = thrust::transform_reduce(
+            candidates.begin(), candidates.end(),
+            inlier_sum_functor(points_ptr, hypothesis, distance_threshold),
+            Eigen::Vector4f::Zero().eval(), thrust::plus<Eigen::Vector4f>());
+    const Eigen::Vector3f centroid = sum.head<3>() / sum(3);
+    const Eigen::Vector6f cov = thrust::transform_reduce(
+            candidates.begin(), candidates.end(),
+            inlier_covariance_functor(points_ptr, hypothesis, distance_threshold, centroid),
+            Eigen::Vector6f::Zero().eval(), thrust::plus<Eigen::Vector6f>());
+    Eigen::Matrix3f covariance;
+    covariance << cov(0), cov(1), cov(2),
+                  cov(1), cov(3), cov(4),
+                  cov(2), cov(4), cov(5);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver;
+    solver.computeDirect(covariance);
+    Eigen::Vector3f normal = solver.eigenvectors().col(0);
+    if (normal.dot(hypothesis.head<3>()) < 0) normal = -normal;
+    plane << normal, -normal.dot(centroid);
+    return thrust::count_if(candidates.begin(), candidates.end(),
+                            is_plane_inlier_functor(points_ptr, plane, distance_threshold));
+}
+
+bool CheckSegmentPlaneParameters(float distance_threshold, int ransac_n, int num_iterations) {
+    if (distance_threshold <= 0) {
+        utility::LogError("[SegmentPlane] distance_threshold must be positive.");
+        return false;
+    }
+    if (ransac_n < 3) {
+        utility::LogError("[SegmentPlane] ransac_n should be set to at least 3.");
+        return false;
+    }
+    if (num_iterations < 1) {
+        utility::LogError("[SegmentPlane] num_iterations must be positive.");
+        return false;
+    }
+    return true;
+}
+
+}
+
+std::tuple<Eigen::Vector4f, thrustcupoch::device_vector<size_t>>
+PointCloud::SegmentPlane(float distance_threshold,
+                         int ransac_n,
+                         int num_iterations,
+                         uint64_t seed) const {
+    thrustcupoch::device_vector<size_t> inliers;
+    Eigen::Vector4f plane = Eigen::Vector4f::Zero();
+    if (!CheckSegmentPlaneParameters(distance_threshold, ransac_n, num_iterations)) {
+        return std::make_tuple(plane, inliers);
+    }
+    thrustcupoch::device_vector<int> candidates(points_.size());
+    thrust::sequence(candidates.begin(), candidates.end());
+    const size_t n_inliers = SegmentPlaneInCandidates(points_, candidates, distance_threshold,
+                                                      ransac_n, num_iterations,
+                                                      utility::MakeRandomKey(seed), plane);
+    if (n_inliers == 0) {
+        utility::LogWarning("[SegmentPlane] No plane found.");
+        return std::make_tuple(plane, inliers);
+    }
+    inliers.resize(n_inliers);
+    thrust::copy_if(thrust::make_counting_iterator<size_t>(0),
+                    thrust::make_counting_iterator(points_.size()),
+                    inliers.begin(),
+                    is_plane_inlier_functor(thrust::raw_pointer_cast(points_.data()),
+                                            plane, distance_threshold));
+    return std::make_tuple(plane, inliers);
+}
+
+std::tuple<Eigen::Vector4f, thrust::host_vector<size_t>>
+PointCloud::SegmentPlaneHost(float distance_threshold,
+                             int ransac_n,
+                             int num_iterations,
+                             uint64_t seed) const {
+    auto res = SegmentPlane(distance_threshold, ransac_n, num_iterations, seed);
+    thrust::host_vector<size_t> inliers = std::get<1>(res);
+    return std::make_tuple(std::get<0>(res), inliers);
+}
+
+std::tuple<thrust::host_vector<Eigen::Vector4f>, thrustcupoch::device_vector<int>>
+PointCloud::SegmentPlanes(float distance_threshold,
+                          int ransac_n,
+                          int num_iterations,
+                          size_t max_planes,
+                          size_t min_inliers,
+                          uint64_t seed) const {
+    thrust::host_vector<Eigen::Vector4f> planes;
+    thrustcupoch::device_vector<int> labels(points_.size(), -1);
+    if (!CheckSegmentPlaneParameters(distance_threshold, ransac_n, num_iterations)) {
+        return std::make_tuple(planes, labels);
+    }
+    // the remaining points are tracked by index, the cloud is never copied
+    thrustcupoch::device_vector<int> candidates(points_.size());
+    thrust::sequence(candidates.begin(), candidates.end());
+    const Eigen::Vector3f* points_ptr = thrust::raw_pointer_cast(points_.data());
+    int* labels_ptr = thrust::raw_pointer_cast(labels.data());
+    while (planes.size() < max_planes) {
+        Eigen::Vector4f plane;
+        const size_t n_inliers = SegmentPlaneInCandidates(
+                points_, candidates, distance_threshold, ransac_n, num_iterations,
+                utility::MakeRandomKey(seed + planes.size()), plane);
+        if (n_inliers == 0 || n_inliers < min_inliers) break;
+        thrust::for_each(candidates.begin(), candidates.end(),
+                         set_plane_label_functor(points_ptr, plane, distance_threshold,
+                                                 planes.size(), labels_ptr));
+        auto end = thrust::remove_if(candidates.begin(), candidates.end(),
+                                     is_labeled_functor(labels_ptr));
+        candidates.resize(thrust::distance(candidates.begin(), end));
+        planes.push_back(plane);
+    }
+    return std::make_tuple(planes, labels);
+}
+
+std::tuple<thrust::host_vector<Eigen::Vector4f>, thrust::host_vector<int>>
+PointCloud::SegmentPlanesHost(float distance_threshold,
+                              int ransac_n,
+                              int num_iterations,
+                              size_t max_planes,
+                              size_t min_inliers,
+                              uint64_t seed) const {
+    auto res = SegmentPlanes(distance_threshold, ransac_n, num_iterations,
+                             max_planes, min_inliers, seed);
+    thrust::host_vector<int> labels = std::get<1>(res);
+    return std::make_tuple(std::get<0>(res), labels);
+}
@@ -9,7 +9,7 @@ namespace {
 struct convert_sun_format_functor {
     convert_sun_format_functor(uint8_t* depth) : depth_(depth) {};
     uint8_t* depth_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         uint16_t &d = *(uint16_t*)(depth_ + idx * sizeof(uint16_t));
         d = (d >> 3) | (d << 13);
@@ -19,7 +19,7 @@ struct convert_sun_format_functor {
 struct convert_nyu_format_functor {
     convert_nyu_format_functor(uint8_t* depth) : depth_(depth) {};
     uint8_t* depth_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         uint16_t *d = (uint16_t*)(depth_ + idx * sizeof(uint16_t));
         uint8_t *p = (uint8_t *)d;
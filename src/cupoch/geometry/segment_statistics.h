@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace geometry {
+
+/// Summary of the segments of a labeled point cloud, one entry per label
+/// 0..GetNumSegments()-1 (see PointCloud::ComputeSegmentStatistics).
+/// The members of the i-th segment are the point indices in the slots
+/// [offsets_[i], offsets_[i + 1]) of indices_, in ascending order.
+/// The oriented bounding box of a segment is aligned with its principal
+/// axes, the columns of obb_rotations_ in decreasing order of variance.
+/// Labels without points have a zero count and empty boxes at the origin.
+struct SegmentStatistics {
+    size_t GetNumSegments() const { return counts_.size(); }
+    thrustcupoch::device_vector<int> counts_;
+    thrustcupoch::device_vector<Eigen::Vector3f> centroids_;
+    thrustcupoch::device_vector<Eigen::Vector3f> min_bounds_;
+    thrustcupoch::device_vector<Eigen::Vector3f> max_bounds_;
+    thrustcupoch::device_vector<Eigen::Vector3f> obb_centers_;
+    thrustcupoch::device_vector<Eigen::Matrix3f> obb_rotations_;
+    thrustcupoch::device_vector<Eigen::Vector3f> obb_extents_;
+    thrustcupoch::device_vector<int> offsets_;
+    thrustcupoch::device_vector<int> indices_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -14,7 +14,7 @@ namespace {
 struct compute_triangle_normals_functor {
     compute_triangle_normals_functor(const Eigen::Vector3f* vertices) : vertices_(vertices) {};
     const Eigen::Vector3f* vertices_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (const Eigen::Vector3i& tri) const {
         Eigen::Vector3f v01 = vertices_[tri(1)] - vertices_[tri(0)];
         Eigen::Vector3f v02 = vertices_[tri(2)] - vertices_[tri(0)];
@@ -27,7 +27,7 @@ struct compute_adjacency_matrix_functor {
         : adjacency_matrix_(adjacency_matrix), n_vertices_(n_vertices) {};
     int* adjacency_matrix_;
     size_t n_vertices_;
-    __device__
+    __host__ __device__
     void operator() (const Eigen::Vector3i& triangle) {
         adjacency_matrix_[triangle(0) * n_vertices_ + triangle(1)] = 1;
         adjacency_matrix_[triangle(0) * n_vertices_ + triangle(2)] = 1;
@@ -47,7 +47,7 @@ struct check_self_intersecting_triangles{
     const Eigen::Vector3i* triangles_;
     const Eigen::Vector3f* vertices_;
     const int n_triangles_;
-    __device__
+    __host__ __device__
     Eigen::Vector2i operator() (size_t idx) const {
         int tidx0 = idx / n_triangles_;
         int tidx1 = idx % n_triangles_;
@@ -83,8 +83,8 @@ struct check_self_intersecting_triangles{
 TriangleMesh::TriangleMesh() : MeshBase(Geometry::GeometryType::TriangleMesh) {}
 TriangleMesh::~TriangleMesh() {}
 
-TriangleMesh::TriangleMesh(const thrust::device_vector<Eigen::Vector3f> &vertices,
-                           const thrust::device_vector<Eigen::Vector3i> &triangles)
+TriangleMesh::TriangleMesh(const thrustcupoch::device_vector<Eigen::Vector3f> &vertices,
+                           const thrustcupoch::device_vector<Eigen::Vector3i> &triangles)
     : MeshBase(Geometry::GeometryType::TriangleMesh, vertices), triangles_(triangles) {}
 
 TriangleMesh::TriangleMesh(const thrust::host_vector<Eigen::Vector3f> &vertices,
@@ -171,7 +171,7 @@ TriangleMesh &TriangleMesh::operator+=(const TriangleMesh &mesh) {
     Eigen::Vector3i index_shift((int)old_vert_num, (int)old_vert_num,
                                 (int)old_vert_num);
     thrust::transform(mesh.triangles_.begin(), mesh.triangles_.end(), triangles_.begin() + n_tri_old,
-                      [=] __device__ (const Eigen::Vector3i& tri) {return tri + index_shift;});
+                      [=] __host__ __device__ (const Eigen::Vector3i& tri) {return tri + index_shift;});
     if (HasAdjacencyMatrix()) {
         ComputeAdjacencyMatrix();
     }
@@ -190,7 +190,7 @@ TriangleMesh TriangleMesh::operator+(const TriangleMesh &mesh) const {
 TriangleMesh &TriangleMesh::NormalizeNormals() {
     MeshBase::NormalizeNormals();
     thrust::for_each(triangle_normals_.begin(), triangle_normals_.end(),
-                     [] __device__ (Eigen::Vector3f& nl) {
+                     [] __host__ __device__ (Eigen::Vector3f& nl) {
                          nl.normalize();
                          if (std::isnan(nl(0))) {
                             nl = Eigen::Vector3f(0.0, 0.0, 1.0);
@@ -215,8 +215,8 @@ TriangleMesh &TriangleMesh::ComputeVertexNormals(bool normalized /* = true*/) {
         ComputeTriangleNormals(false);
     }
     vertex_normals_.resize(vertices_.size());
-    thrust::repeated_range<thrust::device_vector<Eigen::Vector3f>::iterator> range(triangle_normals_.begin(), triangle_normals_.end(), 3);
-    thrust::device_vector<Eigen::Vector3f> nm_thrice(triangle_normals_.size() * 3);
+    thrust::repeated_range<thrustcupoch::device_vector<Eigen::Vector3f>::iterator> range(triangle_normals_.begin(), triangle_normals_.end(), 3);
+    thrustcupoch::device_vector<Eigen::Vector3f> nm_thrice(triangle_normals_.size() * 3);
     thrust::copy(range.begin(), range.end(), nm_thrice.begin());
     int* tri_ptr = (int*)(thrust::raw_pointer_cast(triangles_.data()));
     thrust::sort_by_key(thrust::device, tri_ptr, tri_ptr + triangles_.size() * 3, nm_thrice.begin());
@@ -236,10 +236,10 @@ TriangleMesh &TriangleMesh::ComputeAdjacencyMatrix() {
     return *this;
 }
 
-thrust::device_vector<Eigen::Vector2i> TriangleMesh::GetSelfIntersectingTriangles()
+thrustcupoch::device_vector<Eigen::Vector2i> TriangleMesh::GetSelfIntersectingTriangles()
         const {
     const size_t n_triangles2 = triangles_.size() * triangles_.size();
-    thrust::device_vector<Eigen::Vector2i> self_intersecting_triangles(n_triangles2);
+    thrustcupoch::device_vector<Eigen::Vector2i> self_intersecting_triangles(n_triangles2);
     check_self_intersecting_triangles func(thrust::raw_pointer_cast(triangles_.data()),
                                            thrust::raw_pointer_cast(vertices_.data()),
                                            triangles_.size());
@@ -247,7 +247,7 @@ thrust::device_vector<Eigen::Vector2i> TriangleMesh::GetSelfIntersectingTriangle
                       thrust::make_counting_iterator(n_triangles2),
                       self_intersecting_triangles.begin(), func);
     auto end = thrust::remove_if(self_intersecting_triangles.begin(), self_intersecting_triangles.end(),
-                                 [] __device__ (const Eigen::Vector2i& idxs) {return idxs[0] < 0;});
+                                 [] __host__ __device__ (const Eigen::Vector2i& idxs) {return idxs[0] < 0;});
     self_intersecting_triangles.resize(thrust::distance(self_intersecting_triangles.begin(), end));
     return self_intersecting_triangles;
 }
\ No newline at end of file
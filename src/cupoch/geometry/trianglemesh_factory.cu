@@ -12,7 +12,7 @@ struct compute_sphere_vertices_functor {
     const int resolution_;
     const float radius_;
     float step_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (size_t idx) const {
         int i = idx / (2 * resolution_) + 1;
         int j = idx % (2 * resolution_);
@@ -30,7 +30,7 @@ struct compute_sphere_triangles_functor1 {
         : triangles_(triangle), resolution_(resolution) {};
     Eigen::Vector3i* triangles_;
     const int resolution_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int j1 = (idx + 1) % (2 * resolution_);
         int base = 2;
@@ -45,7 +45,7 @@ struct compute_sphere_triangles_functor2 {
         : triangles_(triangle), resolution_(resolution) {};
     Eigen::Vector3i* triangles_;
     const int resolution_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int i = idx / (2 * resolution_) + 1;
         int j = idx % (2 * resolution_);
@@ -65,7 +65,7 @@ struct compute_cylinder_vertices_functor {
     const float height_;
     const float step_;
     const float h_step_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (size_t idx) const {
         int i = idx / resolution_;
         int j = idx % resolution_;
@@ -81,7 +81,7 @@ struct compute_cylinder_triangles_functor1 {
     Eigen::Vector3i* triangles_;
     const int resolution_;
     const int split_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int j1 = (idx + 1) % resolution_;
         int base = 2;
@@ -96,7 +96,7 @@ struct compute_cylinder_triangles_functor2 {
         : triangles_(triangle), resolution_(resolution) {};
     Eigen::Vector3i* triangles_;
     const int resolution_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int i = idx / resolution_;
         int j = idx % resolution_;
@@ -116,7 +116,7 @@ struct compute_cone_vertices_functor {
     const float step_;
     const float r_step_;
     const float h_step_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (size_t idx) const {
         int i = idx / resolution_;
         int j = idx % resolution_;
@@ -132,7 +132,7 @@ struct compute_cone_triangles_functor1 {
     Eigen::Vector3i* triangles_;
     const int resolution_;
     const int split_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int j1 = (idx + 1) % resolution_;
         int base = 2;
@@ -147,7 +147,7 @@ struct compute_cone_triangles_functor2 {
         : triangles_(triangle), resolution_(resolution) {};
     Eigen::Vector3i* triangles_;
     const int resolution_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int i = idx / resolution_;
         int j = idx % resolution_;
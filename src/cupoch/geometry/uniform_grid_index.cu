@@ -0,0 +1,725 @@
+#include "cupoch/geometry/uniform_grid_index.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/trianglemesh.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/helper.h"
+#include <thrust/binary_search.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cupoch;
+using namespace cupoch::geometry;
+
+namespace {
+
+// Number of bits of each cell coordinate in the 64-bit cell keys
+const int CELL_KEY_BITS = 21;
+const int MAX_NUM_CELLS = 1 << CELL_KEY_BITS;
+
+__host__ __device__
+inline uint64_t MakeCellKey(const Eigen::Vector3i& cell) {
+    return (uint64_t(cell[2]) << (2 * CELL_KEY_BITS)) |
+           (uint64_t(cell[1]) << CELL_KEY_BITS) | uint64_t(cell[0]);
+}
+
+// Inserts a neighbor into the rows sorted by distance holding at most knn
+// neighbors.
+__host__ __device__
+inline void InsertNeighbor(int* indices, float* distance2, int& n, int knn,
+                           int index, float dist2) {
+    if (n == knn && dist2 >= distance2[knn - 1]) return;
+    int j = (n < knn) ? n++ : knn - 1;
+    while (j > 0 && distance2[j - 1] > dist2) {
+        distance2[j] = distance2[j - 1];
+        indices[j] = indices[j - 1];
+        --j;
+    }
+    distance2[j] = dist2;
+    indices[j] = index;
+}
+
+struct grid_view {
+    grid_view(const Eigen::Vector3f* points, const int* point_indices,
+              const uint64_t* cell_keys, const int* cell_starts, int n_cells,
+              const Eigen::Vector3f& origin, float cell_size,
+              const Eigen::Vector3i& num_cells)
+        : points_(points), point_indices_(point_indices), cell_keys_(cell_keys),
+          cell_starts_(cell_starts), n_cells_(n_cells), origin_(origin),
+          cell_size_(cell_size), num_cells_(num_cells) {};
+    const Eigen::Vector3f* points_;
+    const int* point_indices_;
+    const uint64_t* cell_keys_;
+    const int* cell_starts_;
+    const int n_cells_;
+    const Eigen::Vector3f origin_;
+    const float cell_size_;
+    const Eigen::Vector3i num_cells_;
+
+    // Cell of a point. Points outside the grid are clamped to the layer of
+    // cells around it before the conversion to int, which keeps the ring
+    // distances a lower bound of the distances to the grid.
+    __host__ __device__
+    Eigen::Vector3i CellOf(const Eigen::Vector3f& pt) const {
+        const Eigen::Vector3f ref = (pt - origin_) / cell_size_;
+        Eigen::Vector3i cell;
+        for (int i = 0; i < 3; ++i) {
+            cell[i] = floorf(fminf(fmaxf(ref[i], -1.0f), float(num_cells_[i])));
+        }
+        return cell;
+    }
+
+    // Returns the index of the cell in the sorted cell keys, or -1 if the
+    // cell is empty.
+    __host__ __device__
+    int FindCell(const Eigen::Vector3i& cell) const {
+        for (int i = 0; i < 3; ++i) {
+            if (cell[i] < 0 || cell[i] >= num_cells_[i]) return -1;
+        }
+        const uint64_t key = MakeCellKey(cell);
+        const uint64_t* it = thrust::lower_bound(thrust::seq, cell_keys_,
+                                                 cell_keys_ + n_cells_, key);
+        return (it != cell_keys_ + n_cells_ && *it == key) ? int(it - cell_keys_) : -1;
+    }
+
+    // Number of rings around the cell that cover the whole grid
+    __host__ __device__
+    int MaxRing(const Eigen::Vector3i& cell) const {
+        int ring = 0;
+        for (int i = 0; i < 3; ++i) {
+            ring = max(ring, max(cell[i], num_cells_[i] - 1 - cell[i]));
+        }
+        return ring;
+    }
+
+    // Calls visit with the index of every non-empty cell at the Chebyshev
+    // distance r from the center cell. Only the six faces of the shell are
+    // enumerated, clipped to the grid.
+    template <class Visitor>
+    __host__ __device__
+    void VisitRing(const Eigen::Vector3i& center, int r, Visitor& visit) const {
+        int lo[3], hi[3];
+        for (int i = 0; i < 3; ++i) {
+            lo[i] = max(-r, -center[i]);
+            hi[i] = min(r, num_cells_[i] - 1 - center[i]);
+            if (lo[i] > hi[i]) return;
+        }
+        // the faces normal to z, then to y and x without the shared edges
+        const int zlo = max(lo[2], -r + 1);
+        const int zhi = min(hi[2], r - 1);
+        const int ylo = max(lo[1], -r + 1);
+        const int yhi = min(hi[1], r - 1);
+        for (int dz = -r; dz <= r; dz += max(2 * r, 1)) {
+            if (dz < lo[2] || dz > hi[2]) continue;
+            for (int dy = lo[1]; dy <= hi[1]; ++dy) {
+                for (int dx = lo[0]; dx <= hi[0]; ++dx) {
+                    VisitCell(center + Eigen::Vector3i(dx, dy, dz), visit);
+                }
+            }
+        }
+        if (r == 0) return;
+        for (int dy = -r; dy <= r; dy += 2 * r) {
+            if (dy < lo[1] || dy > hi[1]) continue;
+            for (int dz = zlo; dz <= zhi; ++dz) {
+                for (int dx = lo[0]; dx <= hi[0]; ++dx) {
+                    VisitCell(center + Eigen::Vector3i(dx, dy, dz), visit);
+                }
+            }
+        }
+        for (int dx = -r; dx <= r; dx += 2 * r) {
+            if (dx < lo[0] || dx > hi[0]) continue;
+            for (int dz = zlo; dz <= zhi; ++dz) {
+                for (int dy = ylo; dy <= yhi; ++dy) {
+                    VisitCell(center + Eigen::Vector3i(dx, dy, dz), visit);
+                }
+            }
+        }
+    }
+
+    template <class Visitor>
+    __host__ __device__
+    void VisitCell(const Eigen::Vector3i& cell, Visitor& visit) const {
+        const int c = FindCell(cell);
+        if (c >= 0) visit(c);
+    }
+};
+
+// Inserts the points of a cell within the radius into the sorted row of the
+// nearest knn neighbors.
+struct knn_cell_visitor {
+    __host__ __device__
+    knn_cell_visitor(const grid_view& grid, const Eigen::Vector3f& query,
+                     float radius2, int knn, int* indices, float* distance2)
+        : grid_(grid), query_(query), radius2_(radius2), knn_(knn),
+          indices_(indices), distance2_(distance2), n_(0) {};
+    const grid_view& grid_;
+    const Eigen::Vector3f query_;
+    const float radius2_;
+    const int knn_;
+    int* indices_;
+    float* distance2_;
+    int n_;
+    __host__ __device__
+    void operator() (int c) {
+        for (int j = grid_.cell_starts_[c]; j < grid_.cell_starts_[c + 1]; ++j) {
+            const float d2 = (grid_.points_[j] - query_).squaredNorm();
+            if (d2 >= radius2_) continue;
+            InsertNeighbor(indices_, distance2_, n_, knn_, grid_.point_indices_[j], d2);
+        }
+    }
+};
+
+struct compute_cell_key_functor {
+    compute_cell_key_functor(const Eigen::Vector3f& origin, float cell_size)
+        : origin_(origin), cell_size_(cell_size) {};
+    const Eigen::Vector3f origin_;
+    const float cell_size_;
+    __host__ __device__
+    uint64_t operator() (const Eigen::Vector3f& pt) const {
+        const Eigen::Vector3f ref = (pt - origin_) / cell_size_;
+        return MakeCellKey(Eigen::Vector3i(floorf(ref[0]), floorf(ref[1]), floorf(ref[2])));
+    }
+};
+
+struct xyz_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (const Eigen::Vector4f& pt) const {
+        return Eigen::Vector3f(pt[0], pt[1], pt[2]);
+    }
+};
+
+struct elementwise_min_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (const Eigen::Vector3f& a, const Eigen::Vector3f& b) const {
+        return a.array().min(b.array()).matrix();
+    }
+};
+
+struct elementwise_max_functor {
+    __host__ __device__
+    Eigen::Vector3f operator() (const Eigen::Vector3f& a, const Eigen::Vector3f& b) const {
+        return a.array().max(b.array()).matrix();
+    }
+};
+
+// Searches the nearest knn neighbors within the radius, visiting the cells
+// in rings around the query cell. The rows of the outputs are used as the
+// sorted working buffers.
+struct search_bounded_functor {
+    search_bounded_functor(const grid_view& grid, const Eigen::Vector3f* queries,
+                           float radius2, int knn, int ring,
+                           int* indices, float* distance2)
+        : grid_(grid), queries_(queries), radius2_(radius2), knn_(knn),
+          ring_(ring), indices_(indices), distance2_(distance2) {};
+    const grid_view grid_;
+    const Eigen::Vector3f* queries_;
+    const float radius2_;
+    const int knn_;
+    const int ring_;
+    int* indices_;
+    float* distance2_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        const Eigen::Vector3f query = queries_[idx];
+        const Eigen::Vector3i center = grid_.CellOf(query);
+        int* row_indices = indices_ + idx * knn_;
+        float* row_distance2 = distance2_ + idx * knn_;
+        knn_cell_visitor visit(grid_, query, radius2_, knn_, row_indices, row_distance2);
+        const int max_ring = (ring_ >= 0) ? ring_ : grid_.MaxRing(center);
+        for (int r = 0; r <= max_ring; ++r) {
+            grid_.VisitRing(center, r, visit);
+            // the points in the next ring are at least r * cell_size away
+            const float next_min_dist = r * grid_.cell_size_;
+            const float next_min_dist2 = next_min_dist * next_min_dist;
+            if (next_min_dist2 >= radius2_) break;
+            if (visit.n_ == knn_ && row_distance2[knn_ - 1] <= next_min_dist2) break;
+        }
+        const int n = visit.n_;
+        for (int k = n; k < knn_; ++k) {
+            row_indices[k] = -1;
+            row_distance2[k] = std::numeric_limits<float>::infinity();
+        }
+        return n;
+    }
+};
+
+struct count_radius_neighbors_functor {
+    count_radius_neighbors_functor(const grid_view& grid, const Eigen::Vector3f* queries,
+                                   float radius2, int ring)
+        : grid_(grid), queries_(queries), radius2_(radius2), ring_(ring) {};
+    const grid_view grid_;
+    const Eigen::Vector3f* queries_;
+    const float radius2_;
+    const int ring_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        const Eigen::Vector3f query = queries_[idx];
+        const Eigen::Vector3i center = grid_.CellOf(query);
+        int count = 0;
+        for (int dz = -ring_; dz <= ring_; ++dz) {
+            for (int dy = -ring_; dy <= ring_; ++dy) {
+                for (int dx = -ring_; dx <= ring_; ++dx) {
+                    const int c = grid_.FindCell(center + Eigen::Vector3i(dx, dy, dz));
+                    if (c < 0) continue;
+                    for (int j = grid_.cell_starts_[c]; j < grid_.cell_starts_[c + 1]; ++j) {
+                        if ((grid_.points_[j] - query).squaredNorm() < radius2_) ++count;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+};
+
+struct fill_radius_neighbors_functor {
+    fill_radius_neighbors_functor(const grid_view& grid, const Eigen::Vector3f* queries,
+                                  float radius2, int ring, const int* offsets,
+                                  int* indices, float* distance2, int* rows)
+        : grid_(grid), queries_(queries), radius2_(radius2), ring_(ring),
+          offsets_(offsets), indices_(indices), distance2_(distance2), rows_(rows) {};
+    const grid_view grid_;
+    const Eigen::Vector3f* queries_;
+    const float radius2_;
+    const int ring_;
+    const int* offsets_;
+    int* indices_;
+    float* distance2_;
+    int* rows_;
+    __host__ __device__
+    void operator() (size_t idx) const {
+        const Eigen::Vector3f query = queries_[idx];
+        const Eigen::Vector3i center = grid_.CellOf(query);
+        int k = offsets_[idx];
+        for (int dz = -ring_; dz <= ring_; ++dz) {
+            for (int dy = -ring_; dy <= ring_; ++dy) {
+                for (int dx = -ring_; dx <= ring_; ++dx) {
+                    const int c = grid_.FindCell(center + Eigen::Vector3i(dx, dy, dz));
+                    if (c < 0) continue;
+                    for (int j = grid_.cell_starts_[c]; j < grid_.cell_starts_[c + 1]; ++j) {
+                        const float d2 = (grid_.points_[j] - query).squaredNorm();
+                        if (d2 >= radius2_) continue;
+                        indices_[k] = grid_.point_indices_[j];
+                        distance2_[k] = d2;
+                        rows_[k] = idx;
+                        ++k;
+                    }
+                }
+            }
+        }
+    }
+};
+
+struct clip_count_functor {
+    clip_count_functor(const int* offsets, int max_nn)
+        : offsets_(offsets), max_nn_(max_nn) {};
+    const int* offsets_;
+    const int max_nn_;
+    __host__ __device__
+    int operator() (size_t idx) const {
+        return min(offsets_[idx + 1] - offsets_[idx], max_nn_);
+    }
+};
+
+struct within_max_nn_functor {
+    within_max_nn_functor(const int* offsets, const int* rows, int max_nn)
+        : offsets_(offsets), rows_(rows), max_nn_(max_nn) {};
+    const int* offsets_;
+    const int* rows_;
+    const int max_nn_;
+    __host__ __device__
+    bool operator() (int idx) const {
+        return idx - offsets_[rows_[idx]] < max_nn_;
+    }
+};
+
+const thrustcupoch::device_vector<Eigen::Vector3f>& AsPoints(
+        const thrustcupoch::device_vector<Eigen::Vector3f>& query,
+        thrustcupoch::device_vector<Eigen::Vector3f>& buffer) {
+    return query;
+}
+
+const thrustcupoch::device_vector<Eigen::Vector3f>& AsPoints(
+        const thrustcupoch::device_vector<Eigen::Vector4f>& query,
+        thrustcupoch::device_vector<Eigen::Vector3f>& buffer) {
+    buffer.resize(query.size());
+    thrust::transform(query.begin(), query.end(), buffer.begin(), xyz_functor());
+    return buffer;
+}
+
+int NumRings(float radius, float cell_size) {
+    return std::max(int(std::ceil(radius / cell_size)), 1);
+}
+
+}
+
+UniformGridIndex::UniformGridIndex(float cell_size) : cell_size_(cell_size) {}
+
+UniformGridIndex::UniformGridIndex(const Geometry &geometry, float cell_size)
+    : cell_size_(cell_size) {
+    SetGeometry(geometry);
+}
+
+UniformGridIndex::~UniformGridIndex() {}
+
+bool UniformGridIndex::SetGeometry(const Geometry &geometry) {
+    switch (geometry.GetGeometryType()) {
+        case Geometry::GeometryType::PointCloud:
+            return SetRawData(((const PointCloud &)geometry).points_);
+        case Geometry::GeometryType::TriangleMesh:
+            return SetRawData(((const TriangleMesh &)geometry).vertices_);
+        case Geometry::GeometryType::Image:
+        case Geometry::GeometryType::Unspecified:
+        default:
+            utility::LogWarning(
+                    "[UniformGridIndex::SetGeometry] Unsupported Geometry type.");
+            return false;
+    }
+}
+
+template <typename T>
+bool UniformGridIndex::SetRawData(const thrustcupoch::device_vector<T> &data) {
+    points_.clear();
+    point_indices_.clear();
+    cell_keys_.clear();
+    cell_starts_.clear();
+    if (cell_size_ <= 0.0) {
+        utility::LogWarning(
+                "[UniformGridIndex::SetRawData] Cell size must be positive.");
+        return false;
+    }
+    if (data.empty()) {
+        utility::LogWarning(
+                "[UniformGridIndex::SetRawData] Failed due to no data.");
+        return false;
+    }
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    points_ = AsPoints(data, buffer);
+    const size_t n = points_.size();
+    origin_ = thrust::reduce(points_.begin(), points_.end(), Eigen::Vector3f(points_[0]),
+                             elementwise_min_functor());
+    const Eigen::Vector3f max_bound = thrust::reduce(points_.begin(), points_.end(),
+                                                     Eigen::Vector3f(points_[0]),
+                                                     elementwise_max_functor());
+    const Eigen::Vector3f extent = (max_bound - origin_) / cell_size_;
+    for (int i = 0; i < 3; ++i) {
+        if (extent[i] >= MAX_NUM_CELLS - 1) {
+            utility::LogWarning(
+                    "[UniformGridIndex::SetRawData] Too many cells, increase the cell size.");
+            points_.clear();
+            return false;
+        }
+        num_cells_[i] = int(std::floor(extent[i])) + 1;
+    }
+
+    // bucket the points by a sort on the cell keys
+    thrustcupoch::device_vector<uint64_t> keys(n);
+    thrust::transform(points_.begin(), points_.end(), keys.begin(),
+                      compute_cell_key_functor(origin_, cell_size_));
+    point_indices_.resize(n);
+    thrust::sequence(point_indices_.begin(), point_indices_.end());
+    thrust::sort_by_key(keys.begin(), keys.end(),
+                        make_tuple_iterator(points_.begin(), point_indices_.begin()));
+
+    cell_keys_.resize(n);
+    cell_starts_.resize(n + 1);
+    auto end = thrust::reduce_by_key(keys.begin(), keys.end(),
+                                     thrust::make_constant_iterator<int>(1),
+                                     cell_keys_.begin(), cell_starts_.begin());
+    const size_t n_cells = thrust::distance(cell_keys_.begin(), end.first);
+    cell_keys_.resize(n_cells);
+    cell_starts_.resize(n_cells + 1);
+    thrust::fill(cell_starts_.begin() + n_cells, cell_starts_.end(), 0);
+    thrust::exclusive_scan(cell_starts_.begin(), cell_starts_.end(), cell_starts_.begin());
+    return true;
+}
+
+template <typename T>
+int UniformGridIndex::Search(const thrustcupoch::device_vector<T> &query,
+                             const KDTreeSearchParam &param,
+                             thrustcupoch::device_vector<int> &indices,
+                             thrustcupoch::device_vector<float> &distance2) const {
+    switch (param.GetSearchType()) {
+        case KDTreeSearchParam::SearchType::Knn:
+            return SearchKNN(query, ((const KDTreeSearchParamKNN &)param).knn_,
+                             indices, distance2);
+        case KDTreeSearchParam::SearchType::Radius:
+            return SearchRadius(
+                    query, ((const KDTreeSearchParamRadius &)param).radius_,
+                    indices, distance2);
+        case KDTreeSearchParam::SearchType::Hybrid:
+            return SearchHybrid(
+                    query, ((const KDTreeSearchParamHybrid &)param).radius_,
+                    ((const KDTreeSearchParamHybrid &)param).max_nn_, indices,
+                    distance2);
+        default:
+            return -1;
+    }
+    return -1;
+}
+
+template <typename T>
+int UniformGridIndex::SearchKNN(const thrustcupoch::device_vector<T> &query,
+                                int knn,
+                                thrustcupoch::device_vector<int> &indices,
+                                thrustcupoch::device_vector<float> &distance2) const {
+    if (points_.empty() || query.empty() || knn <= 0 || knn > NUM_MAX_NN) return -1;
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    return SearchBounded(AsPoints(query, buffer), std::numeric_limits<float>::infinity(),
+                         knn, -1, indices, distance2);
+}
+
+template <typename T>
+int UniformGridIndex::SearchRadius(const thrustcupoch::device_vector<T> &query,
+                                   float radius,
+                                   thrustcupoch::device_vector<int> &indices,
+                                   thrustcupoch::device_vector<float> &distance2) const {
+    if (points_.empty() || query.empty() || radius <= 0) return -1;
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    return SearchBounded(AsPoints(query, buffer), radius, NUM_MAX_NN,
+                         NumRings(radius, cell_size_), indices, distance2);
+}
+
+template <typename T>
+int UniformGridIndex::SearchHybrid(const thrustcupoch::device_vector<T> &query,
+                                   float radius,
+                                   int max_nn,
+                                   thrustcupoch::device_vector<int> &indices,
+                                   thrustcupoch::device_vector<float> &distance2) const {
+    if (points_.empty() || query.empty() || radius <= 0 || max_nn <= 0 || max_nn > NUM_MAX_NN) return -1;
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    return SearchBounded(AsPoints(query, buffer), radius, max_nn,
+                         NumRings(radius, cell_size_), indices, distance2);
+}
+
+template <typename T>
+int UniformGridIndex::SearchRadiusCSR(const thrustcupoch::device_vector<T> &query,
+                                      float radius,
+                                      thrustcupoch::device_vector<int> &offsets,
+                                      thrustcupoch::device_vector<int> &indices,
+                                      thrustcupoch::device_vector<float> &distance2) const {
+    if (points_.empty() || query.empty() || radius <= 0) return -1;
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    return SearchCSR(AsPoints(query, buffer), radius, -1, offsets, indices, distance2);
+}
+
+template <typename T>
+int UniformGridIndex::SearchHybridCSR(const thrustcupoch::device_vector<T> &query,
+                                      float radius,
+                                      int max_nn,
+                                      thrustcupoch::device_vector<int> &offsets,
+                                      thrustcupoch::device_vector<int> &indices,
+                                      thrustcupoch::device_vector<float> &distance2) const {
+    if (points_.empty() || query.empty() || radius <= 0 || max_nn <= 0) return -1;
+    thrustcupoch::device_vector<Eigen::Vector3f> buffer;
+    return SearchCSR(AsPoints(query, buffer), radius, max_nn, offsets, indices, distance2);
+}
+
+int UniformGridIndex::SearchBounded(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                                    float radius,
+                                    int knn,
+                                    int ring,
+                                    thrustcupoch::device_vector<int> &indices,
+                                    thrustcupoch::device_vector<float> &distance2) const {
+    const size_t n_query = query.size();
+    indices.resize(n_query * knn);
+    distance2.resize(n_query * knn);
+    grid_view grid(thrust::raw_pointer_cast(points_.data()),
+                   thrust::raw_pointer_cast(point_indices_.data()),
+                   thrust::raw_pointer_cast(cell_keys_.data()),
+                   thrust::raw_pointer_cast(cell_starts_.data()),
+                   cell_keys_.size(), origin_, cell_size_, num_cells_);
+    search_bounded_functor func(grid, thrust::raw_pointer_cast(query.data()),
+                                radius * radius, knn, ring,
+                                thrust::raw_pointer_cast(indices.data()),
+                                thrust::raw_pointer_cast(distance2.data()));
+    return thrust::transform_reduce(thrust::make_counting_iterator<size_t>(0),
+                                    thrust::make_counting_iterator(n_query),
+                                    func, 0, thrust::plus<int>());
+}
+
+int UniformGridIndex::SearchCSR(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                                float radius,
+                                int max_nn,
+                                thrustcupoch::device_vector<int> &offsets,
+                                thrustcupoch::device_vector<int> &indices,
+                                thrustcupoch::device_vector<float> &distance2) const {
+    const size_t n_query = query.size();
+    const float radius2 = radius * radius;
+    const int ring = NumRings(radius, cell_size_);
+    grid_view grid(thrust::raw_pointer_cast(points_.data()),
+                   thrust::raw_pointer_cast(point_indices_.data()),
+                   thrust::raw_pointer_cast(cell_keys_.data()),
+                   thrust::raw_pointer_cast(cell_starts_.data()),
+                   cell_keys_.size(), origin_, cell_size_, num_cells_);
+    // count the neighbors of each query
+    offsets.resize(n_query + 1);
+    thrust::fill(offsets.begin() + n_query, offsets.end(), 0);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_query), offsets.begin(),
+                      count_radius_neighbors_functor(grid, thrust::raw_pointer_cast(query.data()),
+                                                     radius2, ring));
+    // the offsets are int, so large radius searches may not fit in them
+    const size_t n_neighbors = thrust::reduce(offsets.begin(), offsets.begin() + n_query,
+                                              size_t(0));
+    if (n_neighbors > size_t(std::numeric_limits<int>::max())) {
+        utility::LogError("[UniformGridIndex::SearchCSR] {:d} neighbors overflow the int offsets, "
+                          "reduce the radius or max_nn.\n", n_neighbors);
+        offsets.clear();
+        indices.clear();
+        distance2.clear();
+        return -1;
+    }
+    thrust::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+    const int total = int(n_neighbors);
+    indices.resize(total);
+    distance2.resize(total);
+    if (total == 0) return 0;
+
+    // fill the rows and sort each of them by distance
+    thrustcupoch::device_vector<int> rows(total);
+    thrust::for_each(thrust::make_counting_iterator<size_t>(0),
+                     thrust::make_counting_iterator(n_query),
+                     fill_radius_neighbors_functor(grid, thrust::raw_pointer_cast(query.data()),
+                                                   radius2, ring,
+                                                   thrust::raw_pointer_cast(offsets.data()),
+                                                   thrust::raw_pointer_cast(indices.data()),
+                                                   thrust::raw_pointer_cast(distance2.data()),
+                                                   thrust::raw_pointer_cast(rows.data())));
+    thrust::sort_by_key(distance2.begin(), distance2.end(),
+                        make_tuple_iterator(indices.begin(), rows.begin()));
+    thrust::stable_sort_by_key(rows.begin(), rows.end(),
+                               make_tuple_iterator(indices.begin(), distance2.begin()));
+    if (max_nn <= 0) return total;
+
+    // keep the nearest max_nn neighbors of each row
+    thrustcupoch::device_vector<int> clipped_indices(total);
+    thrustcupoch::device_vector<float> clipped_distance2(total);
+    auto end = thrust::copy_if(make_tuple_iterator(indices.begin(), distance2.begin()),
+                               make_tuple_iterator(indices.end(), distance2.end()),
+                               thrust::make_counting_iterator(0),
+                               make_tuple_iterator(clipped_indices.begin(), clipped_distance2.begin()),
+                               within_max_nn_functor(thrust::raw_pointer_cast(offsets.data()),
+                                                     thrust::raw_pointer_cast(rows.data()),
+                                                     max_nn));
+    const int n_clipped = thrust::distance(make_tuple_iterator(clipped_indices.begin(), clipped_distance2.begin()), end);
+    clipped_indices.resize(n_clipped);
+    clipped_distance2.resize(n_clipped);
+    thrustcupoch::device_vector<int> clipped_offsets(n_query + 1, 0);
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(n_query), clipped_offsets.begin(),
+                      clip_count_functor(thrust::raw_pointer_cast(offsets.data()), max_nn));
+    thrust::exclusive_scan(clipped_offsets.begin(), clipped_offsets.end(), clipped_offsets.begin());
+    offsets.swap(clipped_offsets);
+    indices.swap(clipped_indices);
+    distance2.swap(clipped_distance2);
+    return n_clipped;
+}
+
+template <typename T>
+int UniformGridIndex::Search(const T &query,
+                             const KDTreeSearchParam &param,
+                             thrust::host_vector<int> &indices,
+                             thrust::host_vector<float> &distance2) const {
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
+    auto result = Search<T>(query_dv, param, indices_dv, distance2_dv);
+    indices = indices_dv;
+    distance2 = distance2_dv;
+    return result;
+}
+
+template <typename T>
+int UniformGridIndex::SearchKNN(const T &query,
+                                int knn,
+                                thrust::host_vector<int> &indices,
+                                thrust::host_vector<float> &distance2) const {
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
+    auto result = SearchKNN<T>(query_dv, knn, indices_dv, distance2_dv);
+    indices = indices_dv;
+    distance2 = distance2_dv;
+    return result;
+}
+
+template <typename T>
+int UniformGridIndex::SearchRadius(const T &query,
+                                   float radius,
+                                   thrust::host_vector<int> &indices,
+                                   thrust::host_vector<float> &distance2) const {
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
+    auto result = SearchRadius<T>(query_dv, radius, indices_dv, distance2_dv);
+    indices = indices_dv;
+    distance2 = distance2_dv;
+    return result;
+}
+
+template <typename T>
+int UniformGridIndex::SearchHybrid(const T &query,
+                                   float radius,
+                                   int max_nn,
+                                   thrust::host_vector<int> &indices,
+                                   thrust::host_vector<float> &distance2) const {
+    thrustcupoch::device_vector<T> query_dv(1, query);
+    thrustcupoch::device_vector<int> indices_dv;
+    thrustcupoch::device_vector<float> distance2_dv;
+    auto result = SearchHybrid<T>(query_dv, radius, max_nn, indices_dv, distance2_dv);
+    indices = indices_dv;
+    distance2 = distance2_dv;
+    return result;
+}
+
+#define INSTANTIATE_UNIFORM_GRID_INDEX(T)                                      \
+    template bool UniformGridIndex::SetRawData<T>(                             \
+            const thrustcupoch::device_vector<T> &data);                       \
+    template int UniformGridIndex::Search<T>(                                  \
+            const thrustcupoch::device_vector<T> &query,                       \
+            const KDTreeSearchParam &param,                                    \
+            thrustcupoch::device_vector<int> &indices,                         \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::SearchKNN<T>(                               \
+            const thrustcupoch::device_vector<T> &query, int knn,              \
+            thrustcupoch::device_vector<int> &indices,                         \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::SearchRadius<T>(                            \
+            const thrustcupoch::device_vector<T> &query, float radius,         \
+            thrustcupoch::device_vector<int> &indices,                         \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::SearchHybrid<T>(                            \
+            const thrustcupoch::device_vector<T> &query, float radius,         \
+            int max_nn, thrustcupoch::device_vector<int> &indices,             \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::SearchRadiusCSR<T>(                         \
+            const thrustcupoch::device_vector<T> &query, float radius,         \
+            thrustcupoch::device_vector<int> &offsets,                         \
+            thrustcupoch::device_vector<int> &indices,                         \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::SearchHybridCSR<T>(                         \
+            const thrustcupoch::device_vector<T> &query, float radius,         \
+            int max_nn, thrustcupoch::device_vector<int> &offsets,             \
+            thrustcupoch::device_vector<int> &indices,                         \
+            thrustcupoch::device_vector<float> &distance2) const;              \
+    template int UniformGridIndex::Search<T>(                                  \
+            const T &query, const KDTreeSearchParam &param,                    \
+            thrust::host_vector<int> &indices,                                 \
+            thrust::host_vector<float> &distance2) const;                      \
+    template int UniformGridIndex::SearchKNN<T>(                               \
+            const T &query, int knn, thrust::host_vector<int> &indices,        \
+            thrust::host_vector<float> &distance2) const;                      \
+    template int UniformGridIndex::SearchRadius<T>(                            \
+            const T &query, float radius, thrust::host_vector<int> &indices,   \
+            thrust::host_vector<float> &distance2) const;                      \
+    template int UniformGridIndex::SearchHybrid<T>(                            \
+            const T &query, float radius, int max_nn,                          \
+            thrust::host_vector<int> &indices,                                 \
+            thrust::host_vector<float> &distance2) const;
+
+INSTANTIATE_UNIFORM_GRID_INDEX(Eigen::Vector3f)
+INSTANTIATE_UNIFORM_GRID_INDEX(Eigen::Vector4f)
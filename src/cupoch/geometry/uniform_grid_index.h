@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <stdint.h>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/utility/thrust_cupoch.h"
+#include <thrust/host_vector.h>
+
+namespace cupoch {
+namespace geometry {
+
+class Geometry;
+
+/// \class UniformGridIndex
+///
+/// \brief Uniform grid index for fixed-radius neighbor searches.
+///
+/// The points are bucketed into cubic cells of size cell_size_ by a sort on
+/// their 64-bit cell keys, so building the index is a radix sort and a
+/// segmented reduction. A radius search visits the cells within
+/// ceil(radius / cell_size_) cells of the query cell, i.e. only the 27
+/// neighboring cells when the cell size is set to the search radius.
+/// The search functions have the same interface and result layout as
+/// KDTreeFlann.
+class UniformGridIndex {
+public:
+    /// \param cell_size should be the radius of the searches that will be
+    /// run on the index.
+    UniformGridIndex(float cell_size);
+    UniformGridIndex(const Geometry &geometry, float cell_size);
+    ~UniformGridIndex();
+    UniformGridIndex(const UniformGridIndex &) = delete;
+    UniformGridIndex &operator=(const UniformGridIndex &) = delete;
+
+public:
+    bool SetGeometry(const Geometry &geometry);
+
+    template <typename T>
+    bool SetRawData(const thrustcupoch::device_vector<T> &data);
+
+    float GetCellSize() const { return cell_size_; }
+    size_t GetNumCells() const { return cell_keys_.size(); }
+
+    template <typename T>
+    int Search(const thrustcupoch::device_vector<T> &query,
+               const KDTreeSearchParam &param,
+               thrustcupoch::device_vector<int> &indices,
+               thrustcupoch::device_vector<float> &distance2) const;
+
+    /// The cells are visited in rings around the query cell until knn
+    /// neighbors are found and no closer point can be in the next ring.
+    template <typename T>
+    int SearchKNN(const thrustcupoch::device_vector<T> &query,
+                  int knn,
+                  thrustcupoch::device_vector<int> &indices,
+                  thrustcupoch::device_vector<float> &distance2) const;
+
+    template <typename T>
+    int SearchRadius(const thrustcupoch::device_vector<T> &query,
+                     float radius,
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
+
+    template <typename T>
+    int SearchHybrid(const thrustcupoch::device_vector<T> &query,
+                     float radius,
+                     int max_nn,
+                     thrustcupoch::device_vector<int> &indices,
+                     thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Same as KDTreeFlann::SearchRadiusCSR.
+    template <typename T>
+    int SearchRadiusCSR(const thrustcupoch::device_vector<T> &query,
+                        float radius,
+                        thrustcupoch::device_vector<int> &offsets,
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const;
+
+    /// Same as KDTreeFlann::SearchHybridCSR.
+    template <typename T>
+    int SearchHybridCSR(const thrustcupoch::device_vector<T> &query,
+                        float radius,
+                        int max_nn,
+                        thrustcupoch::device_vector<int> &offsets,
+                        thrustcupoch::device_vector<int> &indices,
+                        thrustcupoch::device_vector<float> &distance2) const;
+
+    template <typename T>
+    int Search(const T &query,
+               const KDTreeSearchParam &param,
+               thrust::host_vector<int> &indices,
+               thrust::host_vector<float> &distance2) const;
+
+    template <typename T>
+    int SearchKNN(const T &query,
+                  int knn,
+                  thrust::host_vector<int> &indices,
+                  thrust::host_vector<float> &distance2) const;
+
+    template <typename T>
+    int SearchRadius(const T &query,
+                     float radius,
+                     thrust::host_vector<int> &indices,
+                     thrust::host_vector<float> &distance2) const;
+
+    template <typename T>
+    int SearchHybrid(const T &query,
+                     float radius,
+                     int max_nn,
+                     thrust::host_vector<int> &indices,
+                     thrust::host_vector<float> &distance2) const;
+
+protected:
+    /// Searches the nearest \param knn neighbors within \param radius,
+    /// visiting \param ring cells around the query cell. A negative
+    /// \param ring expands the rings until knn neighbors are found.
+    int SearchBounded(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                      float radius,
+                      int knn,
+                      int ring,
+                      thrustcupoch::device_vector<int> &indices,
+                      thrustcupoch::device_vector<float> &distance2) const;
+
+    int SearchCSR(const thrustcupoch::device_vector<Eigen::Vector3f> &query,
+                  float radius,
+                  int max_nn,
+                  thrustcupoch::device_vector<int> &offsets,
+                  thrustcupoch::device_vector<int> &indices,
+                  thrustcupoch::device_vector<float> &distance2) const;
+
+    float cell_size_;
+    Eigen::Vector3f origin_ = Eigen::Vector3f::Zero();
+    Eigen::Vector3i num_cells_ = Eigen::Vector3i::Zero();
+    /// Points sorted by cell key and their indices in the input data
+    thrustcupoch::device_vector<Eigen::Vector3f> points_;
+    thrustcupoch::device_vector<int> point_indices_;
+    /// Sorted unique keys of the occupied cells; the points of the i-th
+    /// cell are points_[cell_starts_[i]:cell_starts_[i + 1]].
+    thrustcupoch::device_vector<uint64_t> cell_keys_;
+    thrustcupoch::device_vector<int> cell_starts_;
+};
+
+}  // namespace geometry
+}  // namespace cupoch
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <stdint.h>
+
+namespace cupoch {
+namespace geometry {
+
+/// Number of bits of each voxel coordinate in the 64-bit Morton codes
+static const int MORTON_CODE_BITS = 21;
+
+/// Index of the voxel of size \param voxel_size containing \param pt in a
+/// grid starting at \param voxel_min_bound.
+__host__ __device__
+inline Eigen::Vector3i ComputeVoxelIndex(const Eigen::Vector3f& pt,
+                                         const Eigen::Vector3f& voxel_min_bound,
+                                         float voxel_size) {
+    auto ref_coord = (pt - voxel_min_bound) / voxel_size;
+    return Eigen::Vector3i(int(floor(ref_coord(0))), int(floor(ref_coord(1))),
+                           int(floor(ref_coord(2))));
+}
+
+/// Spreads the lower 21 bits of \param x to every third bit.
+__host__ __device__
+inline uint64_t SpreadBits3(uint64_t x) {
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+/// 63-bit Morton (Z-order) code of a voxel index. The coordinates are
+/// clamped to [0, 2^21 - 1].
+__host__ __device__
+inline uint64_t MortonEncode(const Eigen::Vector3i& voxel) {
+    const int max_coord = (1 << MORTON_CODE_BITS) - 1;
+    uint64_t code = 0;
+    for (int i = 0; i < 3; ++i) {
+        const int c = voxel[i] < 0 ? 0 : (voxel[i] > max_coord ? max_coord : voxel[i]);
+        code |= SpreadBits3(uint64_t(c)) << i;
+    }
+    return code;
+}
+
+}  // namespace geometry
+}  // namespace cupoch
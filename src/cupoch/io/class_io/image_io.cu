@@ -1,6 +1,7 @@
 #include "cupoch/io/class_io/image_io.h"
 #include "cupoch/geometry/image.h"
 #include "cupoch/utility/helper.h"
+#include "cupoch/utility/execution_context.h"
 
 using namespace cupoch;
 using namespace cupoch::io;
@@ -9,14 +10,14 @@ void HostImage::FromDevice(const geometry::Image& image) {
     data_.resize(image.data_.size());
     Prepare(image.width_, image.height_, image.num_of_channels_, image.bytes_per_channel_);
     utility::CopyFromDeviceMultiStream(image.data_, data_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
 }
 
 void HostImage::ToDevice(geometry::Image& image) const {
     image.Prepare(width_, height_, num_of_channels_, bytes_per_channel_);
     image.data_.resize(data_.size());
     utility::CopyToDeviceMultiStream(data_, image.data_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
 }
 
 void HostImage::Clear() {
@@ -1,6 +1,7 @@
 #include "cupoch/io/class_io/pointcloud_io.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/utility/helper.h"
+#include "cupoch/utility/execution_context.h"
 
 using namespace cupoch;
 using namespace cupoch::io;
@@ -13,7 +14,7 @@ void HostPointCloud::FromDevice(const geometry::PointCloud& pointcloud) {
     utility::CopyFromDeviceMultiStream(pointcloud.points_, points_);
     utility::CopyFromDeviceMultiStream(pointcloud.normals_, normals_);
     utility::CopyFromDeviceMultiStream(pointcloud.colors_, colors_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
 }
 
 void HostPointCloud::ToDevice(geometry::PointCloud& pointcloud) const {
@@ -23,7 +24,8 @@ void HostPointCloud::ToDevice(geometry::PointCloud& pointcloud) const {
     utility::CopyToDeviceMultiStream(points_, pointcloud.points_);
     utility::CopyToDeviceMultiStream(normals_, pointcloud.normals_);
     utility::CopyToDeviceMultiStream(colors_, pointcloud.colors_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
+    pointcloud.InvalidateKDTree();
 }
 
 void HostPointCloud::Clear() {
@@ -1,5 +1,6 @@
 #include "cupoch/io/class_io/trianglemesh_io.h"
 #include "cupoch/geometry/trianglemesh.h"
+#include "cupoch/utility/execution_context.h"
 
 using namespace cupoch;
 using namespace cupoch::io;
@@ -17,7 +18,7 @@ void HostTriangleMesh::FromDevice(const geometry::TriangleMesh& trianglemesh) {
     utility::CopyFromDeviceMultiStream(trianglemesh.triangles_, triangles_);
     utility::CopyFromDeviceMultiStream(trianglemesh.triangle_normals_, triangle_normals_);
     utility::CopyFromDeviceMultiStream(trianglemesh.triangle_uvs_, triangle_uvs_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
 }
 
 void HostTriangleMesh::ToDevice(geometry::TriangleMesh& trianglemesh) const {
@@ -33,7 +34,8 @@ void HostTriangleMesh::ToDevice(geometry::TriangleMesh& trianglemesh) const {
     utility::CopyToDeviceMultiStream(triangles_, trianglemesh.triangles_);
     utility::CopyToDeviceMultiStream(triangle_normals_, trianglemesh.triangle_normals_);
     utility::CopyToDeviceMultiStream(triangle_uvs_, trianglemesh.triangle_uvs_);
-    cudaDeviceSynchronize();
+    utility::GetExecutionContext().Synchronize();
+    trianglemesh.InvalidateKDTree();
 }
 
 void HostTriangleMesh::Clear() {
@@ -21,7 +21,7 @@ struct initialize_correspondence_map_functor {
     uint8_t* correspondence_map_;
     uint8_t* depth_buffer_;
     int width_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         *(int*)(correspondence_map_ + idx * 2 * sizeof(int)) = -1;
         *(int*)(correspondence_map_ + (idx * 2  + 1) * sizeof(int)) = -1;
@@ -44,7 +44,7 @@ InitializeCorrespondenceMap(int width, int height) {
     return std::make_tuple(correspondence_map, depth_buffer);
 }
 
-__device__
+__host__ __device__
 inline void AddElementToCorrespondenceMap(uint8_t* correspondence_map,
                                           uint8_t* depth_buffer,
                                           int width,
@@ -84,7 +84,7 @@ struct merge_correspondence_maps_functor {
     uint8_t* correspondence_map_part_;
     uint8_t* depth_buffer_part_;
     int width_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int v_s = idx / width_;
         int u_s = idx % width_;
@@ -131,7 +131,7 @@ struct compute_correspondence_map {
     const Eigen::Vector3f Kt_;
     const Eigen::Matrix3f KRK_inv_;
     const float max_depth_diff_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int v_s = idx / width_;
         int u_s = idx % width_;
@@ -167,7 +167,7 @@ struct compute_correspondence_functor {
     const uint8_t* correspondence_map_;
     const int width_;
     Eigen::Vector4i* correspondence_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int v_s = idx / width_;
         int u_s = idx % width_;
@@ -221,7 +221,7 @@ void ComputeCorrespondence(
     thrust::for_each(thrust::make_counting_iterator<size_t>(0),
                      thrust::make_counting_iterator<size_t>(correspondence_map->width_ * correspondence_map->height_), func_cc);
     auto end = thrust::remove_if(correspondence.begin(), correspondence.end(),
-                                 [] __device__ (const Eigen::Vector4i& pc) {return (pc[2] == -1 || pc[3] == -1);});
+                                 [] __host__ __device__ (const Eigen::Vector4i& pc) {return (pc[2] == -1 || pc[3] == -1);});
     correspondence.resize(thrust::distance(correspondence.begin(), end));
 }
 
@@ -241,7 +241,7 @@ struct convert_depth_to_xyz_image_functor {
     const float oy_;
     const float inv_fx_;
     const float inv_fy_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         int y = idx / width_;
         int x = idx % width_;
@@ -301,7 +301,7 @@ struct compute_gtg_functor {
     const Eigen::Vector4i* correspondences_;
     const uint8_t* xyz_t_;
     const int width_;
-    __device__
+    __host__ __device__
     Eigen::Matrix6f operator() (size_t idx) const {
         int u_t = correspondences_[idx](2);
         int v_t = correspondences_[idx](3);
@@ -351,7 +351,7 @@ struct compute_mean_functor {
     const uint8_t* image_s_;
     const uint8_t* image_t_;
     int width_;
-    __device__
+    __host__ __device__
     thrust::tuple<float, float> operator() (size_t idx) const {
         int u_s = corres_[idx](0);
         int v_s = corres_[idx](1);
@@ -363,7 +363,7 @@ struct compute_mean_functor {
 };
 
 struct add_tuple2f_functor {
-    __device__
+    __host__ __device__
     thrust::tuple<float, float> operator()(const thrust::tuple<float, float>& lhs, const thrust::tuple<float, float>& rhs) const {
         return thrust::make_tuple(thrust::get<0>(lhs) + thrust::get<0>(rhs), thrust::get<1>(lhs) + thrust::get<1>(rhs));
     }
@@ -403,7 +403,7 @@ struct preprocess_depth_functor {
     uint8_t* depth_;
     const float min_depth_;
     const float max_depth_;
-    __device__
+    __host__ __device__
     void operator() (size_t idx) {
         float *p = (float*)(depth_ + idx * sizeof(float));
         if ((*p < min_depth_ || *p > max_depth_ || *p <= 0))
@@ -505,7 +505,7 @@ struct compute_jacobian_and_residual_functor : public utility::multiple_jacobian
     const Eigen::Matrix4f extrinsic_;
     const Eigen::Vector4i* corresps_;
     JacobianType jacobian_;
-    __device__
+    __host__ __device__
     void operator() (int i, Eigen::Vector6f J_r[2], float r[2]) const {
         jacobian_.ComputeJacobianAndResidual(
             i, J_r, r,
@@ -16,7 +16,7 @@ namespace {
 
 class PointCloudForColoredICP : public geometry::PointCloud {
 public:
-    thrust::device_vector<Eigen::Vector3f> color_gradient_;
+    thrustcupoch::device_vector<Eigen::Vector3f> color_gradient_;
 };
 
 class TransformationEstimationForColoredICP : public TransformationEstimation {
@@ -61,7 +61,7 @@ struct compute_color_gradient_functor {
     const int* indices_;
     const float* distances2_;
     const int knn_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator()(size_t idx) const {
         const Eigen::Vector3f &vt = points_[idx];
         const Eigen::Vector3f &nt = normals_[idx];
@@ -106,9 +106,6 @@ std::shared_ptr<PointCloudForColoredICP> InitializePointCloudForColoredICP(
         const geometry::KDTreeSearchParamHybrid &search_param) {
     utility::LogDebug("InitializePointCloudForColoredICP");
 
-    geometry::KDTreeFlann tree;
-    tree.SetGeometry(target);
-
     auto output = std::make_shared<PointCloudForColoredICP>();
     output->colors_ = target.colors_;
     output->normals_ = target.normals_;
@@ -116,16 +113,13 @@ std::shared_ptr<PointCloudForColoredICP> InitializePointCloudForColoredICP(
 
     size_t n_points = output->points_.size();
     output->color_gradient_.resize(n_points, Eigen::Vector3f::Zero());
-    thrust::device_vector<int> point_idx;
-    thrust::device_vector<float> point_squared_distance;
-    tree.SearchHybrid(output->points_, search_param.radius_, search_param.max_nn_,
-                      point_idx, point_squared_distance);
+    auto neighbors = target.SearchNeighbors(search_param);
     compute_color_gradient_functor func(thrust::raw_pointer_cast(output->points_.data()),
                                         thrust::raw_pointer_cast(output->normals_.data()),
                                         thrust::raw_pointer_cast(output->colors_.data()),
-                                        thrust::raw_pointer_cast(point_idx.data()),
-                                        thrust::raw_pointer_cast(point_squared_distance.data()),
-                                        search_param.max_nn_);
+                                        thrust::raw_pointer_cast(neighbors->indices_.data()),
+                                        thrust::raw_pointer_cast(neighbors->distance2_.data()),
+                                        neighbors->knn_);
     thrust::transform(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(n_points),
                       output->color_gradient_.begin(), func);
     return output;
@@ -152,7 +146,7 @@ struct compute_jacobian_and_residual_functor : public utility::multiple_jacobian
     const Eigen::Vector2i* corres_;
     const float sqrt_lambda_geometric_;
     const float sqrt_lambda_photometric_;
-    __device__
+    __host__ __device__
     void operator() (int i, Eigen::Vector6f J_r[2], float r[2]) const {
         size_t cs = corres_[i][0];
         size_t ct = corres_[i][1];
@@ -248,7 +242,7 @@ struct diff_square_colored_functor {
     const Eigen::Vector2i* corres_;
     const float sqrt_lambda_geometric_;
     const float sqrt_lambda_photometric_;
-    __device__
+    __host__ __device__
     float operator()(size_t idx) const {
         size_t cs = corres_[idx][0];
         size_t ct = corres_[idx][1];
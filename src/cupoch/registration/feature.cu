@@ -1,7 +1,7 @@
 #include <Eigen/Geometry>
 #include "cupoch/registration/feature.h"
 #include "cupoch/geometry/pointcloud.h"
-#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/kdtree_cache.h"
 #include "cupoch/utility/console.h"
 
 using namespace cupoch;
@@ -9,7 +9,7 @@ using namespace cupoch::registration;
 
 namespace {
 
-__device__
+__host__ __device__
 Eigen::Vector4f ComputePairFeatures(const Eigen::Vector3f &p1,
         const Eigen::Vector3f &n1,
         const Eigen::Vector3f &p2,
@@ -55,7 +55,7 @@ struct compute_spfh_functor {
     const int* indices_;
     const int knn_;
     const float hist_incr_;
-    __device__
+    __host__ __device__
     Feature<33>::FeatureType operator()(size_t idx) const {
         Feature<33>::FeatureType ft;
         for (size_t k = 1; k < knn_; k++) {
@@ -82,20 +82,15 @@ struct compute_spfh_functor {
 
 std::shared_ptr<Feature<33>> ComputeSPFHFeature(
     const geometry::PointCloud &input,
-    const geometry::KDTreeFlann &kdtree,
-    const geometry::KDTreeSearchParam &search_param) {
+    const geometry::NeighborSearchResult &neighbors) {
     auto feature = std::make_shared<Feature<33>>();
     feature->Resize((int)input.points_.size());
 
-    thrust::device_vector<int> indices;
-    thrust::device_vector<float> distance2;
-    auto knn = ((const geometry::KDTreeSearchParamKNN &)search_param).knn_;
-    kdtree.SearchKNN(input.points_, knn,
-                     indices, distance2);
+    const int knn = neighbors.knn_;
     float hist_incr = 100.0 / (float)(knn - 1);
     compute_spfh_functor func(thrust::raw_pointer_cast(input.points_.data()),
                               thrust::raw_pointer_cast(input.normals_.data()),
-                              thrust::raw_pointer_cast(indices.data()),
+                              thrust::raw_pointer_cast(neighbors.indices_.data()),
                               knn, hist_incr);
     thrust::transform(thrust::make_counting_iterator<size_t>(0),
                       thrust::make_counting_iterator(input.points_.size()),
@@ -111,7 +106,7 @@ struct compute_fpfh_functor {
     const int* indices_;
     const float* distance2_;
     const int knn_;
-    __device__
+    __host__ __device__
     Feature<33>::FeatureType operator() (size_t idx) const {
         Feature<33>::FeatureType ft;
         float sum[3] = {0.0, 0.0, 0.0};
@@ -155,17 +150,13 @@ std::shared_ptr<Feature<33>> ComputeFPFHFeature(
                 "normal.");
     }
 
-    geometry::KDTreeFlann kdtree(input);
-    auto spfh = ComputeSPFHFeature(input, kdtree, search_param);
-    thrust::device_vector<int> indices;
-    thrust::device_vector<float> distance2;
-    kdtree.SearchKNN(input.points_,
-                     ((const geometry::KDTreeSearchParamKNN &)search_param).knn_,
-                     indices, distance2);
+    // The same neighbors are used by the SPFH and FPFH passes.
+    auto neighbors = input.SearchNeighbors(search_param);
+    auto spfh = ComputeSPFHFeature(input, *neighbors);
     compute_fpfh_functor func(thrust::raw_pointer_cast(spfh->data_.data()),
-                              thrust::raw_pointer_cast(indices.data()),
-                              thrust::raw_pointer_cast(distance2.data()),
-                              ((const geometry::KDTreeSearchParamKNN &)search_param).knn_);
+                              thrust::raw_pointer_cast(neighbors->indices_.data()),
+                              thrust::raw_pointer_cast(neighbors->distance2_.data()),
+                              neighbors->knn_);
     thrust::transform(thrust::make_counting_iterator<size_t>(0),
                       thrust::make_counting_iterator(input.points_.size()),
                       feature->data_.begin(), func);
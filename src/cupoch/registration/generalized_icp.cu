@@ -0,0 +1,200 @@
+#include "cupoch/registration/generalized_icp.h"
+
+#include <Eigen/Geometry>
+#include <thrust/transform_reduce.h>
+
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/eigen.h"
+
+using namespace cupoch;
+using namespace cupoch::registration;
+
+namespace {
+
+// Returns W = L^-1 for the Cholesky factor M = L L^T, so that
+// W^T W = M^-1 and the rows of W whiten the residual. Any such factor gives
+// the same JTJ and JTr as the symmetric square root of M^-1.
+__host__ __device__
+Eigen::Matrix3f InverseCholeskyFactor(const Eigen::Matrix3f& M) {
+    Eigen::Matrix3f W = Eigen::Matrix3f::Zero();
+    if (M(0, 0) <= 0.0) return W;
+    const float l00 = sqrt(M(0, 0));
+    const float l10 = M(1, 0) / l00;
+    const float l20 = M(2, 0) / l00;
+    const float d11 = M(1, 1) - l10 * l10;
+    if (d11 <= 0.0) return W;
+    const float l11 = sqrt(d11);
+    const float l21 = (M(2, 1) - l20 * l10) / l11;
+    const float d22 = M(2, 2) - l20 * l20 - l21 * l21;
+    if (d22 <= 0.0) return W;
+    const float l22 = sqrt(d22);
+    W(0, 0) = 1.0 / l00;
+    W(1, 1) = 1.0 / l11;
+    W(2, 2) = 1.0 / l22;
+    W(1, 0) = -l10 * W(0, 0) / l11;
+    W(2, 1) = -l21 * W(1, 1) / l22;
+    W(2, 0) = -(l20 * W(0, 0) + l21 * W(1, 0)) / l22;
+    return W;
+}
+
+struct gicp_jacobian_residual_functor : public utility::multiple_jacobians_residuals_functor<Eigen::Vector6f, 3> {
+    gicp_jacobian_residual_functor(const Eigen::Vector3f* source_points,
+                                   const Eigen::Matrix3f* source_covariances,
+                                   const Eigen::Vector3f* target_points,
+                                   const Eigen::Matrix3f* target_covariances,
+                                   const Eigen::Vector2i* corres)
+        : source_points_(source_points), source_covariances_(source_covariances),
+          target_points_(target_points), target_covariances_(target_covariances),
+          corres_(corres) {};
+    const Eigen::Vector3f* source_points_;
+    const Eigen::Matrix3f* source_covariances_;
+    const Eigen::Vector3f* target_points_;
+    const Eigen::Matrix3f* target_covariances_;
+    const Eigen::Vector2i* corres_;
+    __host__ __device__
+    void operator() (int i, Eigen::Vector6f J_r[3], float r[3]) const {
+        const int cs = corres_[i][0];
+        const int ct = corres_[i][1];
+        const Eigen::Vector3f &vs = source_points_[cs];
+        const Eigen::Vector3f &vt = target_points_[ct];
+        const Eigen::Matrix3f W = InverseCholeskyFactor(source_covariances_[cs] +
+                                                        target_covariances_[ct]);
+        const Eigen::Vector3f d = vs - vt;
+        for (int k = 0; k < 3; ++k) {
+            const Eigen::Vector3f w = W.row(k).transpose();
+            J_r[k].block<3, 1>(0, 0) = vs.cross(w);
+            J_r[k].block<3, 1>(3, 0) = w;
+            r[k] = w.dot(d);
+        }
+    }
+};
+
+struct mahalanobis_square_functor {
+    mahalanobis_square_functor(const Eigen::Vector3f* source_points,
+                               const Eigen::Matrix3f* source_covariances,
+                               const Eigen::Vector3f* target_points,
+                               const Eigen::Matrix3f* target_covariances,
+                               const Eigen::Vector2i* corres)
+        : source_points_(source_points), source_covariances_(source_covariances),
+          target_points_(target_points), target_covariances_(target_covariances),
+          corres_(corres) {};
+    const Eigen::Vector3f* source_points_;
+    const Eigen::Matrix3f* source_covariances_;
+    const Eigen::Vector3f* target_points_;
+    const Eigen::Matrix3f* target_covariances_;
+    const Eigen::Vector2i* corres_;
+    __host__ __device__
+    float operator()(size_t idx) const {
+        const int cs = corres_[idx][0];
+        const int ct = corres_[idx][1];
+        const Eigen::Matrix3f W = InverseCholeskyFactor(source_covariances_[cs] +
+                                                        target_covariances_[ct]);
+        return (W * (source_points_[cs] - target_points_[ct])).squaredNorm();
+    }
+};
+
+struct mahalanobis_distance_functor : public mahalanobis_square_functor {
+    mahalanobis_distance_functor(const Eigen::Vector3f* source_points,
+                                 const Eigen::Matrix3f* source_covariances,
+                                 const Eigen::Vector3f* target_points,
+                                 const Eigen::Matrix3f* target_covariances,
+                                 const Eigen::Vector2i* corres)
+        : mahalanobis_square_functor(source_points, source_covariances,
+                                     target_points, target_covariances, corres) {};
+    __host__ __device__
+    float operator()(size_t idx) const {
+        return sqrt(mahalanobis_square_functor::operator()(idx));
+    }
+};
+
+}
+
+float TransformationEstimationForGeneralizedICP::ComputeRMSE(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        const CorrespondenceSet &corres) const {
+    if (corres.empty() || !source.HasCovariances() || !target.HasCovariances()) return 0.0;
+    mahalanobis_square_functor func(thrust::raw_pointer_cast(source.points_.data()),
+                                    thrust::raw_pointer_cast(source.covariances_.data()),
+                                    thrust::raw_pointer_cast(target.points_.data()),
+                                    thrust::raw_pointer_cast(target.covariances_.data()),
+                                    thrust::raw_pointer_cast(corres.data()));
+    const float err = thrust::transform_reduce(thrust::make_counting_iterator<size_t>(0),
+                                               thrust::make_counting_iterator(corres.size()),
+                                               func, 0.0f, thrust::plus<float>());
+    return std::sqrt(err / (float)corres.size());
+}
+
+Eigen::Matrix4f TransformationEstimationForGeneralizedICP::ComputeTransformation(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        const CorrespondenceSet &corres) const {
+    if (corres.empty() || !source.HasCovariances() || !target.HasCovariances())
+        return Eigen::Matrix4f::Identity();
+
+    gicp_jacobian_residual_functor func(thrust::raw_pointer_cast(source.points_.data()),
+                                        thrust::raw_pointer_cast(source.covariances_.data()),
+                                        thrust::raw_pointer_cast(target.points_.data()),
+                                        thrust::raw_pointer_cast(target.covariances_.data()),
+                                        thrust::raw_pointer_cast(corres.data()));
+    Eigen::Matrix6f JTJ;
+    Eigen::Vector6f JTr;
+    float r2;
+    if (kernel_.IsUniform()) {
+        thrust::tie(JTJ, JTr, r2) =
+                utility::ComputeJTJandJTr<Eigen::Matrix6f, Eigen::Vector6f, 3, gicp_jacobian_residual_functor>(
+                        func, (int)corres.size());
+    } else {
+        // the scale and the weights both use the Mahalanobis distance, the
+        // norm of the whitened residual of a correspondence
+        RobustKernel kernel = kernel_;
+        if (kernel.scale_ <= 0.0) {
+            thrustcupoch::device_vector<float> residuals(corres.size());
+            thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                              thrust::make_counting_iterator(corres.size()), residuals.begin(),
+                              mahalanobis_distance_functor(thrust::raw_pointer_cast(source.points_.data()),
+                                                           thrust::raw_pointer_cast(source.covariances_.data()),
+                                                           thrust::raw_pointer_cast(target.points_.data()),
+                                                           thrust::raw_pointer_cast(target.covariances_.data()),
+                                                           thrust::raw_pointer_cast(corres.data())));
+            kernel = kernel_.EstimateScale(residuals);
+        }
+        thrust::tie(JTJ, JTr, r2) =
+                utility::ComputeWeightedJTJandJTr<Eigen::Matrix6f, Eigen::Vector6f, 3,
+                                                  gicp_jacobian_residual_functor, RobustKernel>(
+                        func, kernel, (int)corres.size());
+    }
+
+    bool is_success;
+    Eigen::Matrix4f extrinsic;
+    thrust::tie(is_success, extrinsic) =
+            utility::SolveJacobianSystemAndObtainExtrinsicMatrix(JTJ, JTr);
+
+    return is_success ? extrinsic : Eigen::Matrix4f::Identity();
+}
+
+RegistrationResult cupoch::registration::RegistrationGeneralizedICP(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        float max_distance,
+        const Eigen::Matrix4f &init /* = Eigen::Matrix4f::Identity()*/,
+        const ICPConvergenceCriteria &criteria /* = ICPConvergenceCriteria()*/,
+        const geometry::KDTreeSearchParam &search_param /* = geometry::KDTreeSearchParamKNN(20)*/,
+        float epsilon /* = 1.0e-3*/,
+        const RobustKernel &kernel /* = RobustKernel()*/) {
+    std::shared_ptr<geometry::PointCloud> source_c;
+    std::shared_ptr<geometry::PointCloud> target_c;
+    if (!source.HasCovariances()) {
+        source_c = std::make_shared<geometry::PointCloud>(source);
+        source_c->EstimateCovariances(search_param, epsilon);
+    }
+    if (!target.HasCovariances()) {
+        target_c = std::make_shared<geometry::PointCloud>(target);
+        target_c->EstimateCovariances(search_param, epsilon);
+    }
+    return RegistrationICP((source_c) ? *source_c : source,
+                           (target_c) ? *target_c : target,
+                           max_distance, init,
+                           TransformationEstimationForGeneralizedICP(kernel), criteria);
+}
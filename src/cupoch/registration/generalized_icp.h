@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include "cupoch/geometry/kdtree_search_param.h"
+#include "cupoch/registration/registration.h"
+#include "cupoch/registration/transformation_estimation.h"
+
+namespace cupoch {
+
+namespace geometry {
+class PointCloud;
+}
+
+namespace registration {
+class RegistrationResult;
+
+/// Estimate a transformation for the plane to plane distance of generalized
+/// ICP. Both point clouds must have covariances, see
+/// PointCloud::EstimateCovariances. The covariances of the source follow
+/// the transformations applied by RegistrationICP, so they are computed
+/// only once. Each correspondence is weighted by \param kernel of its
+/// Mahalanobis distance.
+class TransformationEstimationForGeneralizedICP : public TransformationEstimation {
+public:
+    TransformationEstimationForGeneralizedICP(const RobustKernel &kernel = RobustKernel())
+        : kernel_(kernel) {}
+    ~TransformationEstimationForGeneralizedICP() override {}
+
+public:
+    TransformationEstimationType GetTransformationEstimationType()
+            const override {
+        return type_;
+    };
+    /// Root mean square of the Mahalanobis distances of the correspondences
+    /// under the combined covariances.
+    float ComputeRMSE(const geometry::PointCloud &source,
+                      const geometry::PointCloud &target,
+                      const CorrespondenceSet &corres) const override;
+    Eigen::Matrix4f ComputeTransformation(
+            const geometry::PointCloud &source,
+            const geometry::PointCloud &target,
+            const CorrespondenceSet &corres) const override;
+
+public:
+    RobustKernel kernel_;
+
+private:
+    const TransformationEstimationType type_ =
+            TransformationEstimationType::GeneralizedICP;
+};
+
+/// Function for generalized ICP registration
+/// This is implementation of following paper
+/// A. Segal, D. Haehnel, S. Thrun,
+/// Generalized-ICP, RSS 2009
+/// The covariances of the point clouds without covariances are computed
+/// with \param search_param and \param epsilon on copies of them.
+/// The residuals are weighted by \param kernel.
+RegistrationResult RegistrationGeneralizedICP(
+        const geometry::PointCloud &source,
+        const geometry::PointCloud &target,
+        float max_distance,
+        const Eigen::Matrix4f &init = Eigen::Matrix4f::Identity(),
+        const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria(),
+        const geometry::KDTreeSearchParam &search_param = geometry::KDTreeSearchParamKNN(20),
+        float epsilon = 1.0e-3,
+        const RobustKernel &kernel = RobustKernel());
+
+}  // namespace registration
+}  // namespace cupoch
@@ -1,6 +1,8 @@
 #include "cupoch/registration/kabsch.h"
 #include "cupoch/utility/svd3_cuda.h"
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/thrust_cupoch.h"
+#include "cupoch/utility/execution_context.h"
 #include <Eigen/Geometry>
 #include <thrust/reduce.h>
 #include <thrust/transform_reduce.h>
@@ -16,7 +18,7 @@ struct extract_correspondence_functor {
         : points_(points), corres_(corres) {};
     const Eigen::Vector3f* points_;
     const Eigen::Vector2i* corres_;
-    __device__
+    __host__ __device__
     Eigen::Vector3f operator() (size_t idx) const {
         return points_[corres_[idx][Index]];
     }
@@ -32,7 +34,7 @@ struct outer_product_functor {
     const Eigen::Vector2i* corres_;
     const Eigen::Vector3f x_offset_;
     const Eigen::Vector3f y_offset_;
-    __device__
+    __host__ __device__
     Eigen::Matrix3f operator() (size_t idx) const {
         const Eigen::Vector3f centralized_x = source_[corres_[idx][0]] - x_offset_;
         const Eigen::Vector3f centralized_y = target_[corres_[idx][1]] - y_offset_;
@@ -41,35 +43,86 @@ struct outer_product_functor {
     }
 };
 
+template<int Index>
+struct weighted_correspondence_functor {
+    weighted_correspondence_functor(const Eigen::Vector3f* points, const Eigen::Vector2i* corres,
+                                    const float* weights)
+        : points_(points), corres_(corres), weights_(weights) {};
+    const Eigen::Vector3f* points_;
+    const Eigen::Vector2i* corres_;
+    const float* weights_;
+    __host__ __device__
+    Eigen::Vector4f operator() (size_t idx) const {
+        const float w = weights_[idx];
+        const Eigen::Vector3f p = w * points_[corres_[idx][Index]];
+        return Eigen::Vector4f(p(0), p(1), p(2), w);
+    }
+};
+
+struct weighted_outer_product_functor : public outer_product_functor {
+    weighted_outer_product_functor(const Eigen::Vector3f* source, const Eigen::Vector3f* target,
+                                   const Eigen::Vector2i* corres, const Eigen::Vector3f& x_offset,
+                                   const Eigen::Vector3f& y_offset, const float* weights)
+        : outer_product_functor(source, target, corres, x_offset, y_offset), weights_(weights) {};
+    const float* weights_;
+    __host__ __device__
+    Eigen::Matrix3f operator() (size_t idx) const {
+        return weights_[idx] * outer_product_functor::operator()(idx);
+    }
+};
+
 struct set_correspondence_functor {
-    __device__
+    __host__ __device__
     Eigen::Vector2i operator() (size_t idx) {
         return Eigen::Vector2i(idx, idx);
     }
 };
 
+// Rotation and translation from the cross-covariance \param hh of the
+// centralized points.
+Eigen::Matrix4f_u ComputeRigidTransformation(const Eigen::Matrix3f& hh,
+                                             const Eigen::Vector3f& model_center,
+                                             const Eigen::Vector3f& target_center) {
+    //Do svd
+    Eigen::Matrix3f uu, ss, vv;
+    svd(hh(0, 0), hh(0, 1), hh(0, 2), hh(1, 0), hh(1, 1), hh(1, 2), hh(2, 0), hh(2, 1), hh(2, 2),
+        uu(0, 0), uu(0, 1), uu(0, 2), uu(1, 0), uu(1, 1), uu(1, 2), uu(2, 0), uu(2, 1), uu(2, 2),
+        ss(0, 0), ss(0, 1), ss(0, 2), ss(1, 0), ss(1, 1), ss(1, 2), ss(2, 0), ss(2, 1), ss(2, 2),
+        vv(0, 0), vv(0, 1), vv(0, 2), vv(1, 0), vv(1, 1), vv(1, 2), vv(2, 0), vv(2, 1), vv(2, 2));
+    ss = Eigen::Matrix3f::Identity();
+    ss(2, 2) = (uu * vv).determinant();
+    Eigen::Matrix4f_u tr = Eigen::Matrix4f_u::Identity();
+    tr.block<3, 3>(0, 0) = vv * ss * uu.transpose();
+
+    //The translation
+    tr.block<3, 1>(0, 3) = target_center;
+    tr.block<3, 1>(0, 3) -= tr.block<3, 3>(0, 0) * model_center;
+
+    return tr;
+}
+
 }
 
-Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrust::device_vector<Eigen::Vector3f>& model,
-                                               const thrust::device_vector<Eigen::Vector3f>& target,
+Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                                               const thrustcupoch::device_vector<Eigen::Vector3f>& target,
                                                const CorrespondenceSet& corres) {
     //Compute the center
     extract_correspondence_functor<0> ex_func0(thrust::raw_pointer_cast(model.data()),
                                                thrust::raw_pointer_cast(corres.data()));
     extract_correspondence_functor<1> ex_func1(thrust::raw_pointer_cast(target.data()),
                                                thrust::raw_pointer_cast(corres.data()));
-    Eigen::Vector3f model_center = thrust::transform_reduce(thrust::cuda::par.on(utility::GetStream(0)),
+    Eigen::Vector3f model_center = thrust::transform_reduce(exec_policy_on(utility::GetStream(0)),
                                                             thrust::make_counting_iterator<size_t>(0),
                                                             thrust::make_counting_iterator(corres.size()),
                                                             ex_func0, Eigen::Vector3f(0.0, 0.0, 0.0),
                                                             thrust::plus<Eigen::Vector3f>());
-    Eigen::Vector3f target_center = thrust::transform_reduce(thrust::cuda::par.on(utility::GetStream(1)),
+    Eigen::Vector3f target_center = thrust::transform_reduce(exec_policy_on(utility::GetStream(1)),
                                                              thrust::make_counting_iterator<size_t>(0),
                                                              thrust::make_counting_iterator(corres.size()),
                                                              ex_func1, Eigen::Vector3f(0.0, 0.0, 0.0),
                                                              thrust::plus<Eigen::Vector3f>());
-    cudaSafeCall(cudaDeviceSynchronize());
-    float divided_by = 1.0f / model.size();
+    utility::GetExecutionContext().Synchronize();
+    float divided_by = 1.0f / corres.size();
     model_center *= divided_by;
     target_center *= divided_by;
 
@@ -84,29 +137,55 @@ Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrust::device_vector<Eigen
                                                   thrust::make_counting_iterator(corres.size()),
                                                   func, init, thrust::plus<Eigen::Matrix3f>());
 
-    //Do svd
-    hh /= model.size();
-    Eigen::Matrix3f uu, ss, vv;
-    svd(hh(0, 0), hh(0, 1), hh(0, 2), hh(1, 0), hh(1, 1), hh(1, 2), hh(2, 0), hh(2, 1), hh(2, 2),
-        uu(0, 0), uu(0, 1), uu(0, 2), uu(1, 0), uu(1, 1), uu(1, 2), uu(2, 0), uu(2, 1), uu(2, 2),
-        ss(0, 0), ss(0, 1), ss(0, 2), ss(1, 0), ss(1, 1), ss(1, 2), ss(2, 0), ss(2, 1), ss(2, 2),
-        vv(0, 0), vv(0, 1), vv(0, 2), vv(1, 0), vv(1, 1), vv(1, 2), vv(2, 0), vv(2, 1), vv(2, 2));
-    ss = Eigen::Matrix3f::Identity();
-    ss(2, 2) = (uu * vv).determinant();
-    Eigen::Matrix4f_u tr = Eigen::Matrix4f_u::Identity();
-    tr.block<3, 3>(0, 0) = vv * ss * uu.transpose();
-
-    //The translation
-    tr.block<3, 1>(0, 3) = target_center;
-    tr.block<3, 1>(0, 3) -= tr.block<3, 3>(0, 0) * model_center;
-
-    return tr;
+    hh /= corres.size();
+    return ComputeRigidTransformation(hh, model_center, target_center);
 }
 
-Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrust::device_vector<Eigen::Vector3f>& model,
-                                               const thrust::device_vector<Eigen::Vector3f>& target) {
+Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                                               const thrustcupoch::device_vector<Eigen::Vector3f>& target) {
     CorrespondenceSet corres(model.size());
     set_correspondence_functor func;
     thrust::transform(thrust::make_counting_iterator<size_t>(0), thrust::make_counting_iterator(model.size()), corres.begin(), func);
     return Kabsch(model, target, corres);
-}
\ No newline at end of file
+}
+
+Eigen::Matrix4f_u cupoch::registration::Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                                               const thrustcupoch::device_vector<Eigen::Vector3f>& target,
+                                               const CorrespondenceSet& corres,
+                                               const thrustcupoch::device_vector<float>& weights) {
+    //Compute the weighted center
+    weighted_correspondence_functor<0> ex_func0(thrust::raw_pointer_cast(model.data()),
+                                                thrust::raw_pointer_cast(corres.data()),
+                                                thrust::raw_pointer_cast(weights.data()));
+    weighted_correspondence_functor<1> ex_func1(thrust::raw_pointer_cast(target.data()),
+                                                thrust::raw_pointer_cast(corres.data()),
+                                                thrust::raw_pointer_cast(weights.data()));
+    const Eigen::Vector4f model_sum = thrust::transform_reduce(exec_policy_on(utility::GetStream(0)),
+                                                               thrust::make_counting_iterator<size_t>(0),
+                                                               thrust::make_counting_iterator(corres.size()),
+                                                               ex_func0, Eigen::Vector4f(Eigen::Vector4f::Zero()),
+                                                               thrust::plus<Eigen::Vector4f>());
+    const Eigen::Vector4f target_sum = thrust::transform_reduce(exec_policy_on(utility::GetStream(1)),
+                                                                thrust::make_counting_iterator<size_t>(0),
+                                                                thrust::make_counting_iterator(corres.size()),
+                                                                ex_func1, Eigen::Vector4f(Eigen::Vector4f::Zero()),
+                                                                thrust::plus<Eigen::Vector4f>());
+    utility::GetExecutionContext().Synchronize();
+    const float total_weight = model_sum(3);
+    if (total_weight <= 0.0) return Eigen::Matrix4f_u::Identity();
+    const Eigen::Vector3f model_center = model_sum.head<3>() / total_weight;
+    const Eigen::Vector3f target_center = target_sum.head<3>() / total_weight;
+
+    //Compute the weighted H matrix
+    weighted_outer_product_functor func(thrust::raw_pointer_cast(model.data()),
+                                        thrust::raw_pointer_cast(target.data()),
+                                        thrust::raw_pointer_cast(corres.data()),
+                                        model_center, target_center,
+                                        thrust::raw_pointer_cast(weights.data()));
+    const Eigen::Matrix3f init = Eigen::Matrix3f::Zero();
+    Eigen::Matrix3f hh = thrust::transform_reduce(thrust::make_counting_iterator<size_t>(0),
+                                                  thrust::make_counting_iterator(corres.size()),
+                                                  func, init, thrust::plus<Eigen::Matrix3f>());
+    hh /= total_weight;
+    return ComputeRigidTransformation(hh, model_center, target_center);
+}
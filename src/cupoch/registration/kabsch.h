@@ -2,17 +2,24 @@
 
 #include "cupoch/utility/eigen.h"
 #include "cupoch/registration/transformation_estimation.h"
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
 
 namespace cupoch {
 namespace registration {
 
-Eigen::Matrix4f_u Kabsch(const thrust::device_vector<Eigen::Vector3f>& model,
-                         const thrust::device_vector<Eigen::Vector3f>& target,
+Eigen::Matrix4f_u Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                         const thrustcupoch::device_vector<Eigen::Vector3f>& target,
                          const CorrespondenceSet& corres);
 
-Eigen::Matrix4f_u Kabsch(const thrust::device_vector<Eigen::Vector3f>& model,
-                         const thrust::device_vector<Eigen::Vector3f>& target);
+Eigen::Matrix4f_u Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                         const thrustcupoch::device_vector<Eigen::Vector3f>& target);
+
+/// Weighted Kabsch minimizing sum_i weights[i] * |T * model - target|^2
+/// over the correspondences, weights[i] belongs to corres[i].
+Eigen::Matrix4f_u Kabsch(const thrustcupoch::device_vector<Eigen::Vector3f>& model,
+                         const thrustcupoch::device_vector<Eigen::Vector3f>& target,
+                         const CorrespondenceSet& corres,
+                         const thrustcupoch::device_vector<float>& weights);
 
 }
 }
\ No newline at end of file
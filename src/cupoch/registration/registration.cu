@@ -4,6 +4,8 @@
 #include "cupoch/utility/helper.h"
 #include "cupoch/utility/console.h"
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/thrust_cupoch.h"
+#include "cupoch/utility/execution_context.h"
 
 using namespace cupoch;
 using namespace cupoch::registration;
@@ -13,7 +15,7 @@ namespace {
 struct extact_knn_distance_functor {
     extact_knn_distance_functor(const float* distances) : distances_(distances) {};
     const float* distances_;
-    __device__
+    __host__ __device__
     float operator() (int idx) const {
         return (std::isinf(distances_[idx])) ? 0.0 : distances_[idx];
     }
@@ -22,7 +24,7 @@ struct extact_knn_distance_functor {
 struct make_correspondence_pair_functor {
     make_correspondence_pair_functor(const int* indices) : indices_(indices) {};
     const int* indices_;
-   __device__
+   __host__ __device__
    Eigen::Vector2i operator() (int i) const {
         return (indices_[i] < 0) ? Eigen::Vector2i(-1, -1) : Eigen::Vector2i(i, indices_[i]);
    }
@@ -40,26 +42,26 @@ RegistrationResult GetRegistrationResultAndCorrespondences(
     }
 
     const int n_pt = source.points_.size();
-    thrust::device_vector<int> indices(n_pt);
-    thrust::device_vector<float> dists(n_pt);
+    thrustcupoch::device_vector<int> indices(n_pt);
+    thrustcupoch::device_vector<float> dists(n_pt);
     target_kdtree.SearchHybrid(source.points_, max_correspondence_distance,
                                1, indices, dists);
     extact_knn_distance_functor func(thrust::raw_pointer_cast(dists.data()));
     result.correspondence_set_.resize(n_pt);
-    const float error2 = thrust::transform_reduce(thrust::cuda::par.on(utility::GetStream(0)),
+    const float error2 = thrust::transform_reduce(exec_policy_on(utility::GetStream(0)),
                                                   thrust::make_counting_iterator(0),
                                                   thrust::make_counting_iterator(n_pt),
                                                   func, 0.0f, thrust::plus<float>());
-    thrust::transform(thrust::cuda::par.on(utility::GetStream(1)),
+    thrust::transform(exec_policy_on(utility::GetStream(1)),
                       thrust::make_counting_iterator(0), thrust::make_counting_iterator(n_pt),
                       result.correspondence_set_.begin(),
                       make_correspondence_pair_functor(thrust::raw_pointer_cast(indices.data())));
-    auto end = thrust::remove_if(thrust::cuda::par.on(utility::GetStream(1)),
+    auto end = thrust::remove_if(exec_policy_on(utility::GetStream(1)),
                                  result.correspondence_set_.begin(), result.correspondence_set_.end(),
-                                 [] __device__ (const Eigen::Vector2i& x) -> bool {return (x[0] < 0);});
+                                 [] __host__ __device__ (const Eigen::Vector2i& x) -> bool {return (x[0] < 0);});
     int n_out = thrust::distance(result.correspondence_set_.begin(), end);
     result.correspondence_set_.resize(n_out);
-    cudaSafeCall(cudaDeviceSynchronize());
+    utility::GetExecutionContext().Synchronize();
 
     if (result.correspondence_set_.empty()) {
         result.fitness_ = 0.0;
@@ -117,8 +119,17 @@ RegistrationResult cupoch::registration::RegistrationICP(
                 "require pre-computed normal vectors.");
     }
 
+    if (estimation.GetTransformationEstimationType() ==
+                TransformationEstimationType::GeneralizedICP &&
+        (!source.HasCovariances() || !target.HasCovariances())) {
+        utility::LogError(
+                "TransformationEstimationForGeneralizedICP "
+                "requires pre-computed covariances.");
+    }
+
     Eigen::Matrix4f transformation = init;
-    geometry::KDTreeFlann kdtree(target);
+    const auto kdtree_ptr = target.GetKDTree();
+    const geometry::KDTreeFlann &kdtree = *kdtree_ptr;
     geometry::PointCloud pcd = source;
     if (init.isIdentity() == false) {
         pcd.Transform(init);
@@ -0,0 +1,40 @@
+#include "cupoch/registration/robust_kernel.h"
+#include <thrust/sort.h>
+
+using namespace cupoch;
+using namespace cupoch::registration;
+
+namespace {
+
+struct abs_functor {
+    __host__ __device__
+    float operator() (float x) const {
+        return fabsf(x);
+    }
+};
+
+// Scale of each loss relative to the standard deviation of Gaussian
+// residuals, the usual 95% efficiency constants.
+float TuningConstant(RobustKernelType type) {
+    switch (type) {
+        case RobustKernelType::Huber:
+            return 1.345;
+        case RobustKernelType::Tukey:
+            return 4.685;
+        case RobustKernelType::Cauchy:
+            return 2.3849;
+        default:
+            return 1.0;
+    }
+}
+
+}
+
+RobustKernel RobustKernel::EstimateScale(const thrustcupoch::device_vector<float> &residuals) const {
+    if (IsUniform() || scale_ > 0.0 || residuals.empty()) return *this;
+    thrustcupoch::device_vector<float> abs_residuals(residuals.size());
+    thrust::transform(residuals.begin(), residuals.end(), abs_residuals.begin(), abs_functor());
+    thrust::sort(abs_residuals.begin(), abs_residuals.end());
+    const float median = abs_residuals[abs_residuals.size() / 2];
+    return RobustKernel(type_, TuningConstant(type_) * 1.4826 * median);
+}
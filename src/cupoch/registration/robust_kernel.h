@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace registration {
+
+enum class RobustKernelType {
+    L2 = 0,
+    Huber = 1,
+    Tukey = 2,
+    Cauchy = 3,
+    GemanMcClure = 4,
+};
+
+/// \class RobustKernel
+///
+/// \brief Robust loss applied as the weight of each residual in iteratively
+/// reweighted least squares.
+///
+/// The kernel is a plain value passed to the device functors, the loss is
+/// selected by type_. With a positive scale_ the residuals are weighted
+/// against it, otherwise the scale is estimated from the residuals of each
+/// iteration by EstimateScale.
+class RobustKernel {
+public:
+    RobustKernel(RobustKernelType type = RobustKernelType::L2,
+                 float scale = 0.0)
+        : type_(type), scale_(scale) {};
+
+    __host__ __device__
+    float Weight(float residual) const {
+        if (type_ == RobustKernelType::L2 || scale_ <= 0.0) return 1.0;
+        const float e = fabsf(residual) / scale_;
+        switch (type_) {
+            case RobustKernelType::Huber:
+                return (e <= 1.0) ? 1.0 : 1.0 / e;
+            case RobustKernelType::Tukey: {
+                if (e > 1.0) return 0.0;
+                const float t = 1.0 - e * e;
+                return t * t;
+            }
+            case RobustKernelType::Cauchy:
+                return 1.0 / (1.0 + e * e);
+            case RobustKernelType::GemanMcClure: {
+                const float t = 1.0 + e * e;
+                return 1.0 / (t * t);
+            }
+            default:
+                return 1.0;
+        }
+    }
+
+    /// Returns true if the residuals are weighted uniformly.
+    bool IsUniform() const { return type_ == RobustKernelType::L2; }
+
+    /// Returns a copy of the kernel scaled to \param residuals if scale_ is
+    /// not positive: the tuning constant of the loss times the median
+    /// absolute residual normalized to the standard deviation (1.4826 MAD).
+    RobustKernel EstimateScale(const thrustcupoch::device_vector<float> &residuals) const;
+
+public:
+    RobustKernelType type_;
+    float scale_;
+};
+
+}  // namespace registration
+}  // namespace cupoch
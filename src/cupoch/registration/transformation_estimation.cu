@@ -17,12 +17,32 @@ struct diff_square_pt2pt_functor {
     const Eigen::Vector3f* source_;
     const Eigen::Vector3f* target_;
     const Eigen::Vector2i* corres_;
-    __device__
+    __host__ __device__
     float operator()(size_t idx) const {
         return (source_[corres_[idx][0]] - target_[corres_[idx][1]]).squaredNorm();
     }
 };
 
+struct distance_pt2pt_functor : public diff_square_pt2pt_functor {
+    distance_pt2pt_functor(const Eigen::Vector3f* source,
+                           const Eigen::Vector3f* target,
+                           const Eigen::Vector2i* corres)
+        : diff_square_pt2pt_functor(source, target, corres) {};
+    __host__ __device__
+    float operator()(size_t idx) const {
+        return sqrt(diff_square_pt2pt_functor::operator()(idx));
+    }
+};
+
+struct robust_weight_functor {
+    robust_weight_functor(const RobustKernel& kernel) : kernel_(kernel) {};
+    const RobustKernel kernel_;
+    __host__ __device__
+    float operator()(float r) const {
+        return kernel_.Weight(r);
+    }
+};
+
 struct diff_square_pt2pl_functor {
     diff_square_pt2pl_functor(const Eigen::Vector3f* source,
                               const Eigen::Vector3f* target_points,
@@ -33,13 +53,29 @@ struct diff_square_pt2pl_functor {
     const Eigen::Vector3f* target_points_;
     const Eigen::Vector3f* target_normals_;
     const Eigen::Vector2i* corres_;
-    __device__
+    __host__ __device__
     float operator()(size_t idx) const {
         float r = (source_[corres_[idx][0]] - target_points_[corres_[idx][1]]).dot(target_normals_[corres_[idx][1]]);
         return r * r;
     }
 };
 
+struct residual_pt2pl_functor {
+    residual_pt2pl_functor(const Eigen::Vector3f* source,
+                           const Eigen::Vector3f* target_points,
+                           const Eigen::Vector3f* target_normals,
+                           const Eigen::Vector2i* corres)
+        : source_(source), target_points_(target_points), target_normals_(target_normals), corres_(corres) {};
+    const Eigen::Vector3f* source_;
+    const Eigen::Vector3f* target_points_;
+    const Eigen::Vector3f* target_normals_;
+    const Eigen::Vector2i* corres_;
+    __host__ __device__
+    float operator()(size_t idx) const {
+        return (source_[corres_[idx][0]] - target_points_[corres_[idx][1]]).dot(target_normals_[corres_[idx][1]]);
+    }
+};
+
 struct pt2pl_jacobian_residual_functor : public utility::jacobian_residual_functor<Eigen::Vector6f> {
     pt2pl_jacobian_residual_functor(const Eigen::Vector3f* source,
                                     const Eigen::Vector3f* target_points,
@@ -50,7 +86,7 @@ struct pt2pl_jacobian_residual_functor : public utility::jacobian_residual_funct
     const Eigen::Vector3f* target_points_;
     const Eigen::Vector3f* target_normals_;
     const Eigen::Vector2i* corres_;
-    __device__
+    __host__ __device__
     void operator() (int idx, Eigen::Vector6f& vec, float& r) const {
         const Eigen::Vector3f &vs = source_[corres_[idx][0]];
         const Eigen::Vector3f &vt = target_points_[corres_[idx][1]];
@@ -80,7 +116,19 @@ Eigen::Matrix4f TransformationEstimationPointToPoint::ComputeTransformation(
     const geometry::PointCloud &source,
     const geometry::PointCloud &target,
     const CorrespondenceSet &corres) const {
-    return Kabsch(source.points_, target.points_, corres);
+    if (kernel_.IsUniform()) return Kabsch(source.points_, target.points_, corres);
+    if (corres.empty()) return Eigen::Matrix4f::Identity();
+
+    thrustcupoch::device_vector<float> weights(corres.size());
+    thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                      thrust::make_counting_iterator(corres.size()), weights.begin(),
+                      distance_pt2pt_functor(thrust::raw_pointer_cast(source.points_.data()),
+                                             thrust::raw_pointer_cast(target.points_.data()),
+                                             thrust::raw_pointer_cast(corres.data())));
+    const RobustKernel kernel = kernel_.EstimateScale(weights);
+    thrust::transform(weights.begin(), weights.end(), weights.begin(),
+                      robust_weight_functor(kernel));
+    return Kabsch(source.points_, target.points_, corres, weights);
 }
 
 float TransformationEstimationPointToPlane::ComputeRMSE(
@@ -111,9 +159,27 @@ Eigen::Matrix4f TransformationEstimationPointToPlane::ComputeTransformation(
                                          thrust::raw_pointer_cast(target.points_.data()),
                                          thrust::raw_pointer_cast(target.normals_.data()),
                                          thrust::raw_pointer_cast(corres.data()));
-    thrust::tie(JTJ, JTr, r2) =
-            utility::ComputeJTJandJTr<Eigen::Matrix6f, Eigen::Vector6f, pt2pl_jacobian_residual_functor>(
-                func, (int)corres.size());
+    if (kernel_.IsUniform()) {
+        thrust::tie(JTJ, JTr, r2) =
+                utility::ComputeJTJandJTr<Eigen::Matrix6f, Eigen::Vector6f, pt2pl_jacobian_residual_functor>(
+                    func, (int)corres.size());
+    } else {
+        RobustKernel kernel = kernel_;
+        if (kernel.scale_ <= 0.0) {
+            thrustcupoch::device_vector<float> residuals(corres.size());
+            thrust::transform(thrust::make_counting_iterator<size_t>(0),
+                              thrust::make_counting_iterator(corres.size()), residuals.begin(),
+                              residual_pt2pl_functor(thrust::raw_pointer_cast(source.points_.data()),
+                                                     thrust::raw_pointer_cast(target.points_.data()),
+                                                     thrust::raw_pointer_cast(target.normals_.data()),
+                                                     thrust::raw_pointer_cast(corres.data())));
+            kernel = kernel_.EstimateScale(residuals);
+        }
+        thrust::tie(JTJ, JTr, r2) =
+                utility::ComputeWeightedJTJandJTr<Eigen::Matrix6f, Eigen::Vector6f,
+                                                  pt2pl_jacobian_residual_functor, RobustKernel>(
+                    func, kernel, (int)corres.size());
+    }
 
     bool is_success;
     Eigen::Matrix4f extrinsic;
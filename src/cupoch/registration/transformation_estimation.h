@@ -2,7 +2,8 @@
 
 #include <Eigen/Core>
 #include <memory>
-#include <thrust/device_vector.h>
+#include "cupoch/registration/robust_kernel.h"
+#include "cupoch/utility/thrust_cupoch.h"
 
 namespace cupoch {
 
@@ -12,13 +13,14 @@ class PointCloud;
 
 namespace registration {
 
-typedef thrust::device_vector<Eigen::Vector2i> CorrespondenceSet;
+typedef thrustcupoch::device_vector<Eigen::Vector2i> CorrespondenceSet;
 
 enum class TransformationEstimationType {
     Unspecified = 0,
     PointToPoint = 1,
     PointToPlane = 2,
     ColoredICP = 3,
+    GeneralizedICP = 4,
 };
 
 /// Base class that estimates a transformation between two point clouds
@@ -42,9 +44,12 @@ public:
 };
 
 /// Estimate a transformation for point to point distance
+/// The correspondences are weighted by \param kernel of their distance
+/// with the weighted Kabsch algorithm.
 class TransformationEstimationPointToPoint : public TransformationEstimation {
 public:
-    TransformationEstimationPointToPoint() {}
+    TransformationEstimationPointToPoint(const RobustKernel &kernel = RobustKernel())
+        : kernel_(kernel) {}
     ~TransformationEstimationPointToPoint() override {}
 
 public:
@@ -60,15 +65,21 @@ public:
             const geometry::PointCloud &target,
             const CorrespondenceSet &corres) const override;
 
+public:
+    RobustKernel kernel_;
+
 private:
     const TransformationEstimationType type_ =
             TransformationEstimationType::PointToPoint;
 };
 
 /// Estimate a transformation for point to plane distance
+/// The rows of the Jacobian are weighted by \param kernel of their
+/// residual.
 class TransformationEstimationPointToPlane : public TransformationEstimation {
 public:
-    TransformationEstimationPointToPlane() {}
+    TransformationEstimationPointToPlane(const RobustKernel &kernel = RobustKernel())
+        : kernel_(kernel) {}
     ~TransformationEstimationPointToPlane() override {}
 
 public:
@@ -84,6 +95,9 @@ public:
             const geometry::PointCloud &target,
             const CorrespondenceSet &corres) const override;
 
+public:
+    RobustKernel kernel_;
+
 private:
     const TransformationEstimationType type_ =
             TransformationEstimationType::PointToPlane;
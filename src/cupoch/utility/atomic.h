@@ -0,0 +1,91 @@
+#pragma once
+
+namespace cupoch {
+namespace utility {
+
+// Atomic operations usable in the functors of every thrust device system.
+// Device code uses the CUDA intrinsics, host code (OMP/TBB device systems)
+// the GCC atomic builtins. All of them return the old value.
+
+__host__ __device__
+inline unsigned long long AtomicCAS(unsigned long long* address,
+                                   unsigned long long compare,
+                                   unsigned long long val) {
+#ifdef __CUDA_ARCH__
+    return atomicCAS(address, compare, val);
+#else
+    __atomic_compare_exchange_n(address, &compare, val, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return compare;
+#endif
+}
+
+__host__ __device__
+inline int AtomicCAS(int* address, int compare, int val) {
+#ifdef __CUDA_ARCH__
+    return atomicCAS(address, compare, val);
+#else
+    __atomic_compare_exchange_n(address, &compare, val, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return compare;
+#endif
+}
+
+__host__ __device__
+inline int AtomicAdd(int* address, int val) {
+#ifdef __CUDA_ARCH__
+    return atomicAdd(address, val);
+#else
+    return __atomic_fetch_add(address, val, __ATOMIC_SEQ_CST);
+#endif
+}
+
+__host__ __device__
+inline float AtomicAdd(float* address, float val) {
+#ifdef __CUDA_ARCH__
+    return atomicAdd(address, val);
+#else
+    float expected;
+    __atomic_load(address, &expected, __ATOMIC_RELAXED);
+    float desired = expected + val;
+    while (!__atomic_compare_exchange(address, &expected, &desired, true,
+                                      __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        desired = expected + val;
+    }
+    return expected;
+#endif
+}
+
+__host__ __device__
+inline unsigned int AtomicMin(unsigned int* address, unsigned int val) {
+#ifdef __CUDA_ARCH__
+    return atomicMin(address, val);
+#else
+    unsigned int expected;
+    __atomic_load(address, &expected, __ATOMIC_RELAXED);
+    while (val < expected &&
+           !__atomic_compare_exchange_n(address, &expected, val, true,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+    return expected;
+#endif
+}
+
+__host__ __device__
+inline unsigned long long AtomicMin(unsigned long long* address,
+                                    unsigned long long val) {
+#ifdef __CUDA_ARCH__
+    return atomicMin(address, val);
+#else
+    unsigned long long expected;
+    __atomic_load(address, &expected, __ATOMIC_RELAXED);
+    while (val < expected &&
+           !__atomic_compare_exchange_n(address, &expected, val, true,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+    return expected;
+#endif
+}
+
+}  // namespace utility
+}  // namespace cupoch
@@ -24,7 +24,7 @@ DLDataTypeCode GetDLDataTypeCode() {
 
 template<typename T, int Dim>
 struct DeviceVectorDLMTensor {
-    thrust::device_vector<Eigen::Matrix<T, Dim, 1>> handle;
+    thrustcupoch::device_vector<Eigen::Matrix<T, Dim, 1>> handle;
     DLManagedTensor tensor;
 };
 
@@ -37,7 +37,7 @@ void deleter(DLManagedTensor* arg) {
 }
 
 template<typename T, int Dim>
-DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Matrix<T, Dim, 1>>& src) {
+DLManagedTensor* cupoch::utility::ToDLPack(const thrustcupoch::device_vector<Eigen::Matrix<T, Dim, 1>>& src) {
     DeviceVectorDLMTensor<T, Dim>* dvdl(new DeviceVectorDLMTensor<T, Dim>);
     dvdl->handle = src;
     dvdl->tensor.manager_ctx = dvdl;
@@ -46,7 +46,11 @@ DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Ma
     int64_t device_id = GetDevice();
     DLContext ctx;
     ctx.device_id = device_id;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     ctx.device_type = DLDeviceType::kDLGPU;
+#else
+    ctx.device_type = DLDeviceType::kDLCPU;
+#endif
     dvdl->tensor.dl_tensor.ctx = ctx;
     dvdl->tensor.dl_tensor.ndim = 2;
     DLDataType dtype;
@@ -63,26 +67,26 @@ DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Ma
     return &(dvdl->tensor);
 }
 
-template DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Matrix<float, 3, 1>>& src);
-template DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Matrix<int, 2, 1>>& src);
-template DLManagedTensor* cupoch::utility::ToDLPack(const thrust::device_vector<Eigen::Matrix<int, 3, 1>>& src);
+template DLManagedTensor* cupoch::utility::ToDLPack(const thrustcupoch::device_vector<Eigen::Matrix<float, 3, 1>>& src);
+template DLManagedTensor* cupoch::utility::ToDLPack(const thrustcupoch::device_vector<Eigen::Matrix<int, 2, 1>>& src);
+template DLManagedTensor* cupoch::utility::ToDLPack(const thrustcupoch::device_vector<Eigen::Matrix<int, 3, 1>>& src);
 
 template<>
-void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrust::device_vector<Eigen::Matrix<float, 3, 1>>& dst) {
+void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrustcupoch::device_vector<Eigen::Matrix<float, 3, 1>>& dst) {
     dst.resize(src->dl_tensor.shape[0]);
     auto base_ptr = thrust::device_pointer_cast((Eigen::Matrix<float, 3, 1>*)src->dl_tensor.data);
     thrust::copy(base_ptr, base_ptr + src->dl_tensor.shape[0], dst.begin());
 }
 
 template<>
-void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrust::device_vector<Eigen::Matrix<int, 2, 1>>& dst) {
+void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrustcupoch::device_vector<Eigen::Matrix<int, 2, 1>>& dst) {
     dst.resize(src->dl_tensor.shape[0]);
     auto base_ptr = thrust::device_pointer_cast((Eigen::Matrix<int, 2, 1>*)src->dl_tensor.data);
     thrust::copy(base_ptr, base_ptr + src->dl_tensor.shape[0], dst.begin());
 }
 
 template<>
-void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrust::device_vector<Eigen::Matrix<int, 3, 1>>& dst) {
+void cupoch::utility::FromDLPack(const DLManagedTensor* src, thrustcupoch::device_vector<Eigen::Matrix<int, 3, 1>>& dst) {
     dst.resize(src->dl_tensor.shape[0]);
     auto base_ptr = thrust::device_pointer_cast((Eigen::Matrix<int, 3, 1>*)src->dl_tensor.data);
     thrust::copy(base_ptr, base_ptr + src->dl_tensor.shape[0], dst.begin());
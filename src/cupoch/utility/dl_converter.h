@@ -1,17 +1,17 @@
 #pragma once
 
 #include <Eigen/Core>
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
 #include <dlpack/dlpack.h>
 
 namespace cupoch {
 namespace utility {
 
 template<typename T, int Dim>
-DLManagedTensor* ToDLPack(const thrust::device_vector<Eigen::Matrix<T, Dim, 1>>& src);
+DLManagedTensor* ToDLPack(const thrustcupoch::device_vector<Eigen::Matrix<T, Dim, 1>>& src);
 
 template<typename T, int Dim>
-void FromDLPack(const DLManagedTensor* src, thrust::device_vector<Eigen::Matrix<T, Dim, 1>>& dst);
+void FromDLPack(const DLManagedTensor* src, thrustcupoch::device_vector<Eigen::Matrix<T, Dim, 1>>& dst);
 
 }
 }
\ No newline at end of file
@@ -18,13 +18,13 @@ namespace utility {
 
 template <typename VecType>
 struct jacobian_residual_functor {
-    __device__
+    __host__ __device__
     virtual void operator() (int i, VecType& vec, float& r) const = 0;
 };
 
 template <typename VecType, int NumJ>
 struct multiple_jacobians_residuals_functor {
-    __device__
+    __host__ __device__
     virtual void operator() (int i, VecType J_r[NumJ], float r[NumJ]) const = 0;
 };
 
@@ -69,6 +69,27 @@ thrust::tuple<MatType, VecType, float> ComputeJTJandJTr(
         int iteration_num,
         bool verbose = true);
 
+/// Same as ComputeJTJandJTr, with the row of each residual r weighted by
+/// kernel.Weight(r) for iteratively reweighted least squares.
+/// Output: weighted JTJ, weighted JTr, weighted sum of r^2
+template <typename MatType, typename VecType, typename FuncType, typename KernelType>
+thrust::tuple<MatType, VecType, float> ComputeWeightedJTJandJTr(
+        const FuncType& f,
+        const KernelType& kernel,
+        int iteration_num,
+        bool verbose = true);
+
+/// Same as ComputeJTJandJTr with NumJ rows per element. The residuals of an
+/// element are the components of one vector residual, so all its rows are
+/// weighted by kernel.Weight(|r|) of the norm of that vector, which does not
+/// depend on the basis the components are expressed in.
+template <typename MatType, typename VecType, int NumJ, typename FuncType, typename KernelType>
+thrust::tuple<MatType, VecType, float> ComputeWeightedJTJandJTr(
+        const FuncType& f,
+        const KernelType& kernel,
+        int iteration_num,
+        bool verbose = true);
+
 Eigen::Matrix3f RotationMatrixX(float radians);
 Eigen::Matrix3f RotationMatrixY(float radians);
 Eigen::Matrix3f RotationMatrixZ(float radians);
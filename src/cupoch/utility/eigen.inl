@@ -13,7 +13,7 @@ template<typename MatType, typename VecType, typename FuncType>
 struct jtj_jtr_reduce_functor {
     jtj_jtr_reduce_functor(const FuncType& f) : f_(f) {};
     const FuncType f_;
-    __device__
+    __host__ __device__
     thrust::tuple<MatType, VecType, float> operator() (int idx) const {
         VecType J_r;
         float r;
@@ -28,7 +28,7 @@ template<typename MatType, typename VecType, int NumJ, typename FuncType>
 struct multiple_jtj_jtr_reduce_functor {
     multiple_jtj_jtr_reduce_functor(const FuncType& f) : f_(f) {};
     const FuncType f_;
-    __device__
+    __host__ __device__
     thrust::tuple<MatType, VecType, float> operator() (int idx) const {
         MatType JTJ_private;
         VecType JTr_private;
@@ -47,6 +47,52 @@ struct multiple_jtj_jtr_reduce_functor {
     }
 };
 
+template<typename MatType, typename VecType, typename FuncType, typename KernelType>
+struct weighted_jtj_jtr_reduce_functor {
+    weighted_jtj_jtr_reduce_functor(const FuncType& f, const KernelType& kernel)
+        : f_(f), kernel_(kernel) {};
+    const FuncType f_;
+    const KernelType kernel_;
+    __host__ __device__
+    thrust::tuple<MatType, VecType, float> operator() (int idx) const {
+        VecType J_r;
+        float r;
+        f_(idx, J_r, r);
+        const float w = kernel_.Weight(r);
+        MatType jtj = w * J_r * J_r.transpose();
+        VecType jr = w * J_r * r;
+        return thrust::make_tuple(jtj, jr, w * r * r);
+    }
+};
+
+template<typename MatType, typename VecType, int NumJ, typename FuncType, typename KernelType>
+struct multiple_weighted_jtj_jtr_reduce_functor {
+    multiple_weighted_jtj_jtr_reduce_functor(const FuncType& f, const KernelType& kernel)
+        : f_(f), kernel_(kernel) {};
+    const FuncType f_;
+    const KernelType kernel_;
+    __host__ __device__
+    thrust::tuple<MatType, VecType, float> operator() (int idx) const {
+        MatType JTJ_private;
+        VecType JTr_private;
+        float r2_sum_private = 0.0;
+        JTJ_private.setZero();
+        JTr_private.setZero();
+        VecType J_r[NumJ];
+        float r[NumJ];
+        f_(idx, J_r, r);
+        float r2 = 0.0;
+        for (size_t j = 0; j < NumJ; ++j) r2 += r[j] * r[j];
+        const float w = kernel_.Weight(sqrt(r2));
+        for (size_t j = 0; j < NumJ; ++j) {
+            JTJ_private.noalias() += w * J_r[j] * J_r[j].transpose();
+            JTr_private.noalias() += w * J_r[j] * r[j];
+            r2_sum_private += w * r[j] * r[j];
+        }
+        return thrust::make_tuple(JTJ_private, JTr_private, r2_sum_private);
+    }
+};
+
 }
 
 template <typename MatType, typename VecType, typename FuncType>
@@ -95,5 +141,53 @@ thrust::tuple<MatType, VecType, float> ComputeJTJandJTr(
     return jtj_jtr_r2;
 }
 
+template <typename MatType, typename VecType, typename FuncType, typename KernelType>
+thrust::tuple<MatType, VecType, float> ComputeWeightedJTJandJTr(
+        const FuncType& f,
+        const KernelType& kernel,
+        int iteration_num,
+        bool verbose) {
+    MatType JTJ;
+    VecType JTr;
+    float r2_sum = 0.0;
+    JTJ.setZero();
+    JTr.setZero();
+    weighted_jtj_jtr_reduce_functor<MatType, VecType, FuncType, KernelType> func(f, kernel);
+    auto jtj_jtr_r2 = thrust::transform_reduce(thrust::make_counting_iterator(0),
+                                               thrust::make_counting_iterator(iteration_num),
+                                               func, thrust::make_tuple(JTJ, JTr, r2_sum),
+                                               thrust::plus<thrust::tuple<MatType, VecType, float>>());
+    r2_sum = thrust::get<2>(jtj_jtr_r2);
+    if (verbose) {
+        LogDebug("Weighted residual : {:.2e} (# of elements : {:d})",
+                 r2_sum / (float)iteration_num, iteration_num);
+    }
+    return jtj_jtr_r2;
+}
+
+template <typename MatType, typename VecType, int NumJ, typename FuncType, typename KernelType>
+thrust::tuple<MatType, VecType, float> ComputeWeightedJTJandJTr(
+        const FuncType& f,
+        const KernelType& kernel,
+        int iteration_num,
+        bool verbose /*=true*/) {
+    MatType JTJ;
+    VecType JTr;
+    float r2_sum = 0.0;
+    JTJ.setZero();
+    JTr.setZero();
+    multiple_weighted_jtj_jtr_reduce_functor<MatType, VecType, NumJ, FuncType, KernelType> func(f, kernel);
+    auto jtj_jtr_r2 = thrust::transform_reduce(thrust::make_counting_iterator(0),
+                                               thrust::make_counting_iterator(iteration_num),
+                                               func, thrust::make_tuple(JTJ, JTr, r2_sum),
+                                               thrust::plus<thrust::tuple<MatType, VecType, float>>());
+    r2_sum = thrust::get<2>(jtj_jtr_r2);
+    if (verbose) {
+        LogDebug("Weighted residual : {:.2e} (# of elements : {:d})",
+                 r2_sum / (float)iteration_num, iteration_num);
+    }
+    return jtj_jtr_r2;
+}
+
 }  // namespace utility
 }  // namespace cupoch
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "cupoch/utility/execution_context.h"
+
+using namespace cupoch;
+using namespace cupoch::utility;
+
+namespace {
+
+thread_local ExecutionContext *current_context = nullptr;
+
+}
+
+ExecutionContext::ExecutionContext() : owns_main_stream_(true) {
+    for (size_t i = 0; i < MAX_NUM_STREAMS; ++i) streams_[i] = 0;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaSafeCall(cudaStreamCreateWithFlags(&streams_[0], cudaStreamNonBlocking));
+    cudaSafeCall(cudaEventCreateWithFlags(&fork_event_, cudaEventDisableTiming));
+#endif
+}
+
+ExecutionContext::ExecutionContext(cudaStream_t stream) : owns_main_stream_(false) {
+    for (size_t i = 0; i < MAX_NUM_STREAMS; ++i) streams_[i] = 0;
+    streams_[0] = stream;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaSafeCall(cudaEventCreateWithFlags(&fork_event_, cudaEventDisableTiming));
+#endif
+}
+
+ExecutionContext::~ExecutionContext() {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    // Errors are ignored here since the default contexts may be destroyed
+    // after the CUDA runtime has been shut down.
+    for (size_t i = 1; i < MAX_NUM_STREAMS; ++i) {
+        if (streams_[i]) {
+            cudaStreamSynchronize(streams_[i]);
+            cudaStreamDestroy(streams_[i]);
+        }
+    }
+    if (owns_main_stream_) {
+        cudaStreamSynchronize(streams_[0]);
+        cudaStreamDestroy(streams_[0]);
+    }
+    cudaEventDestroy(fork_event_);
+#endif
+}
+
+cudaStream_t ExecutionContext::GetStream(size_t i) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    if (i > 0 && !streams_[i]) {
+        cudaSafeCall(cudaStreamCreateWithFlags(&streams_[i], cudaStreamNonBlocking));
+    }
+    // Fork: the returned stream must see the results of the work already
+    // issued without an explicit policy (per-thread default stream) and,
+    // for the side streams, to the main stream.
+    if (streams_[i] != cudaStreamPerThread) {
+        WaitFor(streams_[i], cudaStreamPerThread);
+    }
+    if (i > 0 && streams_[0] != cudaStreamPerThread) {
+        WaitFor(streams_[i], streams_[0]);
+    }
+    return streams_[i];
+#else
+    return 0;
+#endif
+}
+
+void ExecutionContext::Synchronize() {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaSafeCall(cudaStreamSynchronize(cudaStreamPerThread));
+    for (size_t i = 0; i < MAX_NUM_STREAMS; ++i) {
+        if (streams_[i] && streams_[i] != cudaStreamPerThread) {
+            cudaSafeCall(cudaStreamSynchronize(streams_[i]));
+        }
+    }
+#endif
+}
+
+void ExecutionContext::WaitFor(cudaStream_t waiting, cudaStream_t producer) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaSafeCall(cudaEventRecord(fork_event_, producer));
+    cudaSafeCall(cudaStreamWaitEvent(waiting, fork_event_, 0));
+#endif
+}
+
+pool_allocator<char> &ExecutionContext::GetAllocator() const {
+    return GetTemporaryAllocator();
+}
+
+void *ExecutionContext::GetWorkspace(size_t bytes) {
+    if (workspace_.size() < bytes) {
+        workspace_.clear();
+        workspace_.shrink_to_fit();
+        workspace_.resize(bytes);
+    }
+    return thrust::raw_pointer_cast(workspace_.data());
+}
+
+ExecutionContext &cupoch::utility::GetExecutionContext() {
+    if (current_context) return *current_context;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    thread_local ExecutionContext default_context(cudaStreamPerThread);
+#else
+    thread_local ExecutionContext default_context(0);
+#endif
+    return default_context;
+}
+
+ScopedExecutionContext::ScopedExecutionContext(ExecutionContext &context)
+    : previous_(current_context) {
+    current_context = &context;
+}
+
+ScopedExecutionContext::~ScopedExecutionContext() {
+    current_context = previous_;
+}
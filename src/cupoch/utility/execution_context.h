@@ -0,0 +1,67 @@
+#pragma once
+
+#include "cupoch/utility/platform.h"
+#include "cupoch/utility/thrust_cupoch.h"
+
+namespace cupoch {
+namespace utility {
+
+/// \class ExecutionContext
+///
+/// \brief Stream, allocator and scratch workspace used by the operations
+/// issued from one pipeline.
+///
+/// Every thread has its own default context on the per-thread default stream,
+/// so pipelines running on different threads do not block each other.
+/// A context can be made current for a scope with ScopedExecutionContext.
+class ExecutionContext {
+public:
+    /// Creates a context that owns a new non-blocking stream.
+    ExecutionContext();
+    /// Creates a context that issues work to an externally owned stream.
+    explicit ExecutionContext(cudaStream_t stream);
+    ~ExecutionContext();
+    ExecutionContext(const ExecutionContext &) = delete;
+    ExecutionContext &operator=(const ExecutionContext &) = delete;
+
+public:
+    /// Returns the i-th stream of the context. The 0-th stream is the main
+    /// stream, the others are created on first use. The returned stream
+    /// waits for the work already issued on the calling thread.
+    cudaStream_t GetStream(size_t i = 0);
+    /// Blocks until all work issued to the streams of this context and to the
+    /// per-thread default stream has completed. Unlike DeviceSynchronize,
+    /// work of other contexts is not waited for.
+    void Synchronize();
+    pool_allocator<char> &GetAllocator() const;
+    /// Returns a scratch buffer of at least \param bytes bytes, which is
+    /// reused by the subsequent calls on this context.
+    void *GetWorkspace(size_t bytes);
+
+private:
+    void WaitFor(cudaStream_t waiting, cudaStream_t producer);
+
+    cudaStream_t streams_[MAX_NUM_STREAMS];
+    bool owns_main_stream_;
+    cudaEvent_t fork_event_;
+    thrustcupoch::device_vector<char> workspace_;
+};
+
+/// Returns the context that is current on the calling thread.
+ExecutionContext &GetExecutionContext();
+
+/// Makes \param context current on the calling thread until the guard is
+/// destroyed.
+class ScopedExecutionContext {
+public:
+    explicit ScopedExecutionContext(ExecutionContext &context);
+    ~ScopedExecutionContext();
+    ScopedExecutionContext(const ScopedExecutionContext &) = delete;
+    ScopedExecutionContext &operator=(const ScopedExecutionContext &) = delete;
+
+private:
+    ExecutionContext *previous_;
+};
+
+}  // namespace utility
+}  // namespace cupoch
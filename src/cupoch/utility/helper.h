@@ -5,7 +5,8 @@
 #include <thrust/functional.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/host_vector.h>
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
+#include <thrust/copy.h>
 #include "cupoch/utility/platform.h"
 
 namespace thrust {
@@ -185,8 +186,9 @@ std::string& StripString(std::string& str,
                          const std::string& chars = "\t\n\v\f\r ");
 
 template<typename T>
-void CopyToDeviceMultiStream(const thrust::host_vector<T>& src, thrust::device_vector<T>& dst,
+void CopyToDeviceMultiStream(const thrust::host_vector<T>& src, thrustcupoch::device_vector<T>& dst,
                              int n_stream = MAX_NUM_STREAMS) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     const int step = src.size() / n_stream;
     int step_size = step * sizeof(T);
     for (int i = 0; i < n_stream; ++i) {
@@ -195,11 +197,15 @@ void CopyToDeviceMultiStream(const thrust::host_vector<T>& src, thrust::device_v
         cudaMemcpyAsync(thrust::raw_pointer_cast(&dst[offset]), thrust::raw_pointer_cast(&src[offset]),
                         step_size, cudaMemcpyHostToDevice, GetStream(i));
     }
+#else
+    thrust::copy(src.begin(), src.end(), dst.begin());
+#endif
 }
 
 template<typename T>
-void CopyFromDeviceMultiStream(const thrust::device_vector<T>& src, thrust::host_vector<T>& dst,
+void CopyFromDeviceMultiStream(const thrustcupoch::device_vector<T>& src, thrust::host_vector<T>& dst,
                                int n_stream = MAX_NUM_STREAMS) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     const int step = src.size() / n_stream;
     int step_size = step * sizeof(T);
     for (int i = 0; i < n_stream; ++i) {
@@ -208,6 +214,9 @@ void CopyFromDeviceMultiStream(const thrust::device_vector<T>& src, thrust::host
         cudaMemcpyAsync(thrust::raw_pointer_cast(&dst[offset]), thrust::raw_pointer_cast(&src[offset]),
                         step_size, cudaMemcpyDeviceToHost, GetStream(i));
     }
+#else
+    thrust::copy(src.begin(), src.end(), dst.begin());
+#endif
 }
 
 }
@@ -1,30 +1,47 @@
 #include "cupoch/utility/platform.h"
+#include "cupoch/utility/execution_context.h"
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
 #if defined(__arm__) || defined(__aarch64__)
 #include <GL/gl.h>
 #endif
 #include <cuda_gl_interop.h>
-#include <mutex>
+#endif
 
 using namespace cupoch;
 using namespace cupoch::utility;
 
 cudaStream_t cupoch::utility::GetStream(size_t i) {
-    static std::once_flag streamInitFlags[MAX_NUM_STREAMS];
-    static cudaStream_t streams[MAX_NUM_STREAMS];
-    std::call_once(streamInitFlags[i], [i]() {
-        cudaStreamCreate(&(streams[i]));
-    });
-    return streams[i];
+    return GetExecutionContext().GetStream(i);
+}
+
+void cupoch::utility::DeviceSynchronize() {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaSafeCall(cudaDeviceSynchronize());
+#endif
+}
+
+bool cupoch::utility::IsCudaDeviceSystem() {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    return true;
+#else
+    return false;
+#endif
 }
 
 int cupoch::utility::GetDevice() {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     int device_no;
     cudaGetDevice(&device_no);
     return device_no;
+#else
+    return 0;
+#endif
 }
 
 void cupoch::utility::SetDevice(int device_no) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
     cudaSetDevice(device_no);
+#endif
 }
 
 void cupoch::utility::Error(const char *error_string, const char *file, const int line,
@@ -32,4 +49,4 @@ void cupoch::utility::Error(const char *error_string, const char *file, const in
     std::cout << "Error: " << error_string << "\t" << file << ":" << line
               << std::endl;
     exit(0);
-}
\ No newline at end of file
+}
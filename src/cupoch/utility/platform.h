@@ -1,5 +1,6 @@
 #pragma once
 #include <cuda_runtime.h>
+#include <thrust/detail/config.h>
 #include <iostream>
 
 #if defined(__GNUC__)
@@ -8,13 +9,31 @@
     #define cudaSafeCall(expr)  ___cudaSafeCall(expr, __FILE__, __LINE__)
 #endif
 
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+#define CUPOCH_USE_CUDA_DEVICE_SYSTEM
+#endif
+
 namespace cupoch {
 namespace utility {
 
 static const size_t MAX_NUM_STREAMS = 16;
 
+/// Returns the i-th stream of the execution context that is current on the
+/// calling thread (see ExecutionContext::GetStream).
+/// On the host (OpenMP/TBB) device systems there are no streams and the
+/// default stream handle is returned.
 cudaStream_t GetStream(size_t i);
 
+/// Blocks until all work issued to the device system has completed.
+/// Prefer GetExecutionContext().Synchronize(), which does not wait for the
+/// work of other threads.
+/// This is a no-op on the host device systems, whose algorithms are
+/// synchronous.
+void DeviceSynchronize();
+
+/// Returns true if the library was built for the CUDA device system.
+bool IsCudaDeviceSystem();
+
 int GetDevice();
 
 void SetDevice(int device_no);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace cupoch {
+namespace utility {
+
+// Counter-based random numbers: the i-th number of a stream is a pure
+// function of (i, key), so the functors of every device system draw
+// independent numbers without per-thread generator state.
+
+/// Derives a stream key from a user seed. The key of the squares generator
+/// must be odd with well mixed bits.
+__host__ __device__
+inline uint64_t MakeRandomKey(uint64_t seed) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (z ^ (z >> 31)) | 1ull;
+}
+
+/// Widynski's "squares" counter-based generator, 32 random bits of the
+/// \param counter -th number of the stream \param key.
+__host__ __device__
+inline uint32_t RandomUint32(uint64_t counter, uint64_t key) {
+    uint64_t x = counter * key;
+    const uint64_t y = x;
+    const uint64_t z = y + key;
+    x = x * x + y;
+    x = (x >> 32) | (x << 32);
+    x = x * x + z;
+    x = (x >> 32) | (x << 32);
+    x = x * x + y;
+    x = (x >> 32) | (x << 32);
+    return uint32_t((x * x + z) >> 32);
+}
+
+/// Uniform float in [0, 1).
+__host__ __device__
+inline float RandomUniform(uint64_t counter, uint64_t key) {
+    return (RandomUint32(counter, key) >> 8) * (1.0f / 16777216.0f);
+}
+
+}  // namespace utility
+}  // namespace cupoch
@@ -0,0 +1,409 @@
+#include "cupoch/utility/thrust_cupoch.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/platform.h"
+#ifdef USE_RMM
+#include <rmm/rmm.h>
+#endif
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+using namespace cupoch;
+using namespace cupoch::utility;
+
+namespace {
+
+// Requests are rounded up to this granularity so that buffers of slightly
+// different sizes (e.g. frames with a varying number of points) share blocks.
+const size_t kBlockAlignment = 512;
+
+size_t RoundUpBlockSize(size_t bytes) {
+    return (bytes + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+/// Caching allocator with best-fit reuse of freed blocks.
+/// Blocks allocated on demand are never split, a cached block is reused
+/// only for requests of at least half its size to bound the internal
+/// fragmentation. The chunk reserved by the initial pool size is split to
+/// serve requests of any size and its freed blocks are merged again.
+/// On CUDA, a freed block records an event on the per-thread default stream,
+/// which the streams of the execution contexts fork from, and the next user
+/// of the block waits for it, so a block is not reused before the work
+/// issued on it has completed.
+class MemoryPool {
+public:
+    static MemoryPool &GetInstance() {
+        // Intentionally leaked so that buffers in static objects can still
+        // be released during program termination.
+        static MemoryPool *instance = new MemoryPool();
+        return *instance;
+    }
+
+    void Initialize(size_t initial_pool_size, size_t max_pool_size, bool logging) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_pool_size_ = max_pool_size;
+        logging_ = logging;
+        if (initial_pool_size > 0) Reserve(RoundUpBlockSize(initial_pool_size));
+        ReleaseExceedingBlocks();
+    }
+
+    void *Allocate(size_t bytes) {
+        if (bytes == 0) return nullptr;
+        bytes = RoundUpBlockSize(bytes);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = free_blocks_.lower_bound(bytes);
+        if (it != free_blocks_.end() && it->first <= 2 * bytes) {
+            char *ptr = it->second;
+            Block block = TakeFreeBlock(ptr);
+            WaitForBlock(block, true);
+            return UseBlock(ptr, block);
+        }
+        it = reserved_free_blocks_.lower_bound(bytes);
+        if (it != reserved_free_blocks_.end()) {
+            char *ptr = it->second;
+            Block block = TakeFreeBlock(ptr);
+            if (block.size_ > bytes) {
+                // the rest keeps the events, its next user waits for them too
+                WaitForBlock(block, false);
+                Block rest = block;
+                rest.size_ = block.size_ - bytes;
+                InsertFreeBlock(ptr + bytes, rest);
+                block.size_ = bytes;
+            } else {
+                WaitForBlock(block, true);
+            }
+            return UseBlock(ptr, block);
+        }
+        char *ptr = SystemAllocate(bytes);
+        if (!ptr) {
+            // Retry once after giving back everything cached.
+            ReleaseAllCachedBlocks();
+            ptr = SystemAllocate(bytes);
+            if (!ptr) throw std::bad_alloc();
+        }
+        chunks_[ptr] = Chunk{bytes, false};
+        allocated_blocks_[ptr] = std::make_pair(ptr, bytes);
+        stats_.in_use_bytes_ += bytes;
+        UpdatePeak();
+        if (logging_) {
+            LogDebug("[MemoryPool] allocated {:d} bytes from the system.\n", (int)bytes);
+        }
+        return ptr;
+    }
+
+    void Free(void *ptr) {
+        if (!ptr) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = allocated_blocks_.find(ptr);
+        if (it == allocated_blocks_.end()) {
+            LogWarning("[MemoryPool] free of an unknown pointer.\n");
+            return;
+        }
+        Block block;
+        block.chunk_ = it->second.first;
+        block.size_ = it->second.second;
+        allocated_blocks_.erase(it);
+        stats_.in_use_bytes_ -= block.size_;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        cudaEvent_t event = AcquireEvent();
+        cudaEventRecord(event, cudaStreamPerThread);
+        block.events_.push_back(event);
+#endif
+        InsertFreeBlock(static_cast<char *>(ptr), block);
+        ReleaseExceedingBlocks();
+    }
+
+    void Trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReleaseAllCachedBlocks();
+    }
+
+    AllocatorStatistics GetStatistics() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    MemoryPool() {}
+
+    /// System allocation carved into blocks.
+    struct Chunk {
+        size_t size_;
+        bool reserved_;
+    };
+
+    /// Free range of a chunk.
+    struct Block {
+        char *chunk_ = nullptr;
+        size_t size_ = 0;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        /// Recorded when the parts of the block were freed.
+        std::vector<cudaEvent_t> events_;
+#endif
+    };
+
+    void *UseBlock(char *ptr, const Block &block) {
+        allocated_blocks_[ptr] = std::make_pair(block.chunk_, block.size_);
+        stats_.in_use_bytes_ += block.size_;
+        ++stats_.num_pool_hits_;
+        return ptr;
+    }
+
+    char *SystemAllocate(size_t bytes) {
+        void *ptr = nullptr;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        if (cudaMalloc(&ptr, bytes) != cudaSuccess) {
+            cudaGetLastError();
+            return nullptr;
+        }
+#else
+        ptr = std::malloc(bytes);
+#endif
+        if (ptr) ++stats_.num_system_allocations_;
+        return static_cast<char *>(ptr);
+    }
+
+    void SystemFree(void *ptr) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        cudaFree(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    /// Caches \param bytes as one chunk that is split on demand.
+    void Reserve(size_t bytes) {
+        char *ptr = SystemAllocate(bytes);
+        if (!ptr) {
+            LogWarning("[MemoryPool] failed to reserve {:d} bytes.\n", (int)bytes);
+            return;
+        }
+        chunks_[ptr] = Chunk{bytes, true};
+        Block block;
+        block.chunk_ = ptr;
+        block.size_ = bytes;
+        InsertFreeBlock(ptr, block);
+        UpdatePeak();
+    }
+
+    /// Inserts a free block, merged with the free blocks around it in the
+    /// same chunk.
+    void InsertFreeBlock(char *ptr, Block block) {
+        auto next = free_blocks_by_address_.find(ptr + block.size_);
+        if (next != free_blocks_by_address_.end() && next->second.chunk_ == block.chunk_) {
+            Block merged = TakeFreeBlock(next->first);
+            block.size_ += merged.size_;
+            AppendEvents(block, merged);
+        }
+        auto prev = free_blocks_by_address_.lower_bound(ptr);
+        if (prev != free_blocks_by_address_.begin()) {
+            --prev;
+            if (prev->second.chunk_ == block.chunk_ &&
+                prev->first + prev->second.size_ == ptr) {
+                char *prev_ptr = prev->first;
+                Block merged = TakeFreeBlock(prev_ptr);
+                merged.size_ += block.size_;
+                AppendEvents(merged, block);
+                block = merged;
+                ptr = prev_ptr;
+            }
+        }
+        SizeOrderedBlocks(block).insert(std::make_pair(block.size_, ptr));
+        stats_.cached_bytes_ += block.size_;
+        free_blocks_by_address_[ptr] = block;
+    }
+
+    std::multimap<size_t, char *> &SizeOrderedBlocks(const Block &block) {
+        return chunks_[block.chunk_].reserved_ ? reserved_free_blocks_ : free_blocks_;
+    }
+
+    /// Removes a free block from the cache and returns it.
+    Block TakeFreeBlock(char *ptr) {
+        auto it = free_blocks_by_address_.find(ptr);
+        Block block = it->second;
+        free_blocks_by_address_.erase(it);
+        auto &blocks = SizeOrderedBlocks(block);
+        auto range = blocks.equal_range(block.size_);
+        for (auto jt = range.first; jt != range.second; ++jt) {
+            if (jt->second == ptr) {
+                blocks.erase(jt);
+                break;
+            }
+        }
+        stats_.cached_bytes_ -= block.size_;
+        return block;
+    }
+
+    void AppendEvents(Block &block, const Block &other) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        block.events_.insert(block.events_.end(), other.events_.begin(), other.events_.end());
+#endif
+    }
+
+    /// Makes the per-thread default stream wait for the work issued on the
+    /// block before it was freed. \param recycle returns the events to the
+    /// pool when no other block holds them.
+    void WaitForBlock(Block &block, bool recycle) {
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        for (auto event : block.events_) {
+            if (cudaEventQuery(event) != cudaSuccess) {
+                cudaGetLastError();
+                cudaStreamWaitEvent(cudaStreamPerThread, event, 0);
+            }
+            if (recycle) free_events_.push_back(event);
+        }
+        if (recycle) block.events_.clear();
+#endif
+    }
+
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    cudaEvent_t AcquireEvent() {
+        if (free_events_.empty()) {
+            cudaEvent_t event;
+            cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+            return event;
+        }
+        cudaEvent_t event = free_events_.back();
+        free_events_.pop_back();
+        return event;
+    }
+#endif
+
+    /// Returns the free block at \param ptr to the system if it covers its
+    /// whole chunk.
+    bool ReleaseChunk(char *ptr) {
+        const Block &block = free_blocks_by_address_[ptr];
+        if (block.chunk_ != ptr || chunks_[ptr].size_ != block.size_) return false;
+        Block released = TakeFreeBlock(ptr);
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+        // cudaFree waits for the work on the block
+        for (auto event : released.events_) free_events_.push_back(event);
+#endif
+        chunks_.erase(ptr);
+        SystemFree(ptr);
+        return true;
+    }
+
+    void ReleaseAllCachedBlocks() {
+        for (auto it = free_blocks_by_address_.begin(); it != free_blocks_by_address_.end();) {
+            char *ptr = (it++)->first;
+            ReleaseChunk(ptr);
+        }
+    }
+
+    /// Releases the largest cached chunks until the cache fits in
+    /// max_pool_size_. Chunks with blocks in use are kept.
+    void ReleaseExceedingBlocks() {
+        if (max_pool_size_ == 0 || stats_.cached_bytes_ <= max_pool_size_) return;
+        std::multimap<size_t, char *> candidates(free_blocks_);
+        candidates.insert(reserved_free_blocks_.begin(), reserved_free_blocks_.end());
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            if (stats_.cached_bytes_ <= max_pool_size_) break;
+            ReleaseChunk(it->second);
+        }
+    }
+
+    void UpdatePeak() {
+        stats_.peak_bytes_ = std::max(stats_.peak_bytes_,
+                                      stats_.in_use_bytes_ + stats_.cached_bytes_);
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<char *, Chunk> chunks_;
+    std::map<char *, Block> free_blocks_by_address_;
+    /// Free blocks of the chunks allocated on demand and of the reserved
+    /// chunks, by size.
+    std::multimap<size_t, char *> free_blocks_;
+    std::multimap<size_t, char *> reserved_free_blocks_;
+    std::unordered_map<void *, std::pair<char *, size_t>> allocated_blocks_;
+#ifdef CUPOCH_USE_CUDA_DEVICE_SYSTEM
+    std::vector<cudaEvent_t> free_events_;
+#endif
+    size_t max_pool_size_ = 0;
+    bool logging_ = false;
+    AllocatorStatistics stats_;
+};
+
+}
+
+void cupoch::utility::InitializeAllocator(size_t initial_pool_size,
+                                          size_t max_pool_size,
+                                          bool logging) {
+#ifdef USE_RMM
+    rmmOptions_t options;
+    options.allocation_mode = PoolAllocation;
+    options.enable_logging = logging;
+    if (rmmIsInitialized(nullptr)) {
+        size_t free_size = 0, total_size = 0;
+        rmmGetInfo(&free_size, &total_size, 0);
+        if (total_size > free_size) {
+            LogError("[InitializeAllocator] {:d} bytes of the rmm pool are in use, the pool is not re-initialized.\n",
+                     (int)(total_size - free_size));
+            return;
+        }
+        rmmFinalize();
+    }
+    // The rmm pool is never shrunk, so max_pool_size bounds the reservation,
+    // which rmm would otherwise set to half of the device memory for 0.
+    if (max_pool_size > 0 &&
+        (initial_pool_size == 0 || initial_pool_size > max_pool_size)) {
+        initial_pool_size = max_pool_size;
+    }
+    options.initial_pool_size = initial_pool_size;
+    rmmError_t err = rmmInitialize(&options);
+    if (err != RMM_SUCCESS) {
+        LogError("[InitializeAllocator] {}\n", rmmGetErrorString(err));
+    }
+#else
+    MemoryPool::GetInstance().Initialize(initial_pool_size, max_pool_size, logging);
+#endif
+}
+
+void cupoch::utility::TrimAllocator() {
+#ifdef USE_RMM
+    LogWarning("[TrimAllocator] rmm pool can not be trimmed.\n");
+#else
+    MemoryPool::GetInstance().Trim();
+#endif
+}
+
+AllocatorStatistics cupoch::utility::GetAllocatorStatistics() {
+#ifdef USE_RMM
+    AllocatorStatistics stats;
+    size_t free_size = 0, total_size = 0;
+    rmmGetInfo(&free_size, &total_size, 0);
+    stats.in_use_bytes_ = total_size - free_size;
+    stats.cached_bytes_ = free_size;
+    stats.peak_bytes_ = total_size;
+    return stats;
+#else
+    return MemoryPool::GetInstance().GetStatistics();
+#endif
+}
+
+void *cupoch::utility::PoolAllocate(size_t bytes) {
+#ifdef USE_RMM
+    void *ptr = nullptr;
+    if (RMM_ALLOC(&ptr, bytes, 0) != RMM_SUCCESS) throw std::bad_alloc();
+    return ptr;
+#else
+    return MemoryPool::GetInstance().Allocate(bytes);
+#endif
+}
+
+void cupoch::utility::PoolFree(void *ptr, size_t bytes) {
+#ifdef USE_RMM
+    RMM_FREE(ptr, 0);
+#else
+    MemoryPool::GetInstance().Free(ptr);
+#endif
+}
+
+pool_allocator<char> &cupoch::utility::GetTemporaryAllocator() {
+    static pool_allocator<char> allocator;
+    return allocator;
+}
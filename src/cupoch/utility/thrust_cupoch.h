@@ -1,23 +1,128 @@
 #pragma once
 
+#include <thrust/detail/config.h>
+#include <thrust/device_malloc_allocator.h>
+#include <thrust/device_vector.h>
+#include <cstddef>
+
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
 #ifdef USE_RMM
 #include <rmm/thrust_rmm_allocator.h>
-#else
-#include <thrust/device_vector.h>
+#endif
+#elif THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_OMP
+#include <thrust/system/omp/execution_policy.h>
+#elif THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+#include <thrust/system/tbb/execution_policy.h>
 #endif
 
 namespace cupoch {
+namespace utility {
+
+/// Statistics of the memory pool shared by all geometry buffers.
+struct AllocatorStatistics {
+    /// Bytes handed out to live buffers.
+    size_t in_use_bytes_ = 0;
+    /// Bytes held by the pool for reuse.
+    size_t cached_bytes_ = 0;
+    /// Highest value of in_use_bytes_ + cached_bytes_ seen so far.
+    size_t peak_bytes_ = 0;
+    /// Number of requests that reached cudaMalloc / malloc.
+    size_t num_system_allocations_ = 0;
+    /// Number of requests served from cached blocks.
+    size_t num_pool_hits_ = 0;
+};
+
+/// Configures the memory pool behind thrustcupoch::device_vector and the
+/// thrust temporary buffers. \param initial_pool_size is the number of bytes
+/// reserved up front as one chunk that is split to serve buffers of any
+/// size (0 lets the pool grow on demand), \param max_pool_size
+/// bounds the bytes kept cached after buffers are freed (0 means unbounded).
+/// With rmm, the pool can not shrink, so \param max_pool_size bounds the
+/// initial reservation instead, and re-initializing is refused while
+/// buffers of the pool are alive.
+void InitializeAllocator(size_t initial_pool_size = 0,
+                         size_t max_pool_size = 0,
+                         bool logging = false);
+
+/// Returns all cached chunks without buffers in use to the system allocator.
+void TrimAllocator();
+
+/// Returns the current statistics of the memory pool.
+AllocatorStatistics GetAllocatorStatistics();
+
+void *PoolAllocate(size_t bytes);
+void PoolFree(void *ptr, size_t bytes);
+
+/// Thrust allocator that serves device (or host backend) memory from the
+/// library-wide pool.
+template <typename T>
+class pool_allocator : public thrust::device_malloc_allocator<T> {
+public:
+    typedef thrust::device_malloc_allocator<T> super_t;
+    typedef typename super_t::pointer pointer;
+    typedef typename super_t::size_type size_type;
+
+    template <typename U>
+    struct rebind {
+        typedef pool_allocator<U> other;
+    };
+
+    __host__ __device__ pool_allocator() {}
+    __host__ __device__ pool_allocator(const pool_allocator &) {}
+    template <typename U>
+    __host__ __device__ pool_allocator(const pool_allocator<U> &) {}
+    __host__ __device__ ~pool_allocator() {}
+
+    pointer allocate(size_type n) {
+        return pointer(static_cast<T *>(PoolAllocate(n * sizeof(T))));
+    }
+
+    void deallocate(pointer ptr, size_type n) {
+        PoolFree(thrust::raw_pointer_cast(ptr), n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) {
+    return false;
+}
+
+/// Allocator for the temporary storage of thrust algorithms
+/// (sort, reduce_by_key, ...).
+pool_allocator<char> &GetTemporaryAllocator();
+
+}  // namespace utility
+
 namespace thrustcupoch {
 
+#if THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
 #ifdef USE_RMM
 template<typename T>
 using device_vector = rmm::device_vector<T>;
 #define exec_policy_on(stream) (rmm::exec_policy(stream)->on(stream))
 #else
 template<typename T>
-using device_vector = thrust::device_vector<T>;
-#define exec_policy_on(stream) (thrust::cuda::par.on(stream))
+using device_vector = thrust::device_vector<T, utility::pool_allocator<T>>;
+#define exec_policy_on(stream) (thrust::cuda::par(cupoch::utility::GetTemporaryAllocator()).on(stream))
+#endif
+#elif THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_OMP
+// Host backends have no streams; every algorithm runs synchronously
+// on the calling thread's OpenMP/TBB worker pool.
+template<typename T>
+using device_vector = thrust::device_vector<T, utility::pool_allocator<T>>;
+#define exec_policy_on(stream) (thrust::omp::par(cupoch::utility::GetTemporaryAllocator()))
+#elif THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_TBB
+template<typename T>
+using device_vector = thrust::device_vector<T, utility::pool_allocator<T>>;
+#define exec_policy_on(stream) (thrust::tbb::par(cupoch::utility::GetTemporaryAllocator()))
+#else
+#error "Unsupported THRUST_DEVICE_SYSTEM. Use CUDA, OMP or TBB."
 #endif
 
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cupoch/utility/atomic.h"
+
+namespace cupoch {
+namespace utility {
+
+// Lock-free union-find over an array of parent indices, usable in the
+// functors of every thrust device system. Unions only ever link a root below
+// a root of lower index, so concurrent readers just follow longer paths.
+
+/// Root of the tree of \param idx.
+__host__ __device__
+inline int FindRoot(const int* parents, int idx) {
+    int parent = parents[idx];
+    while (parent != idx) {
+        idx = parent;
+        parent = parents[idx];
+    }
+    return idx;
+}
+
+/// Merges the trees of \param a and \param b. Returns false if they were
+/// already the same tree.
+__host__ __device__
+inline bool UnionRoots(int* parents, int a, int b) {
+    while (true) {
+        a = FindRoot(parents, a);
+        b = FindRoot(parents, b);
+        if (a == b) return false;
+        if (a < b) {
+            const int tmp = a;
+            a = b;
+            b = tmp;
+        }
+        if (AtomicCAS(parents + a, a, b) == a) return true;
+    }
+}
+
+}  // namespace utility
+}  // namespace cupoch
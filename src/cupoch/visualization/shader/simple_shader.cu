@@ -302,7 +302,7 @@ bool SimpleShaderForAxisAlignedBoundingBox::PrepareBinding(
     }
     auto lineset = geometry::LineSet::CreateFromAxisAlignedBoundingBox(
             (const geometry::AxisAlignedBoundingBox &)geometry);
-    thrust::device_vector<thrust::pair<Eigen::Vector3f, Eigen::Vector3f>> line_coords(lineset->lines_.size());
+    thrustcupoch::device_vector<thrust::pair<Eigen::Vector3f, Eigen::Vector3f>> line_coords(lineset->lines_.size());
     line_coordinates_functor func_line(thrust::raw_pointer_cast(lineset->points_.data()));
     thrust::transform(lineset->lines_.begin(), lineset->lines_.end(),
                       line_coords.begin(), func_line);
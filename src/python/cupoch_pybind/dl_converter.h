@@ -1,16 +1,16 @@
 #pragma once
 #include <dlpack/dlpack.h>
 #include <Eigen/Core>
-#include <thrust/device_vector.h>
+#include "cupoch/utility/thrust_cupoch.h"
 #include <pybind11/pybind11.h>
 namespace py = pybind11;
 
 namespace cupoch {
 namespace dlpack {
 
-py::capsule ToDLpackCapsule(thrust::device_vector<Eigen::Vector3f>& src);
+py::capsule ToDLpackCapsule(thrustcupoch::device_vector<Eigen::Vector3f>& src);
 
-void FromDLpackCapsule(py::capsule dlpack, thrust::device_vector<Eigen::Vector3f>& dst);
+void FromDLpackCapsule(py::capsule dlpack, thrustcupoch::device_vector<Eigen::Vector3f>& dst);
 
 }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "cupoch/camera/pinhole_camera_intrinsic.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/rgbdimage.h"
+#include "cupoch/geometry/segment_statistics.h"
 #include "cupoch_pybind/geometry/geometry_trampoline.h"
 #include "cupoch_pybind/dl_converter.h"
 #include "cupoch_pybind/docstring.h"
@@ -9,6 +10,50 @@
 using namespace cupoch;
 
 void pybind_pointcloud(py::module &m) {
+    py::class_<geometry::SegmentStatistics,
+               std::shared_ptr<geometry::SegmentStatistics>>
+            segment_statistics(m, "SegmentStatistics",
+                               "Summary of the segments of a labeled point "
+                               "cloud, one entry per label. The members of "
+                               "the i-th segment are "
+                               "indices[offsets[i]:offsets[i + 1]].");
+    py::detail::bind_default_constructor<geometry::SegmentStatistics>(segment_statistics);
+    segment_statistics
+            .def("get_num_segments", &geometry::SegmentStatistics::GetNumSegments,
+                 "Returns the number of segments.")
+            .def_property_readonly("counts", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<int>(s.counts_);
+            }, "Number of points of each segment.")
+            .def_property_readonly("centroids", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Vector3f>(s.centroids_);
+            }, "Centroid of each segment.")
+            .def_property_readonly("min_bounds", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Vector3f>(s.min_bounds_);
+            }, "Min bound of the axis aligned box of each segment.")
+            .def_property_readonly("max_bounds", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Vector3f>(s.max_bounds_);
+            }, "Max bound of the axis aligned box of each segment.")
+            .def_property_readonly("obb_centers", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Vector3f>(s.obb_centers_);
+            }, "Center of the oriented box of each segment.")
+            .def_property_readonly("obb_rotations", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Matrix3f>(s.obb_rotations_);
+            }, "Rotation of the oriented box of each segment, the principal "
+               "axes in decreasing order of variance.")
+            .def_property_readonly("obb_extents", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<Eigen::Vector3f>(s.obb_extents_);
+            }, "Extent of the oriented box of each segment.")
+            .def_property_readonly("offsets", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<int>(s.offsets_);
+            }, "Offsets of the segments in indices.")
+            .def_property_readonly("indices", [](const geometry::SegmentStatistics &s) {
+                return thrust::host_vector<int>(s.indices_);
+            }, "Point indices of the segments in ascending order.")
+            .def("__repr__", [](const geometry::SegmentStatistics &s) {
+                return std::string("geometry::SegmentStatistics with ") +
+                       std::to_string(s.GetNumSegments()) + " segments.";
+            });
+
     py::class_<geometry::PointCloud, PyGeometry3D<geometry::PointCloud>,
                std::shared_ptr<geometry::PointCloud>, geometry::Geometry3D>
             pointcloud(m, "PointCloud",
@@ -34,7 +79,10 @@ void pybind_pointcloud(py::module &m) {
             .def("to_points_dlpack", [](geometry::PointCloud &pcd) {return dlpack::ToDLpackCapsule(pcd.points_);})
             .def("to_normals_dlpack", [](geometry::PointCloud &pcd) {return dlpack::ToDLpackCapsule(pcd.normals_);})
             .def("to_colors_dlpack", [](geometry::PointCloud &pcd) {return dlpack::ToDLpackCapsule(pcd.colors_);})
-            .def("from_points_dlpack", [](geometry::PointCloud &pcd, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, pcd.points_);})
+            .def("from_points_dlpack", [](geometry::PointCloud &pcd, py::capsule dlpack) {
+                dlpack::FromDLpackCapsule(dlpack, pcd.points_);
+                pcd.InvalidateKDTree();
+            })
             .def("from_normals_dlpack", [](geometry::PointCloud &pcd, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, pcd.normals_);})
             .def("from_colors_dlpack", [](geometry::PointCloud &pcd, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, pcd.colors_);})
             .def("has_points", &geometry::PointCloud::HasPoints,
@@ -97,16 +145,57 @@ void pybind_pointcloud(py::module &m) {
                  "are oriented with respect to the input point cloud if "
                  "normals exist",
                  "search_param"_a = geometry::KDTreeSearchParamKNN())
+            .def("estimate_covariances",
+                 &geometry::PointCloud::EstimateCovariances,
+                 "Function to compute the covariance of each point for "
+                 "generalized ICP",
+                 "search_param"_a = geometry::KDTreeSearchParamKNN(20),
+                 "epsilon"_a = 1.0e-3)
             .def("orient_normals_to_align_with_direction",
                  &geometry::PointCloud::OrientNormalsToAlignWithDirection,
                  "Function to orient the normals of a point cloud",
                  "orientation_reference"_a = Eigen::Vector3f(0.0, 0.0, 1.0))
+            .def("orient_normals_towards_camera_location",
+                 &geometry::PointCloud::OrientNormalsTowardsCameraLocation,
+                 "Function to orient the normals of a point cloud",
+                 "camera_location"_a = Eigen::Vector3f(0.0, 0.0, 0.0))
+            .def("orient_normals_consistent_tangent_plane",
+                 &geometry::PointCloud::OrientNormalsConsistentTangentPlane,
+                 "Function to orient the normals with respect to consistent "
+                 "tangent planes",
+                 "k"_a)
             .def("cluster_dbscan", &geometry::PointCloud::ClusterDBSCANHost,
                  "Cluster PointCloud using the DBSCAN algorithm  Ester et al., "
                  "'A Density-Based Algorithm for Discovering Clusters in Large "
                  "Spatial Databases with Noise', 1996. Returns a list of point "
                  "labels, -1 indicates noise according to the algorithm.",
                  "eps"_a, "min_points"_a, "print_progress"_a = false)
+            .def("cluster_euclidean", &geometry::PointCloud::ClusterEuclideanHost,
+                 "Cluster PointCloud into the connected components of the "
+                 "points closer than tolerance to each other. Returns a list "
+                 "of point labels, -1 indicates a cluster of less than "
+                 "min_size or more than max_size points.",
+                 "tolerance"_a, "min_size"_a = 1,
+                 "max_size"_a = std::numeric_limits<int>::max())
+            .def("compute_segment_statistics",
+                 &geometry::PointCloud::ComputeSegmentStatisticsHost,
+                 "Summarizes the segments given by one label per point, e.g. "
+                 "the labels of cluster_dbscan or cluster_euclidean. Points "
+                 "labeled -1 are ignored.",
+                 "labels"_a)
+            .def("segment_plane", &geometry::PointCloud::SegmentPlaneHost,
+                 "Segments a plane in the point cloud using the RANSAC "
+                 "algorithm. Returns the plane model ax + by + cz + d = 0 and "
+                 "the indices of the plane inliers.",
+                 "distance_threshold"_a = 0.01, "ransac_n"_a = 3,
+                 "num_iterations"_a = 100, "seed"_a = 0)
+            .def("segment_planes", &geometry::PointCloud::SegmentPlanesHost,
+                 "Extracts planes one after the other with the RANSAC "
+                 "algorithm. Returns the plane models and a list of point "
+                 "labels, -1 indicates a point on none of the planes.",
+                 "distance_threshold"_a = 0.01, "ransac_n"_a = 3,
+                 "num_iterations"_a = 100, "max_planes"_a = 10,
+                 "min_inliers"_a = 100, "seed"_a = 0)
             .def_static(
                     "create_from_depth_image",
                     &geometry::PointCloud::CreateFromDepthImage,
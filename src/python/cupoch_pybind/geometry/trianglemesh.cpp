@@ -129,7 +129,10 @@ void pybind_trianglemesh(py::module &m) {
             .def("to_vertices_dlpack", [](geometry::TriangleMesh &mesh) {return dlpack::ToDLpackCapsule(mesh.vertices_);})
             .def("to_vertex_normals_dlpack", [](geometry::TriangleMesh &mesh) {return dlpack::ToDLpackCapsule(mesh.vertex_normals_);})
             .def("to_vertex_colors_dlpack", [](geometry::TriangleMesh &mesh) {return dlpack::ToDLpackCapsule(mesh.vertex_colors_);})
-            .def("from_vertices_dlpack", [](geometry::TriangleMesh &mesh, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, mesh.vertices_);})
+            .def("from_vertices_dlpack", [](geometry::TriangleMesh &mesh, py::capsule dlpack) {
+                dlpack::FromDLpackCapsule(dlpack, mesh.vertices_);
+                mesh.InvalidateKDTree();
+            })
             .def("from_vertex_normals_dlpack", [](geometry::TriangleMesh &mesh, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, mesh.vertex_normals_);})
             .def("from_vertex_colors_dlpack", [](geometry::TriangleMesh &mesh, py::capsule dlpack) {dlpack::FromDLpackCapsule(dlpack, mesh.vertex_colors_);});
     docstring::ClassMethodDocInject(m, "TriangleMesh",
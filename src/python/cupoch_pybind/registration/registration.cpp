@@ -2,6 +2,8 @@
 #include "cupoch/registration/registration.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/registration/colored_icp.h"
+#include "cupoch/registration/generalized_icp.h"
+#include "cupoch/registration/robust_kernel.h"
 #include "cupoch/utility/console.h"
 #include "cupoch_pybind/docstring.h"
 
@@ -73,6 +75,46 @@ void pybind_registration_classes(py::module &m) {
                         c.max_iteration_);
             });
 
+    // cupoch.registration.RobustKernelType
+    py::enum_<registration::RobustKernelType> robust_kernel_type(
+            m, "RobustKernelType", py::arithmetic(), "RobustKernelType");
+    robust_kernel_type.attr("__doc__") = docstring::static_property(
+            py::cpp_function([](py::handle arg) -> std::string {
+                return "Enum class for the loss of ``RobustKernel``.";
+            }),
+            py::none(), py::none(), "");
+    robust_kernel_type
+            .value("L2", registration::RobustKernelType::L2)
+            .value("Huber", registration::RobustKernelType::Huber)
+            .value("Tukey", registration::RobustKernelType::Tukey)
+            .value("Cauchy", registration::RobustKernelType::Cauchy)
+            .value("GemanMcClure", registration::RobustKernelType::GemanMcClure)
+            .export_values();
+
+    // cupoch.registration.RobustKernel
+    py::class_<registration::RobustKernel> robust_kernel(
+            m, "RobustKernel",
+            "Robust loss weighting the residuals of the transformation "
+            "estimation. A non positive scale is estimated from the "
+            "residuals of each iteration.");
+    py::detail::bind_copy_functions<registration::RobustKernel>(robust_kernel);
+    robust_kernel
+            .def(py::init<registration::RobustKernelType, float>(),
+                 "type"_a = registration::RobustKernelType::L2,
+                 "scale"_a = 0.0)
+            .def("weight", &registration::RobustKernel::Weight, "residual"_a,
+                 "Weight of the residual.")
+            .def_readwrite("type", &registration::RobustKernel::type_,
+                           "RobustKernelType: Loss of the kernel.")
+            .def_readwrite("scale", &registration::RobustKernel::scale_,
+                           "float: Scale of the residuals.")
+            .def("__repr__", [](const registration::RobustKernel &k) {
+                return fmt::format(
+                        "registration::RobustKernel with type={:d} and "
+                        "scale={:e}",
+                        static_cast<int>(k.type_), k.scale_);
+            });
+
     // cupoch.registration.TransformationEstimation
     py::class_<
             registration::TransformationEstimation,
@@ -106,6 +148,15 @@ void pybind_registration_classes(py::module &m) {
                    return new registration::
                            TransformationEstimationPointToPoint();
                }))
+            .def(py::init([](const registration::RobustKernel &kernel) {
+                     return new registration::
+                             TransformationEstimationPointToPoint(kernel);
+                 }),
+                 "kernel"_a)
+            .def_readwrite(
+                    "kernel",
+                    &registration::TransformationEstimationPointToPoint::kernel_,
+                    "RobustKernel: Weight of the correspondences.")
             .def("__repr__",
                  [](const registration::TransformationEstimationPointToPoint
                             &te) {
@@ -127,12 +178,49 @@ void pybind_registration_classes(py::module &m) {
             registration::TransformationEstimationPointToPlane>(te_p2l);
     py::detail::bind_copy_functions<
             registration::TransformationEstimationPointToPlane>(te_p2l);
+    te_p2l.def(py::init([](const registration::RobustKernel &kernel) {
+                   return new registration::
+                           TransformationEstimationPointToPlane(kernel);
+               }),
+               "kernel"_a)
+            .def_readwrite(
+                    "kernel",
+                    &registration::TransformationEstimationPointToPlane::kernel_,
+                    "RobustKernel: Weight of the residuals.");
     te_p2l.def(
             "__repr__",
             [](const registration::TransformationEstimationPointToPlane &te) {
                 return std::string("TransformationEstimationPointToPlane");
             });
 
+    // cupoch.registration.TransformationEstimationForGeneralizedICP:
+    // TransformationEstimation
+    py::class_<registration::TransformationEstimationForGeneralizedICP,
+               PyTransformationEstimation<
+                       registration::TransformationEstimationForGeneralizedICP>,
+               registration::TransformationEstimation>
+            te_gicp(m, "TransformationEstimationForGeneralizedICP",
+                    "Class to estimate a transformation for the plane to plane "
+                    "distance of generalized ICP.");
+    py::detail::bind_default_constructor<
+            registration::TransformationEstimationForGeneralizedICP>(te_gicp);
+    py::detail::bind_copy_functions<
+            registration::TransformationEstimationForGeneralizedICP>(te_gicp);
+    te_gicp.def(py::init([](const registration::RobustKernel &kernel) {
+                    return new registration::
+                            TransformationEstimationForGeneralizedICP(kernel);
+                }),
+                "kernel"_a)
+            .def_readwrite(
+                    "kernel",
+                    &registration::TransformationEstimationForGeneralizedICP::kernel_,
+                    "RobustKernel: Weight of the whitened residuals.");
+    te_gicp.def(
+            "__repr__",
+            [](const registration::TransformationEstimationForGeneralizedICP &te) {
+                return std::string("TransformationEstimationForGeneralizedICP");
+            });
+
     // cupoch.registration.RegistrationResult
     py::class_<registration::RegistrationResult> registration_result(
             m, "RegistrationResult",
@@ -191,11 +279,14 @@ static const std::unordered_map<std::string, std::string>
                  "``registration::TransformationEstimationPointToPlane``)"},
                 {"init", "Initial transformation estimation"},
                 {"lambda_geometric", "lambda_geometric value"},
+                {"kernel", "Robust kernel weighting the residuals."},
                 {"max_correspondence_distance",
                  "Maximum correspondence points-pair distance."},
                 {"option", "Registration option"},
                 {"ransac_n", "Fit ransac with ``ransac_n`` correspondences"},
                 {"source_feature", "Source point cloud feature."},
+                {"search_param",
+                 "KDTree search parameters of the covariances."},
                 {"source", "The source point cloud."},
                 {"target_feature", "Target point cloud feature."},
                 {"target", "The target point cloud."},
@@ -222,6 +313,18 @@ void pybind_registration_methods(py::module &m) {
           "lambda_geometric"_a = 0.968);
     docstring::FunctionDocInject(m, "registration_colored_icp",
                                  map_shared_argument_docstrings);
+
+    m.def("registration_generalized_icp",
+          &registration::RegistrationGeneralizedICP,
+          "Function for Generalized ICP registration", "source"_a, "target"_a,
+          "max_correspondence_distance"_a,
+          "init"_a = Eigen::Matrix4f::Identity(),
+          "criteria"_a = registration::ICPConvergenceCriteria(),
+          "search_param"_a = geometry::KDTreeSearchParamKNN(20),
+          "epsilon"_a = 1.0e-3,
+          "kernel"_a = registration::RobustKernel());
+    docstring::FunctionDocInject(m, "registration_generalized_icp",
+                                 map_shared_argument_docstrings);
 }
 
 void pybind_registration(py::module &m) {
@@ -1,6 +1,47 @@
 #include "cupoch_pybind/utility/utility.h"
+#include "cupoch/utility/console.h"
+#include "cupoch/utility/thrust_cupoch.h"
+
+using namespace cupoch;
+
+void pybind_utility_allocator(py::module &m) {
+    py::class_<utility::AllocatorStatistics> stats(
+            m, "AllocatorStatistics",
+            "Statistics of the memory pool shared by all geometry buffers.");
+    stats.def_readonly("in_use_bytes",
+                       &utility::AllocatorStatistics::in_use_bytes_,
+                       "Bytes handed out to live buffers.")
+            .def_readonly("cached_bytes",
+                          &utility::AllocatorStatistics::cached_bytes_,
+                          "Bytes held by the pool for reuse.")
+            .def_readonly("peak_bytes",
+                          &utility::AllocatorStatistics::peak_bytes_,
+                          "Highest number of bytes held by the pool.")
+            .def_readonly("num_system_allocations",
+                          &utility::AllocatorStatistics::num_system_allocations_,
+                          "Number of requests that reached the system "
+                          "allocator.")
+            .def_readonly("num_pool_hits",
+                          &utility::AllocatorStatistics::num_pool_hits_,
+                          "Number of requests served from cached blocks.")
+            .def("__repr__", [](const utility::AllocatorStatistics &s) {
+                return fmt::format(
+                        "utility::AllocatorStatistics with in_use_bytes={:d}, "
+                        "cached_bytes={:d}, peak_bytes={:d}",
+                        s.in_use_bytes_, s.cached_bytes_, s.peak_bytes_);
+            });
+    m.def("initialize_allocator", &utility::InitializeAllocator,
+          "Configure the memory pool used by all geometry buffers",
+          "initial_pool_size"_a = 0, "max_pool_size"_a = 0,
+          "logging"_a = false);
+    m.def("trim_allocator", &utility::TrimAllocator,
+          "Release cached blocks of the memory pool");
+    m.def("get_allocator_statistics", &utility::GetAllocatorStatistics,
+          "Get the statistics of the memory pool");
+}
 
 void pybind_utility(py::module &m) {
     py::module m_submodule = m.def_submodule("utility");
     pybind_eigen(m_submodule);
-}
\ No newline at end of file
+    pybind_utility_allocator(m_submodule);
+}
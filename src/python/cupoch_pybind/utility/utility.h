@@ -4,4 +4,5 @@
 
 void pybind_utility(py::module &m);
 
-void pybind_eigen(py::module &m);
\ No newline at end of file
+void pybind_eigen(py::module &m);
+void pybind_utility_allocator(py::module &m);
\ No newline at end of file
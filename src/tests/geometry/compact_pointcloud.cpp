@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include <Eigen/Geometry>
+
+#include "cupoch/geometry/compact_pointcloud.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "tests/test_utility/pointcloud.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(CompactPointCloud, EncodeDecode) {
+    Vector3f n(0.3, -0.8, -0.5);
+    n.normalize();
+    ExpectEQ(n, geometry::DecodeNormal32(geometry::EncodeNormal32(n)), 1e-3);
+    ExpectEQ(n, geometry::DecodeNormal16(geometry::EncodeNormal16(n)), 3e-2);
+    Vector3f c(0.2, 0.5, 1.0);
+    ExpectEQ(c, geometry::DecodeColor8(geometry::EncodeColor8(c)), 1.0 / 255.0);
+}
+
+TEST(CompactPointCloud, CreateFromPointCloud) {
+    const int size = 100;
+    geometry::PointCloud pc = MakeRandomPointCloud(size, true);
+
+    auto compact = geometry::CompactPointCloud::CreateFromPointCloud(pc);
+    EXPECT_EQ(size_t(size), compact->Size());
+    EXPECT_TRUE(compact->HasNormals());
+    EXPECT_TRUE(compact->HasColors());
+    EXPECT_EQ(size_t(size * (12 + 4 + 4)), compact->GetMemorySize());
+    auto decoded = compact->ToPointCloud();
+    ExpectEQ(pc.GetPoints(), decoded->GetPoints());
+    ExpectEQ(pc.GetNormals(), decoded->GetNormals(), 1e-3);
+    ExpectEQ(pc.GetColors(), decoded->GetColors(), 1.0 / 255.0);
+
+    auto half = geometry::CompactPointCloud::CreateFromPointCloud(
+            pc, true, geometry::CompactPointCloud::NormalEncoding::Oct16);
+    EXPECT_EQ(size_t(size * (6 + 2 + 4)), half->GetMemorySize());
+    auto decoded_half = half->ToPointCloud();
+    ExpectEQ(pc.GetPoints(), decoded_half->GetPoints(), 1e-2);
+}
+
+TEST(CompactPointCloud, Transform) {
+    const int size = 100;
+    geometry::PointCloud pc = MakeRandomPointCloud(size, true);
+    auto half = geometry::CompactPointCloud::CreateFromPointCloud(pc, true);
+
+    Matrix4f transformation = Matrix4f::Identity();
+    transformation.block<3, 3>(0, 0) =
+            AngleAxisf(0.5, Vector3f::UnitZ()).toRotationMatrix();
+    transformation.block<3, 1>(0, 3) = Vector3f(1000.0, 0.0, 0.0);
+    pc.Transform(transformation);
+    half->Transform(transformation);
+
+    auto decoded = half->ToPointCloud();
+    ExpectEQ(pc.GetPoints(), decoded->GetPoints(), 1e-2);
+    ExpectEQ(pc.GetNormals(), decoded->GetNormals(), 1e-3);
+
+    // projective transformations are rejected
+    Matrix4f projective = Matrix4f::Identity();
+    projective(3, 0) = 0.1;
+    half->Transform(projective);
+    ExpectEQ(decoded->GetPoints(), half->ToPointCloud()->GetPoints());
+}
+
+TEST(CompactPointCloud, VoxelDownSample) {
+    const int size = 100;
+    geometry::PointCloud pc = MakeRandomPointCloud(size, true);
+    auto compact = geometry::CompactPointCloud::CreateFromPointCloud(pc);
+
+    auto ref = pc.VoxelDownSample(2.0);
+    auto output = compact->VoxelDownSample(2.0);
+    EXPECT_EQ(ref->points_.size(), output->points_.size());
+    EXPECT_TRUE(output->HasNormals());
+    EXPECT_TRUE(output->HasColors());
+}
+
+TEST(CompactPointCloud, VoxelDownSampleHalfPrecision) {
+    const int size = 100;
+    geometry::PointCloud pc = MakeRandomPointCloud(size, true);
+    auto half = geometry::CompactPointCloud::CreateFromPointCloud(
+            pc, true, geometry::CompactPointCloud::NormalEncoding::Oct16);
+
+    // same result as down sampling the decoded cloud
+    auto ref = half->ToPointCloud()->VoxelDownSample(2.0);
+    auto output = half->VoxelDownSample(2.0);
+    ASSERT_EQ(ref->points_.size(), output->points_.size());
+    ASSERT_TRUE(output->HasNormals());
+    ASSERT_TRUE(output->HasColors());
+    // the voxel order follows the hash table, compare sorted points
+    thrust::host_vector<Vector3f> ref_points = ref->GetPoints();
+    thrust::host_vector<Vector3f> points = output->GetPoints();
+    auto less = [](const Vector3f &a, const Vector3f &b) {
+        return std::lexicographical_compare(a.data(), a.data() + 3, b.data(), b.data() + 3);
+    };
+    std::sort(ref_points.begin(), ref_points.end(), less);
+    std::sort(points.begin(), points.end(), less);
+    for (size_t i = 0; i < points.size(); ++i) {
+        ExpectEQ(ref_points[i], points[i], 1.0e-5);
+    }
+}
@@ -0,0 +1,87 @@
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/crop_regions.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "tests/test_utility/unit_test.h"
+#include <Eigen/Geometry>
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+namespace {
+
+bool IsInsideL(const Vector3f& pt) {
+    // L shape [0, 4] x [0, 2] + [0, 2] x [2, 4], z in [1, 3]
+    if (pt(2) < 1.0 || pt(2) > 3.0) return false;
+    return (pt(0) >= 0.0 && pt(0) <= 4.0 && pt(1) >= 0.0 && pt(1) <= 2.0) ||
+           (pt(0) >= 0.0 && pt(0) <= 2.0 && pt(1) >= 0.0 && pt(1) <= 4.0);
+}
+
+}
+
+TEST(CropRegions, BoxesAndPolygons) {
+    int size = 2000;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Vector3f(-5.0, -5.0, -5.0), Vector3f(5.0, 5.0, 5.0), 0);
+    thrustcupoch::device_vector<Vector3f> d_points = points;
+
+    const Matrix3f R = AngleAxisf(0.25 * M_PI, Vector3f::UnitZ()).toRotationMatrix();
+    const geometry::OrientedBoundingBox obox(Vector3f(-2.0, -2.0, 0.0), R,
+                                             Vector3f(4.0, 1.0, 2.0));
+    const geometry::AxisAlignedBoundingBox abox(Vector3f(1.0, -4.0, -4.0),
+                                                Vector3f(4.0, 1.0, 0.0));
+    thrust::host_vector<Vector2f> polygon;
+    polygon.push_back(Vector2f(0.0, 0.0));
+    polygon.push_back(Vector2f(4.0, 0.0));
+    polygon.push_back(Vector2f(4.0, 2.0));
+    polygon.push_back(Vector2f(2.0, 2.0));
+    polygon.push_back(Vector2f(2.0, 4.0));
+    polygon.push_back(Vector2f(0.0, 4.0));
+
+    geometry::CropRegions regions;
+    EXPECT_EQ(0, regions.AddBox(obox));
+    EXPECT_EQ(1, regions.AddBox(abox));
+    EXPECT_EQ(2, regions.AddPolygonPrism(polygon, 1.0, 3.0));
+    EXPECT_EQ(3u, regions.GetNumRegions());
+
+    vector<vector<int>> ref_indices(3);
+    thrust::host_vector<int> ref_labels(size, -1);
+    for (int i = 0; i < size; ++i) {
+        const Vector3f q = R.transpose() * (points[i] - obox.center_);
+        const bool inside[3] = {
+                abs(q(0)) <= 2.0 && abs(q(1)) <= 0.5 && abs(q(2)) <= 1.0,
+                (points[i].array() >= abox.min_bound_.array()).all() &&
+                        (points[i].array() <= abox.max_bound_.array()).all(),
+                IsInsideL(points[i])};
+        for (int r = 2; r >= 0; --r) {
+            if (!inside[r]) continue;
+            ref_indices[r].push_back(i);
+            ref_labels[i] = r;
+        }
+    }
+    for (const auto& ref : ref_indices) EXPECT_LT(0u, ref.size());
+
+    thrust::host_vector<int> labels = regions.GetPointRegionLabels(d_points);
+    ExpectEQ(ref_labels, labels);
+
+    thrustcupoch::device_vector<int> d_offsets;
+    thrustcupoch::device_vector<int> d_indices;
+    const int total = regions.GetPointIndicesWithinRegions(d_points, d_offsets, d_indices);
+    thrust::host_vector<int> offsets = d_offsets;
+    thrust::host_vector<int> indices = d_indices;
+    ASSERT_EQ(4u, offsets.size());
+    EXPECT_EQ(total, offsets[3]);
+    for (int r = 0; r < 3; ++r) {
+        thrust::host_vector<int> region_indices(indices.begin() + offsets[r],
+                                                indices.begin() + offsets[r + 1]);
+        thrust::host_vector<int> ref(ref_indices[r].begin(), ref_indices[r].end());
+        ExpectEQ(ref, region_indices);
+    }
+
+    // single oriented box crop
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    auto cropped = pc.Crop(obox);
+    EXPECT_EQ(ref_indices[0].size(), cropped->points_.size());
+}
@@ -0,0 +1,119 @@
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/dynamic_kdtree.h"
+#include "cupoch/geometry/kdtree_flann.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+namespace {
+
+// Checks the results of the dynamic tree against a static tree built on the
+// remaining points.
+void ExpectSameAsStaticTree(const geometry::DynamicKDTree& tree,
+                            const thrustcupoch::device_vector<Eigen::Vector3f>& query,
+                            const geometry::KDTreeSearchParam& param) {
+    thrustcupoch::device_vector<Eigen::Vector3f> points;
+    thrustcupoch::device_vector<int> ids;
+    tree.ExtractPoints(points, ids);
+    EXPECT_EQ(tree.GetNumPoints(), points.size());
+    geometry::KDTreeFlann kdtree;
+    kdtree.SetRawData(points);
+
+    thrustcupoch::device_vector<int> ref_indices;
+    thrustcupoch::device_vector<float> ref_distance2;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    int ref_result = kdtree.Search(query, param, ref_indices, ref_distance2);
+    int result = tree.Search(query, param, indices, distance2);
+    EXPECT_EQ(ref_result, result);
+    ASSERT_EQ(ref_indices.size(), indices.size());
+
+    thrust::host_vector<int> h_ids = ids;
+    thrust::host_vector<int> h_ref_indices = ref_indices;
+    thrust::host_vector<float> h_ref_distance2 = ref_distance2;
+    thrust::host_vector<int> h_indices = indices;
+    thrust::host_vector<float> h_distance2 = distance2;
+    for (size_t i = 0; i < h_indices.size(); ++i) {
+        if (h_ref_indices[i] < 0) {
+            EXPECT_EQ(-1, h_indices[i]);
+            continue;
+        }
+        EXPECT_NEAR(h_ref_distance2[i], h_distance2[i], THRESHOLD_1E_4);
+        if (h_ref_distance2[i] == h_distance2[i]) {
+            EXPECT_EQ(h_ids[h_ref_indices[i]], h_indices[i]);
+        }
+    }
+}
+
+}
+
+TEST(DynamicKDTree, InsertAndDelete) {
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    geometry::DynamicKDTree tree;
+    for (int i = 0; i < 5; ++i) {
+        thrust::host_vector<Eigen::Vector3f> points(100 * (i + 1));
+        Rand(points, vmin, vmax, i);
+        thrustcupoch::device_vector<Eigen::Vector3f> d_points = points;
+        const size_t n_points = tree.GetNumPoints();
+        EXPECT_EQ(int(n_points), tree.Insert(d_points));
+        EXPECT_EQ(n_points + points.size(), tree.GetNumPoints());
+    }
+    EXPECT_LE(tree.GetNumLevels(), 5u);
+
+    thrust::host_vector<Eigen::Vector3f> h_query(20);
+    Rand(h_query, vmin, vmax, 10);
+    thrustcupoch::device_vector<Eigen::Vector3f> query = h_query;
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamKNN(10));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamHybrid(1.5, 20));
+
+    geometry::AxisAlignedBoundingBox box(Vector3f(0.0, 0.0, 0.0),
+                                         Vector3f(5.0, 10.0, 10.0));
+    const size_t n_points = tree.GetNumPoints();
+    const size_t n_deleted = tree.DeleteInBoundingBox(box);
+    EXPECT_GT(n_deleted, 0u);
+    EXPECT_EQ(n_points - n_deleted, tree.GetNumPoints());
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamKNN(10));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamHybrid(1.5, 20));
+
+    thrust::host_vector<int> h_ids;
+    for (int i = 0; i < 1500; i += 3) h_ids.push_back(i);
+    thrustcupoch::device_vector<int> ids = h_ids;
+    const size_t n_deleted_ids = tree.DeleteByIndex(ids);
+    EXPECT_GT(n_deleted_ids, 0u);
+    EXPECT_EQ(0u, tree.DeleteByIndex(ids));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamKNN(10));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamRadius(2.0));
+
+    const size_t n_remaining = tree.GetNumPoints();
+    tree.Rebuild();
+    EXPECT_EQ(1u, tree.GetNumLevels());
+    EXPECT_EQ(n_remaining, tree.GetNumPoints());
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamKNN(10));
+}
+
+TEST(DynamicKDTree, ManyDeletedPoints) {
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+    thrust::host_vector<Eigen::Vector3f> points(1000);
+    Rand(points, vmin, vmax, 0);
+    thrustcupoch::device_vector<Eigen::Vector3f> d_points = points;
+
+    geometry::DynamicKDTree tree;
+    tree.Insert(d_points);
+    // less than half of the points is deleted so the level is not rebuilt
+    // and the knn searches exceed NUM_MAX_NN candidates
+    geometry::AxisAlignedBoundingBox box(Vector3f(0.0, 0.0, 0.0),
+                                         Vector3f(10.0, 10.0, 4.0));
+    tree.DeleteInBoundingBox(box);
+    EXPECT_EQ(1u, tree.GetNumLevels());
+
+    thrustcupoch::device_vector<Eigen::Vector3f> query(
+            1, Vector3f(5.0, 5.0, 0.0));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamKNN(30));
+    ExpectSameAsStaticTree(tree, query, geometry::KDTreeSearchParamHybrid(6.0, 30));
+}
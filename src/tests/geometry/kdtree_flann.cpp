@@ -1,4 +1,5 @@
 #include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/kdtree_query_batcher.h"
 #include "cupoch/geometry/pointcloud.h"
 #include "tests/test_utility/unit_test.h"
 #include <thrust/sort.h>
@@ -162,4 +163,182 @@ TEST(KDTreeFlann, SearchHybrid) {
     thrust::sort(distance2.begin(), distance2.end());
     ExpectEQ(ref_indices, indices);
     ExpectEQ(ref_distance2, distance2);
-}
\ No newline at end of file
+}
+
+TEST(KDTreeFlann, SearchKNNAligned) {
+    int size = 100;
+
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    thrust::host_vector<Eigen::Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::KDTreeFlann kdtree_aligned;
+    thrustcupoch::device_vector<Eigen::Vector4f> aligned = pc.GetAlignedPoints();
+    EXPECT_TRUE(kdtree_aligned.SetRawData(aligned));
+
+    int knn = 10;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    thrustcupoch::device_vector<int> indices_aligned;
+    thrustcupoch::device_vector<float> distance2_aligned;
+    int result = kdtree.SearchKNN(pc.points_, knn, indices, distance2);
+    int result_aligned = kdtree_aligned.SearchKNN(aligned, knn, indices_aligned,
+                                                  distance2_aligned);
+
+    EXPECT_EQ(result, result_aligned);
+    thrust::host_vector<int> h_indices = indices;
+    thrust::host_vector<int> h_indices_aligned = indices_aligned;
+    thrust::host_vector<float> h_distance2 = distance2;
+    thrust::host_vector<float> h_distance2_aligned = distance2_aligned;
+    ExpectEQ(h_indices, h_indices_aligned);
+    ExpectEQ(h_distance2, h_distance2_aligned);
+
+    geometry::PointCloud pc_aligned;
+    pc_aligned.SetAlignedPoints(aligned);
+    ExpectEQ(pc.GetPoints(), pc_aligned.GetPoints());
+}
+
+TEST(KDTreeFlann, SearchRadiusCSR) {
+    thrust::host_vector<int> ref_indices;
+    int indices0[] = {27, 48, 4,  77, 90, 7, 54, 17, 76, 38, 39,
+                      60, 15, 84, 11, 57, 3, 32, 99, 36, 52};
+    for (int i = 0; i < 21; ++i) ref_indices.push_back(indices0[i]);
+
+    int size = 100;
+
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    thrust::host_vector<Eigen::Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    geometry::KDTreeFlann kdtree(pc);
+
+    thrustcupoch::device_vector<Eigen::Vector3f> query(1, Vector3f(1.647059, 4.392157, 8.784314));
+    thrustcupoch::device_vector<int> offsets;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    int result = kdtree.SearchRadiusCSR(query, 5.0, offsets, indices, distance2);
+
+    EXPECT_EQ(result, 21);
+    thrust::host_vector<int> h_offsets = offsets;
+    EXPECT_EQ(2u, h_offsets.size());
+    EXPECT_EQ(0, h_offsets[0]);
+    EXPECT_EQ(21, h_offsets[1]);
+    thrust::host_vector<int> h_indices = indices;
+    thrust::sort(ref_indices.begin(), ref_indices.end());
+    thrust::sort(h_indices.begin(), h_indices.end());
+    ExpectEQ(ref_indices, h_indices);
+
+    // all the points are neighbors of each other, beyond NUM_MAX_NN
+    result = kdtree.SearchRadiusCSR(pc.points_, 100.0, offsets, indices, distance2);
+    EXPECT_EQ(size * size, result);
+    h_offsets = offsets;
+    for (int i = 0; i <= size; ++i) EXPECT_EQ(i * size, h_offsets[i]);
+
+    result = kdtree.SearchHybridCSR(pc.points_, 100.0, 15, offsets, indices, distance2);
+    EXPECT_EQ(size * 15, result);
+    thrust::host_vector<float> h_distance2 = distance2;
+    h_offsets = offsets;
+    for (int i = 0; i < size; ++i) {
+        EXPECT_EQ(0.0, h_distance2[h_offsets[i]]);
+    }
+}
+
+TEST(KDTreeFlann, CountAndMeanDistance) {
+    int size = 100;
+    geometry::PointCloud pc;
+    thrust::host_vector<Eigen::Vector3f> points(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 10.0), 0);
+    pc.SetPoints(points);
+    geometry::KDTreeFlann kdtree(pc);
+
+    // the counts match the row lengths of the CSR search
+    thrustcupoch::device_vector<int> counts;
+    thrustcupoch::device_vector<int> offsets;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    const int total = kdtree.CountRadius(pc.points_, 3.0, counts);
+    EXPECT_EQ(total, kdtree.SearchRadiusCSR(pc.points_, 3.0, offsets, indices, distance2));
+    thrust::host_vector<int> h_counts = counts;
+    thrust::host_vector<int> h_offsets = offsets;
+    for (int i = 0; i < size; ++i) EXPECT_EQ(h_offsets[i + 1] - h_offsets[i], h_counts[i]);
+
+    // the means match the averages of the KNN rows
+    const int knn = 8;
+    thrustcupoch::device_vector<float> mean_distance2;
+    EXPECT_EQ(size, kdtree.SearchKNNMeanDistance2(pc.points_, knn, mean_distance2));
+    kdtree.SearchKNN(pc.points_, knn, indices, distance2);
+    thrust::host_vector<float> h_mean_distance2 = mean_distance2;
+    thrust::host_vector<float> h_distance2 = distance2;
+    for (int i = 0; i < size; ++i) {
+        float sum = 0.0;
+        for (int k = 0; k < knn; ++k) sum += h_distance2[i * knn + k];
+        EXPECT_NEAR(sum / knn, h_mean_distance2[i], 1.0e-4);
+    }
+    EXPECT_EQ(-1, kdtree.SearchKNNMeanDistance2(pc.points_, geometry::NUM_MAX_NN + 1, mean_distance2));
+}
+
+TEST(KDTreeFlann, QueryBatcher) {
+    int size = 100;
+
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(10.0, 10.0, 10.0);
+
+    thrust::host_vector<Eigen::Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::KDTreeSearchParamHybrid param(3.0, 10);
+
+    thrust::host_vector<Eigen::Vector3f> queries(20);
+    Rand(queries, vmin, vmax, 1);
+
+    geometry::KDTreeQueryBatcher batcher(kdtree, param);
+    std::vector<std::future<geometry::NeighborQueryResult>> futures;
+    std::vector<geometry::NeighborQueryResult> callback_results(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        futures.push_back(batcher.Enqueue(queries[i]));
+        batcher.Enqueue(queries[i],
+                        [&callback_results, i](
+                                const geometry::NeighborQueryResult &r) {
+                            callback_results[i] = r;
+                        });
+    }
+    auto batch_future = batcher.Enqueue(queries.data(), queries.size());
+    EXPECT_EQ(3 * queries.size(), batcher.GetNumPendingQueries());
+    batcher.Flush();
+    EXPECT_EQ(0u, batcher.GetNumPendingQueries());
+    std::vector<geometry::NeighborQueryResult> batch_results =
+            batch_future.get();
+    EXPECT_EQ(queries.size(), batch_results.size());
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        thrust::host_vector<int> indices;
+        thrust::host_vector<float> distance2;
+        kdtree.SearchHybrid(queries[i], 3.0, 10, indices, distance2);
+        indices.erase(thrust::remove_if(indices.begin(), indices.end(),
+                                        is_minus_one_functor()),
+                      indices.end());
+        distance2.erase(thrust::remove_if(distance2.begin(), distance2.end(),
+                                          is_inf_functor()),
+                        distance2.end());
+        geometry::NeighborQueryResult future_result = futures[i].get();
+        ExpectEQ(indices, future_result.indices_);
+        ExpectEQ(distance2, future_result.distance2_);
+        ExpectEQ(indices, callback_results[i].indices_);
+        ExpectEQ(indices, batch_results[i].indices_);
+    }
+}
@@ -0,0 +1,123 @@
+#include <cstring>
+
+#include "cupoch/camera/pinhole_camera_intrinsic.h"
+#include "cupoch/geometry/image.h"
+#include "cupoch/geometry/organized_pointcloud.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+namespace {
+
+const int width = 20;
+const int height = 16;
+const int hole_row = 5;
+const int hole_col = 7;
+
+// Depth image of the plane n . p = 2 with a single pixel without depth.
+geometry::Image MakePlaneDepthImage(const camera::PinholeCameraIntrinsic& intrinsic,
+                                    const Vector3f& n) {
+    const auto focal_length = intrinsic.GetFocalLength();
+    const auto principal_point = intrinsic.GetPrincipalPoint();
+    thrust::host_vector<float> depth(width * height);
+    for (int v = 0; v < height; ++v) {
+        for (int u = 0; u < width; ++u) {
+            const Vector3f ray((u - principal_point.first) / focal_length.first,
+                               (v - principal_point.second) / focal_length.second, 1.0);
+            depth[v * width + u] = 2.0 / n.dot(ray);
+        }
+    }
+    depth[hole_row * width + hole_col] = 0.0;
+    geometry::Image image;
+    image.Prepare(width, height, 1, 4);
+    thrust::host_vector<uint8_t> data(width * height * sizeof(float));
+    memcpy(data.data(), depth.data(), data.size());
+    image.SetData(data);
+    return image;
+}
+
+}  // namespace
+
+TEST(OrganizedPointCloud, CreateFromDepthImage) {
+    const camera::PinholeCameraIntrinsic intrinsic(width, height, 20.0, 20.0,
+                                                   10.0, 8.0);
+    const Vector3f n = Vector3f(0.2, -0.1, 1.0).normalized();
+    auto organized = geometry::OrganizedPointCloud::CreateFromDepthImage(
+            MakePlaneDepthImage(intrinsic, n), intrinsic);
+    EXPECT_EQ(width, organized->width_);
+    EXPECT_EQ(height, organized->height_);
+    EXPECT_EQ(size_t(width * height), organized->Size());
+    EXPECT_EQ(size_t(width * height - 1), organized->CountValidPoints());
+
+    thrust::host_vector<uint8_t> mask = organized->mask_;
+    EXPECT_EQ(0, mask[hole_row * width + hole_col]);
+
+    auto pc = organized->ToPointCloud();
+    thrust::host_vector<Vector3f> points = pc->GetPoints();
+    EXPECT_EQ(size_t(width * height - 1), points.size());
+    for (const auto& pt : points) EXPECT_NEAR(2.0, n.dot(pt), 1.0e-4);
+}
+
+TEST(OrganizedPointCloud, EstimateNormals) {
+    const camera::PinholeCameraIntrinsic intrinsic(width, height, 20.0, 20.0,
+                                                   10.0, 8.0);
+    const Vector3f n = Vector3f(0.2, -0.1, 1.0).normalized();
+    auto organized = geometry::OrganizedPointCloud::CreateFromDepthImage(
+            MakePlaneDepthImage(intrinsic, n), intrinsic);
+
+    // normals face the camera at the origin
+    const Vector3f ref = -n;
+    for (auto method : {geometry::OrganizedPointCloud::NormalMethod::CrossProduct,
+                        geometry::OrganizedPointCloud::NormalMethod::IntegralImage}) {
+        EXPECT_TRUE(organized->EstimateNormals(method, 2));
+        EXPECT_TRUE(organized->HasNormals());
+        auto pc = organized->ToPointCloud();
+        thrust::host_vector<Vector3f> normals = pc->GetNormals();
+        EXPECT_EQ(size_t(width * height - 1), normals.size());
+        for (const auto& nl : normals) ExpectEQ(ref, nl, 1.0e-3);
+    }
+    EXPECT_FALSE(organized->EstimateNormals(
+            geometry::OrganizedPointCloud::NormalMethod::CrossProduct, 0));
+}
+
+TEST(OrganizedPointCloud, SearchNeighbors) {
+    const camera::PinholeCameraIntrinsic intrinsic(width, height, 20.0, 20.0,
+                                                   10.0, 8.0);
+    auto organized = geometry::OrganizedPointCloud::CreateFromDepthImage(
+            MakePlaneDepthImage(intrinsic, Vector3f(0.0, 0.0, 1.0)), intrinsic);
+
+    thrustcupoch::device_vector<int> d_indices;
+    thrustcupoch::device_vector<float> d_distance2;
+    const int n_slots = organized->SearchNeighbors(1, 0.0, d_indices, d_distance2);
+    EXPECT_EQ(8, n_slots);
+    thrust::host_vector<int> indices = d_indices;
+    thrust::host_vector<float> distance2 = d_distance2;
+    thrust::host_vector<Vector3f> points = organized->points_;
+
+    auto count = [&](int idx) {
+        int n = 0;
+        for (int k = 0; k < n_slots; ++k) {
+            const int j = indices[idx * n_slots + k];
+            if (j < 0) continue;
+            EXPECT_NEAR((points[j] - points[idx]).squaredNorm(),
+                        distance2[idx * n_slots + k], 1.0e-6);
+            ++n;
+        }
+        return n;
+    };
+    // corner, interior, next to the hole and the hole itself
+    EXPECT_EQ(3, count(0));
+    EXPECT_EQ(8, count(2 * width + 2));
+    EXPECT_EQ(7, count(hole_row * width + hole_col + 1));
+    EXPECT_EQ(0, count(hole_row * width + hole_col));
+
+    // the diagonal pixels are 0.14 away, the others 0.1
+    organized->SearchNeighbors(1, 0.11, d_indices, d_distance2);
+    indices = d_indices;
+    distance2 = d_distance2;
+    EXPECT_EQ(4, count(2 * width + 2));
+}
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 #include "cupoch/geometry/pointcloud.h"
 #include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/segment_statistics.h"
+#include "cupoch/geometry/voxel_key.h"
 #include "tests/test_utility/unit_test.h"
 #include <thrust/unique.h>
+#include <limits>
+#include <map>
+#include <tuple>
 
 using namespace Eigen;
 using namespace cupoch;
@@ -168,6 +173,63 @@ TEST(PointCloud, Transform) {
     ExpectEQ(ref_normals, pc.GetNormals());
 }
 
+TEST(PointCloud, AlignedPoints) {
+    int size = 100;
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(1000.0, 1000.0, 1000.0);
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    thrust::host_vector<Vector3f> normals(size);
+    Rand(normals, vmin, vmax, 1);
+    pc.SetNormals(normals);
+
+    thrustcupoch::device_vector<Vector4f> aligned = pc.GetAlignedPoints();
+    thrust::host_vector<Vector4f> h_aligned = aligned;
+    ASSERT_EQ(size_t(size), h_aligned.size());
+    for (int i = 0; i < size; ++i) {
+        ExpectEQ(points[i], Vector3f(h_aligned[i].head<3>()));
+        EXPECT_EQ(0.0, h_aligned[i](3));
+    }
+
+    // the reductions match the unaligned ones
+    ExpectEQ(pc.GetMinBound(), pc.ComputeMinBound(0, aligned));
+    ExpectEQ(pc.GetMaxBound(), pc.ComputeMaxBound(0, aligned));
+    ExpectEQ(pc.GetCenter(), pc.ComputeCenter(aligned), 1.0e-3);
+
+    // the transforms match the unaligned ones and keep the padding at zero
+    thrust::host_vector<Vector4f> h_aligned_normals(size);
+    for (int i = 0; i < size; ++i) {
+        h_aligned_normals[i] = Vector4f(normals[i](0), normals[i](1), normals[i](2), 0.0);
+    }
+    thrustcupoch::device_vector<Vector4f> aligned_normals = h_aligned_normals;
+    Matrix4f transformation;
+    transformation << 0.10, 0.20, 0.30, 0.40, 0.50, 0.60, 0.70, 0.80, 0.90,
+            0.10, 0.11, 0.12, 0.13, 0.14, 0.15, 0.16;
+    pc.TransformPoints(0, transformation, aligned);
+    pc.TransformNormals(0, transformation, aligned_normals);
+    pc.Transform(transformation);
+    h_aligned = aligned;
+    h_aligned_normals = aligned_normals;
+    thrust::host_vector<Vector3f> ref_points = pc.GetPoints();
+    thrust::host_vector<Vector3f> ref_normals = pc.GetNormals();
+    for (int i = 0; i < size; ++i) {
+        ExpectEQ(ref_points[i], Vector3f(h_aligned[i].head<3>()));
+        ExpectEQ(ref_normals[i], Vector3f(h_aligned_normals[i].head<3>()));
+        EXPECT_EQ(0.0, h_aligned[i](3));
+        EXPECT_EQ(0.0, h_aligned_normals[i](3));
+    }
+
+    // SetAlignedPoints drops the padding
+    geometry::PointCloud pc_aligned;
+    pc_aligned.SetAlignedPoints(aligned);
+    ExpectEQ(ref_points, pc_aligned.GetPoints());
+}
+
 TEST(PointCloud, HasPoints) {
     int size = 100;
 
@@ -404,6 +466,179 @@ TEST(PointCloud, VoxelDownSample) {
     ExpectEQ(ref_colors, output_cl);
 }
 
+TEST(PointCloud, VoxelDownSampleAverage) {
+    size_t size = 2000;
+    geometry::PointCloud pc;
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Zero3f, Vector3f(1000.0, 1000.0, 1000.0), 0);
+    pc.SetPoints(points);
+    thrust::host_vector<Vector3f> colors(size);
+    Rand(colors, Zero3f, Vector3f(255.0, 255.0, 255.0), 1);
+    pc.SetColors(colors);
+
+    // reference averages computed on the host
+    float voxel_size = 200.0;
+    const Vector3f voxel_min_bound =
+            pc.GetMinBound() - Vector3f::Constant(voxel_size * 0.5);
+    std::map<std::tuple<int, int, int>, std::tuple<Vector3f, Vector3f, int>> voxels;
+    for (size_t i = 0; i < size; ++i) {
+        Vector3i v = geometry::ComputeVoxelIndex(points[i], voxel_min_bound, voxel_size);
+        auto& acc = voxels[std::make_tuple(v[0], v[1], v[2])];
+        if (std::get<2>(acc) == 0) {
+            std::get<0>(acc).setZero();
+            std::get<1>(acc).setZero();
+        }
+        std::get<0>(acc) += points[i];
+        std::get<1>(acc) += colors[i];
+        std::get<2>(acc) += 1;
+    }
+    thrust::host_vector<Vector3f> ref_points;
+    thrust::host_vector<Vector3f> ref_colors;
+    for (const auto& kv : voxels) {
+        ref_points.push_back(std::get<0>(kv.second) / std::get<2>(kv.second));
+        ref_colors.push_back(std::get<1>(kv.second) / std::get<2>(kv.second));
+    }
+
+    auto output_pc = pc.VoxelDownSample(voxel_size);
+    EXPECT_FALSE(output_pc->HasNormals());
+    auto output_pt = output_pc->GetPoints();
+    auto output_cl = output_pc->GetColors();
+    ASSERT_EQ(ref_points.size(), output_pt.size());
+    sort::Do(ref_points);
+    sort::Do(ref_colors);
+    sort::Do(output_pt);
+    sort::Do(output_cl);
+    ExpectEQ(ref_points, output_pt, 1e-2);
+    ExpectEQ(ref_colors, output_cl, 1e-2);
+}
+
+TEST(PointCloud, VoxelDownSampleSparse) {
+    // every point falls into its own voxel
+    size_t size = 5000;
+    geometry::PointCloud pc;
+    thrust::host_vector<Vector3f> points(size);
+    for (size_t i = 0; i < size; ++i) {
+        points[i] = Vector3f(i % 17, (i / 17) % 17, i / (17 * 17));
+    }
+    pc.SetPoints(points);
+
+    auto output_pc = pc.VoxelDownSample(0.5);
+    auto output_pt = output_pc->GetPoints();
+    ASSERT_EQ(size, output_pt.size());
+    sort::Do(points);
+    sort::Do(output_pt);
+    ExpectEQ(points, output_pt, 1e-4);
+}
+
+TEST(PointCloud, VoxelDownSampleLargeExtent) {
+    // more voxels per axis than a Morton code holds
+    geometry::PointCloud pc;
+    thrust::host_vector<Vector3f> points;
+    points.push_back(Vector3f(0.0, 0.0, 0.0));
+    points.push_back(Vector3f(0.2, 0.0, 0.0));
+    points.push_back(Vector3f(1.0e7, 0.2, 0.0));
+    points.push_back(Vector3f(1.0e7, 0.4, 0.0));
+    pc.SetPoints(points);
+
+    auto output_pt = pc.VoxelDownSample(1.0)->GetPoints();
+    ASSERT_EQ(2u, output_pt.size());
+    thrust::host_vector<Vector3f> ref_points;
+    ref_points.push_back(Vector3f(0.1, 0.0, 0.0));
+    ref_points.push_back(Vector3f(1.0e7, 0.3, 0.0));
+    sort::Do(output_pt);
+    ExpectEQ(ref_points, output_pt, 1e-4);
+}
+
+TEST(PointCloud, VoxelDownSampleAndTrace) {
+    size_t size = 1000;
+    geometry::PointCloud pc;
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Zero3f, Vector3f(1000.0, 1000.0, 1000.0), 0);
+    pc.SetPoints(points);
+
+    float voxel_size = 200.0;
+    auto output = pc.VoxelDownSampleAndTrace(voxel_size);
+    auto output_pc = std::get<0>(output);
+    thrust::host_vector<int> point_voxels = std::get<1>(output);
+    thrust::host_vector<int> offsets = std::get<2>(output);
+    thrust::host_vector<int> indices = std::get<3>(output);
+    auto output_pt = output_pc->GetPoints();
+
+    EXPECT_EQ(pc.VoxelDownSample(voxel_size)->points_.size(), output_pt.size());
+    ASSERT_EQ(output_pt.size() + 1, offsets.size());
+    EXPECT_EQ(size, indices.size());
+    EXPECT_EQ(int(size), offsets.back());
+    for (size_t v = 0; v < output_pt.size(); ++v) {
+        Vector3f sum = Vector3f::Zero();
+        for (int j = offsets[v]; j < offsets[v + 1]; ++j) {
+            EXPECT_EQ(int(v), point_voxels[indices[j]]);
+            sum += points[indices[j]];
+        }
+        ExpectEQ(Vector3f(sum / (offsets[v + 1] - offsets[v])), output_pt[v], 1e-2);
+    }
+}
+
+TEST(PointCloud, VoxelDownSamplePyramid) {
+    size_t size = 1000;
+    geometry::PointCloud pc;
+
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Zero3f, Vector3f(1000.0, 1000.0, 1000.0), 0);
+    pc.SetPoints(points);
+
+    float voxel_size = 50.0;
+    int n_levels = 4;
+    auto output = pc.VoxelDownSamplePyramid(voxel_size, n_levels);
+    auto& levels = std::get<0>(output);
+    thrust::host_vector<int> indices = std::get<1>(output);
+    ASSERT_EQ(size_t(n_levels), levels.size());
+    ASSERT_EQ(size, indices.size());
+
+    auto trace = pc.VoxelDownSampleAndTrace(voxel_size);
+    EXPECT_EQ(std::get<0>(trace)->points_.size(), levels[0].cloud_->points_.size());
+    for (int l = 0; l < n_levels; ++l) {
+        const size_t n_voxels = levels[l].cloud_->points_.size();
+        // the points of each voxel are mapped back to it
+        thrust::host_vector<int> point_voxels = levels[l].point_voxels_;
+        thrust::host_vector<int> offsets = levels[l].offsets_;
+        ASSERT_EQ(n_voxels + 1, offsets.size());
+        EXPECT_EQ(int(size), offsets[n_voxels]);
+        for (size_t v = 0; v < n_voxels; ++v) {
+            for (int k = offsets[v]; k < offsets[v + 1]; ++k) {
+                EXPECT_EQ(int(v), point_voxels[indices[k]]);
+            }
+        }
+        if (l == 0) {
+            EXPECT_EQ(size_t(1), levels[l].child_offsets_.size());
+            EXPECT_TRUE(levels[l].children_.empty());
+            continue;
+        }
+        EXPECT_LT(n_voxels, levels[l - 1].cloud_->points_.size());
+        // the children of a voxel are the finer voxels whose points fall
+        // into it, and their parent is that voxel
+        thrust::host_vector<int> fine_voxels = levels[l - 1].point_voxels_;
+        thrust::host_vector<int> parents = levels[l - 1].parents_;
+        thrust::host_vector<int> child_offsets = levels[l].child_offsets_;
+        thrust::host_vector<int> children = levels[l].children_;
+        ASSERT_EQ(levels[l - 1].cloud_->points_.size(), parents.size());
+        ASSERT_EQ(n_voxels + 1, child_offsets.size());
+        EXPECT_EQ(int(parents.size()), child_offsets[n_voxels]);
+        ASSERT_EQ(parents.size(), children.size());
+        for (size_t v = 0; v < n_voxels; ++v) {
+            EXPECT_LT(child_offsets[v], child_offsets[v + 1]);
+            for (int k = child_offsets[v]; k < child_offsets[v + 1]; ++k) {
+                EXPECT_EQ(int(v), parents[children[k]]);
+            }
+        }
+        for (size_t i = 0; i < size; ++i) {
+            EXPECT_EQ(point_voxels[i], parents[fine_voxels[i]]);
+        }
+    }
+    EXPECT_TRUE(levels[n_levels - 1].parents_.empty());
+}
+
 TEST(PointCloud, UniformDownSample) {
     thrust::host_vector<Vector3f> ref;
     ref.push_back(Vector3f(839.215686, 392.156863, 780.392157));
@@ -448,6 +683,75 @@ TEST(PointCloud, UniformDownSample) {
     ExpectEQ(ref, output_pc->GetPoints());
 }
 
+TEST(PointCloud, FarthestPointDownSample) {
+    size_t size = 500;
+    size_t num_samples = 20;
+    geometry::PointCloud pc;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Zero3f, Vector3f(1000.0, 1000.0, 1000.0), 0);
+    pc.SetPoints(points);
+
+    // reference farthest point sampling on the host
+    std::vector<size_t> ref_indices(1, 0);
+    std::vector<float> min_distance2(size, std::numeric_limits<float>::infinity());
+    for (size_t s = 1; s < num_samples; ++s) {
+        size_t farthest = 0;
+        for (size_t i = 0; i < size; ++i) {
+            min_distance2[i] = std::min(min_distance2[i],
+                                        (points[i] - points[ref_indices.back()]).squaredNorm());
+            if (min_distance2[i] > min_distance2[farthest]) farthest = i;
+        }
+        ref_indices.push_back(farthest);
+    }
+
+    auto output = pc.FarthestPointDownSample(num_samples);
+    thrust::host_vector<size_t> indices = std::get<1>(output);
+    ASSERT_EQ(num_samples, indices.size());
+    for (size_t s = 0; s < num_samples; ++s) EXPECT_EQ(ref_indices[s], indices[s]);
+    EXPECT_EQ(num_samples, std::get<0>(output)->points_.size());
+
+    // batched sampling gives the same samples; small clouds are sampled
+    // completely
+    geometry::PointCloud small_pc;
+    small_pc.SetPoints(thrust::host_vector<Vector3f>(points.begin(), points.begin() + 5));
+    std::vector<const geometry::PointCloud*> clouds = {&small_pc, &pc};
+    auto outputs = geometry::PointCloud::BatchFarthestPointDownSample(clouds, num_samples);
+    ASSERT_EQ(2u, outputs.size());
+    thrust::host_vector<size_t> small_indices = std::get<1>(outputs[0]);
+    EXPECT_EQ(5u, small_indices.size());
+    thrust::sort(small_indices.begin(), small_indices.end());
+    for (size_t i = 0; i < small_indices.size(); ++i) EXPECT_EQ(i, small_indices[i]);
+    thrust::host_vector<size_t> batch_indices = std::get<1>(outputs[1]);
+    ASSERT_EQ(num_samples, batch_indices.size());
+    for (size_t s = 0; s < num_samples; ++s) EXPECT_EQ(ref_indices[s], batch_indices[s]);
+}
+
+TEST(PointCloud, RandomDownSample) {
+    size_t size = 1000;
+    geometry::PointCloud pc;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Zero3f, Vector3f(1000.0, 1000.0, 1000.0), 0);
+    pc.SetPoints(points);
+
+    auto output = pc.RandomDownSample(0.25, 1);
+    thrust::host_vector<size_t> indices = std::get<1>(output);
+    EXPECT_EQ(250u, indices.size());
+    EXPECT_EQ(250u, std::get<0>(output)->points_.size());
+    for (size_t i = 1; i < indices.size(); ++i) EXPECT_LT(indices[i - 1], indices[i]);
+
+    // the selection only depends on the seed
+    thrust::host_vector<size_t> same_indices = std::get<1>(pc.RandomDownSample(0.25, 1));
+    thrust::host_vector<size_t> other_indices = std::get<1>(pc.RandomDownSample(0.25, 2));
+    EXPECT_TRUE(indices == same_indices);
+    EXPECT_FALSE(indices == other_indices);
+
+    EXPECT_EQ(size, std::get<1>(pc.RandomDownSampleToSize(2 * size)).size());
+
+    // illegal ratios give an empty cloud
+    EXPECT_TRUE(std::get<0>(pc.RandomDownSample(-0.5, 1))->IsEmpty());
+    EXPECT_TRUE(std::get<1>(pc.RandomDownSample(1.5, 1)).empty());
+}
+
 TEST(PointCloud, CropPointCloud) {
     size_t size = 100;
     geometry::PointCloud pc;
@@ -531,6 +835,58 @@ TEST(PointCloud, EstimateNormals) {
     ExpectEQ(ref, normals);
 }
 
+TEST(PointCloud, EstimateNormalsFused) {
+    size_t size = 200;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 10.0), 0);
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    geometry::PointCloud ref = pc;
+
+    // same normals as the search with neighbor lists
+    ref.EstimateNormals(geometry::KDTreeSearchParamKNN(10));
+    EXPECT_TRUE(pc.EstimateNormalsFused(geometry::KDTreeSearchParamKNN(10)));
+    thrust::host_vector<Vector3f> ref_normals = ref.GetNormals();
+    thrust::host_vector<Vector3f> normals = pc.GetNormals();
+    for (size_t i = 0; i < size; ++i) {
+        if (normals[i].dot(ref_normals[i]) < 0) normals[i] *= -1;
+    }
+    ExpectEQ(ref_normals, normals, 1.0e-3);
+
+    ref.EstimateNormals(geometry::KDTreeSearchParamHybrid(2.0, 20));
+    EXPECT_TRUE(pc.EstimateNormalsFused(geometry::KDTreeSearchParamHybrid(2.0, 20)));
+    ref_normals = ref.GetNormals();
+    normals = pc.GetNormals();
+    for (size_t i = 0; i < size; ++i) {
+        if (normals[i].dot(ref_normals[i]) < 0) normals[i] *= -1;
+    }
+    ExpectEQ(ref_normals, normals, 1.0e-3);
+
+    // a plane and a line
+    thrust::host_vector<Vector3f> shape;
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) shape.push_back(Vector3f(i * 0.1, j * 0.1, 0.0));
+    }
+    for (int i = 0; i < 20; ++i) shape.push_back(Vector3f(5.0, 5.0, i * 0.1));
+    geometry::PointCloud shape_pc;
+    shape_pc.SetPoints(shape);
+    thrustcupoch::device_vector<Vector3f> d_features;
+    EXPECT_TRUE(shape_pc.EstimateNormalsFused(geometry::KDTreeSearchParamRadius(0.35),
+                                              d_features));
+    thrust::host_vector<Vector3f> features = d_features;
+    thrust::host_vector<Vector3f> shape_normals = shape_pc.GetNormals();
+    ASSERT_EQ(shape.size(), features.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NEAR(1.0, std::abs(shape_normals[i](2)), 1.0e-4);
+        EXPECT_NEAR(0.0, features[i](0), 1.0e-4);
+        EXPECT_NEAR(1.0, features[i](1) + features[i](2), 1.0e-4);
+    }
+    for (int i = 100; i < 120; ++i) {
+        EXPECT_NEAR(1.0, features[i](1), 1.0e-4);
+        EXPECT_NEAR(0.0, features[i](2), 1.0e-4);
+    }
+}
+
 TEST(PointCloud, OrientNormalsToAlignWithDirection) {
     thrust::host_vector<Vector3f> ref;
     ref.push_back(Vector3f(0.282003, 0.866394, 0.412111));
@@ -589,4 +945,338 @@ TEST(PointCloud, OrientNormalsToAlignWithDirection) {
     pc.OrientNormalsToAlignWithDirection(Vector3f(1.5, 0.5, 3.3));
 
     ExpectEQ(ref, pc.GetNormals());
-}
\ No newline at end of file
+}
+
+TEST(PointCloud, OrientNormalsTowardsCameraLocation) {
+    int size = 100;
+    thrust::host_vector<Vector3f> points(size);
+    thrust::host_vector<Vector3f> normals(size);
+    Rand(points, Vector3f(-1.0, -1.0, 0.0), Vector3f(1.0, 1.0, 0.0), 0);
+    for (int i = 0; i < size; ++i) {
+        normals[i] = (i % 2 == 0) ? Vector3f(0.0, 0.0, 1.0) : Vector3f(0.0, 0.0, -1.0);
+    }
+    normals[0] = Vector3f::Zero();
+
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    EXPECT_TRUE(pc.OrientNormalsTowardsCameraLocation(Vector3f(0.0, 0.0, 10.0)));
+    thrust::host_vector<Vector3f> oriented = pc.GetNormals();
+    for (int i = 1; i < size; ++i) {
+        ExpectEQ(Vector3f(0.0, 0.0, 1.0), oriented[i]);
+    }
+    EXPECT_NEAR(1.0, oriented[0].norm(), 1.0e-6);
+    EXPECT_LT(0.0, oriented[0](2));
+
+    geometry::PointCloud empty;
+    empty.SetPoints(points);
+    EXPECT_FALSE(empty.OrientNormalsTowardsCameraLocation());
+}
+
+TEST(PointCloud, OrientNormalsConsistentTangentPlane) {
+    int size = 1000;
+    thrust::host_vector<Vector3f> points(size);
+    thrust::host_vector<Vector3f> normals(size);
+    // points on the unit sphere with every third normal flipped
+    const float golden_angle = M_PI * (3.0 - std::sqrt(5.0));
+    for (int i = 0; i < size; ++i) {
+        const float z = 1.0 - 2.0 * (i + 0.5) / size;
+        const float r = std::sqrt(1.0 - z * z);
+        points[i] = Vector3f(r * cos(golden_angle * i), r * sin(golden_angle * i), z);
+        normals[i] = (i % 3 == 0) ? Vector3f(-points[i]) : points[i];
+    }
+
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    EXPECT_TRUE(pc.OrientNormalsConsistentTangentPlane(10));
+    thrust::host_vector<Vector3f> oriented = pc.GetNormals();
+    const bool outward = oriented[0].dot(points[0]) > 0.0;
+    for (int i = 0; i < size; ++i) {
+        EXPECT_NEAR(1.0, std::abs(oriented[i].dot(points[i])), 1.0e-6);
+        EXPECT_EQ(outward, oriented[i].dot(points[i]) > 0.0);
+    }
+}
+
+TEST(PointCloud, KDTreeCache) {
+    int size = 100;
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(1000.0, 1000.0, 1000.0);
+
+    thrust::host_vector<Vector3f> points;
+    points.resize(size);
+    Rand(points, vmin, vmax, 0);
+    pc.SetPoints(points);
+
+    const size_t generation = pc.GetGeneration();
+    auto result0 = pc.SearchNeighbors(KDTreeSearchParamKNN(5));
+    auto result1 = pc.SearchNeighbors(KDTreeSearchParamKNN(5));
+    EXPECT_EQ(result0.get(), result1.get());
+    EXPECT_EQ(5, result0->knn_);
+    EXPECT_EQ(size_t(size * 5), result0->indices_.size());
+    EXPECT_EQ(pc.GetKDTree().get(), pc.GetKDTree().get());
+
+    auto result2 = pc.SearchNeighbors(KDTreeSearchParamKNN(6));
+    EXPECT_NE(result0.get(), result2.get());
+
+    // copies share the cache until they are modified
+    geometry::PointCloud pc_copy(pc);
+    EXPECT_EQ(result0.get(), pc_copy.SearchNeighbors(KDTreeSearchParamKNN(5)).get());
+
+    pc.Translate(Vector3f(1.0, 2.0, 3.0));
+    EXPECT_NE(generation, pc.GetGeneration());
+    auto result3 = pc.SearchNeighbors(KDTreeSearchParamKNN(5));
+    EXPECT_NE(result0.get(), result3.get());
+    EXPECT_EQ(result0.get(), pc_copy.SearchNeighbors(KDTreeSearchParamKNN(5)).get());
+
+    // a tree handed out stays valid when the cache moves on
+    auto kdtree = pc_copy.GetKDTree();
+    const thrustcupoch::device_vector<Vector3f> query = pc_copy.points_;
+
+    // points replaced without InvalidateKDTree are searched again, also
+    // with the same size and in place; the mirrored points have the same
+    // neighbor distances
+    thrust::host_vector<Vector3f> mirrored = points;
+    for (auto &pt : mirrored) pt = -pt;
+    pc_copy.points_ = mirrored;
+    auto result4 = pc_copy.SearchNeighbors(KDTreeSearchParamKNN(5));
+    EXPECT_NE(result0.get(), result4.get());
+    EXPECT_NE(kdtree.get(), pc_copy.GetKDTree().get());
+    thrust::host_vector<float> distance2 = result4->distance2_;
+    thrust::host_vector<float> ref_distance2 = result0->distance2_;
+    ExpectEQ(ref_distance2, distance2);
+    thrustcupoch::device_vector<int> kdtree_indices;
+    thrustcupoch::device_vector<float> kdtree_distance2;
+    kdtree->Search(query, KDTreeSearchParamKNN(5), kdtree_indices, kdtree_distance2);
+    distance2 = kdtree_distance2;
+    ExpectEQ(ref_distance2, distance2);
+
+    pc_copy.points_[0] = Vector3f(-100.0, -100.0, -100.0);
+    auto result5 = pc_copy.SearchNeighbors(KDTreeSearchParamKNN(5));
+    EXPECT_NE(result4.get(), result5.get());
+
+    points.resize(size / 2);
+    pc_copy.points_ = points;
+    auto result6 = pc_copy.SearchNeighbors(KDTreeSearchParamKNN(5));
+    EXPECT_NE(result0.get(), result6.get());
+    EXPECT_EQ(size_t(size / 2 * 5), result6->indices_.size());
+}
+
+TEST(PointCloud, RemoveNoneFinitePoints) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    thrust::host_vector<Vector3f> points;
+    thrust::host_vector<Vector3f> normals;
+    thrust::host_vector<Matrix3f> covariances;
+    for (int i = 0; i < 6; ++i) {
+        points.push_back(Vector3f(i, 0.0, 0.0));
+        normals.push_back(Vector3f(0.0, 0.0, i));
+        covariances.push_back(Matrix3f::Identity() * i);
+    }
+    points[1](1) = nan;
+    points[4](2) = inf;
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    pc.covariances_ = covariances;
+
+    pc.RemoveNoneFinitePoints();
+    ASSERT_EQ(4u, pc.points_.size());
+    ASSERT_TRUE(pc.HasNormals());
+    ASSERT_TRUE(pc.HasCovariances());
+    // the attributes are compacted together with the points
+    thrust::host_vector<Vector3f> out_points = pc.GetPoints();
+    thrust::host_vector<Vector3f> out_normals = pc.GetNormals();
+    thrust::host_vector<Matrix3f> out_covariances = pc.covariances_;
+    const int kept[] = {0, 2, 3, 5};
+    for (int i = 0; i < 4; ++i) {
+        ExpectEQ(Vector3f(kept[i], 0.0, 0.0), out_points[i]);
+        ExpectEQ(Vector3f(0.0, 0.0, kept[i]), out_normals[i]);
+        EXPECT_TRUE(out_covariances[i].isApprox(Matrix3f::Identity() * kept[i]));
+    }
+}
+
+TEST(PointCloud, SortSpatially) {
+    int size = 1000;
+    geometry::PointCloud pc;
+
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(1000.0, 1000.0, 1000.0);
+
+    thrust::host_vector<Vector3f> points(size);
+    thrust::host_vector<Vector3f> normals(size);
+    thrust::host_vector<Vector3f> colors(size);
+    Rand(points, vmin, vmax, 0);
+    Rand(normals, vmin, vmax, 1);
+    Rand(colors, vmin, vmax, 2);
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    pc.SetColors(colors);
+
+    const float voxel_size = 10.0;
+    const size_t generation = pc.GetGeneration();
+    thrust::host_vector<size_t> permutation = pc.SortSpatially(voxel_size);
+    EXPECT_NE(generation, pc.GetGeneration());
+    ASSERT_EQ(size_t(size), permutation.size());
+
+    // the attributes follow the permutation
+    thrust::host_vector<Vector3f> sorted_points = pc.GetPoints();
+    thrust::host_vector<Vector3f> sorted_normals = pc.GetNormals();
+    thrust::host_vector<Vector3f> sorted_colors = pc.GetColors();
+    for (int i = 0; i < size; ++i) {
+        ExpectEQ(points[permutation[i]], sorted_points[i]);
+        ExpectEQ(normals[permutation[i]], sorted_normals[i]);
+        ExpectEQ(colors[permutation[i]], sorted_colors[i]);
+    }
+
+    // the Morton codes are sorted
+    Vector3f min_bound = pc.GetMinBound();
+    uint64_t prev_code = 0;
+    for (int i = 0; i < size; ++i) {
+        uint64_t code = geometry::MortonEncode(
+                geometry::ComputeVoxelIndex(sorted_points[i], min_bound, voxel_size));
+        EXPECT_LE(prev_code, code);
+        prev_code = code;
+    }
+}
+
+TEST(PointCloud, ClusterDBSCAN) {
+    // two chains of points and an isolated point
+    thrust::host_vector<Vector3f> points;
+    for (int i = 0; i < 20; ++i) points.push_back(Vector3f(i * 0.1, 0.0, 0.0));
+    for (int i = 0; i < 30; ++i) points.push_back(Vector3f(10.0, i * 0.1, 0.0));
+    points.push_back(Vector3f(-5.0, -5.0, -5.0));
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    thrust::host_vector<int> labels = pc.ClusterDBSCANHost(0.15, 3);
+    ASSERT_EQ(points.size(), labels.size());
+    for (int i = 0; i < 20; ++i) EXPECT_EQ(0, labels[i]);
+    for (int i = 20; i < 50; ++i) EXPECT_EQ(1, labels[i]);
+    EXPECT_EQ(-1, labels[50]);
+
+    // the two points at each end of the chains are border points
+    labels = pc.ClusterDBSCANHost(0.25, 5);
+    for (int i = 0; i < 20; ++i) EXPECT_EQ(0, labels[i]);
+    for (int i = 20; i < 50; ++i) EXPECT_EQ(1, labels[i]);
+    EXPECT_EQ(-1, labels[50]);
+
+    // no core points
+    labels = pc.ClusterDBSCANHost(0.15, 4);
+    for (size_t i = 0; i < labels.size(); ++i) EXPECT_EQ(-1, labels[i]);
+}
+
+TEST(PointCloud, ClusterEuclidean) {
+    // a line of 30 points along (1, 1, 0), a line of 10 points and a point
+    thrust::host_vector<Vector3f> points;
+    const Vector3f dir = Vector3f(1.0, 1.0, 0.0).normalized();
+    for (int i = 0; i < 30; ++i) points.push_back(Vector3f(5.0, 0.0, 0.0) + i * 0.1 * dir);
+    for (int i = 0; i < 10; ++i) points.push_back(Vector3f(0.0, 0.0, i * 0.1));
+    points.push_back(Vector3f(-5.0, -5.0, -5.0));
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    thrust::host_vector<int> labels = pc.ClusterEuclideanHost(0.15);
+    for (int i = 0; i < 30; ++i) EXPECT_EQ(0, labels[i]);
+    for (int i = 30; i < 40; ++i) EXPECT_EQ(1, labels[i]);
+    EXPECT_EQ(2, labels[40]);
+
+    labels = pc.ClusterEuclideanHost(0.15, 2, 20);
+    for (int i = 0; i < 30; ++i) EXPECT_EQ(-1, labels[i]);
+    for (int i = 30; i < 40; ++i) EXPECT_EQ(0, labels[i]);
+    EXPECT_EQ(-1, labels[40]);
+
+    auto stats = pc.ComputeSegmentStatistics(pc.ClusterEuclidean(0.15, 2));
+    ASSERT_EQ(2u, stats->GetNumSegments());
+    thrust::host_vector<int> counts = stats->counts_;
+    thrust::host_vector<int> offsets = stats->offsets_;
+    thrust::host_vector<int> indices = stats->indices_;
+    EXPECT_EQ(30, counts[0]);
+    EXPECT_EQ(10, counts[1]);
+    ASSERT_EQ(3u, offsets.size());
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(30, offsets[1]);
+    EXPECT_EQ(40, offsets[2]);
+    for (int i = 0; i < 40; ++i) EXPECT_EQ(i, indices[i]);
+
+    // same segments from host labels, as used by the python binding
+    auto host_stats = pc.ComputeSegmentStatisticsHost(pc.ClusterEuclideanHost(0.15, 2));
+    EXPECT_TRUE(thrust::host_vector<int>(host_stats->counts_) == counts);
+    EXPECT_TRUE(thrust::host_vector<int>(host_stats->indices_) == indices);
+
+    thrust::host_vector<Vector3f> centroids = stats->centroids_;
+    thrust::host_vector<Vector3f> min_bounds = stats->min_bounds_;
+    thrust::host_vector<Vector3f> max_bounds = stats->max_bounds_;
+    ExpectEQ(Vector3f(5.0, 0.0, 0.0) + 1.45 * dir, centroids[0], 1.0e-4);
+    ExpectEQ(Vector3f(0.0, 0.0, 0.45), centroids[1], 1.0e-4);
+    ExpectEQ(Vector3f(5.0, 0.0, 0.0), min_bounds[0], 1.0e-4);
+    ExpectEQ(Vector3f(5.0, 0.0, 0.0) + 2.9 * dir, max_bounds[0], 1.0e-4);
+    ExpectEQ(Vector3f(0.0, 0.0, 0.0), min_bounds[1], 1.0e-4);
+    ExpectEQ(Vector3f(0.0, 0.0, 0.9), max_bounds[1], 1.0e-4);
+
+    // the main axis of the oriented boxes follows the lines
+    thrust::host_vector<Matrix3f> rotations = stats->obb_rotations_;
+    thrust::host_vector<Vector3f> obb_centers = stats->obb_centers_;
+    thrust::host_vector<Vector3f> obb_extents = stats->obb_extents_;
+    EXPECT_NEAR(1.0, std::abs(rotations[0].col(0).dot(dir)), 1.0e-4);
+    EXPECT_NEAR(1.0, std::abs(rotations[1].col(0).z()), 1.0e-4);
+    EXPECT_NEAR(1.0, rotations[0].determinant(), 1.0e-4);
+    ExpectEQ(centroids[0], obb_centers[0], 1.0e-4);
+    EXPECT_NEAR(2.9, obb_extents[0][0], 1.0e-4);
+    EXPECT_NEAR(0.0, obb_extents[0][1], 1.0e-4);
+    EXPECT_NEAR(0.9, obb_extents[1][0], 1.0e-4);
+}
+
+TEST(PointCloud, SegmentPlane) {
+    // a floor z = 0, a wall x = 2 and scattered points
+    thrust::host_vector<Vector3f> floor(500);
+    thrust::host_vector<Vector3f> wall(300);
+    thrust::host_vector<Vector3f> noise(100);
+    Rand(floor, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 0.0), 0);
+    Rand(wall, Vector3f(2.0, 0.0, 1.0), Vector3f(2.0, 10.0, 5.0), 1);
+    Rand(noise, Vector3f(6.0, 0.0, 2.0), Vector3f(10.0, 10.0, 8.0), 2);
+    thrust::host_vector<Vector3f> points;
+    points.insert(points.end(), floor.begin(), floor.end());
+    points.insert(points.end(), wall.begin(), wall.end());
+    points.insert(points.end(), noise.begin(), noise.end());
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    auto res = pc.SegmentPlaneHost(0.01, 3, 200);
+    const Vector4f plane = std::get<0>(res);
+    const thrust::host_vector<size_t> inliers = std::get<1>(res);
+    EXPECT_NEAR(1.0, std::abs(plane(2)), 1.0e-4);
+    EXPECT_NEAR(0.0, plane(3), 1.0e-4);
+    ASSERT_EQ(500u, inliers.size());
+    for (size_t i = 0; i < inliers.size(); ++i) EXPECT_EQ(i, inliers[i]);
+
+    // least squares hypotheses
+    res = pc.SegmentPlaneHost(0.01, 5, 500);
+    EXPECT_NEAR(1.0, std::abs(std::get<0>(res)(2)), 1.0e-4);
+    EXPECT_EQ(500u, std::get<1>(res).size());
+
+    auto planes_res = pc.SegmentPlanesHost(0.01, 3, 200, 3, 50);
+    const thrust::host_vector<Vector4f> planes = std::get<0>(planes_res);
+    const thrust::host_vector<int> labels = std::get<1>(planes_res);
+    ASSERT_EQ(2u, planes.size());
+    EXPECT_NEAR(1.0, std::abs(planes[0](2)), 1.0e-4);
+    EXPECT_NEAR(1.0, std::abs(planes[1](0)), 1.0e-4);
+    EXPECT_NEAR(2.0, std::abs(planes[1](3)), 1.0e-4);
+    for (int i = 0; i < 500; ++i) EXPECT_EQ(0, labels[i]);
+    for (int i = 500; i < 800; ++i) EXPECT_EQ(1, labels[i]);
+    for (int i = 800; i < 900; ++i) EXPECT_EQ(-1, labels[i]);
+}
+
+TEST(PointCloud, SegmentPlaneCollinear) {
+    // points on a line do not define a plane
+    thrust::host_vector<Vector3f> points(100);
+    for (int i = 0; i < 100; ++i) points[i] = Vector3f(1.0, 2.0, 3.0) * 0.01 * i;
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    auto res = pc.SegmentPlaneHost(0.01, 5, 100);
+    EXPECT_TRUE(std::get<0>(res).isZero());
+    EXPECT_EQ(0u, std::get<1>(res).size());
+}
@@ -0,0 +1,103 @@
+#include "cupoch/geometry/boundingvolume.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/pointcloud_pipeline.h"
+#include "cupoch/utility/eigen.h"
+#include "tests/test_utility/unit_test.h"
+#include <limits>
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(PointCloudPipeline, FusedElementWise) {
+    int size = 1000;
+    thrust::host_vector<Vector3f> points(size);
+    thrust::host_vector<Vector3f> normals(size);
+    thrust::host_vector<Vector3f> colors(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 10.0), 0);
+    Rand(normals, Vector3f(-1.0, -1.0, -1.0), Vector3f(1.0, 1.0, 1.0), 1);
+    Rand(colors, Vector3f(0.0, 0.0, 0.0), Vector3f(1.0, 1.0, 1.0), 2);
+    points[3] = Vector3f(std::numeric_limits<float>::quiet_NaN(), 1.0, 1.0);
+    points[7] = Vector3f(1.0, std::numeric_limits<float>::infinity(), 1.0);
+    thrust::host_vector<Matrix3f> covariances(size);
+    for (int i = 0; i < size; ++i) {
+        covariances[i] = normals[i] * normals[i].transpose() +
+                         colors[i].asDiagonal().toDenseMatrix();
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    pc.SetNormals(normals);
+    pc.SetColors(colors);
+    pc.covariances_ = covariances;
+
+    const geometry::AxisAlignedBoundingBox bbox(Vector3f(2.0, 2.0, 2.0),
+                                                Vector3f(8.0, 8.0, 8.0));
+    const Matrix4f transformation =
+            (Matrix4f() << 0.0, -1.0, 0.0, 1.0,
+                           1.0, 0.0, 0.0, 2.0,
+                           0.0, 0.0, 1.0, 3.0,
+                           0.0, 0.0, 0.0, 1.0).finished();
+
+    geometry::PointCloudPipeline pipeline;
+    pipeline.RemoveNoneFinitePoints().Crop(bbox).Transform(transformation)
+            .PassThrough(2, 6.0, 10.0);
+    auto output = pipeline.Run(pc);
+
+    // same result as the separate operations
+    geometry::PointCloud ref = pc;
+    ref.RemoveNoneFinitePoints();
+    auto ref_output = ref.Crop(bbox);
+    ref_output->Transform(transformation);
+    ref_output = ref_output->Crop(geometry::AxisAlignedBoundingBox(
+            Vector3f(-100.0, -100.0, 6.0), Vector3f(100.0, 100.0, 10.0)));
+    ExpectEQ(ref_output->GetPoints(), output->GetPoints(), 1.0e-5);
+    ExpectEQ(ref_output->GetNormals(), output->GetNormals(), 1.0e-5);
+    ExpectEQ(ref_output->GetColors(), output->GetColors());
+    thrust::host_vector<Matrix3f> ref_covariances = ref_output->covariances_;
+    thrust::host_vector<Matrix3f> out_covariances = output->covariances_;
+    ASSERT_EQ(ref_output->points_.size(), out_covariances.size());
+    ExpectEQ(ref_covariances, out_covariances, 1.0e-5);
+
+    // the element-wise stages run as a single stage
+    ASSERT_EQ(1u, pipeline.GetTimings().size());
+    EXPECT_EQ("RemoveNoneFinitePoints+Crop+Transform+PassThrough",
+              pipeline.GetTimings()[0].name_);
+    EXPECT_EQ(output->points_.size(), pipeline.GetTimings()[0].num_points_);
+    EXPECT_EQ(size_t(size), pc.points_.size());
+}
+
+TEST(PointCloudPipeline, MixedStages) {
+    int size = 1000;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 10.0), 0);
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+
+    geometry::PointCloudPipeline pipeline;
+    pipeline.PassThrough(0, 0.0, 5.0)
+            .VoxelDownSample(0.5)
+            .PassThrough(1, 0.0, 5.0)
+            .EstimateNormals(geometry::KDTreeSearchParamKNN(10));
+    EXPECT_EQ(4u, pipeline.GetNumStages());
+    auto output = pipeline.Run(pc);
+
+    auto ref = pc.Crop(geometry::AxisAlignedBoundingBox(
+            Vector3f(0.0, -100.0, -100.0), Vector3f(5.0, 100.0, 100.0)));
+    ref = ref->VoxelDownSample(0.5);
+    ref = ref->Crop(geometry::AxisAlignedBoundingBox(
+            Vector3f(-100.0, 0.0, -100.0), Vector3f(100.0, 5.0, 100.0)));
+    ExpectEQ(ref->GetPoints(), output->GetPoints());
+    EXPECT_TRUE(output->HasNormals());
+    ASSERT_EQ(4u, pipeline.GetTimings().size());
+    EXPECT_EQ("VoxelDownSample", pipeline.GetTimings()[1].name_);
+    for (const auto& timing : pipeline.GetTimings()) EXPECT_LE(0.0, timing.elapsed_ms_);
+
+    // the buffers of a released result are reused
+    const geometry::PointCloud* first = output.get();
+    output.reset();
+    output = pipeline.Run(pc);
+    EXPECT_EQ(first, output.get());
+    ExpectEQ(ref->GetPoints(), output->GetPoints());
+    EXPECT_FALSE(pc.HasNormals());
+}
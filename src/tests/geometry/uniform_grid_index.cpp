@@ -0,0 +1,120 @@
+#include "cupoch/geometry/kdtree_flann.h"
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/geometry/uniform_grid_index.h"
+#include "tests/test_utility/pointcloud.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+TEST(UniformGridIndex, SearchKNN) {
+    geometry::PointCloud pc = MakeRandomPointCloud(100);
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::UniformGridIndex grid(pc, 1.0);
+
+    int knn = 30;
+    thrustcupoch::device_vector<int> ref_indices;
+    thrustcupoch::device_vector<float> ref_distance2;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    kdtree.SearchKNN(pc.points_, knn, ref_indices, ref_distance2);
+    int result = grid.SearchKNN(pc.points_, knn, indices, distance2);
+
+    EXPECT_EQ(100 * knn, result);
+    thrust::host_vector<float> h_ref_distance2 = ref_distance2;
+    thrust::host_vector<float> h_distance2 = distance2;
+    ExpectEQ(h_ref_distance2, h_distance2);
+}
+
+TEST(UniformGridIndex, SearchKNNFarQuery) {
+    // the query cell is clamped to the grid, the neighbors are still exact
+    geometry::PointCloud pc = MakeRandomPointCloud(100);
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::UniformGridIndex grid(pc, 0.5);
+
+    Eigen::Vector3f query = {-1.0e3, 5.0, 5.0};
+    thrust::host_vector<int> ref_indices;
+    thrust::host_vector<float> ref_distance2;
+    thrust::host_vector<int> indices;
+    thrust::host_vector<float> distance2;
+    kdtree.SearchKNN(query, 3, ref_indices, ref_distance2);
+    int result = grid.SearchKNN(query, 3, indices, distance2);
+
+    EXPECT_EQ(3, result);
+    ExpectEQ(ref_indices, indices);
+}
+
+TEST(UniformGridIndex, SearchRadius) {
+    geometry::PointCloud pc = MakeRandomPointCloud(100);
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::UniformGridIndex grid(pc, 2.5);
+
+    Eigen::Vector3f query = {1.647059, 4.392157, 8.784314};
+    thrust::host_vector<int> ref_indices;
+    thrust::host_vector<float> ref_distance2;
+    thrust::host_vector<int> indices;
+    thrust::host_vector<float> distance2;
+    // the radius covers 2 cells around the query cell
+    int ref_result = kdtree.SearchRadius(query, 5.0, ref_indices, ref_distance2);
+    int result = grid.SearchRadius(query, 5.0, indices, distance2);
+
+    EXPECT_EQ(21, result);
+    EXPECT_EQ(ref_result, result);
+    // compare the valid neighbors, the rows are padded with -1 and inf
+    ref_indices.resize(result);
+    ref_distance2.resize(result);
+    indices.resize(result);
+    distance2.resize(result);
+    ExpectEQ(ref_indices, indices);
+    ExpectEQ(ref_distance2, distance2);
+}
+
+TEST(UniformGridIndex, SearchHybrid) {
+    geometry::PointCloud pc = MakeRandomPointCloud(100);
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::UniformGridIndex grid(pc, 5.0);
+
+    Eigen::Vector3f query = {1.647059, 4.392157, 8.784314};
+    thrust::host_vector<int> ref_indices;
+    thrust::host_vector<float> ref_distance2;
+    thrust::host_vector<int> indices;
+    thrust::host_vector<float> distance2;
+    kdtree.SearchHybrid(query, 5.0, 15, ref_indices, ref_distance2);
+    int result = grid.SearchHybrid(query, 5.0, 15, indices, distance2);
+
+    EXPECT_EQ(15, result);
+    ExpectEQ(ref_indices, indices);
+    ExpectEQ(ref_distance2, distance2);
+}
+
+TEST(UniformGridIndex, SearchRadiusCSR) {
+    geometry::PointCloud pc = MakeRandomPointCloud(100);
+    geometry::KDTreeFlann kdtree(pc);
+    geometry::UniformGridIndex grid(pc, 2.0);
+
+    thrustcupoch::device_vector<int> ref_offsets;
+    thrustcupoch::device_vector<int> ref_indices;
+    thrustcupoch::device_vector<float> ref_distance2;
+    thrustcupoch::device_vector<int> offsets;
+    thrustcupoch::device_vector<int> indices;
+    thrustcupoch::device_vector<float> distance2;
+    int ref_result = kdtree.SearchRadiusCSR(pc.points_, 2.0, ref_offsets, ref_indices, ref_distance2);
+    int result = grid.SearchRadiusCSR(pc.points_, 2.0, offsets, indices, distance2);
+
+    EXPECT_EQ(ref_result, result);
+    thrust::host_vector<int> h_ref_offsets = ref_offsets;
+    thrust::host_vector<int> h_offsets = offsets;
+    ExpectEQ(h_ref_offsets, h_offsets);
+    thrust::host_vector<float> h_ref_distance2 = ref_distance2;
+    thrust::host_vector<float> h_distance2 = distance2;
+    ExpectEQ(h_ref_distance2, h_distance2);
+
+    ref_result = kdtree.SearchHybridCSR(pc.points_, 2.0, 3, ref_offsets, ref_indices, ref_distance2);
+    result = grid.SearchHybridCSR(pc.points_, 2.0, 3, offsets, indices, distance2);
+    EXPECT_EQ(ref_result, result);
+    h_ref_offsets = ref_offsets;
+    h_offsets = offsets;
+    ExpectEQ(h_ref_offsets, h_offsets);
+}
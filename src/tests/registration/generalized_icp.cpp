@@ -0,0 +1,74 @@
+#include <Eigen/Geometry>
+
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/registration/generalized_icp.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+namespace {
+
+// Three orthogonal planes meeting at the origin, sampled on a grid.
+geometry::PointCloud MakeCorner() {
+    thrust::host_vector<Vector3f> points;
+    const int n = 21;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const float u = 0.05 * i;
+            const float v = 0.05 * j;
+            points.push_back(Vector3f(u, v, 0.0));
+            points.push_back(Vector3f(0.0, u, v));
+            points.push_back(Vector3f(v, 0.0, u));
+        }
+    }
+    geometry::PointCloud pc;
+    pc.SetPoints(points);
+    return pc;
+}
+
+}  // namespace
+
+TEST(GeneralizedICP, EstimateCovariances) {
+    geometry::PointCloud pc = MakeCorner();
+    EXPECT_FALSE(pc.HasCovariances());
+    EXPECT_TRUE(pc.EstimateCovariances(geometry::KDTreeSearchParamKNN(10), 1.0e-3));
+    EXPECT_TRUE(pc.HasCovariances());
+
+    // a point inside the z = 0 plane has the plane covariance
+    thrust::host_vector<Vector3f> points = pc.GetPoints();
+    thrust::host_vector<Matrix3f> covariances = pc.covariances_;
+    const int idx = 3 * (10 * 21 + 10);
+    ASSERT_TRUE(points[idx].isApprox(Vector3f(0.5, 0.5, 0.0)));
+    const Matrix3f ref = Vector3f(1.0, 1.0, 1.0e-3).asDiagonal();
+    EXPECT_TRUE(covariances[idx].isApprox(ref, 1.0e-3));
+
+    // covariances follow the transformation
+    Matrix4f tf = Matrix4f::Identity();
+    tf.block<3, 3>(0, 0) = AngleAxisf(0.5, Vector3f(1.0, 2.0, 3.0).normalized()).toRotationMatrix();
+    tf.block<3, 1>(0, 3) = Vector3f(0.1, -0.2, 0.3);
+    pc.Transform(tf);
+    covariances = pc.covariances_;
+    const Matrix3f R = tf.block<3, 3>(0, 0);
+    EXPECT_TRUE(covariances[idx].isApprox(R * ref * R.transpose(), 1.0e-3));
+}
+
+TEST(GeneralizedICP, RegistrationGeneralizedICP) {
+    geometry::PointCloud source = MakeCorner();
+    Matrix4f ref_tf = Matrix4f::Identity();
+    ref_tf.block<3, 3>(0, 0) = AngleAxisf(0.05, Vector3f(1.0, -1.0, 2.0).normalized()).toRotationMatrix();
+    ref_tf.block<3, 1>(0, 3) = Vector3f(0.02, -0.01, 0.03);
+    geometry::PointCloud target = source;
+    target.Transform(ref_tf);
+
+    const auto result = registration::RegistrationGeneralizedICP(
+            source, target, 0.3, Matrix4f::Identity(),
+            registration::ICPConvergenceCriteria(1.0e-6, 1.0e-6, 50));
+    EXPECT_NEAR(1.0, result.fitness_, 1.0e-6);
+    EXPECT_TRUE(result.transformation_.isApprox(ref_tf, 1.0e-3));
+    // the inputs are left without covariances
+    EXPECT_FALSE(source.HasCovariances());
+    EXPECT_FALSE(target.HasCovariances());
+}
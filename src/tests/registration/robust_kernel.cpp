@@ -0,0 +1,182 @@
+#include <Eigen/Geometry>
+
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/registration/generalized_icp.h"
+#include "cupoch/registration/kabsch.h"
+#include "cupoch/registration/robust_kernel.h"
+#include "cupoch/registration/transformation_estimation.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace std;
+using namespace unit_test;
+
+namespace {
+
+// Source points with their transformed copies as targets, the last
+// num_outliers targets are displaced far from their sources.
+void MakeOutlierPair(geometry::PointCloud &source,
+                     geometry::PointCloud &target,
+                     registration::CorrespondenceSet &corres,
+                     Matrix4f &ref_tf,
+                     size_t num_outliers) {
+    const size_t size = 100;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(1.0, 1.0, 1.0), 0);
+    source.SetPoints(points);
+    ref_tf = Matrix4f::Identity();
+    ref_tf.block<3, 3>(0, 0) = AngleAxisf(0.3, Vector3f(1.0, 2.0, -1.0).normalized()).toRotationMatrix();
+    ref_tf.block<3, 1>(0, 3) = Vector3f(0.1, 0.2, -0.1);
+    target = source;
+    target.Transform(ref_tf);
+    thrust::host_vector<Vector3f> target_points = target.GetPoints();
+    for (size_t i = size - num_outliers; i < size; ++i) {
+        target_points[i] += Vector3f(5.0, -3.0, 4.0);
+    }
+    target.SetPoints(target_points);
+    thrust::host_vector<Vector2i> h_corres(size);
+    for (size_t i = 0; i < size; ++i) h_corres[i] = Vector2i(i, i);
+    corres = h_corres;
+}
+
+// Three orthogonal planes with their normals and covariances, and their
+// transformed copies as targets. Every tenth target is displaced far along
+// its normal.
+void MakeOutlierCornerPair(geometry::PointCloud &source,
+                           geometry::PointCloud &target,
+                           registration::CorrespondenceSet &corres,
+                           Matrix4f &ref_tf) {
+    thrust::host_vector<Vector3f> points;
+    thrust::host_vector<Vector3f> normals;
+    const int n = 21;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const float u = 0.05 * i;
+            const float v = 0.05 * j;
+            points.push_back(Vector3f(u, v, 0.0));
+            normals.push_back(Vector3f(0.0, 0.0, 1.0));
+            points.push_back(Vector3f(0.0, u, v));
+            normals.push_back(Vector3f(1.0, 0.0, 0.0));
+            points.push_back(Vector3f(v, 0.0, u));
+            normals.push_back(Vector3f(0.0, 1.0, 0.0));
+        }
+    }
+    source.SetPoints(points);
+    source.SetNormals(normals);
+    source.EstimateCovariances(geometry::KDTreeSearchParamKNN(10), 1.0e-3);
+    ref_tf = Matrix4f::Identity();
+    ref_tf.block<3, 3>(0, 0) = AngleAxisf(0.05, Vector3f(1.0, -1.0, 2.0).normalized()).toRotationMatrix();
+    ref_tf.block<3, 1>(0, 3) = Vector3f(0.02, -0.01, 0.03);
+    target = source;
+    target.Transform(ref_tf);
+    thrust::host_vector<Vector3f> target_points = target.GetPoints();
+    thrust::host_vector<Vector3f> target_normals = target.GetNormals();
+    for (size_t i = 0; i < target_points.size(); i += 10) {
+        target_points[i] += target_normals[i];
+    }
+    target.points_ = target_points;
+    target.InvalidateKDTree();
+    thrust::host_vector<Vector2i> h_corres(points.size());
+    for (size_t i = 0; i < points.size(); ++i) h_corres[i] = Vector2i(i, i);
+    corres = h_corres;
+}
+
+}  // namespace
+
+TEST(RobustKernel, Weight) {
+    registration::RobustKernel l2;
+    EXPECT_TRUE(l2.IsUniform());
+    EXPECT_EQ(1.0, l2.Weight(100.0));
+
+    registration::RobustKernel huber(registration::RobustKernelType::Huber, 2.0);
+    EXPECT_EQ(1.0, huber.Weight(-1.0));
+    EXPECT_NEAR(0.5, huber.Weight(4.0), 1.0e-6);
+
+    registration::RobustKernel tukey(registration::RobustKernelType::Tukey, 2.0);
+    EXPECT_NEAR(0.5625, tukey.Weight(1.0), 1.0e-6);
+    EXPECT_EQ(0.0, tukey.Weight(3.0));
+
+    registration::RobustKernel cauchy(registration::RobustKernelType::Cauchy, 2.0);
+    EXPECT_NEAR(0.5, cauchy.Weight(2.0), 1.0e-6);
+
+    registration::RobustKernel gm(registration::RobustKernelType::GemanMcClure, 2.0);
+    EXPECT_NEAR(0.25, gm.Weight(-2.0), 1.0e-6);
+
+    // a kernel without scale weights uniformly until it is estimated
+    registration::RobustKernel unscaled(registration::RobustKernelType::Tukey);
+    EXPECT_EQ(1.0, unscaled.Weight(100.0));
+}
+
+TEST(RobustKernel, EstimateScale) {
+    thrust::host_vector<float> h_residuals;
+    for (int i = 0; i < 9; ++i) h_residuals.push_back((i % 2 == 0) ? i : -i);
+    h_residuals.push_back(1000.0);
+    thrustcupoch::device_vector<float> residuals = h_residuals;
+
+    registration::RobustKernel huber(registration::RobustKernelType::Huber);
+    const auto scaled = huber.EstimateScale(residuals);
+    EXPECT_EQ(registration::RobustKernelType::Huber, scaled.type_);
+    EXPECT_NEAR(1.345 * 1.4826 * 5.0, scaled.scale_, 1.0e-4);
+
+    // a given scale is kept
+    registration::RobustKernel fixed(registration::RobustKernelType::Huber, 0.1);
+    EXPECT_EQ(0.1f, fixed.EstimateScale(residuals).scale_);
+}
+
+TEST(RobustKernel, WeightedKabsch) {
+    geometry::PointCloud source, target;
+    registration::CorrespondenceSet corres;
+    Matrix4f ref_tf;
+    MakeOutlierPair(source, target, corres, ref_tf, 10);
+
+    thrust::host_vector<float> h_weights(corres.size(), 1.0);
+    for (size_t i = corres.size() - 10; i < corres.size(); ++i) h_weights[i] = 0.0;
+    thrustcupoch::device_vector<float> weights = h_weights;
+    const Matrix4f res = registration::Kabsch(source.points_, target.points_, corres, weights);
+    EXPECT_TRUE(res.isApprox(ref_tf, 1.0e-3));
+}
+
+TEST(RobustKernel, PointToPointWithOutliers) {
+    geometry::PointCloud source, target;
+    registration::CorrespondenceSet corres;
+    Matrix4f ref_tf;
+    MakeOutlierPair(source, target, corres, ref_tf, 10);
+
+    const registration::TransformationEstimationPointToPoint l2;
+    const registration::TransformationEstimationPointToPoint tukey(
+            registration::RobustKernel(registration::RobustKernelType::Tukey));
+    const Matrix4f res_l2 = l2.ComputeTransformation(source, target, corres);
+    const Matrix4f res_tukey = tukey.ComputeTransformation(source, target, corres);
+    EXPECT_LT((res_tukey - ref_tf).norm(), (res_l2 - ref_tf).norm());
+}
+
+TEST(RobustKernel, PointToPlaneWithOutliers) {
+    geometry::PointCloud source, target;
+    registration::CorrespondenceSet corres;
+    Matrix4f ref_tf;
+    MakeOutlierCornerPair(source, target, corres, ref_tf);
+
+    const registration::TransformationEstimationPointToPlane l2;
+    const registration::TransformationEstimationPointToPlane tukey(
+            registration::RobustKernel(registration::RobustKernelType::Tukey));
+    const Matrix4f res_l2 = l2.ComputeTransformation(source, target, corres);
+    const Matrix4f res_tukey = tukey.ComputeTransformation(source, target, corres);
+    EXPECT_LT((res_tukey - ref_tf).norm(), (res_l2 - ref_tf).norm());
+    EXPECT_TRUE(res_tukey.isApprox(ref_tf, 1.0e-2));
+}
+
+TEST(RobustKernel, GeneralizedICPWithOutliers) {
+    geometry::PointCloud source, target;
+    registration::CorrespondenceSet corres;
+    Matrix4f ref_tf;
+    MakeOutlierCornerPair(source, target, corres, ref_tf);
+
+    const registration::TransformationEstimationForGeneralizedICP l2;
+    const registration::TransformationEstimationForGeneralizedICP tukey(
+            registration::RobustKernel(registration::RobustKernelType::Tukey));
+    const Matrix4f res_l2 = l2.ComputeTransformation(source, target, corres);
+    const Matrix4f res_tukey = tukey.ComputeTransformation(source, target, corres);
+    EXPECT_LT((res_tukey - ref_tf).norm(), (res_l2 - ref_tf).norm());
+    EXPECT_TRUE(res_tukey.isApprox(ref_tf, 1.0e-2));
+}
@@ -0,0 +1,27 @@
+#include "tests/test_utility/pointcloud.h"
+
+#include "tests/test_utility/rand.h"
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace unit_test;
+
+// ----------------------------------------------------------------------------
+// Point cloud of size random points in [0:10]^3, optionally with random unit
+// normals and colors.
+// ----------------------------------------------------------------------------
+geometry::PointCloud unit_test::MakeRandomPointCloud(int size, bool attributes) {
+    geometry::PointCloud pc;
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, Vector3f(0.0, 0.0, 0.0), Vector3f(10.0, 10.0, 10.0), 0);
+    pc.SetPoints(points);
+    if (!attributes) return pc;
+    thrust::host_vector<Vector3f> normals(size);
+    Rand(normals, Vector3f(-1.0, -1.0, -1.0), Vector3f(1.0, 1.0, 1.0), 1);
+    for (auto &nl : normals) nl.normalize();
+    thrust::host_vector<Vector3f> colors(size);
+    Rand(colors, Vector3f(0.0, 0.0, 0.0), Vector3f(1.0, 1.0, 1.0), 2);
+    pc.SetNormals(normals);
+    pc.SetColors(colors);
+    return pc;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "cupoch/geometry/pointcloud.h"
+
+namespace unit_test {
+// Point cloud of size random points in [0:10]^3. With attributes, it also
+// has random unit normals and colors in [0:1].
+cupoch::geometry::PointCloud MakeRandomPointCloud(int size, bool attributes = false);
+}  // namespace unit_test
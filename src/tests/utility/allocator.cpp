@@ -0,0 +1,65 @@
+#include "cupoch/utility/thrust_cupoch.h"
+#include "tests/test_utility/unit_test.h"
+
+using namespace cupoch;
+using namespace unit_test;
+
+TEST(Allocator, ReuseCachedBlock) {
+    utility::TrimAllocator();
+    {
+        thrustcupoch::device_vector<float> buf(1000);
+    }
+    auto before = utility::GetAllocatorStatistics();
+    EXPECT_GT(before.cached_bytes_, 0u);
+    {
+        thrustcupoch::device_vector<float> buf(900);
+        auto during = utility::GetAllocatorStatistics();
+        EXPECT_EQ(before.num_system_allocations_, during.num_system_allocations_);
+        EXPECT_EQ(before.num_pool_hits_ + 1, during.num_pool_hits_);
+        EXPECT_GE(during.in_use_bytes_, 900 * sizeof(float));
+    }
+}
+
+TEST(Allocator, Trim) {
+    {
+        thrustcupoch::device_vector<int> buf(1 << 16);
+    }
+    EXPECT_GT(utility::GetAllocatorStatistics().cached_bytes_, 0u);
+    utility::TrimAllocator();
+    EXPECT_EQ(0u, utility::GetAllocatorStatistics().cached_bytes_);
+}
+
+TEST(Allocator, MaxPoolSize) {
+    utility::TrimAllocator();
+    utility::InitializeAllocator(0, 1024);
+    {
+        thrustcupoch::device_vector<int> buf(1 << 16);
+    }
+    EXPECT_LE(utility::GetAllocatorStatistics().cached_bytes_, 1024u);
+    utility::InitializeAllocator();
+}
+
+TEST(Allocator, InitialPoolServesSmallBuffers) {
+    utility::TrimAllocator();
+    utility::InitializeAllocator(8 << 20);
+    auto before = utility::GetAllocatorStatistics();
+    EXPECT_GE(before.cached_bytes_, size_t(8 << 20));
+    {
+        thrustcupoch::device_vector<float> buf(300000);
+        thrustcupoch::device_vector<float> small_buf(100);
+        thrustcupoch::device_vector<int> tiny_buf(1);
+        auto during = utility::GetAllocatorStatistics();
+        EXPECT_EQ(before.num_system_allocations_, during.num_system_allocations_);
+        EXPECT_EQ(before.num_pool_hits_ + 3, during.num_pool_hits_);
+    }
+    // the split blocks are merged again, so the whole reservation serves
+    // one large buffer
+    {
+        thrustcupoch::device_vector<char> buf(8 << 20);
+        EXPECT_EQ(before.num_system_allocations_,
+                  utility::GetAllocatorStatistics().num_system_allocations_);
+    }
+    utility::InitializeAllocator();
+    utility::TrimAllocator();
+    EXPECT_EQ(0u, utility::GetAllocatorStatistics().cached_bytes_);
+}
@@ -0,0 +1,57 @@
+#include "cupoch/geometry/pointcloud.h"
+#include "cupoch/utility/execution_context.h"
+#include "tests/test_utility/unit_test.h"
+
+#include <thread>
+
+using namespace Eigen;
+using namespace cupoch;
+using namespace unit_test;
+
+TEST(ExecutionContext, ScopedExecutionContext) {
+    utility::ExecutionContext &default_context = utility::GetExecutionContext();
+    utility::ExecutionContext context;
+    {
+        utility::ScopedExecutionContext scope(context);
+        EXPECT_EQ(&context, &utility::GetExecutionContext());
+        EXPECT_EQ(context.GetStream(0), utility::GetStream(0));
+    }
+    EXPECT_EQ(&default_context, &utility::GetExecutionContext());
+}
+
+TEST(ExecutionContext, Workspace) {
+    utility::ExecutionContext context;
+    void *ws0 = context.GetWorkspace(1024);
+    EXPECT_TRUE(ws0 != nullptr);
+    EXPECT_EQ(ws0, context.GetWorkspace(512));
+}
+
+TEST(ExecutionContext, ConcurrentTransform) {
+    const int size = 1000;
+    Vector3f vmin(0.0, 0.0, 0.0);
+    Vector3f vmax(1000.0, 1000.0, 1000.0);
+    thrust::host_vector<Vector3f> points(size);
+    Rand(points, vmin, vmax, 0);
+    Matrix4f transformation = Matrix4f::Identity();
+    transformation.block<3, 1>(0, 3) = Vector3f(1.0, 2.0, 3.0);
+
+    geometry::PointCloud ref;
+    ref.SetPoints(points);
+    ref.Transform(transformation);
+
+    std::vector<geometry::PointCloud> pcs(4);
+    std::vector<std::thread> threads;
+    for (auto &pc : pcs) {
+        threads.emplace_back([&pc, &points, &transformation]() {
+            utility::ExecutionContext context;
+            utility::ScopedExecutionContext scope(context);
+            pc.SetPoints(points);
+            pc.Transform(transformation);
+            context.Synchronize();
+        });
+    }
+    for (auto &th : threads) th.join();
+    for (const auto &pc : pcs) {
+        ExpectEQ(ref.GetPoints(), pc.GetPoints());
+    }
+}
@@ -719,6 +719,154 @@ int KDTreeCuda3dIndex< Distance >::radiusSearchGpu(const Matrix<ElementType>& qu
     }
 }
 
+template< typename Distance>
+void KDTreeCuda3dIndex< Distance >::radiusCountGpu(const Matrix<ElementType>& queries, int* counts, float radius, const SearchParams& params) const
+{
+    int istride=queries.stride/sizeof(ElementType);
+    typename GpuDistance<Distance>::type distance;
+    int threadsPerBlock = 128;
+    int blocksPerGrid=(queries.rows+threadsPerBlock-1)/threadsPerBlock;
+    KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                          thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) ),
+                                                                          queries.ptr(),
+                                                                          istride,
+                                                                          1,
+                                                                          counts,
+                                                                          0,
+                                                                          queries.rows, flann::cuda::CountingRadiusResultSet<float>(radius,params.max_neighbors),
+                                                                          distance
+                                                                          );
+}
+
+template< typename Distance>
+void KDTreeCuda3dIndex< Distance >::knnMeanDistanceGpu(const Matrix<ElementType>& queries, DistanceType* mean_dists, size_t knn, const SearchParams& params) const
+{
+    int istride=queries.stride/sizeof(ElementType);
+    typename GpuDistance<Distance>::type distance;
+    int threadsPerBlock = 128;
+    int blocksPerGrid=(queries.rows+threadsPerBlock-1)/threadsPerBlock;
+    KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                          thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                          thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) ),
+                                                                          queries.ptr(),
+                                                                          istride,
+                                                                          1,
+                                                                          0,
+                                                                          mean_dists,
+                                                                          queries.rows, flann::cuda::KnnMeanDistanceResultSet<float, KNN_MEAN_DISTANCE_MAX_K>(knn),
+                                                                          distance
+                                                                          );
+}
+
+template< typename Distance>
+void KDTreeCuda3dIndex< Distance >::covarianceGpu(const Matrix<ElementType>& queries, DistanceType* covariances, int* counts, int knn, float radius, const SearchParams& params) const
+{
+    int istride=queries.stride/sizeof(ElementType);
+    typename GpuDistance<Distance>::type distance;
+    int threadsPerBlock = 128;
+    int blocksPerGrid=(queries.rows+threadsPerBlock-1)/threadsPerBlock;
+    const float4* points=thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) );
+    if( knn>0 ) {
+        KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                              points,
+                                                                              queries.ptr(),
+                                                                              istride,
+                                                                              9,
+                                                                              counts,
+                                                                              covariances,
+                                                                              queries.rows, flann::cuda::KnnCovarianceResultSet<float, KNN_COVARIANCE_MAX_K>(points, queries.ptr(), istride, knn, radius),
+                                                                              distance
+                                                                              );
+    }
+    else {
+        KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                              points,
+                                                                              queries.ptr(),
+                                                                              istride,
+                                                                              9,
+                                                                              counts,
+                                                                              covariances,
+                                                                              queries.rows, flann::cuda::RadiusCovarianceResultSet<float>(points, queries.ptr(), istride, radius),
+                                                                              distance
+                                                                              );
+    }
+}
+
+template< typename Distance>
+void KDTreeCuda3dIndex< Distance >::radiusSearchCSRGpu(const Matrix<ElementType>& queries, const int* offsets, size_t total_neighbors,
+                                                       int* indices, DistanceType* dists, float radius, const SearchParams& params) const
+{
+    int max_neighbors = params.max_neighbors;
+    bool sorted = params.sorted;
+    bool use_heap = params.use_heap;
+    int istride=queries.stride/sizeof(ElementType);
+    typename GpuDistance<Distance>::type distance;
+    int threadsPerBlock = 128;
+    int blocksPerGrid=(queries.rows+threadsPerBlock-1)/threadsPerBlock;
+    // the result sets only read the offsets
+    int* segment_starts = const_cast<int*>(offsets);
+
+    if( max_neighbors<=0 ) {
+        KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                              thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) ),
+                                                                              queries.ptr(),
+                                                                              istride,
+                                                                              1,
+                                                                              indices,
+                                                                              dists,
+                                                                              queries.rows, flann::cuda::RadiusResultSet<float>(radius,segment_starts,sorted), distance);
+    }
+    else if( use_heap ) {
+        KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                              thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) ),
+                                                                              queries.ptr(),
+                                                                              istride,
+                                                                              1,
+                                                                              indices,
+                                                                              dists,
+                                                                              queries.rows, flann::cuda::RadiusKnnResultSet<float, true>(radius,max_neighbors,segment_starts,sorted), distance);
+    }
+    else {
+        KdTreeCudaPrivate::nearestKernel<<<blocksPerGrid, threadsPerBlock>>> (thrust::raw_pointer_cast(&((*gpu_helper_->gpu_splits_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_child1_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_parent_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_min_)[0])),
+                                                                              thrust::raw_pointer_cast(&((*gpu_helper_->gpu_aabb_max_)[0])),
+                                                                              thrust::raw_pointer_cast( &((*gpu_helper_->gpu_points_)[0]) ),
+                                                                              queries.ptr(),
+                                                                              istride,
+                                                                              1,
+                                                                              indices,
+                                                                              dists,
+                                                                              queries.rows, flann::cuda::RadiusKnnResultSet<float, false>(radius,max_neighbors,segment_starts,sorted), distance);
+    }
+    thrust::device_ptr<int> id=thrust::device_pointer_cast(indices);
+    thrust::transform(id, id+total_neighbors, id, map_indices(thrust::raw_pointer_cast( &((*gpu_helper_->gpu_vind_))[0]) ));
+}
+
 template<typename Distance>
 void KDTreeCuda3dIndex<Distance>::uploadTreeToGpu()
 {
@@ -782,6 +930,15 @@ int KDTreeCuda3dIndex< flann::L2<float> >::radiusSearchGpu(const Matrix<ElementT
 template
 int KDTreeCuda3dIndex< flann::L2<float> >::radiusSearchGpu(const Matrix<ElementType>& queries, std::vector< std::vector<int> >& indices,
                                                            std::vector<std::vector<DistanceType> >& dists, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2<float> >::radiusCountGpu(const Matrix<ElementType>& queries, int* counts, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2<float> >::knnMeanDistanceGpu(const Matrix<ElementType>& queries, DistanceType* mean_dists, size_t knn, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2<float> >::covarianceGpu(const Matrix<ElementType>& queries, DistanceType* covariances, int* counts, int knn, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2<float> >::radiusSearchCSRGpu(const Matrix<ElementType>& queries, const int* offsets, size_t total_neighbors,
+                                                 int* indices, DistanceType* dists, float radius, const SearchParams& params) const;
 
 // explicit instantiations for distance-independent functions
 template
@@ -801,6 +958,15 @@ int KDTreeCuda3dIndex< flann::L2_Simple<float> >::radiusSearchGpu(const Matrix<E
 template
 int KDTreeCuda3dIndex< flann::L2_Simple<float> >::radiusSearchGpu(const Matrix<ElementType>& queries, std::vector< std::vector<int> >& indices,
                                                                   std::vector<std::vector<DistanceType> >& dists, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2_Simple<float> >::radiusCountGpu(const Matrix<ElementType>& queries, int* counts, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2_Simple<float> >::knnMeanDistanceGpu(const Matrix<ElementType>& queries, DistanceType* mean_dists, size_t knn, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2_Simple<float> >::covarianceGpu(const Matrix<ElementType>& queries, DistanceType* covariances, int* counts, int knn, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L2_Simple<float> >::radiusSearchCSRGpu(const Matrix<ElementType>& queries, const int* offsets, size_t total_neighbors,
+                                                 int* indices, DistanceType* dists, float radius, const SearchParams& params) const;
 
 
 // explicit instantiations for distance-independent functions
@@ -821,4 +987,13 @@ int KDTreeCuda3dIndex< flann::L1<float> >::radiusSearchGpu(const Matrix<ElementT
 template
 int KDTreeCuda3dIndex< flann::L1<float> >::radiusSearchGpu(const Matrix<ElementType>& queries, std::vector< std::vector<int> >& indices,
                                                            std::vector<std::vector<DistanceType> >& dists, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L1<float> >::radiusCountGpu(const Matrix<ElementType>& queries, int* counts, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L1<float> >::knnMeanDistanceGpu(const Matrix<ElementType>& queries, DistanceType* mean_dists, size_t knn, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L1<float> >::covarianceGpu(const Matrix<ElementType>& queries, DistanceType* covariances, int* counts, int knn, float radius, const SearchParams& params) const;
+template
+void KDTreeCuda3dIndex< flann::L1<float> >::radiusSearchCSRGpu(const Matrix<ElementType>& queries, const int* offsets, size_t total_neighbors,
+                                                 int* indices, DistanceType* dists, float radius, const SearchParams& params) const;
 }
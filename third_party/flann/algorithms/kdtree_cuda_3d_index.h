@@ -268,6 +268,41 @@ public:
     int radiusSearchGpu(const Matrix<ElementType>& queries, std::vector< std::vector<int> >& indices,
                         std::vector<std::vector<DistanceType> >& dists, float radius, const SearchParams& params) const;
 
+    /**
+     * Counts the neighbors within the radius of each query, clipped to params.max_neighbors
+     * if it is positive. The queries and counts have to be in gpu ram.
+     */
+    void radiusCountGpu(const Matrix<ElementType>& queries, int* counts, float radius, const SearchParams& params) const;
+
+    /**
+     * Mean distance of each query to its knn nearest neighbors, -1 for queries without
+     * neighbors. The neighbors are kept in thread-local storage, so knn has to be at most
+     * KNN_MEAN_DISTANCE_MAX_K. The queries and mean_dists have to be in gpu ram.
+     */
+    void knnMeanDistanceGpu(const Matrix<ElementType>& queries, DistanceType* mean_dists, size_t knn, const SearchParams& params) const;
+
+    static const int KNN_MEAN_DISTANCE_MAX_K = 128;
+
+    /**
+     * Covariance of the neighbors of each query around their mean, accumulated during the
+     * search. With knn > 0 the knn nearest neighbors within the radius are used, kept in
+     * thread-local storage, so knn has to be at most KNN_COVARIANCE_MAX_K. With knn <= 0
+     * all the neighbors within the radius are used. Writes 9 floats (column-major) per
+     * query to covariances and the number of neighbors to counts. radius is the squared
+     * radius, INFINITY for a plain knn search. All arrays have to be in gpu ram.
+     */
+    void covarianceGpu(const Matrix<ElementType>& queries, DistanceType* covariances, int* counts, int knn, float radius, const SearchParams& params) const;
+
+    static const int KNN_COVARIANCE_MAX_K = 128;
+
+    /**
+     * Radius search writing the neighbors densely packed (CSR layout): the neighbors of query i
+     * are stored in [offsets[i], offsets[i+1]). offsets is the exclusive scan of the counts
+     * returned by radiusCountGpu() with the same parameters. All buffers have to be in gpu ram.
+     */
+    void radiusSearchCSRGpu(const Matrix<ElementType>& queries, const int* offsets, size_t total_neighbors,
+                            int* indices, DistanceType* dists, float radius, const SearchParams& params) const;
+
     /**
      * Not implemented, since it is only used by single-element searches.
      * (but is needed b/c it is abstract in the base class)
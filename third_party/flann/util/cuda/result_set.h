@@ -266,6 +266,263 @@ struct CountingRadiusResultSet
     }
 };
 
+//! Keeps the k nearest distances in thread-local storage and only writes their mean,
+//! or -1 if no neighbor was found. Used to reduce the neighbor lists to a single value per
+//! query without global memory for them. k has to be at most MaxK.
+template <typename DistanceType, int MaxK>
+struct KnnMeanDistanceResultSet
+{
+    int foundNeighbors;
+    DistanceType largestDist;
+    int maxDistIndex;
+    const int k;
+    DistanceType localDist[MaxK];
+
+    __device__ __host__
+    KnnMeanDistanceResultSet(int knn) : foundNeighbors(0), largestDist(INFINITY), maxDistIndex(0), k(knn){ }
+
+    __device__
+    inline DistanceType
+    worstDist()
+    {
+        return largestDist;
+    }
+
+    __device__
+    inline void
+    insert(int /*index*/, DistanceType dist)
+    {
+        if( foundNeighbors<k ) {
+            localDist[foundNeighbors]=dist;
+            foundNeighbors++;
+            if( foundNeighbors==k ) findLargestDistIndex();
+        }
+        else if( dist < largestDist ) {
+            localDist[maxDistIndex]=dist;
+            findLargestDistIndex();
+        }
+    }
+
+    __device__
+    void
+    findLargestDistIndex( )
+    {
+        largestDist=localDist[0];
+        maxDistIndex=0;
+        for( int i=1; i<k; i++ )
+            if( localDist[i] > largestDist ) {
+                maxDistIndex=i;
+                largestDist=localDist[i];
+            }
+    }
+
+    DistanceType* resultDist;
+
+    __device__
+    inline void
+    setResultLocation( DistanceType* dists, int* /*index*/, int thread, int stride )
+    {
+        resultDist=dists+thread*stride;
+    }
+
+    __device__
+    inline void
+    finish()
+    {
+        if( foundNeighbors==0 ) {
+            resultDist[0]=-1;
+            return;
+        }
+        DistanceType sum=0;
+        for( int i=0; i<foundNeighbors; i++ ) sum+=localDist[i];
+        resultDist[0]=sum/foundNeighbors;
+    }
+};
+
+//! Accumulates the neighbors of a query relative to the query point, as sum(d) and
+//! sum(d d^T) with d = p - q, and writes their covariance (9 floats, column-major) and
+//! their number. Shared by the covariance result sets.
+struct CovarianceAccumulator
+{
+    float4 q;
+    int count;
+    float sum[3];
+    float sum2[6];
+
+    __device__ __host__
+    CovarianceAccumulator() : count(0)
+    {
+        for( int i=0; i<3; i++ ) sum[i]=0;
+        for( int i=0; i<6; i++ ) sum2[i]=0;
+    }
+
+    __device__
+    inline void
+    add(const float4& p)
+    {
+        const float dx=p.x-q.x;
+        const float dy=p.y-q.y;
+        const float dz=p.z-q.z;
+        sum[0]+=dx; sum[1]+=dy; sum[2]+=dz;
+        sum2[0]+=dx*dx; sum2[1]+=dx*dy; sum2[2]+=dx*dz;
+        sum2[3]+=dy*dy; sum2[4]+=dy*dz; sum2[5]+=dz*dz;
+        count++;
+    }
+
+    __device__
+    inline void
+    write(float* cov, int* n) const
+    {
+        n[0]=count;
+        if( count==0 ) {
+            for( int i=0; i<9; i++ ) cov[i]=0;
+            return;
+        }
+        const float inv=1.0f/count;
+        const float mx=sum[0]*inv, my=sum[1]*inv, mz=sum[2]*inv;
+        cov[0]=sum2[0]*inv-mx*mx;
+        cov[1]=cov[3]=sum2[1]*inv-mx*my;
+        cov[2]=cov[6]=sum2[2]*inv-mx*mz;
+        cov[4]=sum2[3]*inv-my*my;
+        cov[5]=cov[7]=sum2[4]*inv-my*mz;
+        cov[8]=sum2[5]*inv-mz*mz;
+    }
+};
+
+//! Covariance of all the neighbors within the radius, accumulated as they are found.
+//! points are the reordered points of the tree, the indices passed to insert.
+template <typename DistanceType>
+struct RadiusCovarianceResultSet
+{
+    const float4* points;
+    const float* queries;
+    int queryStride;
+    DistanceType radius_sq_;
+    CovarianceAccumulator acc;
+
+    __device__ __host__
+    RadiusCovarianceResultSet(const float4* pts, const float* q, int qstride, DistanceType radius)
+        : points(pts), queries(q), queryStride(qstride), radius_sq_(radius){ }
+
+    __device__
+    inline DistanceType
+    worstDist()
+    {
+        return radius_sq_;
+    }
+
+    __device__
+    inline void
+    insert(int index, DistanceType dist)
+    {
+        if( dist < radius_sq_ ) acc.add(points[index]);
+    }
+
+    DistanceType* resultCov;
+    int* resultCount;
+
+    __device__
+    inline void
+    setResultLocation( DistanceType* covs, int* counts, int thread, int stride )
+    {
+        resultCov=covs+thread*stride;
+        resultCount=counts+thread;
+        const float* q=queries+thread*queryStride;
+        acc.q=make_float4(q[0],q[1],q[2],0);
+    }
+
+    __device__
+    inline void
+    finish()
+    {
+        acc.write(resultCov, resultCount);
+    }
+};
+
+//! Covariance of the k nearest neighbors within the radius (INFINITY for a plain knn
+//! search). The neighbors are kept in thread-local storage, so k has to be at most MaxK.
+template <typename DistanceType, int MaxK>
+struct KnnCovarianceResultSet
+{
+    const float4* points;
+    const float* queries;
+    int queryStride;
+    int foundNeighbors;
+    DistanceType radius_sq_;
+    DistanceType largestDist;
+    int maxDistIndex;
+    const int k;
+    int localIndex[MaxK];
+    DistanceType localDist[MaxK];
+    float4 q;
+
+    __device__ __host__
+    KnnCovarianceResultSet(const float4* pts, const float* qs, int qstride, int knn, DistanceType radius)
+        : points(pts), queries(qs), queryStride(qstride), foundNeighbors(0), radius_sq_(radius),
+          largestDist(radius), maxDistIndex(0), k(knn){ }
+
+    __device__
+    inline DistanceType
+    worstDist()
+    {
+        return largestDist;
+    }
+
+    __device__
+    inline void
+    insert(int index, DistanceType dist)
+    {
+        if( dist >= largestDist ) return;
+        if( foundNeighbors<k ) {
+            localIndex[foundNeighbors]=index;
+            localDist[foundNeighbors]=dist;
+            foundNeighbors++;
+            if( foundNeighbors==k ) findLargestDistIndex();
+        }
+        else {
+            localIndex[maxDistIndex]=index;
+            localDist[maxDistIndex]=dist;
+            findLargestDistIndex();
+        }
+    }
+
+    __device__
+    void
+    findLargestDistIndex( )
+    {
+        largestDist=localDist[0];
+        maxDistIndex=0;
+        for( int i=1; i<k; i++ )
+            if( localDist[i] > largestDist ) {
+                maxDistIndex=i;
+                largestDist=localDist[i];
+            }
+    }
+
+    DistanceType* resultCov;
+    int* resultCount;
+
+    __device__
+    inline void
+    setResultLocation( DistanceType* covs, int* counts, int thread, int stride )
+    {
+        resultCov=covs+thread*stride;
+        resultCount=counts+thread;
+        const float* qp=queries+thread*queryStride;
+        q=make_float4(qp[0],qp[1],qp[2],0);
+    }
+
+    __device__
+    inline void
+    finish()
+    {
+        CovarianceAccumulator acc;
+        acc.q=q;
+        for( int i=0; i<foundNeighbors; i++ ) acc.add(points[localIndex[i]]);
+        acc.write(resultCov, resultCount);
+    }
+};
+
 template<typename DistanceType, bool useHeap>
 struct RadiusKnnResultSet
 {